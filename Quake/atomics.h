@@ -87,6 +87,17 @@ static inline uint32_t Atomic_DecrementUInt32 (volatile atomic_uint32_t *atomic)
 	return InterlockedDecrement ((volatile LONG *)&atomic->value) + 1;
 }
 
+static inline qboolean Atomic_CompareExchangeUInt32 (volatile atomic_uint32_t *atomic, uint32_t *expected, uint32_t desired)
+{
+	const uint32_t actual = InterlockedCompareExchange ((volatile LONG *)&atomic->value, desired, *expected);
+	if (actual == *expected)
+	{
+		return true;
+	}
+	*expected = actual;
+	return false;
+}
+
 typedef struct
 {
 	volatile uint64_t value;
@@ -174,6 +185,11 @@ static inline uint32_t Atomic_DecrementUInt32 (atomic_uint32_t *atomic)
 	return atomic_fetch_sub (atomic, 1);
 }
 
+static inline qboolean Atomic_CompareExchangeUInt32 (atomic_uint32_t *atomic, uint32_t *expected, uint32_t desired)
+{
+	return atomic_compare_exchange_strong (atomic, expected, desired);
+}
+
 typedef _Atomic uint64_t atomic_uint64_t;
 
 static inline uint64_t Atomic_LoadUInt64 (atomic_uint64_t *atomic)
@@ -21,6 +21,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 #include "bgmusic.h"
+#include "q_ctype.h"
+#include "miniz.h"
+#include <setjmp.h>
 
 static void CL_FinishTimeDemo (void);
 
@@ -39,6 +42,668 @@ read from the demo file.
 ==============================================================================
 */
 
+/*
+==============================================================================
+
+MULTI-VIEW DEMOS
+
+Server demos (see sv_demo.c) hold records for all viewers and records for a
+single client. Playback follows one client and skips what the others
+received. A followed client's records always come right after the tick
+they belong to, so they are read without waiting for cl.time.
+==============================================================================
+*/
+
+static qboolean demo_mvd;
+static int      demo_follow;
+static qboolean mvd_havenext; // header of the next record has been read
+static long     mvd_nextpos;
+static int      mvd_nextsize;
+static int      mvd_nexttarget;
+static vec3_t   mvd_nextangles;
+
+/*
+==============
+CL_MVD_PeekRecord
+
+Reads the header of the next record of interest, skipping records of
+clients that aren't followed
+==============
+*/
+static qboolean CL_MVD_PeekRecord (void)
+{
+	int   header[2];
+	float angles[3];
+	int   i;
+
+	if (mvd_havenext)
+		return true;
+
+	for (;;)
+	{
+		mvd_nextpos = ftell (cls.demofile);
+		if (fread (header, 8, 1, cls.demofile) != 1 || fread (angles, 12, 1, cls.demofile) != 1)
+			return false;
+		mvd_nextsize = LittleLong (header[0]);
+		mvd_nexttarget = LittleLong (header[1]);
+		if (mvd_nextsize < 0 || mvd_nextsize > MAX_MSGLEN)
+			Sys_Error ("Demo message > MAX_MSGLEN");
+
+		// follow someone who is actually there
+		if (mvd_nexttarget >= 0 && mvd_nexttarget < cl.maxclients && cl.scores && !cl.scores[demo_follow].name[0] &&
+			cl.scores[mvd_nexttarget].name[0])
+			demo_follow = mvd_nexttarget;
+
+		if (mvd_nexttarget < 0 || mvd_nexttarget == demo_follow)
+			break;
+		if (fseek (cls.demofile, mvd_nextsize, SEEK_CUR) != 0)
+			return false;
+	}
+
+	for (i = 0; i < 3; i++)
+		mvd_nextangles[i] = LittleFloat (angles[i]);
+	mvd_havenext = true;
+	return true;
+}
+
+/*
+==============
+CL_MVD_SameTick
+
+True if the next record belongs to the tick that was just read, either
+the followed client's or one continuing the entities of the tick
+==============
+*/
+static qboolean CL_MVD_SameTick (void)
+{
+	return demo_mvd && CL_MVD_PeekRecord () && (mvd_nexttarget >= 0 || mvd_nexttarget == MVD_CONTINUED);
+}
+
+static int CL_MVD_GetMessage (void)
+{
+	if (!CL_MVD_PeekRecord ())
+	{
+		CL_StopPlayback ();
+		return 0;
+	}
+	mvd_havenext = false;
+
+	if (mvd_nexttarget >= 0)
+	{
+		VectorCopy (cl.mviewangles[0], cl.mviewangles[1]);
+		VectorCopy (mvd_nextangles, cl.mviewangles[0]);
+	}
+
+	net_message.cursize = mvd_nextsize;
+	if (mvd_nextsize && fread (net_message.data, mvd_nextsize, 1, cls.demofile) != 1)
+	{
+		CL_StopPlayback ();
+		return 0;
+	}
+
+	return 1;
+}
+
+/*
+====================
+CL_Follow_f
+
+follow [player]
+====================
+*/
+void CL_Follow_f (void)
+{
+	int i;
+
+	if (cmd_source != src_command)
+		return;
+
+	if (!cls.demoplayback || !demo_mvd || !cl.scores)
+	{
+		Con_Printf ("Not playing a server demo.\n");
+		return;
+	}
+
+	if (Cmd_Argc () == 1)
+	{ // next player
+		for (i = 1; i <= cl.maxclients; i++)
+			if (cl.scores[(demo_follow + i) % cl.maxclients].name[0])
+				break;
+		demo_follow = (demo_follow + i) % cl.maxclients;
+	}
+	else
+	{
+		for (i = 0; i < cl.maxclients; i++)
+			if (cl.scores[i].name[0] && !q_strcasecmp (cl.scores[i].name, Cmd_Argv (1)))
+				break;
+		if (i == cl.maxclients)
+			i = atoi (Cmd_Argv (1)) - 1;
+		if (i < 0 || i >= cl.maxclients || !cl.scores[i].name[0])
+		{
+			Con_Printf ("No player \"%s\"\n", Cmd_Argv (1));
+			return;
+		}
+		demo_follow = i;
+	}
+
+	Con_Printf ("Following %s\n", cl.scores[demo_follow].name);
+}
+
+/*
+==============================================================================
+
+COMPRESSED DEMOS
+
+A compressed demo starts with DEMOZ_MAGIC, a version and the forced cd track,
+followed by chunks. Each chunk is an independent raw deflate stream of the
+usual [length][angles][message] blocks, so it can be decoded without any of
+its predecessors. Keyframe chunks begin with a snapshot of the client state
+(scores, lightstyles, stats, view entity) so that seeking can start there
+instead of replaying the whole level.
+
+Positions (cls.demo_prespawn_end, seeking) are offsets into the uncompressed
+block stream.
+==============================================================================
+*/
+
+#define DEMOZ_MAGIC      "VKDZ"
+#define DEMOZ_VERSION    1
+#define DEMOZ_CHUNK_SIZE (256 * 1024) // flush after this many uncompressed bytes...
+#define DEMOZ_CHUNK_TIME 10.0         // ...or this many seconds of demo time
+#define DEMOZ_MAX_CHUNK  (16 * 1024 * 1024)
+#define DEMOZ_KEYFRAME   1
+#define DEMOZ_HEADERSIZE 16
+#define DEMOZ_END_SIZE   (DEMOZ_HEADERSIZE + 5 + 17) // stored chunk holding the final svc_disconnect
+
+cvar_t cl_democompress = {"cl_democompress", "0", CVAR_ARCHIVE};
+
+typedef struct
+{
+	long   fileofs; // of the compressed data
+	int    compsize;
+	int    rawsize;
+	size_t rawstart; // offset in the uncompressed stream
+	float  starttime;
+	int    flags;
+} demoz_chunk_t;
+
+typedef struct
+{
+	FILE *file;
+	byte *raw;
+	int   rawsize;
+	float starttime;
+	int   flags;
+} demoz_writejob_t;
+
+// playback
+static demoz_chunk_t *demoz_chunks;
+static int            demoz_numchunks;
+static int            demoz_curchunk;
+static int            demoz_rawpos;
+static byte          *demoz_raw;
+static byte          *demoz_comp;
+static task_handle_t  demoz_prefetch_task = INVALID_TASK_HANDLE;
+static int            demoz_prefetch_chunk;
+static qboolean       demoz_prefetch_ok;
+static byte          *demoz_prefetch_raw;
+static byte          *demoz_prefetch_comp;
+
+// recording
+static qboolean      demoz_recording;
+static qboolean      demoz_inkeyframe;
+static qboolean      demoz_insignons;
+static byte         *demoz_chunkbuf;
+static int           demoz_chunklen;
+static int           demoz_chunkmaxlen;
+static float         demoz_chunktime;
+static int           demoz_chunkflags;
+static task_handle_t demoz_write_task = INVALID_TASK_HANDLE;
+
+static void CL_WriteDemoMessage (void);
+static void CL_Record_State (void);
+
+/*
+==============
+CL_DemoZ_Store
+
+Wraps size bytes into deflate stored blocks, returns the output size
+==============
+*/
+static size_t CL_DemoZ_StoredSize (size_t size)
+{
+	return size + 5 * q_max ((size + 65534) / 65535, 1);
+}
+
+static size_t CL_DemoZ_Store (const byte *in, size_t size, byte *out)
+{
+	byte *start = out;
+
+	do
+	{
+		size_t len = q_min (size, 65535);
+		out[0] = (len == size) ? 1 : 0; // BFINAL, BTYPE 00
+		out[1] = len & 0xff;
+		out[2] = len >> 8;
+		out[3] = ~len & 0xff;
+		out[4] = (~len >> 8) & 0xff;
+		memcpy (out + 5, in, len);
+		out += 5 + len;
+		in += len;
+		size -= len;
+	} while (size);
+
+	return out - start;
+}
+
+static void CL_DemoZ_WriteChunkHeader (FILE *f, int compsize, int rawsize, float starttime, int flags)
+{
+	int   header[4];
+	float time = LittleFloat (starttime);
+
+	header[0] = LittleLong (compsize);
+	header[1] = LittleLong (rawsize);
+	memcpy (&header[2], &time, 4);
+	header[3] = LittleLong (flags);
+	fwrite (header, sizeof (header), 1, f);
+}
+
+/*
+==============
+CL_DemoZ_WriteChunk_Task
+
+Compresses and writes one chunk, runs on a worker so recording never
+stalls the frame. Chunks are written in order since every flush joins the
+previous write first.
+==============
+*/
+static void CL_DemoZ_WriteChunk_Task (void *data)
+{
+	demoz_writejob_t *job = (demoz_writejob_t *)data;
+	size_t            compsize;
+	byte             *comp = Image_Deflate (job->raw, job->rawsize, &compsize);
+
+	if (!comp)
+	{ // out of memory? store it instead, still a valid stream
+		comp = Mem_Alloc (CL_DemoZ_StoredSize (job->rawsize));
+		compsize = CL_DemoZ_Store (job->raw, job->rawsize, comp);
+	}
+
+	CL_DemoZ_WriteChunkHeader (job->file, compsize, job->rawsize, job->starttime, job->flags);
+	fwrite (comp, compsize, 1, job->file);
+	fflush (job->file);
+
+	Mem_Free (comp);
+	Mem_Free (job->raw);
+}
+
+static void CL_DemoZ_WaitForWrite (void)
+{
+	if (demoz_write_task != INVALID_TASK_HANDLE)
+	{
+		Task_Join (demoz_write_task, SDL_MUTEX_MAXWAIT);
+		demoz_write_task = INVALID_TASK_HANDLE;
+	}
+}
+
+static void CL_DemoZ_FlushChunk (void)
+{
+	demoz_writejob_t job;
+
+	if (!demoz_chunklen)
+		return;
+
+	CL_DemoZ_WaitForWrite ();
+
+	job.file = cls.demofile;
+	job.raw = demoz_chunkbuf;
+	job.rawsize = demoz_chunklen;
+	job.starttime = demoz_chunktime;
+	job.flags = demoz_chunkflags;
+	demoz_write_task = Task_AllocateAssignFuncAndSubmit (CL_DemoZ_WriteChunk_Task, &job, sizeof (job));
+
+	demoz_chunkbuf = NULL;
+	demoz_chunklen = demoz_chunkmaxlen = 0;
+}
+
+/*
+==============
+CL_DemoZ_WriteKeyframe
+
+Snapshots the client state at the start of a chunk. net_message holds the
+message that is about to be recorded, so spin the snapshot out of a
+separate buffer.
+==============
+*/
+static void CL_DemoZ_WriteKeyframe (void)
+{
+	byte *data = net_message.data;
+	int   maxsize = net_message.maxsize;
+	int   cursize = net_message.cursize;
+	byte  keyframebuffer[NET_MAXMESSAGE];
+
+	// net_message may view a loopback record sized to the incoming packet
+	net_message.data = keyframebuffer;
+	net_message.maxsize = sizeof (keyframebuffer);
+	SZ_Clear (&net_message);
+
+	demoz_inkeyframe = true;
+	CL_Record_State ();
+	if (net_message.cursize)
+		CL_WriteDemoMessage ();
+	demoz_inkeyframe = false;
+
+	net_message.data = data;
+	net_message.maxsize = maxsize;
+	net_message.cursize = cursize;
+}
+
+static void CL_DemoZ_WriteBlock (void)
+{
+	int   i, len;
+	float f;
+
+	if (!demoz_inkeyframe)
+	{
+		if (demoz_chunklen &&
+			(demoz_chunklen + 16 + net_message.cursize > DEMOZ_CHUNK_SIZE || cl.mtime[0] - demoz_chunktime > DEMOZ_CHUNK_TIME))
+			CL_DemoZ_FlushChunk ();
+
+		if (!demoz_chunklen)
+		{
+			demoz_chunktime = cl.mtime[0];
+			demoz_chunkflags = 0;
+			// replacement deltas depend on earlier frames, those chunks can't be seeked to
+			if (cls.signon == SIGNONS && !demoz_insignons && !(cl.protocol_pext2 & PEXT2_REPLACEMENTDELTAS))
+			{
+				demoz_chunkflags = DEMOZ_KEYFRAME;
+				CL_DemoZ_WriteKeyframe ();
+			}
+		}
+	}
+
+	if (demoz_chunklen + 16 + net_message.cursize > demoz_chunkmaxlen)
+	{
+		demoz_chunkmaxlen = q_max (demoz_chunkmaxlen * 2, DEMOZ_CHUNK_SIZE + 16 + MAX_MSGLEN);
+		demoz_chunkbuf = Mem_Realloc (demoz_chunkbuf, demoz_chunkmaxlen);
+	}
+
+	len = LittleLong (net_message.cursize);
+	memcpy (demoz_chunkbuf + demoz_chunklen, &len, 4);
+	for (i = 0; i < 3; i++)
+	{
+		f = LittleFloat (cl.viewangles[i]);
+		memcpy (demoz_chunkbuf + demoz_chunklen + 4 + i * 4, &f, 4);
+	}
+	memcpy (demoz_chunkbuf + demoz_chunklen + 16, net_message.data, net_message.cursize);
+	demoz_chunklen += 16 + net_message.cursize;
+}
+
+/*
+==============
+CL_DemoZ_FinishRecording
+
+Flushes everything and terminates the demo with a stored svc_disconnect
+chunk of a fixed size, so that CL_Resume_Record can overwrite it
+==============
+*/
+static void CL_DemoZ_FinishRecording (void)
+{
+	byte  block[17];
+	byte  stored[DEMOZ_END_SIZE - DEMOZ_HEADERSIZE];
+	int   i, len;
+	float f;
+
+	CL_DemoZ_FlushChunk ();
+	CL_DemoZ_WaitForWrite ();
+
+	len = LittleLong (1);
+	memcpy (block, &len, 4);
+	for (i = 0; i < 3; i++)
+	{
+		f = LittleFloat (cl.viewangles[i]);
+		memcpy (block + 4 + i * 4, &f, 4);
+	}
+	block[16] = svc_disconnect;
+
+	CL_DemoZ_WriteChunkHeader (cls.demofile, CL_DemoZ_Store (block, sizeof (block), stored), sizeof (block), cl.mtime[0], 0);
+	fwrite (stored, sizeof (stored), 1, cls.demofile);
+
+	demoz_recording = false;
+}
+
+/*
+==============
+CL_DemoZ_Decode
+==============
+*/
+static qboolean CL_DemoZ_Decode (int chunk, byte *comp, byte *raw)
+{
+	demoz_chunk_t     *c = &demoz_chunks[chunk];
+	tinfl_decompressor inflator;
+	size_t             insize = c->compsize;
+	size_t             outsize = c->rawsize;
+
+	if (fseek (cls.demofile, c->fileofs, SEEK_SET) != 0 || fread (comp, c->compsize, 1, cls.demofile) != 1)
+		return false;
+
+	tinfl_init (&inflator);
+	if (tinfl_decompress (&inflator, comp, &insize, raw, raw, &outsize, TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF) != TINFL_STATUS_DONE)
+		return false;
+	return outsize == (size_t)c->rawsize;
+}
+
+static void CL_DemoZ_Prefetch_Task (void *data)
+{
+	demoz_prefetch_ok = CL_DemoZ_Decode (demoz_prefetch_chunk, demoz_prefetch_comp, demoz_prefetch_raw);
+}
+
+static void CL_DemoZ_WaitForPrefetch (void)
+{
+	if (demoz_prefetch_task != INVALID_TASK_HANDLE)
+	{
+		Task_Join (demoz_prefetch_task, SDL_MUTEX_MAXWAIT);
+		demoz_prefetch_task = INVALID_TASK_HANDLE;
+	}
+}
+
+/*
+==============
+CL_DemoZ_LoadChunk
+
+Makes chunk current, normally by picking up the copy that was decoded in
+the background while the previous chunk played
+==============
+*/
+static qboolean CL_DemoZ_LoadChunk (int chunk)
+{
+	CL_DemoZ_WaitForPrefetch ();
+
+	if (demoz_prefetch_chunk == chunk && demoz_prefetch_ok)
+	{
+		byte *swap = demoz_raw;
+		demoz_raw = demoz_prefetch_raw;
+		demoz_prefetch_raw = swap;
+	}
+	else if (!CL_DemoZ_Decode (chunk, demoz_comp, demoz_raw))
+	{
+		Con_Printf ("ERROR: demo chunk %i is corrupt\n", chunk);
+		return false;
+	}
+
+	demoz_curchunk = chunk;
+	demoz_rawpos = 0;
+
+	demoz_prefetch_chunk = chunk + 1;
+	demoz_prefetch_ok = false;
+	if (demoz_prefetch_chunk < demoz_numchunks)
+		demoz_prefetch_task = Task_AllocateAssignFuncAndSubmit (CL_DemoZ_Prefetch_Task, NULL, 0);
+
+	return true;
+}
+
+/*
+==============
+CL_DemoZ_Open
+
+Reads the chunk index of a compressed demo, the magic has already been
+consumed. Returns false if the demo is unusable.
+==============
+*/
+static qboolean CL_DemoZ_Open (long start, int length)
+{
+	int    header[4];
+	float  time;
+	long   pos, end = start + length;
+	size_t rawstart = 0;
+	int    maxcomp = 0, maxraw = 0;
+
+	if (fread (header, 8, 1, cls.demofile) != 1 || LittleLong (header[0]) != DEMOZ_VERSION)
+		return false;
+	cls.forcetrack = LittleLong (header[1]);
+
+	for (pos = start + 12; pos + DEMOZ_HEADERSIZE <= end; pos += DEMOZ_HEADERSIZE + header[0])
+	{
+		demoz_chunk_t *c;
+
+		if (fseek (cls.demofile, pos, SEEK_SET) != 0 || fread (header, DEMOZ_HEADERSIZE, 1, cls.demofile) != 1)
+			break;
+		header[0] = LittleLong (header[0]);
+		header[1] = LittleLong (header[1]);
+		if (header[0] <= 0 || header[1] <= 0 || header[1] > DEMOZ_MAX_CHUNK || header[0] > end - pos - DEMOZ_HEADERSIZE)
+			break; // truncated recording, play what's there
+
+		if (!(demoz_numchunks & 63))
+			demoz_chunks = Mem_Realloc (demoz_chunks, (demoz_numchunks + 64) * sizeof (demoz_chunk_t));
+		c = &demoz_chunks[demoz_numchunks++];
+		c->fileofs = pos + DEMOZ_HEADERSIZE;
+		c->compsize = header[0];
+		c->rawsize = header[1];
+		c->rawstart = rawstart;
+		memcpy (&time, &header[2], 4);
+		c->starttime = LittleFloat (time);
+		c->flags = LittleLong (header[3]);
+
+		rawstart += c->rawsize;
+		maxcomp = q_max (maxcomp, c->compsize);
+		maxraw = q_max (maxraw, c->rawsize);
+	}
+
+	if (!demoz_numchunks)
+		return false;
+
+	demoz_comp = Mem_Alloc (maxcomp);
+	demoz_raw = Mem_Alloc (maxraw);
+	demoz_prefetch_comp = Mem_Alloc (maxcomp);
+	demoz_prefetch_raw = Mem_Alloc (maxraw);
+	demoz_prefetch_chunk = -1;
+	demoz_curchunk = -1;
+	demoz_rawpos = 0;
+	return true;
+}
+
+static void CL_DemoZ_Close (void)
+{
+	CL_DemoZ_WaitForPrefetch ();
+	Mem_Free (demoz_chunks);
+	Mem_Free (demoz_comp);
+	Mem_Free (demoz_raw);
+	Mem_Free (demoz_prefetch_comp);
+	Mem_Free (demoz_prefetch_raw);
+	demoz_chunks = NULL;
+	demoz_comp = demoz_raw = demoz_prefetch_comp = demoz_prefetch_raw = NULL;
+	demoz_numchunks = 0;
+}
+
+/*
+==============
+CL_DemoRead / CL_DemoTell / CL_DemoSeek
+
+Demo stream access for plain and compressed demos
+==============
+*/
+static qboolean CL_DemoRead (void *buffer, size_t size)
+{
+	byte *out = (byte *)buffer;
+
+	if (!demoz_chunks)
+		return fread (buffer, size, 1, cls.demofile) == 1;
+
+	while (size)
+	{
+		size_t len;
+
+		if (demoz_curchunk < 0 || demoz_rawpos == demoz_chunks[demoz_curchunk].rawsize)
+		{
+			if (demoz_curchunk + 1 >= demoz_numchunks || !CL_DemoZ_LoadChunk (demoz_curchunk + 1))
+				return false;
+		}
+
+		len = q_min (size, (size_t)(demoz_chunks[demoz_curchunk].rawsize - demoz_rawpos));
+		memcpy (out, demoz_raw + demoz_rawpos, len);
+		demoz_rawpos += len;
+		out += len;
+		size -= len;
+	}
+
+	return true;
+}
+
+static size_t CL_DemoTell (void)
+{
+	if (!demoz_chunks)
+		return mvd_havenext ? mvd_nextpos : ftell (cls.demofile);
+	if (demoz_curchunk < 0)
+		return 0;
+	return demoz_chunks[demoz_curchunk].rawstart + demoz_rawpos;
+}
+
+static void CL_DemoSeek (size_t pos)
+{
+	int chunk;
+
+	if (!demoz_chunks)
+	{
+		fseek (cls.demofile, pos, SEEK_SET);
+		mvd_havenext = false;
+		return;
+	}
+
+	for (chunk = demoz_numchunks - 1; chunk > 0; chunk--)
+		if (demoz_chunks[chunk].rawstart <= pos)
+			break;
+
+	if (chunk != demoz_curchunk && !CL_DemoZ_LoadChunk (chunk))
+	{
+		demoz_curchunk = demoz_numchunks - 1; // read will hit the end
+		demoz_rawpos = demoz_chunks[demoz_curchunk].rawsize;
+		return;
+	}
+	demoz_rawpos = q_min (pos - demoz_chunks[chunk].rawstart, (size_t)demoz_chunks[chunk].rawsize);
+}
+
+/*
+==============
+CL_DemoZ_FindKeyframe
+
+Latest keyframe chunk of the current level before seektime, or -1
+==============
+*/
+static int CL_DemoZ_FindKeyframe (float seektime)
+{
+	size_t pos = CL_DemoTell ();
+	int    i, keyframe = -1;
+
+	for (i = 0; i < demoz_numchunks && demoz_chunks[i].rawstart < pos; i++)
+	{
+		demoz_chunk_t *c = &demoz_chunks[i];
+		if ((c->flags & DEMOZ_KEYFRAME) && c->rawstart >= cls.demo_prespawn_end && c->starttime <= seektime)
+			keyframe = i;
+	}
+
+	return keyframe;
+}
+
 /*
 ==============
 CL_StopPlayback
@@ -51,7 +716,10 @@ void CL_StopPlayback (void)
 	if (!cls.demoplayback)
 		return;
 
+	CL_DemoZ_Close ();
 	fclose (cls.demofile);
+	demo_mvd = false;
+	mvd_havenext = false;
 	cls.demoplayback = false;
 	cls.demoseeking = false;
 	cls.demopaused = false;
@@ -61,6 +729,7 @@ void CL_StopPlayback (void)
 
 	if (cls.timedemo)
 		CL_FinishTimeDemo ();
+	CL_StopCapture ();
 }
 
 /*
@@ -76,6 +745,12 @@ static void CL_WriteDemoMessage (void)
 	int   i;
 	float f;
 
+	if (demoz_recording)
+	{
+		CL_DemoZ_WriteBlock ();
+		return;
+	}
+
 	len = LittleLong (net_message.cursize);
 	fwrite (&len, 4, 1, cls.demofile);
 	for (i = 0; i < 3; i++)
@@ -89,16 +764,16 @@ static void CL_WriteDemoMessage (void)
 
 static int CL_GetDemoMessage (void)
 {
-	int   r, i;
+	int   i;
 	float f;
 
 	if (cls.demopaused)
 		return 0;
 
 	if (cls.signon == (SIGNONS - 2))
-		cls.demo_prespawn_end = ftell (cls.demofile);
+		cls.demo_prespawn_end = CL_DemoTell ();
 	// decide if it is time to grab the next message
-	else if (cls.signon == SIGNONS) // always grab until fully connected
+	else if (cls.signon == SIGNONS && !CL_MVD_SameTick ()) // always grab until fully connected
 	{
 		if (cls.timedemo)
 		{
@@ -129,7 +804,10 @@ static int CL_GetDemoMessage (void)
 		cls.demo_prespawn_end = 0;
 
 	// get the next message
-	if (fread (&net_message.cursize, 4, 1, cls.demofile) != 1)
+	if (demo_mvd)
+		return CL_MVD_GetMessage ();
+
+	if (!CL_DemoRead (&net_message.cursize, 4))
 	{
 		CL_StopPlayback ();
 		return 0;
@@ -137,7 +815,7 @@ static int CL_GetDemoMessage (void)
 	VectorCopy (cl.mviewangles[0], cl.mviewangles[1]);
 	for (i = 0; i < 3; i++)
 	{
-		if (fread (&f, 4, 1, cls.demofile) != 1)
+		if (!CL_DemoRead (&f, 4))
 		{
 			CL_StopPlayback ();
 			return 0;
@@ -148,8 +826,7 @@ static int CL_GetDemoMessage (void)
 	net_message.cursize = LittleLong (net_message.cursize);
 	if (net_message.cursize > MAX_MSGLEN)
 		Sys_Error ("Demo message > MAX_MSGLEN");
-	r = fread (net_message.data, net_message.cursize, 1, cls.demofile);
-	if (r != 1)
+	if (!CL_DemoRead (net_message.data, net_message.cursize))
 	{
 		CL_StopPlayback ();
 		return 0;
@@ -203,7 +880,10 @@ void         CL_Seek_f (void)
 	// large positive offsets could benefit from demoseeking, but we'd lose prints etc
 	if ((offset < 0 || (!relative && offset < cl.time)) && cls.demo_prespawn_end)
 	{
-		fseek (cls.demofile, cls.demo_prespawn_end, SEEK_SET);
+		// compressed demos can restart from a keyframe instead of the level start
+		int keyframe = CL_DemoZ_FindKeyframe (cls.seektime);
+
+		CL_DemoSeek ((keyframe >= 0) ? demoz_chunks[keyframe].rawstart : cls.demo_prespawn_end);
 		cl.mtime[0] = cl.time = 0;
 		cls.demoseeking = true;
 
@@ -225,8 +905,9 @@ void         CL_Seek_f (void)
 		memset (cl.stats, 0, sizeof (cl.stats));
 		memset (cl.statsf, 0, sizeof (cl.statsf));
 
-		// replay last signon for stats and lightstyles
-		cls.signon = (SIGNONS - 2);
+		// replay last signon for stats and lightstyles, keyframes carry their own
+		if (keyframe < 0)
+			cls.signon = (SIGNONS - 2);
 		S_StopAllSounds (true);
 	}
 	else
@@ -288,9 +969,14 @@ void CL_Stop_f (void)
 	}
 
 	// write a disconnect message to the demo file
-	SZ_Clear (&net_message);
-	MSG_WriteByte (&net_message, svc_disconnect);
-	CL_WriteDemoMessage ();
+	if (demoz_recording)
+		CL_DemoZ_FinishRecording ();
+	else
+	{
+		SZ_Clear (&net_message);
+		MSG_WriteByte (&net_message, svc_disconnect);
+		CL_WriteDemoMessage ();
+	}
 
 	// finish up
 	fclose (cls.demofile);
@@ -427,7 +1113,8 @@ static void CL_Record_Prespawn (void)
 	SZ_Clear (&net_message);
 }
 
-static void CL_Record_Spawn (void)
+// spins out scores, lightstyles, stats and the view entity into net_message
+static void CL_Record_State (void)
 {
 	int i;
 
@@ -502,6 +1189,11 @@ static void CL_Record_Spawn (void)
 	// view entity
 	MSG_WriteByte (&net_message, svc_setview);
 	MSG_WriteShort (&net_message, cl.viewentity);
+}
+
+static void CL_Record_Spawn (void)
+{
+	CL_Record_State ();
 
 	// signon
 	MSG_WriteByte (&net_message, svc_signonnum);
@@ -521,18 +1213,23 @@ static void CL_Record_Spawn (void)
 static void CL_Record_Signons (void)
 {
 	byte *data = net_message.data;
+	int   maxsize = net_message.maxsize;
 	int   cursize = net_message.cursize;
 	byte  weirdaltbufferthatprobablyisntneeded[NET_MAXMESSAGE];
 
 	net_message.data = weirdaltbufferthatprobablyisntneeded;
+	net_message.maxsize = sizeof (weirdaltbufferthatprobablyisntneeded);
 	SZ_Clear (&net_message);
 
+	demoz_insignons = true;
 	CL_Record_Serverdata ();
 	CL_Record_Prespawn ();
 	CL_Record_Spawn ();
+	demoz_insignons = false;
 
 	// restore net_message
 	net_message.data = data;
+	net_message.maxsize = maxsize;
 	net_message.cursize = cursize;
 }
 
@@ -629,7 +1326,19 @@ void CL_Record_f (void)
 	}
 
 	cls.forcetrack = track;
-	fprintf (cls.demofile, "%i\n", cls.forcetrack);
+	if (cl_democompress.value)
+	{
+		int header[2];
+
+		header[0] = LittleLong (DEMOZ_VERSION);
+		header[1] = LittleLong (cls.forcetrack);
+		fwrite (DEMOZ_MAGIC, 4, 1, cls.demofile);
+		fwrite (header, sizeof (header), 1, cls.demofile);
+		demoz_recording = true;
+		demoz_chunklen = 0;
+	}
+	else
+		fprintf (cls.demofile, "%i\n", cls.forcetrack);
 
 	cls.demorecording = true;
 
@@ -647,6 +1356,8 @@ Keep recording demo after loading a savegame
 */
 void CL_Resume_Record (qboolean recordsignons)
 {
+	char magic[4];
+
 	cls.demofile = fopen (name, "r+b");
 	if (!cls.demofile)
 	{
@@ -654,7 +1365,9 @@ void CL_Resume_Record (qboolean recordsignons)
 		return;
 	}
 	// overwrite svc_disconnect
-	fseek (cls.demofile, -17, SEEK_END);
+	demoz_recording = fread (magic, 4, 1, cls.demofile) == 1 && !memcmp (magic, DEMOZ_MAGIC, 4);
+	demoz_chunklen = 0;
+	fseek (cls.demofile, demoz_recording ? -DEMOZ_END_SIZE : -17, SEEK_END);
 	Con_Printf ("Demo recording resumed\n");
 	cls.demorecording = true;
 	if (recordsignons)
@@ -670,6 +1383,10 @@ play [demoname]
 */
 void CL_PlayDemo_f (void)
 {
+	char magic[4];
+	long start;
+	int  length;
+
 	if (cmd_source != src_command)
 		return;
 
@@ -688,7 +1405,7 @@ void CL_PlayDemo_f (void)
 
 	Con_Printf ("Playing demo from %s.\n", name);
 
-	COM_FOpenFile (name, &cls.demofile, NULL);
+	length = COM_FOpenFile (name, &cls.demofile, NULL);
 	if (!cls.demofile)
 	{
 		Con_Printf ("ERROR: couldn't open %s\n", name);
@@ -696,11 +1413,44 @@ void CL_PlayDemo_f (void)
 		return;
 	}
 
+	start = ftell (cls.demofile);
+	if (fread (magic, 4, 1, cls.demofile) == 1 && !memcmp (magic, DEMOZ_MAGIC, 4))
+	{
+		if (!CL_DemoZ_Open (start, length))
+		{
+			CL_DemoZ_Close ();
+			fclose (cls.demofile);
+			cls.demofile = NULL;
+			cls.demonum = -1; // stop demo loop
+			Con_Printf ("ERROR: demo \"%s\" is invalid\n", name);
+			return;
+		}
+	}
+	else if (!memcmp (magic, MVD_MAGIC, 4))
+	{
+		int header[2];
+
+		if (fread (header, sizeof (header), 1, cls.demofile) != 1 || LittleLong (header[0]) != MVD_VERSION)
+		{
+			fclose (cls.demofile);
+			cls.demofile = NULL;
+			cls.demonum = -1; // stop demo loop
+			Con_Printf ("ERROR: demo \"%s\" is invalid\n", name);
+			return;
+		}
+		cls.forcetrack = LittleLong (header[1]);
+		demo_mvd = true;
+		demo_follow = 0;
+		mvd_havenext = false;
+	}
+	else
+		fseek (cls.demofile, start, SEEK_SET);
+
 	// ZOID, fscanf is evil
 	// O.S.: if a space character e.g. 0x20 (' ') follows '\n',
 	// fscanf skips that byte too and screws up further reads.
 	//	fscanf (cls.demofile, "%i\n", &cls.forcetrack);
-	if (fscanf (cls.demofile, "%i", &cls.forcetrack) != 1 || fgetc (cls.demofile) != '\n')
+	if (!demoz_chunks && !demo_mvd && (fscanf (cls.demofile, "%i", &cls.forcetrack) != 1 || fgetc (cls.demofile) != '\n'))
 	{
 		fclose (cls.demofile);
 		cls.demofile = NULL;
@@ -768,3 +1518,490 @@ void CL_TimeDemo_f (void)
 	cls.td_startframe = host_framecount;
 	cls.td_lastframe = -1; // get a new message this frame
 }
+
+/*
+==============================================================================
+
+DEMO CAPTURE
+
+capturedemo <demoname>
+
+Plays a demo at a fixed capture_fps step. Every frame is copied back from
+the GPU through the screenshot readback ring and written by a task, in
+order, either as raw RGBA to the -capturepipe command or as a capture_format
+image sequence in <gamedir>/capture. The game skips frames instead of
+blocking when the ring is full. Audio is mixed for exactly one step per
+copied frame and written to <gamedir>/capture/<demo>.wav.
+
+The encoder only comes from the command line, so neither a config nor a
+server can make the client run something. %w, %h and %r are replaced with
+the width, height and frame rate:
+vkquake -capturepipe "ffmpeg -f rawvideo -pix_fmt rgba -s %wx%h -r %r -i - -c:v libx264 out.mp4"
+==============================================================================
+*/
+
+#ifdef _WIN32
+#define popen  _popen
+#define pclose _pclose
+#endif
+
+cvar_t capture_fps = {"capture_fps", "30", CVAR_ARCHIVE};
+cvar_t capture_format = {"capture_format", "tga", CVAR_ARCHIVE};
+
+static struct
+{
+	qboolean active;
+	double   frametime;
+	char     name[MAX_QPATH];
+	char     ext[4];
+	FILE    *pipe;
+	int      width; // of the piped stream
+	int      height;
+	qboolean warned;
+	int      frames; // only touched by the frame writer tasks while active
+	uint32_t audio_frames;
+	FILE    *wav;
+	int      wav_channels;
+	int      wav_rate;
+	uint32_t wav_bytes;
+} capture;
+
+/*
+====================
+CL_CaptureFrameTime -- 0 when not capturing
+====================
+*/
+double CL_CaptureFrameTime (void)
+{
+	return capture.active ? capture.frametime : 0.0;
+}
+
+/*
+====================
+CL_CapturePipeCommand
+====================
+*/
+static void CL_CapturePipeCommand (const char *in, char *out, size_t size, int width, int height, float fps)
+{
+	size_t len = 0;
+
+	while (*in && (len + 1 < size))
+	{
+		if ((in[0] == '%') && ((in[1] == 'w') || (in[1] == 'h') || (in[1] == 'r')))
+		{
+			if (in[1] == 'r')
+				q_snprintf (out + len, size - len, "%g", fps);
+			else
+				q_snprintf (out + len, size - len, "%d", (in[1] == 'w') ? width : height);
+			len += strlen (out + len);
+			in += 2;
+		}
+		else
+			out[len++] = *in++;
+	}
+	out[len] = 0;
+}
+
+/*
+====================
+CL_WriteWavHeader
+====================
+*/
+typedef struct
+{
+	char  riff[4];
+	int   riff_size;
+	char  wave_fmt[8];
+	int   fmt_size;
+	short format;
+	short channels;
+	int   rate;
+	int   byte_rate;
+	short block_align;
+	short bits;
+	char  data[4];
+	int   data_size;
+} wav_header_t;
+COMPILE_TIME_ASSERT (wav_header_t, sizeof (wav_header_t) == 44);
+
+static void CL_WriteWavHeader (void)
+{
+	wav_header_t header;
+
+	memcpy (header.riff, "RIFF", 4);
+	header.riff_size = LittleLong (36 + capture.wav_bytes);
+	memcpy (header.wave_fmt, "WAVEfmt ", 8);
+	header.fmt_size = LittleLong (16);
+	header.format = LittleShort (1); // PCM
+	header.channels = LittleShort (capture.wav_channels);
+	header.rate = LittleLong (capture.wav_rate);
+	header.byte_rate = LittleLong (capture.wav_rate * capture.wav_channels * 2);
+	header.block_align = LittleShort (capture.wav_channels * 2);
+	header.bits = LittleShort (16);
+	memcpy (header.data, "data", 4);
+	header.data_size = LittleLong (capture.wav_bytes);
+	fseek (capture.wav, 0, SEEK_SET);
+	fwrite (&header, sizeof (header), 1, capture.wav);
+	fseek (capture.wav, 0, SEEK_END);
+}
+
+/*
+====================
+CL_CaptureAudio -- called by the mixer with one frame worth of little endian 16 bit samples
+====================
+*/
+void CL_CaptureAudio (const short *samples, int count, int channels, int rate)
+{
+	if (!capture.active)
+		return;
+
+	if (!capture.wav)
+	{
+		char path[MAX_OSPATH];
+		q_snprintf (path, sizeof (path), "%s/capture/%s.wav", com_gamedir, capture.name);
+		capture.wav = fopen (path, "wb");
+		if (!capture.wav)
+		{
+			Con_Printf ("ERROR: couldn't open %s\n", path);
+			capture.wav_channels = -1;
+			return;
+		}
+		capture.wav_channels = channels;
+		capture.wav_rate = rate;
+		capture.wav_bytes = 0;
+		CL_WriteWavHeader ();
+	}
+	if (channels != capture.wav_channels || rate != capture.wav_rate)
+		return;
+
+	const size_t size = count * channels * sizeof (short);
+	if (fwrite (samples, size, 1, capture.wav) == 1)
+		capture.wav_bytes += size;
+}
+
+/*
+====================
+CL_CaptureFrameAudio -- mixes one step of audio for every frame copied since the last call
+
+Frames that never reached the screen don't advance the audio either, so the
+sound track stays in step with the video frames that were actually written.
+====================
+*/
+void CL_CaptureFrameAudio (void)
+{
+	if (!capture.active)
+		return;
+
+	// the copy is recorded by the end rendering task of the previous frame
+	GL_SynchronizeEndRenderingTask ();
+	const uint32_t recorded = GL_CaptureFramesRecorded ();
+	while (capture.audio_frames != recorded)
+	{
+		S_CaptureFrame ();
+		++capture.audio_frames;
+	}
+}
+
+/*
+====================
+CL_CaptureVideoFrame -- runs on a task, the frame writer tasks are chained so frames arrive in order
+====================
+*/
+void CL_CaptureVideoFrame (const byte *data, int width, int height)
+{
+	if (capture.pipe)
+	{
+		// a raw stream can't change size, drop frames until the video mode matches again
+		if ((width != capture.width) || (height != capture.height))
+		{
+			if (!capture.warned)
+				Con_Warning ("capture: frame size changed to %dx%d, dropping frames\n", width, height);
+			capture.warned = true;
+			return;
+		}
+		if (fwrite (data, width * height * 4, 1, capture.pipe) != 1 && !capture.warned)
+		{
+			Con_Warning ("capture: couldn't write to the encoder\n");
+			capture.warned = true;
+		}
+	}
+	else
+	{
+		char     filename[MAX_QPATH];
+		qboolean ok;
+		q_snprintf (filename, sizeof (filename), "capture/%s_%06d.%s", capture.name, capture.frames, capture.ext);
+		if (!strcmp (capture.ext, "png"))
+			ok = Image_WritePNG (filename, (byte *)data, width, height, 32, true);
+		else
+			ok = Image_WriteTGA (filename, (byte *)data, width, height, 32, true);
+		if (!ok && !capture.warned)
+		{
+			Con_Warning ("capture: couldn't write %s\n", filename);
+			capture.warned = true;
+		}
+	}
+	++capture.frames;
+}
+
+/*
+====================
+CL_StopCapture
+====================
+*/
+void CL_StopCapture (void)
+{
+	if (!capture.active)
+		return;
+
+	GL_FlushCaptureFrames ();
+	CL_CaptureFrameAudio ();
+	capture.active = false;
+	S_EndCapture ();
+
+	if (capture.pipe)
+		pclose (capture.pipe);
+	capture.pipe = NULL;
+	if (capture.wav)
+	{
+		CL_WriteWavHeader ();
+		fclose (capture.wav);
+	}
+	capture.wav = NULL;
+
+	Con_Printf ("captured %i frames (%.1f seconds)\n", capture.frames, capture.frames * capture.frametime);
+}
+
+/*
+====================
+CL_CaptureDemo_f
+
+capturedemo [demoname]
+====================
+*/
+void CL_CaptureDemo_f (void)
+{
+	if (cmd_source != src_command)
+		return;
+
+	if (Cmd_Argc () != 2)
+	{
+		Con_Printf ("capturedemo <demoname> : renders a demo to video at capture_fps\n");
+		return;
+	}
+
+	CL_PlayDemo_f ();
+	if (!cls.demofile)
+		return;
+
+	const float fps = CLAMP (1.0f, capture_fps.value, 1000.0f);
+	const int   pipe_arg = COM_CheckParm ("-capturepipe");
+	memset (&capture, 0, sizeof (capture));
+	capture.frametime = 1.0 / fps;
+	capture.audio_frames = GL_CaptureFramesRecorded ();
+	COM_FileBase (Cmd_Argv (1), capture.name, sizeof (capture.name));
+	q_strlcpy (capture.ext, q_strcasecmp (capture_format.string, "png") ? "tga" : "png", sizeof (capture.ext));
+	Sys_mkdir (com_gamedir);
+	Sys_mkdir (va ("%s/capture", com_gamedir));
+
+	if (pipe_arg && (pipe_arg < com_argc - 1))
+	{
+		char command[1024];
+		capture.width = vid.width;
+		capture.height = vid.height;
+		CL_CapturePipeCommand (com_argv[pipe_arg + 1], command, sizeof (command), capture.width, capture.height, fps);
+#ifdef _WIN32
+		capture.pipe = popen (command, "wb");
+#else
+		capture.pipe = popen (command, "w");
+#endif
+		if (!capture.pipe)
+		{
+			Con_Printf ("ERROR: couldn't run %s\n", command);
+			CL_StopPlayback ();
+			return;
+		}
+		Con_Printf ("capturing %dx%d at %g fps to %s\n", capture.width, capture.height, fps, command);
+	}
+	else
+		Con_Printf ("capturing at %g fps to %s/capture/%s_*.%s\n", fps, com_gamedir, capture.name, capture.ext);
+
+	S_BeginCapture (capture.frametime);
+	capture.active = true;
+}
+
+/*
+==============================================================================
+
+HEADLESS DEMO ANALYSIS
+
+vkquake -demoanalyze <demo> [<demo> ...] [-demoanalyze_jobs <n>] [-demoanalyze_out <dir>]
+
+Parses demos through CL_ParseServerMessage and CL_RelinkEntities as fast as
+possible with no video, audio or input initialised. Each demo frame produces
+one JSON line in <dir>/<demo>.jsonl, followed by a summary line for the whole
+demo. With -demoanalyze_jobs the demo list is split across worker processes.
+==============================================================================
+*/
+
+extern const char *svc_strings[128];
+extern jmp_buf     host_abortserver;
+extern sizebuf_t   cmd_text;
+
+static const char *CL_DemoAnalyze_SvcName (int cmd)
+{
+	static char name[16];
+
+	if (cmd == U_SIGNAL)
+		return "fast_update";
+	if (cmd < 128 && svc_strings[cmd] && q_isalpha (svc_strings[cmd][0]))
+		return svc_strings[cmd];
+	q_snprintf (name, sizeof (name), "svc_%i", cmd);
+	return name;
+}
+
+static void CL_DemoAnalyze_WriteSvcBytes (FILE *f, const unsigned int *svcbytes)
+{
+	int      i;
+	qboolean first = true;
+
+	fputs ("{", f);
+	for (i = 0; i < 256; i++)
+	{
+		if (!svcbytes[i])
+			continue;
+		fprintf (f, "%s\"%s\":%u", first ? "" : ",", CL_DemoAnalyze_SvcName (i), svcbytes[i]);
+		first = false;
+	}
+	fputs ("}", f);
+}
+
+/*
+====================
+CL_DemoAnalyze_Run
+
+Returns false if the demo couldn't be opened
+====================
+*/
+static qboolean CL_DemoAnalyze_Run (const char *demoname, FILE *f)
+{
+	static unsigned int totalbytes[256];
+	static int          frames, maxvisedicts, maxdlights, maxparticles;
+	static double       starttime;
+	unsigned int        msgbytes;
+	int                 i, particles;
+	jmp_buf             prev_abortserver;
+
+	memset (totalbytes, 0, sizeof (totalbytes));
+	frames = maxvisedicts = maxdlights = maxparticles = 0;
+	starttime = Sys_DoubleTime ();
+
+	// Host_Error/Host_EndGame (e.g. svc_disconnect at the end of the demo) land here
+	// instead of in whatever frame last set host_abortserver
+	memcpy (prev_abortserver, host_abortserver, sizeof (jmp_buf));
+	if (setjmp (host_abortserver))
+		CL_Disconnect ();
+	else
+	{
+		Cmd_ExecuteString (va ("timedemo %s", demoname), src_command);
+		if (!cls.demoplayback)
+		{
+			memcpy (host_abortserver, prev_abortserver, sizeof (jmp_buf));
+			return false;
+		}
+	}
+
+	while (cls.demoplayback)
+	{
+		memset (cls.svcbytes, 0, sizeof (cls.svcbytes));
+		realtime = Sys_DoubleTime ();
+		host_frametime = 0;
+
+		CL_ReadFromServer ();
+		if (!cls.demoplayback)
+			break;
+		CL_RunParticles ();
+		CL_DecayLights ();
+
+		// nothing is sent to a server and stuffed commands are never executed
+		SZ_Clear (&cls.message);
+		SZ_Clear (&cmd_text);
+
+		msgbytes = 0;
+		for (i = 0; i < 256; i++)
+		{
+			msgbytes += cls.svcbytes[i];
+			totalbytes[i] += cls.svcbytes[i];
+		}
+
+		particles = R_CountParticles ();
+		maxvisedicts = q_max (maxvisedicts, dev_stats.visedicts);
+		maxdlights = q_max (maxdlights, dev_stats.dlights);
+		maxparticles = q_max (maxparticles, particles);
+
+		fprintf (
+			f, "{\"frame\":%i,\"time\":%.3f,\"signon\":%i,\"msgbytes\":%u,\"entities\":%i,\"visedicts\":%i,\"tempents\":%i,\"beams\":%i,\"dlights\":%i,\"particles\":%i,\"svc\":",
+			frames, cl.mtime[0], cls.signon, msgbytes, cl.num_entities, dev_stats.visedicts, dev_stats.tempents, dev_stats.beams, dev_stats.dlights, particles);
+		CL_DemoAnalyze_WriteSvcBytes (f, cls.svcbytes);
+		fputs ("}\n", f);
+
+		frames++;
+		host_framecount++;
+	}
+
+	fprintf (
+		f, "{\"demo\":\"%s\",\"frames\":%i,\"demotime\":%.3f,\"parsetime\":%.3f,\"maxvisedicts\":%i,\"maxdlights\":%i,\"maxparticles\":%i,\"svc\":", demoname,
+		frames, cl.mtime[0], Sys_DoubleTime () - starttime, maxvisedicts, maxdlights, maxparticles);
+	CL_DemoAnalyze_WriteSvcBytes (f, totalbytes);
+	fputs ("}\n", f);
+
+	memcpy (host_abortserver, prev_abortserver, sizeof (jmp_buf));
+	return true;
+}
+
+/*
+====================
+CL_DemoAnalyze
+
+Analyses every demo listed after -demoanalyze whose index falls to this worker
+====================
+*/
+void CL_DemoAnalyze (int worker, int numworkers)
+{
+	char        outdir[MAX_OSPATH];
+	char        outname[MAX_OSPATH];
+	char        base[MAX_QPATH];
+	const char *demoname;
+	FILE       *f;
+	int         i, first, demoindex;
+
+	i = COM_CheckParm ("-demoanalyze_out");
+	if (i && i < com_argc - 1)
+		q_strlcpy (outdir, com_argv[i + 1], sizeof (outdir));
+	else
+		q_snprintf (outdir, sizeof (outdir), "%s/demostats", com_gamedir);
+
+	first = COM_CheckParm ("-demoanalyze") + 1;
+	for (i = first, demoindex = 0; i < com_argc && com_argv[i][0] != '-' && com_argv[i][0] != '+'; i++, demoindex++)
+	{
+		if (demoindex % numworkers != worker)
+			continue;
+
+		demoname = com_argv[i];
+		COM_FileBase (demoname, base, sizeof (base));
+		q_snprintf (outname, sizeof (outname), "%s/%s.jsonl", outdir, base);
+		COM_CreatePath (outname);
+		f = fopen (outname, "w");
+		if (!f)
+		{
+			Sys_Printf ("ERROR: couldn't create %s\n", outname);
+			continue;
+		}
+
+		if (CL_DemoAnalyze_Run (demoname, f))
+			Sys_Printf ("analysed %s -> %s\n", demoname, outname);
+		fclose (f);
+	}
+
+	if (i == first)
+		Sys_Printf ("usage: -demoanalyze <demo> [<demo> ...] [-demoanalyze_jobs <n>] [-demoanalyze_out <dir>]\n");
+}
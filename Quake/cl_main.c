@@ -155,6 +155,9 @@ This is also called on Host_Error, so it shouldn't cause any errors
 */
 void CL_Disconnect (void)
 {
+	// the server thread may still be sending to our loopback socket
+	Host_WaitServerThread ();
+
 	if (key_dest == key_message)
 		Key_EndChat (); // don't get stuck in chat mode
 
@@ -1207,6 +1210,9 @@ void CL_Init (void)
 	Cvar_RegisterVariable (&cl_minpitch); // johnfitz -- variable pitch clamping
 
 	Cvar_RegisterVariable (&cl_startdemos);
+	Cvar_RegisterVariable (&cl_democompress);
+	Cvar_RegisterVariable (&capture_fps);
+	Cvar_RegisterVariable (&capture_format);
 
 	Cmd_AddCommand ("entities", CL_PrintEntities_f);
 	Cmd_AddCommand ("disconnect", CL_Disconnect_f);
@@ -1214,7 +1220,9 @@ void CL_Init (void)
 	Cmd_AddCommand ("stop", CL_Stop_f);
 	Cmd_AddCommand ("playdemo", CL_PlayDemo_f);
 	Cmd_AddCommand ("timedemo", CL_TimeDemo_f);
+	Cmd_AddCommand ("capturedemo", CL_CaptureDemo_f);
 	Cmd_AddCommand ("seek", CL_Seek_f);
+	Cmd_AddCommand ("follow", CL_Follow_f);
 
 	Cmd_AddCommand ("tracepos", CL_Tracepos_f); // johnfitz
 	Cmd_AddCommand ("viewpos", CL_Viewpos_f);   // johnfitz
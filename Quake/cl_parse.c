@@ -1716,6 +1716,7 @@ void CL_ParseServerMessage (void)
 	int         i;
 	const char *str;               // johnfitz
 	int         total, j, lastcmd; // johnfitz
+	int         statcmd, statstart;
 
 	//
 	// if recording demos, copy the message out
@@ -1731,12 +1732,22 @@ void CL_ParseServerMessage (void)
 	MSG_BeginReading ();
 
 	lastcmd = 0;
+	statcmd = -1;
+	statstart = 0;
 	while (1)
 	{
 		if (msg_badread)
 			Host_Error ("CL_ParseServerMessage: Bad server message");
 
+		if (cls.demoanalyze)
+		{
+			if (statcmd >= 0)
+				cls.svcbytes[statcmd] += msg_readcount - statstart;
+			statstart = msg_readcount;
+		}
+
 		cmd = MSG_ReadByte ();
+		statcmd = (cmd & U_SIGNAL) ? U_SIGNAL : cmd;
 
 		if (cmd == -1)
 		{
@@ -65,7 +65,8 @@ typedef struct
 
 #define SIGNONS 4 // signon messages to receive before connected
 
-#define MAX_DLIGHTS 64 // johnfitz -- was 32
+#define MAX_DLIGHTS     1024 // johnfitz -- was 32, must match update_lightmap.comp
+#define MAX_CPU_DLIGHTS 64   // lights the CPU lightmap path marks on surfaces, the rest are only lit by r_gpulightmapupdate
 typedef struct
 {
 	vec3_t origin;
@@ -138,6 +139,10 @@ typedef struct
 	int      td_startframe; // host_framecount at start
 	float    td_starttime;  // realtime at second frame of timedemo
 
+	// headless demo analysis (-demoanalyze)
+	qboolean     demoanalyze;
+	unsigned int svcbytes[256]; // bytes parsed per svc type, fast updates are counted under U_SIGNAL
+
 	// connection information
 	int               signon; // 0 to SIGNONS
 	struct qsocket_s *netcon;
@@ -318,6 +323,9 @@ extern cvar_t m_forward;
 extern cvar_t m_side;
 
 extern cvar_t cl_startdemos;
+extern cvar_t cl_democompress;
+extern cvar_t capture_fps;
+extern cvar_t capture_format;
 
 #define MAX_TEMP_ENTITIES 256 // johnfitz -- was 64
 
@@ -391,12 +399,20 @@ void CL_ClearTrailStates (void);
 void CL_StopPlayback (void);
 int  CL_GetMessage (void);
 void CL_Seek_f (void);
+void CL_Follow_f (void);
 
 void CL_Stop_f (void);
 void CL_Record_f (void);
 void CL_PlayDemo_f (void);
 void CL_TimeDemo_f (void);
+void CL_CaptureDemo_f (void);
+void CL_StopCapture (void);
+double CL_CaptureFrameTime (void);
+void CL_CaptureVideoFrame (const byte *data, int width, int height);
+void CL_CaptureAudio (const short *samples, int count, int channels, int rate);
+void CL_CaptureFrameAudio (void);
 void CL_Resume_Record (qboolean recordsignons);
+void CL_DemoAnalyze (int worker, int numworkers);
 
 //
 // cl_parse.c
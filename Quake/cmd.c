@@ -71,6 +71,9 @@ void Cmd_Wait_f (void)
 
 sizebuf_t cmd_text;
 
+// the threaded server may localcmd while the client adds stufftext
+static SDL_mutex *cmd_text_mutex;
+
 /*
 ============
 Cbuf_Init
@@ -80,6 +83,7 @@ void Cbuf_Init (void)
 {
 	SZ_Alloc (&cmd_text, 1 << 18); // space for commands and script files. spike -- was 8192, but modern configs can be _HUGE_, at least if they contain lots of
 	                               // comments/docs for things.
+	cmd_text_mutex = SDL_CreateMutex ();
 }
 
 /*
@@ -91,27 +95,20 @@ Adds command text at the end of the buffer
 */
 void Cbuf_AddText (const char *text)
 {
-	int l;
-
-	l = strlen (text);
-
-	if (cmd_text.cursize + l >= cmd_text.maxsize)
-	{
-		Con_Printf ("Cbuf_AddText: overflow\n");
-		return;
-	}
-
-	SZ_Write (&cmd_text, text, l);
+	Cbuf_AddTextLen (text, strlen (text));
 }
 void Cbuf_AddTextLen (const char *text, int l)
 {
+	SDL_LockMutex (cmd_text_mutex);
 	if (cmd_text.cursize + l >= cmd_text.maxsize)
 	{
+		SDL_UnlockMutex (cmd_text_mutex);
 		Con_Printf ("Cbuf_AddText: overflow\n");
 		return;
 	}
 
 	SZ_Write (&cmd_text, text, l);
+	SDL_UnlockMutex (cmd_text_mutex);
 }
 
 /*
@@ -128,6 +125,8 @@ void Cbuf_InsertText (const char *text)
 	char *temp;
 	int   templen;
 
+	SDL_LockMutex (cmd_text_mutex);
+
 	// copy off any commands still remaining in the exec buffer
 	templen = cmd_text.cursize;
 	if (templen)
@@ -148,6 +147,8 @@ void Cbuf_InsertText (const char *text)
 		SZ_Write (&cmd_text, temp, templen);
 		Mem_Free (temp);
 	}
+
+	SDL_UnlockMutex (cmd_text_mutex);
 }
 
 // Spike: for renderer/server isolation
@@ -170,6 +171,7 @@ void Cbuf_Execute (void)
 	char  line[1024];
 	int   quotes, comment;
 
+	SDL_LockMutex (cmd_text_mutex);
 	while (cmd_text.cursize && !cmd_wait)
 	{
 		// find a \n or ; line break
@@ -214,8 +216,11 @@ void Cbuf_Execute (void)
 		}
 
 		// execute the command line
+		SDL_UnlockMutex (cmd_text_mutex);
 		Cmd_ExecuteString (line, src_command);
+		SDL_LockMutex (cmd_text_mutex);
 	}
+	SDL_UnlockMutex (cmd_text_mutex);
 }
 
 /*
@@ -490,12 +495,13 @@ void Cmd_Unaliasall_f (void)
 
 #define MAX_ARGS 80
 
-static int         cmd_argc;
-static char        cmd_argv[MAX_ARGS][1024];
-static char        cmd_null_string[] = "";
-static const char *cmd_args = NULL;
+// per thread so the threaded server can run client commands while the client parses stufftext
+static THREAD_LOCAL int         cmd_argc;
+static THREAD_LOCAL char        cmd_argv[MAX_ARGS][1024];
+static char                     cmd_null_string[] = "";
+static THREAD_LOCAL const char *cmd_args = NULL;
 
-cmd_source_t cmd_source;
+THREAD_LOCAL cmd_source_t cmd_source;
 
 // johnfitz -- better tab completion
 // static	cmd_function_t	*cmd_functions;		// possible commands to execute
@@ -85,7 +85,7 @@ typedef enum
 	src_command, // from the command buffer
 	src_server   // from a svc_stufftext
 } cmd_source_t;
-extern cmd_source_t cmd_source;
+extern THREAD_LOCAL cmd_source_t cmd_source;
 
 typedef void (*xcommand_t) (void);
 typedef struct cmd_function_s
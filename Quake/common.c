@@ -703,8 +703,8 @@ void MSG_WriteEntity (sizebuf_t *sb, unsigned int entnum, unsigned int pext2)
 //
 // reading functions
 //
-int      msg_readcount;
-qboolean msg_badread;
+THREAD_LOCAL int      msg_readcount;
+THREAD_LOCAL qboolean msg_badread;
 
 void MSG_BeginReading (void)
 {
@@ -1434,7 +1434,8 @@ QUAKE FILESYSTEM
 =============================================================================
 */
 
-THREAD_LOCAL int com_filesize;
+THREAD_LOCAL int      com_filesize;
+THREAD_LOCAL uint64_t com_filestamp;
 
 //
 // on-disk pakfile
@@ -1548,12 +1549,39 @@ long COM_filelength (FILE *f)
 	return end;
 }
 
+/*
+===========
+COM_FileStamp
+
+Combines the location, size and modification time of a file so that
+callers can tell whether a file changed without reading it
+===========
+*/
+static uint64_t COM_FileStamp (const char *path, int filepos, int filelen, int mtime)
+{
+	struct
+	{
+		uint64_t path_hash;
+		int32_t  filepos;
+		int32_t  filelen;
+		int32_t  mtime;
+		int32_t  pad;
+	} stamp;
+
+	memset (&stamp, 0, sizeof (stamp));
+	stamp.path_hash = COM_HashBlock64 (path, strlen (path));
+	stamp.filepos = filepos;
+	stamp.filelen = filelen;
+	stamp.mtime = mtime;
+	return COM_HashBlock64 (&stamp, sizeof (stamp));
+}
+
 /*
 ===========
 COM_FindFile
 
 Finds the file in the search path.
-Sets com_filesize and one of handle or file
+Sets com_filesize, com_filestamp and one of handle or file
 If neither of file or handle is set, this
 can be used for detecting a file's presence.
 ===========
@@ -1584,6 +1612,7 @@ static int COM_FindFile (const char *filename, int *handle, FILE **file, unsigne
 					continue;
 				// found it!
 				com_filesize = pak->files[i].filelen;
+				com_filestamp = COM_FileStamp (pak->filename, pak->files[i].filepos, com_filesize, pak->mtime);
 				file_from_pak = 1;
 				if (path_id)
 					*path_id = search->path_id;
@@ -1624,6 +1653,7 @@ static int COM_FindFile (const char *filename, int *handle, FILE **file, unsigne
 			if (handle)
 			{
 				com_filesize = Sys_FileOpenRead (netpath, &i);
+				com_filestamp = COM_FileStamp (netpath, 0, com_filesize, findtime);
 				*handle = i;
 				return com_filesize;
 			}
@@ -1631,6 +1661,7 @@ static int COM_FindFile (const char *filename, int *handle, FILE **file, unsigne
 			{
 				*file = fopen (netpath, "rb");
 				com_filesize = (*file == NULL) ? -1 : COM_filelength (*file);
+				com_filestamp = COM_FileStamp (netpath, 0, com_filesize, findtime);
 				return com_filesize;
 			}
 			else
@@ -1652,6 +1683,7 @@ static int COM_FindFile (const char *filename, int *handle, FILE **file, unsigne
 	if (file)
 		*file = NULL;
 	com_filesize = -1;
+	com_filestamp = 0;
 	return com_filesize;
 }
 
@@ -1886,6 +1918,7 @@ static pack_t *COM_LoadPackFile (const char *packfile, int packhandle)
 	q_strlcpy (pack->filename, packfile, sizeof (pack->filename));
 	pack->handle = packhandle;
 	pack->numfiles = numpackfiles;
+	pack->mtime = Sys_FileTime (packfile);
 	pack->files = newfiles;
 
 	// Sys_Printf ("Added packfile %s (%i files)\n", packfile, numpackfiles);
@@ -2548,6 +2581,42 @@ unsigned COM_HashString (const char *str)
 	return hash;
 }
 
+/*
+================
+COM_HashBlock
+Computes the FNV-1a hash of a block of memory
+================
+*/
+unsigned COM_HashBlock (const void *data, size_t size)
+{
+	const byte *bytes = (const byte *)data;
+	unsigned    hash = 0x811c9dc5u;
+	while (size--)
+	{
+		hash ^= *bytes++;
+		hash *= 0x01000193u;
+	}
+	return hash;
+}
+
+/*
+================
+COM_HashBlock64
+Computes the 64-bit FNV-1a hash of a block of memory
+================
+*/
+uint64_t COM_HashBlock64 (const void *data, size_t size)
+{
+	const byte *bytes = (const byte *)data;
+	uint64_t    hash = 0xcbf29ce484222325ull;
+	while (size--)
+	{
+		hash ^= *bytes++;
+		hash *= 0x00000100000001b3ull;
+	}
+	return hash;
+}
+
 static size_t mz_zip_file_read_func (void *opaque, mz_uint64 ofs, void *buf, size_t n)
 {
 	if (SDL_RWseek ((SDL_RWops *)opaque, (Sint64)ofs, RW_SEEK_SET) < 0)
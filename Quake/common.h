@@ -145,8 +145,8 @@ void MSG_WriteStaticOrBaseLine (
 	sizebuf_t *buf, int idx, struct entity_state_s *state, unsigned int protocol_pext2, unsigned int protocol,
 	unsigned int protocolflags); // spike
 
-extern int      msg_readcount;
-extern qboolean msg_badread; // set if a read goes beyond end of message
+extern THREAD_LOCAL int      msg_readcount;
+extern THREAD_LOCAL qboolean msg_badread; // set if a read goes beyond end of message
 
 void        MSG_BeginReading (void);
 int         MSG_ReadChar (void);
@@ -231,6 +231,8 @@ char *va (const char *format, ...) FUNC_PRINTF (1, 2);
 // does a varargs printf into a temp buffer
 
 unsigned COM_HashString (const char *str);
+unsigned COM_HashBlock (const void *data, size_t size);
+uint64_t COM_HashBlock64 (const void *data, size_t size);
 
 // localization support for 2021 rerelease version:
 void        LOC_Init (void);
@@ -254,6 +256,7 @@ typedef struct pack_s
 	char        filename[MAX_OSPATH];
 	int         handle;
 	int         numfiles;
+	int         mtime;
 	packfile_t *files;
 } pack_t;
 
@@ -270,7 +273,8 @@ typedef struct searchpath_s
 extern searchpath_t *com_searchpaths;
 extern searchpath_t *com_base_searchpaths;
 
-extern THREAD_LOCAL int com_filesize;
+extern THREAD_LOCAL int      com_filesize;
+extern THREAD_LOCAL uint64_t com_filestamp; // identifies where the last file found was and which version of it
 struct cache_user_s;
 
 extern char             com_basedir[MAX_OSPATH];
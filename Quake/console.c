@@ -513,7 +513,7 @@ void Con_Printf (const char *fmt, ...)
 	Con_Print (msg);
 
 	// update the screen if the console is displayed
-	if (cls.signon != SIGNONS && !scr_disabled_for_loading && !Tasks_IsWorker ())
+	if (cls.signon != SIGNONS && !scr_disabled_for_loading && !Tasks_IsWorker () && !Host_IsServerThread ())
 	{
 		// protect against infinite loop if something in SCR_UpdateScreen calls
 		// Con_Printd
@@ -27,13 +27,47 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "quakedef.h"
 
 static void      Mod_LoadSpriteModel (qmodel_t *mod, void *buffer);
-static void      Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffer);
+static void      Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffer, int filesize);
 static void      Mod_LoadAliasModel (qmodel_t *mod, void *buffer);
 static qmodel_t *Mod_LoadModel (qmodel_t *mod, qboolean crash);
 
 cvar_t external_ents = {"external_ents", "1", CVAR_ARCHIVE};
 cvar_t external_vis = {"external_vis", "1", CVAR_ARCHIVE};
 
+static cvar_t mod_bspcache = {"mod_bspcache", "1", CVAR_ARCHIVE};
+
+// Processed brush model cache, only the results that take a pass over the
+// geometry or the PVS. Nodes, hull 0 and the SIMD arrays are pointer or
+// lane fixups as cheap as reading them back, and the surface polys depend on
+// the lightmap packing of every model the renderer builds at once.
+#define BSPCACHE_DIR     "bspcache"
+#define BSPCACHE_MAGIC   "VKBC"
+#define BSPCACHE_VERSION 2
+
+typedef struct
+{
+	char     magic[4];
+	uint32_t version;
+	uint64_t data_hash; // whole bsp file
+	uint32_t data_size;
+	int32_t  bspversion;
+	uint32_t contentstransparent;
+	uint32_t numsurfaces;
+	uint32_t surfaces_ofs; // from the start of the file
+} bspcache_header_t;
+
+typedef struct
+{
+	short texturemins[2];
+	short extents[2];
+} bspcache_surface_t;
+
+typedef struct
+{
+	bspcache_header_t        *header;
+	const bspcache_surface_t *surfaces;
+} bspcache_t;
+
 static byte *mod_novis;
 static int   mod_novis_capacity;
 
@@ -94,6 +128,8 @@ void Mod_Init (void)
 {
 	Cvar_RegisterVariable (&external_vis);
 	Cvar_RegisterVariable (&external_ents);
+	Cvar_RegisterVariable (&mod_bspcache);
+	Sys_mkdir (va ("%s/" BSPCACHE_DIR, host_parms->userdir));
 
 	// johnfitz -- create notexture miptex
 	r_notexture_mip = (texture_t *)Mem_Alloc (sizeof (texture_t));
@@ -476,7 +512,7 @@ static qmodel_t *Mod_LoadModel (qmodel_t *mod, qboolean crash)
 		break;
 
 	default:
-		Mod_LoadBrushModel (mod, loadname, buf);
+		Mod_LoadBrushModel (mod, loadname, buf, com_filesize);
 		break;
 	}
 
@@ -542,6 +578,19 @@ qboolean Mod_CheckAnimTextureArrayQ64 (texture_t *anims[], int numTex)
 	return true;
 }
 
+/*
+=================
+Mod_LoadExternalTexture -- tries name.dds/.ktx2 before name.tga/.pcx
+=================
+*/
+static gltexture_t *Mod_LoadExternalTexture (qmodel_t *mod, const char *filename, unsigned flags)
+{
+	gltexture_t *glt = TexMgr_LoadCompressedImage (mod, filename, flags);
+	if (!glt)
+		glt = TexMgr_LoadImageFile (mod, filename, flags);
+	return glt;
+}
+
 /*
 =================
 Mod_LoadTextureTask
@@ -554,11 +603,9 @@ static void Mod_LoadTextureTask (int i, qmodel_t **ppmod)
 	if (!tx)
 		return;
 
-	int   pixels = tx->width * tx->height / 64 * 85;
-	char  texturename[64];
-	int   fwidth, fheight;
-	char  filename[MAX_OSPATH], mapname[MAX_OSPATH];
-	byte *data = NULL;
+	int  pixels = tx->width * tx->height / 64 * 85;
+	char texturename[64];
+	char filename[MAX_OSPATH], mapname[MAX_OSPATH];
 
 	if (!q_strncasecmp (tx->name, "sky", 3)) // sky texture //also note -- was strncmp, changed to match qbsp
 	{
@@ -572,19 +619,16 @@ static void Mod_LoadTextureTask (int i, qmodel_t **ppmod)
 		// external textures -- first look in "textures/mapname/" then look in "textures/"
 		COM_StripExtension (mod->name + 5, mapname, sizeof (mapname));
 		q_snprintf (filename, sizeof (filename), "textures/%s/#%s", mapname, tx->name + 1); // this also replaces the '*' with a '#'
-		data = Image_LoadImage (filename, &fwidth, &fheight);
-		if (!data)
+		tx->gltexture = Mod_LoadExternalTexture (mod, filename, TEXPREF_NONE);
+		if (!tx->gltexture)
 		{
 			q_snprintf (filename, sizeof (filename), "textures/#%s", tx->name + 1);
-			data = Image_LoadImage (filename, &fwidth, &fheight);
+			tx->gltexture = Mod_LoadExternalTexture (mod, filename, TEXPREF_NONE);
 		}
 
 		// now load whatever we found
-		if (data) // load external image
-		{
+		if (tx->gltexture) // external image
 			q_strlcpy (texturename, filename, sizeof (texturename));
-			tx->gltexture = TexMgr_LoadImage (mod, texturename, fwidth, fheight, SRC_RGBA, data, filename, 0, TEXPREF_NONE);
-		}
 		else // use the texture from the bsp file
 		{
 			q_snprintf (texturename, sizeof (texturename), "%s:%s", mod->name, tx->name);
@@ -610,32 +654,26 @@ static void Mod_LoadTextureTask (int i, qmodel_t **ppmod)
 		// external textures -- first look in "textures/mapname/" then look in "textures/"
 		COM_StripExtension (mod->name + 5, mapname, sizeof (mapname));
 		q_snprintf (filename, sizeof (filename), "textures/%s/%s", mapname, tx->name);
-		data = Image_LoadImage (filename, &fwidth, &fheight);
-		if (!data)
+		tx->gltexture = Mod_LoadExternalTexture (mod, filename, TEXPREF_MIPMAP | extraflags);
+		if (!tx->gltexture)
 		{
 			q_snprintf (filename, sizeof (filename), "textures/%s", tx->name);
-			data = Image_LoadImage (filename, &fwidth, &fheight);
+			tx->gltexture = Mod_LoadExternalTexture (mod, filename, TEXPREF_MIPMAP | extraflags);
 		}
 
 		// now load whatever we found
-		if (data) // load external image
+		if (tx->gltexture) // external image
 		{
 			char filename2[MAX_OSPATH];
 
-			tx->gltexture = TexMgr_LoadImage (mod, filename, fwidth, fheight, SRC_RGBA, data, filename, 0, TEXPREF_MIPMAP | extraflags);
-			Mem_Free (data);
-
 			// now try to load glow/luma image from the same place
 			q_snprintf (filename2, sizeof (filename2), "%s_glow", filename);
-			data = Image_LoadImage (filename2, &fwidth, &fheight);
-			if (!data)
+			tx->fullbright = Mod_LoadExternalTexture (mod, filename2, TEXPREF_MIPMAP | extraflags);
+			if (!tx->fullbright)
 			{
 				q_snprintf (filename2, sizeof (filename2), "%s_luma", filename);
-				data = Image_LoadImage (filename2, &fwidth, &fheight);
+				tx->fullbright = Mod_LoadExternalTexture (mod, filename2, TEXPREF_MIPMAP | extraflags);
 			}
-
-			if (data)
-				tx->fullbright = TexMgr_LoadImage (mod, filename2, fwidth, fheight, SRC_RGBA, data, filename2, 0, TEXPREF_MIPMAP | extraflags);
 		}
 		else // use the texture from the bsp file
 		{
@@ -657,7 +695,6 @@ static void Mod_LoadTextureTask (int i, qmodel_t **ppmod)
 			}
 		}
 	}
-	Mem_Free (data);
 }
 
 /*
@@ -867,14 +904,15 @@ static void Mod_LoadTextures (qmodel_t *mod, byte *mod_base, lump_t *l)
 
 /*
 =================
-Mod_LoadLighting -- johnfitz -- replaced with lit support code via lordhavoc
+Mod_LoadExternalLighting -- johnfitz -- replaced with lit support code via lordhavoc
+
+Reads through the shared pak file handles, so it has to run on the thread loading the model
 =================
 */
-static void Mod_LoadLighting (qmodel_t *mod, byte *mod_base, lump_t *l)
+static qboolean Mod_LoadExternalLighting (qmodel_t *mod, lump_t *l)
 {
 	int          i;
-	byte        *in, *out, *data;
-	byte         d, q64_b0, q64_b1;
+	byte        *data;
 	char         litfilename[MAX_OSPATH];
 	unsigned int path_id;
 
@@ -903,7 +941,7 @@ static void Mod_LoadLighting (qmodel_t *mod, byte *mod_base, lump_t *l)
 					mod->lightdata = (byte *)Mem_Alloc (l->filelen * 3);
 					memcpy (mod->lightdata, data + 8, (l->filelen * 3) - 8);
 					Mem_Free (data);
-					return;
+					return true;
 				}
 				Con_Printf ("Outdated .lit file (%s should be %u bytes, not %u)\n", litfilename, 8 + l->filelen * 3, com_filesize);
 			}
@@ -919,7 +957,20 @@ static void Mod_LoadLighting (qmodel_t *mod, byte *mod_base, lump_t *l)
 
 		Mem_Free (data);
 	}
-	// LordHavoc: no .lit found, expand the white lighting data to color
+	return false;
+}
+
+/*
+=================
+Mod_LoadLighting -- LordHavoc: no .lit found, expand the white lighting data to color
+=================
+*/
+static void Mod_LoadLighting (qmodel_t *mod, byte *mod_base, lump_t *l)
+{
+	int   i;
+	byte *in, *out;
+	byte  d, q64_b0, q64_b1;
+
 	if (!l->filelen)
 		return;
 
@@ -977,10 +1028,12 @@ static void Mod_LoadVisibility (qmodel_t *mod, byte *mod_base, lump_t *l)
 
 /*
 =================
-Mod_LoadEntities
+Mod_LoadExternalEntities
+
+Reads through the shared pak file handles, so it has to run on the thread loading the model
 =================
 */
-static void Mod_LoadEntities (qmodel_t *mod, byte *mod_base, lump_t *l)
+static qboolean Mod_LoadExternalEntities (qmodel_t *mod, byte *mod_base, lump_t *l)
 {
 	char         basemapname[MAX_QPATH];
 	char         entfilename[MAX_QPATH];
@@ -990,7 +1043,7 @@ static void Mod_LoadEntities (qmodel_t *mod, byte *mod_base, lump_t *l)
 	qboolean     versioned = true;
 
 	if (!external_ents.value)
-		goto _load_embedded;
+		return false;
 
 	if (l->filelen > 0)
 	{
@@ -1025,11 +1078,21 @@ static void Mod_LoadEntities (qmodel_t *mod, byte *mod_base, lump_t *l)
 		{
 			mod->entities = ents;
 			Con_DPrintf ("Loaded external entity file %s\n", entfilename);
-			return;
+			return true;
 		}
 	}
 
-_load_embedded:
+	Mem_Free (ents);
+	return false;
+}
+
+/*
+=================
+Mod_LoadEntities
+=================
+*/
+static void Mod_LoadEntities (qmodel_t *mod, byte *mod_base, lump_t *l)
+{
 	if (!l->filelen)
 	{
 		Mem_Free (mod->entities);
@@ -1038,7 +1101,6 @@ _load_embedded:
 	}
 	mod->entities = (char *)Mem_Alloc (l->filelen);
 	memcpy (mod->entities, mod_base + l->fileofs, l->filelen);
-	Mem_Free (ents);
 }
 
 /*
@@ -1242,6 +1304,23 @@ static void CalcSurfaceExtents (qmodel_t *mod, msurface_t *s)
 	}
 }
 
+/*
+================
+Mod_CachedExtentsValid -- same limits as CalcSurfaceExtents, anything else is recomputed
+================
+*/
+static qboolean Mod_CachedExtentsValid (msurface_t *s, const bspcache_surface_t *cached)
+{
+	for (int i = 0; i < 2; i++)
+	{
+		if ((cached->texturemins[i] % 16) || (cached->extents[i] < 0) || (cached->extents[i] % 16))
+			return false;
+		if (!(s->texinfo->flags & TEX_SPECIAL) && cached->extents[i] > 2000)
+			return false;
+	}
+	return true;
+}
+
 /*
 ================
 Mod_PolyForUnlitSurface -- johnfitz -- creates polys for unlightmapped surfaces (sky and water)
@@ -1296,7 +1375,7 @@ static void Mod_PolyForUnlitSurface (qmodel_t *mod, msurface_t *fa)
 Mod_LoadFaces
 =================
 */
-static void Mod_LoadFaces (qmodel_t *mod, byte *mod_base, lump_t *l, qboolean bsp2)
+static void Mod_LoadFaces (qmodel_t *mod, byte *mod_base, lump_t *l, qboolean bsp2, const bspcache_surface_t *cached_surfaces)
 {
 	byte       *ins;
 	byte       *inl;
@@ -1386,7 +1465,16 @@ static void Mod_LoadFaces (qmodel_t *mod, byte *mod_base, lump_t *l, qboolean bs
 
 		out->texinfo = mod->texinfo + texinfon;
 
-		CalcSurfaceExtents (mod, out);
+		if (cached_surfaces && Mod_CachedExtentsValid (out, &cached_surfaces[surfnum]))
+		{
+			const bspcache_surface_t *cached = &cached_surfaces[surfnum];
+			out->texturemins[0] = cached->texturemins[0];
+			out->texturemins[1] = cached->texturemins[1];
+			out->extents[0] = cached->extents[0];
+			out->extents[1] = cached->extents[1];
+		}
+		else
+			CalcSurfaceExtents (mod, out);
 
 		// lighting info
 		if (mod->bspversion == BSPVERSION_QUAKE64)
@@ -2430,16 +2518,221 @@ static void Mod_SetupSubmodels (qmodel_t *mod)
 	}
 }
 
+/*
+=================
+Mod_BSPCachePath
+=================
+*/
+static const char *Mod_BSPCachePath (const char *loadname, uint64_t data_hash, char *path, size_t size)
+{
+	q_snprintf (path, size, "%s/" BSPCACHE_DIR "/%s_%016" SDL_PRIx64 ".bspc", host_parms->userdir, loadname, data_hash);
+	return path;
+}
+
+/*
+=================
+Mod_LoadBSPCache -- returns false on a cache miss
+
+The whole file is read into one allocation and the surface array is used in
+place, so the cache holds offsets instead of pointers.
+=================
+*/
+static qboolean Mod_LoadBSPCache (qmodel_t *mod, const char *loadname, uint64_t data_hash, int data_size, lump_t *faces, qboolean bsp2, bspcache_t *cache)
+{
+	char  path[MAX_OSPATH];
+	FILE *f;
+	long  file_size;
+
+	memset (cache, 0, sizeof (*cache));
+	if (mod_bspcache.value == 0.0f)
+		return false;
+	const uint32_t numfaces = faces->filelen / (bsp2 ? sizeof (dlface_t) : sizeof (dsface_t));
+
+	f = fopen (Mod_BSPCachePath (loadname, data_hash, path, sizeof (path)), "rb");
+	if (!f)
+		return false;
+	fseek (f, 0, SEEK_END);
+	file_size = ftell (f);
+	fseek (f, 0, SEEK_SET);
+	if (file_size < (long)sizeof (bspcache_header_t))
+	{
+		fclose (f);
+		return false;
+	}
+
+	byte *data = (byte *)Mem_Alloc (file_size);
+	qboolean ok = fread (data, file_size, 1, f) == 1;
+	fclose (f);
+
+	bspcache_header_t *header = (bspcache_header_t *)data;
+	ok = ok && !memcmp (header->magic, BSPCACHE_MAGIC, 4) && (header->version == BSPCACHE_VERSION) && (header->data_hash == data_hash) &&
+		 (header->data_size == (uint32_t)data_size) && (header->bspversion == mod->bspversion) && (header->numsurfaces == numfaces) &&
+		 (header->surfaces_ofs >= sizeof (bspcache_header_t)) && (header->surfaces_ofs % sizeof (short) == 0) &&
+		 ((uint64_t)header->surfaces_ofs + ((uint64_t)header->numsurfaces * sizeof (bspcache_surface_t)) == (uint64_t)file_size);
+	if (!ok)
+	{
+		Mem_Free (data);
+		return false;
+	}
+
+	cache->header = header;
+	cache->surfaces = (const bspcache_surface_t *)(data + header->surfaces_ofs);
+	return true;
+}
+
+/*
+=================
+Mod_StoreBSPCache
+=================
+*/
+static void Mod_StoreBSPCache (qmodel_t *mod, const char *loadname, uint64_t data_hash, int data_size)
+{
+	bspcache_header_t header;
+	char              path[MAX_OSPATH];
+	char              temppath[MAX_OSPATH];
+	FILE             *f;
+	int               i;
+
+	memset (&header, 0, sizeof (header));
+	memcpy (header.magic, BSPCACHE_MAGIC, 4);
+	header.version = BSPCACHE_VERSION;
+	header.data_hash = data_hash;
+	header.data_size = data_size;
+	header.bspversion = mod->bspversion;
+	header.contentstransparent = mod->contentstransparent;
+	header.numsurfaces = mod->numsurfaces;
+	header.surfaces_ofs = sizeof (header);
+
+	bspcache_surface_t *surfaces = (bspcache_surface_t *)Mem_Alloc (mod->numsurfaces * sizeof (bspcache_surface_t));
+	for (i = 0; i < mod->numsurfaces; i++)
+	{
+		surfaces[i].texturemins[0] = mod->surfaces[i].texturemins[0];
+		surfaces[i].texturemins[1] = mod->surfaces[i].texturemins[1];
+		surfaces[i].extents[0] = mod->surfaces[i].extents[0];
+		surfaces[i].extents[1] = mod->surfaces[i].extents[1];
+	}
+
+	Mod_BSPCachePath (loadname, data_hash, path, sizeof (path));
+	q_snprintf (temppath, sizeof (temppath), "%s.tmp", path);
+	f = fopen (temppath, "wb");
+	if (f)
+	{
+		qboolean ok = fwrite (&header, sizeof (header), 1, f) == 1 &&
+					  ((mod->numsurfaces == 0) || fwrite (surfaces, mod->numsurfaces * sizeof (bspcache_surface_t), 1, f) == 1);
+		ok = (fclose (f) == 0) && ok;
+		remove (path);
+		if (!ok || rename (temppath, path) != 0)
+			remove (temppath);
+	}
+	Mem_Free (surfaces);
+}
+
+/*
+===============================================================================
+
+LUMP LOADING TASKS
+
+Lump loaders that only report errors with Sys_Error run as tasks. Anything
+that can Host_Error stays on the calling thread, since that longjmps, and
+only runs once every task has finished. External .lit and .ent files are
+looked up on the calling thread too, because COM_LoadFile reads through the
+pak file handle shared by all threads.
+
+===============================================================================
+*/
+
+typedef struct
+{
+	qmodel_t                 *mod;
+	dheader_t                *header;
+	const bspcache_surface_t *cached_surfaces;
+	int                       lump;
+	int                       bsp2;
+} lump_task_args_t;
+
+typedef void (*lump_task_func_t) (lump_task_args_t *);
+
+#define LUMP_TASK_ARGS(args) (args)->mod, (byte *)(args)->header, &(args)->header->lumps[(args)->lump]
+
+static void Mod_LoadVertexesTask (lump_task_args_t *args)
+{
+	Mod_LoadVertexes (LUMP_TASK_ARGS (args));
+}
+
+static void Mod_LoadEdgesTask (lump_task_args_t *args)
+{
+	Mod_LoadEdges (LUMP_TASK_ARGS (args), args->bsp2);
+}
+
+static void Mod_LoadSurfedgesTask (lump_task_args_t *args)
+{
+	Mod_LoadSurfedges (LUMP_TASK_ARGS (args));
+}
+
+static void Mod_LoadLightingTask (lump_task_args_t *args)
+{
+	Mod_LoadLighting (LUMP_TASK_ARGS (args));
+}
+
+static void Mod_LoadPlanesTask (lump_task_args_t *args)
+{
+	Mod_LoadPlanes (LUMP_TASK_ARGS (args));
+}
+
+static void Mod_LoadTexinfoTask (lump_task_args_t *args)
+{
+	Mod_LoadTexinfo (LUMP_TASK_ARGS (args));
+}
+
+static void Mod_LoadFacesTask (lump_task_args_t *args)
+{
+	Mod_LoadFaces (LUMP_TASK_ARGS (args), args->bsp2, args->cached_surfaces);
+}
+
+static void Mod_LoadEntitiesTask (lump_task_args_t *args)
+{
+	Mod_LoadEntities (LUMP_TASK_ARGS (args));
+}
+
+static void Mod_LoadSubmodelsTask (lump_task_args_t *args)
+{
+	Mod_LoadSubmodels (LUMP_TASK_ARGS (args));
+}
+
+/*
+=================
+Mod_LumpTask -- runs the loader right away when not submitting tasks, in which case the call order has to respect dependencies
+=================
+*/
+static task_handle_t Mod_LumpTask (
+	qboolean parallel, lump_task_func_t func, lump_task_args_t *args, int lump, int num_dependencies, const task_handle_t *dependencies)
+{
+	args->lump = lump;
+	if (!parallel)
+	{
+		func (args);
+		return 0;
+	}
+
+	task_handle_t task = Task_AllocateAndAssignFunc ((task_func_t)func, args, sizeof (lump_task_args_t));
+	for (int i = 0; i < num_dependencies; ++i)
+		Task_AddDependency (dependencies[i], task);
+	Task_Submit (task);
+	return task;
+}
+
 /*
 =================
 Mod_LoadBrushModel
 =================
 */
-static void Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffer)
+static void Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffer, int filesize)
 {
 	int        i;
 	int        bsp2;
 	dheader_t *header;
+	qboolean   external_vis_loaded = false;
+	bspcache_t cache;
 
 	mod->type = mod_brush;
 
@@ -2466,6 +2759,9 @@ static void Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffe
 		break;
 	}
 
+	// key the processed model cache on the file as it is on disk
+	const uint64_t data_hash = (mod_bspcache.value != 0.0f) ? COM_HashBlock64 (buffer, filesize) : 0;
+
 	// swap all the lumps
 	byte *mod_base = (byte *)header;
 
@@ -2474,14 +2770,42 @@ static void Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffe
 
 	// load into heap
 
-	Mod_LoadVertexes (mod, mod_base, &header->lumps[LUMP_VERTEXES]);
-	Mod_LoadEdges (mod, mod_base, &header->lumps[LUMP_EDGES], bsp2);
-	Mod_LoadSurfedges (mod, mod_base, &header->lumps[LUMP_SURFEDGES]);
+	const double     load_start = Sys_DoubleTime ();
+	const qboolean   parallel = !Tasks_IsWorker ();
+	lump_task_args_t args = {mod, header, NULL, 0, bsp2};
+
+	// independent lumps go first, the texture loader below submits its own tasks and waits for them
+	const task_handle_t vertexes = Mod_LumpTask (parallel, Mod_LoadVertexesTask, &args, LUMP_VERTEXES, 0, NULL);
+	const task_handle_t edges = Mod_LumpTask (parallel, Mod_LoadEdgesTask, &args, LUMP_EDGES, 0, NULL);
+	const task_handle_t surfedges = Mod_LumpTask (parallel, Mod_LoadSurfedgesTask, &args, LUMP_SURFEDGES, 0, NULL);
+	const task_handle_t planes = Mod_LumpTask (parallel, Mod_LoadPlanesTask, &args, LUMP_PLANES, 0, NULL);
+	const task_handle_t submodels = Mod_LumpTask (parallel, Mod_LoadSubmodelsTask, &args, LUMP_MODELS, 0, NULL);
+	task_handle_t       lighting = INVALID_TASK_HANDLE;
+	task_handle_t       entities = INVALID_TASK_HANDLE;
+	if (!Mod_LoadExternalLighting (mod, &header->lumps[LUMP_LIGHTING]))
+		lighting = Mod_LumpTask (parallel, Mod_LoadLightingTask, &args, LUMP_LIGHTING, 0, NULL);
+	if (!Mod_LoadExternalEntities (mod, mod_base, &header->lumps[LUMP_ENTITIES]))
+		entities = Mod_LumpTask (parallel, Mod_LoadEntitiesTask, &args, LUMP_ENTITIES, 0, NULL);
+
+	Mod_LoadBSPCache (mod, loadname, data_hash, filesize, &header->lumps[LUMP_FACES], bsp2, &cache);
 	Mod_LoadTextures (mod, mod_base, &header->lumps[LUMP_TEXTURES]);
-	Mod_LoadLighting (mod, mod_base, &header->lumps[LUMP_LIGHTING]);
-	Mod_LoadPlanes (mod, mod_base, &header->lumps[LUMP_PLANES]);
-	Mod_LoadTexinfo (mod, mod_base, &header->lumps[LUMP_TEXINFO]);
-	Mod_LoadFaces (mod, mod_base, &header->lumps[LUMP_FACES], bsp2);
+
+	// faces need texinfo, edges, planes and the lighting data
+	args.cached_surfaces = cache.surfaces;
+	const task_handle_t texinfo = Mod_LumpTask (parallel, Mod_LoadTexinfoTask, &args, LUMP_TEXINFO, 0, NULL);
+	const task_handle_t face_dependencies[] = {vertexes, edges, surfedges, planes, texinfo, lighting};
+	const task_handle_t faces = Mod_LumpTask (
+		parallel, Mod_LoadFacesTask, &args, LUMP_FACES, countof (face_dependencies) - ((lighting == INVALID_TASK_HANDLE) ? 1 : 0), face_dependencies);
+
+	// everything from here on can Host_Error, which must not leave tasks running on the model
+	if (parallel)
+	{
+		const task_handle_t outstanding[] = {faces, submodels, entities};
+		for (i = 0; i < countof (outstanding); ++i)
+			if (outstanding[i] != INVALID_TASK_HANDLE)
+				Task_Join (outstanding[i], SDL_MUTEX_MAXWAIT);
+	}
+	Mod_LoadClipnodes (mod, mod_base, &header->lumps[LUMP_CLIPNODES], bsp2);
 	Mod_LoadMarksurfaces (mod, mod_base, &header->lumps[LUMP_MARKSURFACES], bsp2);
 
 	if (mod->bspversion == BSPVERSION && external_vis.value && sv.modelname[0] && !q_strcasecmp (loadname, sv.name))
@@ -2502,6 +2826,7 @@ static void Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffe
 			fclose (fvis);
 			if (mod->visdata && mod->leafs && mod->numleafs)
 			{
+				external_vis_loaded = true;
 				goto visdone;
 			}
 			Con_DPrintf ("External VIS data failed, using standard vis.\n");
@@ -2512,15 +2837,22 @@ static void Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffe
 	Mod_LoadLeafs (mod, mod_base, &header->lumps[LUMP_LEAFS], bsp2);
 visdone:
 	Mod_LoadNodes (mod, mod_base, &header->lumps[LUMP_NODES], bsp2);
-	Mod_LoadClipnodes (mod, mod_base, &header->lumps[LUMP_CLIPNODES], bsp2);
-	Mod_LoadEntities (mod, mod_base, &header->lumps[LUMP_ENTITIES]);
-	Mod_LoadSubmodels (mod, mod_base, &header->lumps[LUMP_MODELS]);
-
 	Mod_MakeHull0 (mod);
 
 	mod->numframes = 2; // regular and alternate animation
 
-	Mod_CheckWaterVis (mod);
+	// the water vis result depends on the leafs, which an external vis file replaces
+	if (cache.header && !r_novis.value && !external_vis_loaded)
+		mod->contentstransparent = cache.header->contentstransparent;
+	else
+		Mod_CheckWaterVis (mod);
+
+	if (cache.header)
+		Mem_Free (cache.header);
+	else if ((mod_bspcache.value != 0.0f) && !r_novis.value && !external_vis_loaded)
+		Mod_StoreBSPCache (mod, loadname, data_hash, filesize);
+
+	Con_DPrintf2 ("%s processed in %.1f ms\n", mod->name, (Sys_DoubleTime () - load_start) * 1000.0);
 	Mod_SetupSubmodels (mod);
 }
 
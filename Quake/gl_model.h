@@ -170,12 +170,13 @@ typedef struct msurface_s
 
 	mtexinfo_t *texinfo;
 
-	int vbo_firstvert; // index of this surface's first vert in the VBO
+	int vbo_firstvert;  // index of this surface's first vert in the VBO
+	int vbo_firstindex; // index of this surface's first triangle index in the static index buffer
 
 	// lighting info
 	int          dlightframe;
-	unsigned int dlightbits[(MAX_DLIGHTS + 31) >> 5];
-	// int is 32 bits, need an array for MAX_DLIGHTS > 32
+	unsigned int dlightbits[(MAX_CPU_DLIGHTS + 31) >> 5];
+	// int is 32 bits, need an array for MAX_CPU_DLIGHTS > 32
 
 	int      lightmaptexturenum;
 	byte     styles[MAXLIGHTMAPS];
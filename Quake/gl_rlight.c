@@ -168,7 +168,7 @@ void R_PushDlights (void)
 
 	l = cl_dlights;
 
-	for (i = 0; i < MAX_DLIGHTS; i++, l++)
+	for (i = 0; i < MAX_CPU_DLIGHTS; i++, l++)
 	{
 		if (l->die < cl.time || !l->radius)
 			continue;
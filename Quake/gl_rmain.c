@@ -35,7 +35,7 @@ int      render_scale;
 
 // johnfitz -- rendering statistics
 atomic_uint32_t rs_brushpolys, rs_aliaspolys, rs_skypolys, rs_particles, rs_fogpolys;
-atomic_uint32_t rs_dynamiclightmaps, rs_brushpasses, rs_aliaspasses;
+atomic_uint32_t rs_dynamiclightmaps, rs_brushpasses, rs_aliaspasses, rs_occlusiontests;
 
 //
 // view origin
@@ -112,6 +112,49 @@ cvar_t r_gpulightmapupdate = {"r_gpulightmapupdate", "1", CVAR_NONE};
 
 cvar_t r_tasks = {"r_tasks", "1", CVAR_NONE};
 
+cvar_t r_occlusioncull = {"r_occlusioncull", "0", CVAR_ARCHIVE};
+
+cvar_t r_aliasinstancing = {"r_aliasinstancing", "1", CVAR_ARCHIVE};
+
+#define MAX_OCCLUSION_BOXES     4096
+#define OCCLUSION_BOX_EPSILON   1.0f  // keeps boxes of entities flush with walls from being hidden by them
+#define OCCLUSION_NEAR_DISTANCE 16.0f // boxes this close to the eye may be clipped by the near plane
+
+typedef struct
+{
+	float    view_projection[16];
+	float    viewport[4];
+	uint32_t num_boxes;
+	uint32_t num_levels;
+} occlusion_constants_t;
+
+/*
+===============
+occlusion_state_t
+
+Opaque entities are tested against a Hi-Z pyramid built from the depth buffer of the previous frame.
+A compute pass before the main render pass writes one predicate per box that conditional rendering
+consumes, so nothing is read back and the results are never older than one frame.
+===============
+*/
+typedef struct
+{
+	qboolean        active;
+	int             frame_index;
+	VkBuffer        boxes_buffer;
+	vulkan_memory_t boxes_memory;
+	float          *boxes_mapped;
+	VkBuffer        visible_buffer;
+	vulkan_memory_t visible_memory;
+	VkDescriptorSet desc_sets[DOUBLE_BUFFERED];
+
+	// boxes of each frame in flight and the view of the frame the Hi-Z was built from
+	occlusion_constants_t constants[DOUBLE_BUFFERED];
+	float                 last_view_projection[16];
+	float                 last_viewport[4];
+} occlusion_state_t;
+static occlusion_state_t occlusion;
+
 /*
 =================
 R_CullBox -- johnfitz -- replaced with new function from lordhavoc
@@ -139,13 +182,12 @@ qboolean R_CullBox (vec3_t emins, vec3_t emaxs)
 }
 /*
 ===============
-R_CullModelForEntity -- johnfitz -- uses correct bounds based on rotation
+R_EntityBounds -- johnfitz -- uses correct bounds based on rotation
 ===============
 */
-qboolean R_CullModelForEntity (entity_t *e)
+void R_EntityBounds (entity_t *e, vec3_t mins, vec3_t maxs)
 {
-	vec3_t mins, maxs;
-	vec_t  scalefactor, *minbounds, *maxbounds;
+	vec_t scalefactor, *minbounds, *maxbounds;
 
 	if (e->angles[0] || e->angles[2]) // pitch or roll
 	{
@@ -174,10 +216,301 @@ qboolean R_CullModelForEntity (entity_t *e)
 		VectorAdd (e->origin, minbounds, mins);
 		VectorAdd (e->origin, maxbounds, maxs);
 	}
+}
 
+/*
+===============
+R_CullModelForEntity
+===============
+*/
+qboolean R_CullModelForEntity (entity_t *e)
+{
+	vec3_t mins, maxs;
+	R_EntityBounds (e, mins, maxs);
 	return R_CullBox (mins, maxs);
 }
 
+/*
+===============
+R_InitOcclusionCulling
+===============
+*/
+void R_InitOcclusionCulling (void)
+{
+#if defined(VK_EXT_conditional_rendering)
+	if (!vulkan_globals.conditional_rendering)
+		return;
+
+	VkResult err;
+	{
+		const size_t buffer_size = DOUBLE_BUFFERED * MAX_OCCLUSION_BOXES * 8 * sizeof (float);
+
+		VkBufferCreateInfo buffer_create_info;
+		memset (&buffer_create_info, 0, sizeof (buffer_create_info));
+		buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer_create_info.size = buffer_size;
+		buffer_create_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+		err = vkCreateBuffer (vulkan_globals.device, &buffer_create_info, NULL, &occlusion.boxes_buffer);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkCreateBuffer failed");
+		GL_SetObjectName ((uint64_t)occlusion.boxes_buffer, VK_OBJECT_TYPE_BUFFER, "Occlusion Boxes");
+
+		VkMemoryRequirements memory_requirements;
+		vkGetBufferMemoryRequirements (vulkan_globals.device, occlusion.boxes_buffer, &memory_requirements);
+
+		VkMemoryAllocateInfo memory_allocate_info;
+		memset (&memory_allocate_info, 0, sizeof (memory_allocate_info));
+		memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		memory_allocate_info.allocationSize = memory_requirements.size;
+		memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties (
+			memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+
+		Atomic_IncrementUInt32 (&num_vulkan_misc_allocations);
+		R_AllocateVulkanMemory (&occlusion.boxes_memory, &memory_allocate_info, VULKAN_MEMORY_TYPE_HOST);
+		GL_SetObjectName ((uint64_t)occlusion.boxes_memory.handle, VK_OBJECT_TYPE_DEVICE_MEMORY, "Occlusion Boxes");
+
+		err = vkBindBufferMemory (vulkan_globals.device, occlusion.boxes_buffer, occlusion.boxes_memory.handle, 0);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkBindBufferMemory failed");
+
+		err = vkMapMemory (vulkan_globals.device, occlusion.boxes_memory.handle, 0, buffer_size, 0, (void **)&occlusion.boxes_mapped);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkMapMemory failed");
+	}
+
+	{
+		VkBufferCreateInfo buffer_create_info;
+		memset (&buffer_create_info, 0, sizeof (buffer_create_info));
+		buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer_create_info.size = DOUBLE_BUFFERED * MAX_OCCLUSION_BOXES * sizeof (uint32_t);
+		buffer_create_info.usage =
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_CONDITIONAL_RENDERING_BIT_EXT;
+
+		err = vkCreateBuffer (vulkan_globals.device, &buffer_create_info, NULL, &occlusion.visible_buffer);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkCreateBuffer failed");
+		GL_SetObjectName ((uint64_t)occlusion.visible_buffer, VK_OBJECT_TYPE_BUFFER, "Occlusion Predicates");
+
+		VkMemoryRequirements memory_requirements;
+		vkGetBufferMemoryRequirements (vulkan_globals.device, occlusion.visible_buffer, &memory_requirements);
+
+		VkMemoryAllocateInfo memory_allocate_info;
+		memset (&memory_allocate_info, 0, sizeof (memory_allocate_info));
+		memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		memory_allocate_info.allocationSize = memory_requirements.size;
+		memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties (memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+
+		Atomic_IncrementUInt32 (&num_vulkan_misc_allocations);
+		R_AllocateVulkanMemory (&occlusion.visible_memory, &memory_allocate_info, VULKAN_MEMORY_TYPE_DEVICE);
+		GL_SetObjectName ((uint64_t)occlusion.visible_memory.handle, VK_OBJECT_TYPE_DEVICE_MEMORY, "Occlusion Predicates");
+
+		err = vkBindBufferMemory (vulkan_globals.device, occlusion.visible_buffer, occlusion.visible_memory.handle, 0);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkBindBufferMemory failed");
+	}
+
+	for (int i = 0; i < DOUBLE_BUFFERED; ++i)
+	{
+		occlusion.desc_sets[i] = R_AllocateDescriptorSet (&vulkan_globals.occlusion_cull_set_layout);
+
+		VkDescriptorBufferInfo buffer_infos[2];
+		memset (&buffer_infos, 0, sizeof (buffer_infos));
+		buffer_infos[0].buffer = occlusion.boxes_buffer;
+		buffer_infos[0].offset = i * MAX_OCCLUSION_BOXES * 8 * sizeof (float);
+		buffer_infos[0].range = MAX_OCCLUSION_BOXES * 8 * sizeof (float);
+		buffer_infos[1].buffer = occlusion.visible_buffer;
+		buffer_infos[1].offset = i * MAX_OCCLUSION_BOXES * sizeof (uint32_t);
+		buffer_infos[1].range = MAX_OCCLUSION_BOXES * sizeof (uint32_t);
+
+		VkWriteDescriptorSet writes[2];
+		memset (&writes, 0, sizeof (writes));
+		for (int j = 0; j < 2; ++j)
+		{
+			writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[j].dstBinding = j;
+			writes[j].dstArrayElement = 0;
+			writes[j].descriptorCount = 1;
+			writes[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[j].dstSet = occlusion.desc_sets[i];
+			writes[j].pBufferInfo = &buffer_infos[j];
+		}
+		vkUpdateDescriptorSets (vulkan_globals.device, 2, writes, 0, NULL);
+	}
+#endif
+}
+
+/*
+===============
+R_BeginOcclusionCulling
+
+Called once the fence of the frame slot was waited on, its boxes can be overwritten.
+===============
+*/
+void R_BeginOcclusionCulling (int frame_index)
+{
+	occlusion.frame_index = frame_index;
+	occlusion.constants[frame_index].num_boxes = 0;
+}
+
+/*
+===============
+R_OcclusionCullingActive
+===============
+*/
+qboolean R_OcclusionCullingActive (void)
+{
+	return occlusion.active;
+}
+
+/*
+===============
+R_SetupOcclusionCulling
+
+Gathers the boxes of this frame's occlusion tests. Needs the final list of visedicts.
+===============
+*/
+static void R_SetupOcclusionCulling (void *unused)
+{
+	const int              slot = occlusion.frame_index;
+	occlusion_constants_t *constants = &occlusion.constants[slot];
+	float                 *boxes = occlusion.boxes_mapped + (slot * MAX_OCCLUSION_BOXES * 8);
+	uint32_t               num_boxes = 0;
+	int                    i, j;
+
+	for (i = 0; i < cl_numvisedicts; ++i)
+	{
+		entity_t *e = cl_visedicts[i];
+		vec3_t    mins, maxs;
+
+		e->occlusion_index = -1;
+		if (num_boxes == MAX_OCCLUSION_BOXES)
+			continue;
+		if (!e->model || ((e->model->type != mod_alias) && (e->model->type != mod_brush)) || (ENTALPHA_DECODE (e->alpha) < 1) ||
+		    (e->eflags & EFLAGS_EXTERIORMODEL))
+			continue;
+
+		R_EntityBounds (e, mins, maxs);
+		if (R_CullBox (mins, maxs))
+			continue;
+
+		qboolean near_eye = true;
+		for (j = 0; j < 3; ++j)
+		{
+			mins[j] -= OCCLUSION_BOX_EPSILON;
+			maxs[j] += OCCLUSION_BOX_EPSILON;
+			if ((r_refdef.vieworg[j] < mins[j] - OCCLUSION_NEAR_DISTANCE) || (r_refdef.vieworg[j] > maxs[j] + OCCLUSION_NEAR_DISTANCE))
+				near_eye = false;
+		}
+		if (near_eye)
+			continue;
+
+		float *box = boxes + (num_boxes * 8);
+		VectorCopy (mins, box);
+		box[3] = 0.0f;
+		VectorCopy (maxs, box + 4);
+		box[7] = 0.0f;
+		e->occlusion_index = num_boxes++;
+	}
+
+	// the boxes are tested against the depth of the last frame that was drawn
+	memcpy (constants->view_projection, occlusion.last_view_projection, 16 * sizeof (float));
+	memcpy (constants->viewport, occlusion.last_viewport, 4 * sizeof (float));
+	constants->num_boxes = num_boxes;
+
+	memcpy (occlusion.last_view_projection, vulkan_globals.view_projection_matrix, 16 * sizeof (float));
+	occlusion.last_viewport[0] = glx + r_refdef.vrect.x;
+	occlusion.last_viewport[1] = vid.height - (gly + glheight - r_refdef.vrect.y);
+	occlusion.last_viewport[2] = r_refdef.vrect.width;
+	occlusion.last_viewport[3] = r_refdef.vrect.height;
+
+	Atomic_AddUInt32 (&rs_occlusiontests, num_boxes);
+}
+
+/*
+===============
+R_CullOccludedEntities
+
+Writes the predicates of this frame's boxes. Recorded into the primary command buffer before the
+main render pass. Without a Hi-Z pyramid of the previous frame every box is visible.
+===============
+*/
+void R_CullOccludedEntities (cb_context_t *cbx, int frame_index, int hiz_levels)
+{
+#if defined(VK_EXT_conditional_rendering)
+	occlusion_constants_t *constants = &occlusion.constants[frame_index];
+	const VkDeviceSize     offset = frame_index * MAX_OCCLUSION_BOXES * sizeof (uint32_t);
+	if (constants->num_boxes == 0)
+		return;
+
+	R_BeginDebugUtilsLabel (cbx, "Occlusion Culling");
+
+	VkBufferMemoryBarrier buffer_barrier;
+	memset (&buffer_barrier, 0, sizeof (buffer_barrier));
+	buffer_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	buffer_barrier.dstAccessMask = VK_ACCESS_CONDITIONAL_RENDERING_READ_BIT_EXT;
+	buffer_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	buffer_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	buffer_barrier.buffer = occlusion.visible_buffer;
+	buffer_barrier.offset = offset;
+	buffer_barrier.size = constants->num_boxes * sizeof (uint32_t);
+
+	VkPipelineStageFlags src_stage_mask;
+	if (hiz_levels > 0)
+	{
+		constants->num_levels = hiz_levels;
+		VkDescriptorSet sets[2] = {vulkan_globals.hiz_desc_set, occlusion.desc_sets[frame_index]};
+		R_BindPipeline (cbx, VK_PIPELINE_BIND_POINT_COMPUTE, vulkan_globals.occlusion_cull_pipeline);
+		vkCmdBindDescriptorSets (
+			cbx->cb, VK_PIPELINE_BIND_POINT_COMPUTE, vulkan_globals.occlusion_cull_pipeline.layout.handle, 0, 2, sets, 0, NULL);
+		R_PushConstants (cbx, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof (occlusion_constants_t), constants);
+		vulkan_globals.vk_cmd_dispatch (cbx->cb, (constants->num_boxes + 63) / 64, 1, 1);
+		src_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		buffer_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	}
+	else
+	{
+		vkCmdFillBuffer (cbx->cb, occlusion.visible_buffer, offset, constants->num_boxes * sizeof (uint32_t), 1);
+		src_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		buffer_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	}
+
+	vulkan_globals.vk_cmd_pipeline_barrier (
+		cbx->cb, src_stage_mask, VK_PIPELINE_STAGE_CONDITIONAL_RENDERING_BIT_EXT, 0, 0, NULL, 1, &buffer_barrier, 0, NULL);
+
+	R_EndDebugUtilsLabel (cbx);
+#endif
+}
+
+/*
+===============
+R_BeginOcclusionPredicate
+===============
+*/
+static inline void R_BeginOcclusionPredicate (cb_context_t *cbx, int occlusion_index)
+{
+#if defined(VK_EXT_conditional_rendering)
+	VkConditionalRenderingBeginInfoEXT begin_info;
+	memset (&begin_info, 0, sizeof (begin_info));
+	begin_info.sType = VK_STRUCTURE_TYPE_CONDITIONAL_RENDERING_BEGIN_INFO_EXT;
+	begin_info.buffer = occlusion.visible_buffer;
+	begin_info.offset = ((occlusion.frame_index * MAX_OCCLUSION_BOXES) + occlusion_index) * sizeof (uint32_t);
+	vulkan_globals.vk_cmd_begin_conditional_rendering (cbx->cb, &begin_info);
+#endif
+}
+
+/*
+===============
+R_EndOcclusionPredicate
+===============
+*/
+static inline void R_EndOcclusionPredicate (cb_context_t *cbx)
+{
+#if defined(VK_EXT_conditional_rendering)
+	vulkan_globals.vk_cmd_end_conditional_rendering (cbx->cb);
+#endif
+}
+
 /*
 ===============
 R_RotateForEntity -- johnfitz -- modified to take origin and angles instead of pointer to entity
@@ -425,6 +758,26 @@ static void R_SetupViewBeforeMark (void *unused)
 //
 //==============================================================================
 
+/*
+=============
+R_CompareEntityBatches
+
+Orders entities by model, skin and frame so consecutive alias entities end up in
+the same instanced draw, see R_BatchAliasModel
+=============
+*/
+static int R_CompareEntityBatches (const void *a, const void *b)
+{
+	const entity_t *e1 = *(const entity_t **)a;
+	const entity_t *e2 = *(const entity_t **)b;
+
+	if (e1->model != e2->model)
+		return ((uintptr_t)e1->model < (uintptr_t)e2->model) ? -1 : 1;
+	if (e1->skinnum != e2->skinnum)
+		return e1->skinnum - e2->skinnum;
+	return e1->frame - e2->frame;
+}
+
 /*
 =============
 R_DrawEntitiesOnList
@@ -432,21 +785,40 @@ R_DrawEntitiesOnList
 */
 void R_DrawEntitiesOnList (cb_context_t *cbx, qboolean alphapass, int chain, int startedict, int endedict) // johnfitz -- added parameter
 {
-	int i;
+	static THREAD_LOCAL entity_t **sorted_entities;
+	static THREAD_LOCAL int        max_sorted_entities;
+	entity_t                     **entities = cl_visedicts + startedict;
+	const int                      num_entities = endedict - startedict;
+	int                            i;
 
 	if (!r_drawentities.value)
 		return;
 
+	// opaque entities can be drawn in any order, so batch them by model
+	if (!alphapass && (num_entities > 1))
+	{
+		if (num_entities > max_sorted_entities)
+		{
+			max_sorted_entities = q_max (num_entities, max_sorted_entities * 2);
+			sorted_entities = Mem_Realloc (sorted_entities, sizeof (entity_t *) * max_sorted_entities);
+		}
+		memcpy (sorted_entities, cl_visedicts + startedict, sizeof (entity_t *) * num_entities);
+		qsort (sorted_entities, num_entities, sizeof (entity_t *), R_CompareEntityBatches);
+		entities = sorted_entities;
+	}
+
 	int brushpolys = 0;
 	int brushpasses = 0;
 	int aliaspolys = 0;
 	int aliaspasses = 0;
 
+	const qboolean instancing = !alphapass && r_aliasinstancing.value;
+
 	R_BeginDebugUtilsLabel (cbx, alphapass ? "Entities Alpha Pass" : "Entities");
 	// johnfitz -- sprites are not a special case
-	for (i = startedict; i < endedict; ++i)
+	for (i = 0; i < num_entities; ++i)
 	{
-		entity_t *currententity = cl_visedicts[i];
+		entity_t *currententity = entities[i];
 
 		// johnfitz -- if alphapass is true, draw only alpha entites this time
 		// if alphapass is false, draw only nonalpha entities this time
@@ -462,21 +834,40 @@ void R_DrawEntitiesOnList (cb_context_t *cbx, qboolean alphapass, int chain, int
 		if (currententity->eflags & EFLAGS_EXTERIORMODEL)
 			continue;
 
+		// the predicate of an occlusion query only covers the draws of its own entity
+		const qboolean predicated = !alphapass && occlusion.active && (currententity->occlusion_index >= 0);
+		if (instancing && (predicated || (currententity->model->type != mod_alias)))
+			R_FlushAliasBatch (cbx, &aliaspasses);
+		if (predicated)
+			R_BeginOcclusionPredicate (cbx, currententity->occlusion_index);
+
 		switch (currententity->model->type)
 		{
 		case mod_alias:
-			R_DrawAliasModel (cbx, currententity, &aliaspolys);
-			++aliaspasses;
+			if (instancing && !predicated)
+				R_BatchAliasModel (cbx, currententity, &aliaspolys, &aliaspasses);
+			else
+			{
+				R_DrawAliasModel (cbx, currententity, &aliaspolys);
+				++aliaspasses;
+			}
 			break;
 		case mod_brush:
 			R_DrawBrushModel (cbx, currententity, chain, &brushpolys);
 			++brushpasses;
+			cbx->alias_model = NULL;
 			break;
 		case mod_sprite:
 			R_DrawSpriteModel (cbx, currententity);
+			cbx->alias_model = NULL;
 			break;
 		}
+
+		if (predicated)
+			R_EndOcclusionPredicate (cbx);
 	}
+	if (instancing)
+		R_FlushAliasBatch (cbx, &aliaspasses);
 	R_EndDebugUtilsLabel (cbx);
 
 	Atomic_AddUInt32 (&rs_brushpolys, brushpolys);
@@ -593,12 +984,12 @@ draw bounding boxes -- the server-side boxes, not the renderer cullboxes
 */
 void R_ShowBoundingBoxes (cb_context_t *cbx)
 {
-	extern edict_t *sv_player;
 	vec3_t          mins, maxs, center;
 	edict_t        *ed;
 	int             i, pass;
 
-	if (!r_showbboxes.value || cl.maxclients > 1 || !r_drawentities.value || !sv.active)
+	// _Host_Frame joins the server thread first, this only skips renders it didn't
+	if (!r_showbboxes.value || cl.maxclients > 1 || !r_drawentities.value || !sv.active || Host_ServerThreadBusy ())
 		return;
 
 	R_BeginDebugUtilsLabel (cbx, "show bboxes");
@@ -619,7 +1010,7 @@ void R_ShowBoundingBoxes (cb_context_t *cbx)
 			continue;
 		for (i = 1, ed = NEXT_EDICT (qcvm->edicts); i < qcvm->num_edicts; i++, ed = NEXT_EDICT (ed))
 		{
-			if (ed == sv_player || ed->free)
+			if (ed == svs.clients[0].edict || ed->free)
 				continue; // don't draw player's own bbox or freed edicts
 
 			if (ed->v.mins[0] == ed->v.maxs[0] && ed->v.mins[1] == ed->v.maxs[1] && ed->v.mins[2] == ed->v.maxs[2])
@@ -786,6 +1177,18 @@ static void R_DrawAlphaEntitiesTask (void *unused)
 		cl_numvisedicts); // johnfitz -- true means this is the pass for alpha entities
 }
 
+#ifdef PSET_SCRIPT
+/*
+================
+R_UpdateFTEParticlesTask
+================
+*/
+static void R_UpdateFTEParticlesTask (void *unused)
+{
+	PScript_UpdateParticles ();
+}
+#endif
+
 /*
 ================
 R_DrawParticlesTask
@@ -830,9 +1233,18 @@ static void R_PrintStats (double time1)
 			"x %i y %i z %i (pitch %i yaw %i roll %i)\n", (int)cl.entities[cl.viewentity].origin[0], (int)cl.entities[cl.viewentity].origin[1],
 			(int)cl.entities[cl.viewentity].origin[2], (int)cl.viewangles[PITCH], (int)cl.viewangles[YAW], (int)cl.viewangles[ROLL]);
 	else if (r_speeds.value == 2)
+	{
+		static const char *cache_names[] = {"none", "pvs", "pvs+cull"};
+		double             mark_time, saved_time;
+		int                cache_level;
+		R_GetMarkSurfacesStats (&mark_time, &saved_time, &cache_level);
 		Con_Printf (
 			"%6.3f ms  %4u/%4u wpoly %4u/%4u epoly %3u lmap %4u skypoly\n", (time2 - time1) * 1000.0, rs_brushpolys, rs_brushpasses, rs_aliaspolys,
 			rs_aliaspasses, rs_dynamiclightmaps, rs_skypolys);
+		Con_Printf (
+			"%6.3f ms  mark, %6.3f ms saved (reused %s) %4u occlusion tests\n", mark_time * 1000.0, saved_time * 1000.0, cache_names[cache_level],
+			rs_occlusiontests);
+	}
 	else if (r_speeds.value)
 		Con_Printf ("%3i ms  %4i wpoly %4i epoly %3i lmap\n", (int)((time2 - time1) * 1000), rs_brushpolys, rs_aliaspolys, rs_dynamiclightmaps);
 	// johnfitz
@@ -851,6 +1263,8 @@ void R_RenderView (qboolean use_tasks, task_handle_t begin_rendering_task, task_
 	if (!cl.worldmodel)
 		Sys_Error ("R_RenderView: NULL worldmodel");
 
+	R_WaitParticles ();
+
 	time1 = 0; /* avoid compiler warning */
 	if (r_speeds.value)
 		time1 = Sys_DoubleTime ();
@@ -869,11 +1283,15 @@ void R_RenderView (qboolean use_tasks, task_handle_t begin_rendering_task, task_
 		Atomic_StoreUInt32 (&rs_dynamiclightmaps, 0u);
 		Atomic_StoreUInt32 (&rs_aliaspasses, 0u);
 		Atomic_StoreUInt32 (&rs_brushpasses, 0u);
+		Atomic_StoreUInt32 (&rs_occlusiontests, 0u);
 		stats_ready = true;
 	}
 	else
 		stats_ready = false;
 
+	// -discarddraws drops the draws the Hi-Z is built from and the dispatches that test against it
+	occlusion.active = r_occlusioncull.value && r_drawentities.value && vulkan_globals.occlusion_culling && !vulkan_globals.discard_draws;
+
 	cb_context_t *primary_cbx = &vulkan_globals.primary_cb_context;
 	if (use_tasks)
 	{
@@ -910,6 +1328,14 @@ void R_RenderView (qboolean use_tasks, task_handle_t begin_rendering_task, task_
 		Task_AddDependency (store_efrags, draw_entities_task);
 		Task_AddDependency (begin_rendering_task, draw_entities_task);
 		Task_AddDependency (draw_entities_task, draw_done_task);
+		if (occlusion.active)
+		{
+			task_handle_t setup_occlusion_task = Task_AllocateAndAssignFunc (R_SetupOcclusionCulling, NULL, 0);
+			Task_AddDependency (store_efrags, setup_occlusion_task);
+			Task_AddDependency (begin_rendering_task, setup_occlusion_task);
+			Task_AddDependency (setup_occlusion_task, draw_entities_task);
+			Task_Submit (setup_occlusion_task);
+		}
 
 		task_handle_t draw_alpha_entities_task = Task_AllocateAndAssignFunc (R_DrawAlphaEntitiesTask, NULL, 0);
 		Task_AddDependency (store_efrags, draw_alpha_entities_task);
@@ -921,6 +1347,19 @@ void R_RenderView (qboolean use_tasks, task_handle_t begin_rendering_task, task_
 		Task_AddDependency (begin_rendering_task, draw_particles_task);
 		Task_AddDependency (draw_particles_task, draw_done_task);
 
+#ifdef PSET_SCRIPT
+		const int     num_fte_particle_tasks = Tasks_NumWorkers ();
+		task_handle_t update_fte_particles_task = Task_AllocateAndAssignFunc (R_UpdateFTEParticlesTask, NULL, 0);
+		task_handle_t build_fte_particles_task = Task_AllocateAndAssignIndexedFunc (
+			(task_indexed_func_t)PScript_BuildParticleVertices, num_fte_particle_tasks, (void *)&num_fte_particle_tasks, sizeof (int));
+		Task_AddDependency (before_mark, update_fte_particles_task);
+		Task_AddDependency (begin_rendering_task, update_fte_particles_task);
+		Task_AddDependency (update_fte_particles_task, build_fte_particles_task);
+		Task_AddDependency (build_fte_particles_task, draw_particles_task);
+		task_handle_t fte_particle_tasks[] = {update_fte_particles_task, build_fte_particles_task};
+		Tasks_Submit (countof (fte_particle_tasks), fte_particle_tasks);
+#endif
+
 		task_handle_t update_lightmaps_task = Task_AllocateAndAssignFunc (R_UpdateLightmaps, NULL, 0);
 		Task_AddDependency (cull_surfaces, update_lightmaps_task);
 		Task_AddDependency (begin_rendering_task, update_lightmaps_task);
@@ -944,9 +1383,16 @@ void R_RenderView (qboolean use_tasks, task_handle_t begin_rendering_task, task_
 		R_UpdateWarpTextures (&primary_cbx);
 		R_DrawWorldTask (0, NULL);
 		R_DrawSkyAndWaterTask (NULL);
+		if (occlusion.active)
+			R_SetupOcclusionCulling (NULL);
 		for (int i = 0; i < NUM_ENTITIES_CBX; ++i)
 			R_DrawEntitiesTask (i, NULL);
 		R_DrawAlphaEntitiesTask (NULL);
+#ifdef PSET_SCRIPT
+		int num_fte_particle_tasks = 1;
+		R_UpdateFTEParticlesTask (NULL);
+		PScript_BuildParticleVertices (0, &num_fte_particle_tasks);
+#endif
 		R_DrawParticlesTask (NULL);
 		R_DrawViewModelTask (NULL);
 		if (r_gpulightmapupdate.value)
@@ -50,7 +50,12 @@ extern cvar_t gl_zfix; // QuakeSpasm z-fighting fix
 
 extern cvar_t r_gpulightmapupdate;
 extern cvar_t r_tasks;
+extern cvar_t r_occlusioncull;
+extern cvar_t r_aliasinstancing;
 extern cvar_t r_parallelmark;
+extern cvar_t r_drawindirect;
+extern cvar_t r_gpuworldcull;
+extern cvar_t r_bindless;
 extern cvar_t r_usesops;
 
 #if defined(USE_SIMD)
@@ -86,26 +91,39 @@ static SDL_mutex *garbage_mutex;
 Staging
 ================
 */
-#define NUM_STAGING_BUFFERS 2
+#define NUM_STAGING_BUFFERS 3
+#define NUM_STAGING_SLOTS   (TASKS_MAX_WORKERS + 1) // slot 0 is shared by all non-worker threads
 
+// Every thread records into its own command buffer, so staging_mutex only
+// guards the offset bump and submission, not command recording.
 typedef struct
 {
-	VkBuffer        buffer;
+	VkCommandPool   command_pool;
 	VkCommandBuffer command_buffer;
-	VkFence         fence;
-	int             current_offset;
-	qboolean        submitted;
-	unsigned char  *data;
+	qboolean        recording;
+} stagingcommands_t;
+
+typedef struct
+{
+	VkBuffer          buffer;
+	stagingcommands_t commands[NUM_STAGING_SLOTS];
+	VkFence           fence;
+	int               current_offset;
+	int               num_in_flight; // allocations not yet finished with R_StagingEndCopy
+	qboolean          submitted;
+	unsigned char    *data;
 } stagingbuffer_t;
 
-static VkCommandPool   staging_command_pool;
-static vulkan_memory_t staging_memory;
-static stagingbuffer_t staging_buffers[NUM_STAGING_BUFFERS];
-static int             current_staging_buffer = 0;
-static int             num_stagings_in_flight = 0;
-static qboolean        staging_submitting = false;
-static SDL_mutex      *staging_mutex;
-static SDL_cond       *staging_cond;
+static vulkan_memory_t  staging_memory;
+static stagingbuffer_t  staging_buffers[NUM_STAGING_BUFFERS];
+static int              current_staging_buffer = 0;
+static qboolean         staging_submitting = false;
+static SDL_mutex       *staging_mutex;
+static SDL_cond        *staging_cond;
+static SDL_mutex       *staging_slot_mutexes[NUM_STAGING_SLOTS]; // held from R_StagingAllocate to R_StagingBeginCopy
+
+static THREAD_LOCAL stagingbuffer_t *staging_thread_buffer;
+static THREAD_LOCAL int              staging_thread_slot;
 /*
 ================
 Dynamic vertex/index & uniform buffer
@@ -414,6 +432,17 @@ static void R_DestroyStagingBuffers ()
 	for (i = 0; i < NUM_STAGING_BUFFERS; ++i)
 	{
 		vkDestroyBuffer (vulkan_globals.device, staging_buffers[i].buffer, NULL);
+
+		// recorded against the destroyed buffer, R_BeginStagingCommands creates them again
+		for (int slot = 0; slot < NUM_STAGING_SLOTS; ++slot)
+		{
+			stagingcommands_t *commands = &staging_buffers[i].commands[slot];
+			if (commands->command_pool != VK_NULL_HANDLE)
+				vkDestroyCommandPool (vulkan_globals.device, commands->command_pool, NULL);
+			commands->command_pool = VK_NULL_HANDLE;
+			commands->command_buffer = VK_NULL_HANDLE;
+			commands->recording = false;
+		}
 	}
 }
 
@@ -431,49 +460,20 @@ void R_InitStagingBuffers ()
 
 	R_CreateStagingBuffers ();
 
-	VkCommandPoolCreateInfo command_pool_create_info;
-	memset (&command_pool_create_info, 0, sizeof (command_pool_create_info));
-	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-	command_pool_create_info.queueFamilyIndex = vulkan_globals.gfx_queue_family_index;
-
-	err = vkCreateCommandPool (vulkan_globals.device, &command_pool_create_info, NULL, &staging_command_pool);
-	if (err != VK_SUCCESS)
-		Sys_Error ("vkCreateCommandPool failed");
-
-	VkCommandBufferAllocateInfo command_buffer_allocate_info;
-	memset (&command_buffer_allocate_info, 0, sizeof (command_buffer_allocate_info));
-	command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	command_buffer_allocate_info.commandPool = staging_command_pool;
-	command_buffer_allocate_info.commandBufferCount = NUM_STAGING_BUFFERS;
-
-	VkCommandBuffer command_buffers[NUM_STAGING_BUFFERS];
-	err = vkAllocateCommandBuffers (vulkan_globals.device, &command_buffer_allocate_info, command_buffers);
-	if (err != VK_SUCCESS)
-		Sys_Error ("vkAllocateCommandBuffers failed");
-
 	VkFenceCreateInfo fence_create_info;
 	memset (&fence_create_info, 0, sizeof (fence_create_info));
 	fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 
-	VkCommandBufferBeginInfo command_buffer_begin_info;
-	memset (&command_buffer_begin_info, 0, sizeof (command_buffer_begin_info));
-	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
 	for (i = 0; i < NUM_STAGING_BUFFERS; ++i)
 	{
 		err = vkCreateFence (vulkan_globals.device, &fence_create_info, NULL, &staging_buffers[i].fence);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkCreateFence failed");
-
-		staging_buffers[i].command_buffer = command_buffers[i];
-
-		err = vkBeginCommandBuffer (staging_buffers[i].command_buffer, &command_buffer_begin_info);
-		if (err != VK_SUCCESS)
-			Sys_Error ("vkBeginCommandBuffer failed");
 	}
 
+	for (i = 0; i < NUM_STAGING_SLOTS; ++i)
+		staging_slot_mutexes[i] = SDL_CreateMutex ();
+
 	vertex_allocate_mutex = SDL_CreateMutex ();
 	index_allocate_mutex = SDL_CreateMutex ();
 	uniform_allocate_mutex = SDL_CreateMutex ();
@@ -482,6 +482,59 @@ void R_InitStagingBuffers ()
 	staging_cond = SDL_CreateCond ();
 }
 
+/*
+===============
+R_BeginStagingCommands
+
+Command pools are per buffer and slot: the owning thread records while the
+submitting thread may end the buffer's other command buffers.
+===============
+*/
+static VkCommandBuffer R_BeginStagingCommands (stagingbuffer_t *staging_buffer, int slot)
+{
+	stagingcommands_t *commands = &staging_buffer->commands[slot];
+	VkResult           err;
+
+	if (commands->recording)
+		return commands->command_buffer;
+
+	if (commands->command_pool == VK_NULL_HANDLE)
+	{
+		VkCommandPoolCreateInfo command_pool_create_info;
+		memset (&command_pool_create_info, 0, sizeof (command_pool_create_info));
+		command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		command_pool_create_info.queueFamilyIndex = vulkan_globals.gfx_queue_family_index;
+
+		err = vkCreateCommandPool (vulkan_globals.device, &command_pool_create_info, NULL, &commands->command_pool);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkCreateCommandPool failed");
+
+		VkCommandBufferAllocateInfo command_buffer_allocate_info;
+		memset (&command_buffer_allocate_info, 0, sizeof (command_buffer_allocate_info));
+		command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		command_buffer_allocate_info.commandPool = commands->command_pool;
+		command_buffer_allocate_info.commandBufferCount = 1;
+
+		err = vkAllocateCommandBuffers (vulkan_globals.device, &command_buffer_allocate_info, &commands->command_buffer);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkAllocateCommandBuffers failed");
+		GL_SetObjectName ((uint64_t)commands->command_buffer, VK_OBJECT_TYPE_COMMAND_BUFFER, va ("Staging Command Buffer %d", slot));
+	}
+
+	VkCommandBufferBeginInfo command_buffer_begin_info;
+	memset (&command_buffer_begin_info, 0, sizeof (command_buffer_begin_info));
+	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	err = vkBeginCommandBuffer (commands->command_buffer, &command_buffer_begin_info);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkBeginCommandBuffer failed");
+
+	commands->recording = true;
+	return commands->command_buffer;
+}
+
 /*
 ===============
 R_SubmitStagingBuffer
@@ -489,8 +542,11 @@ R_SubmitStagingBuffer
 */
 static void R_SubmitStagingBuffer (int index)
 {
+	stagingbuffer_t *staging_buffer = &staging_buffers[index];
+
+	// only allocations from this buffer have to finish, the others keep copying
 	staging_submitting = true;
-	while (num_stagings_in_flight > 0)
+	while (staging_buffer->num_in_flight > 0)
 		SDL_CondWait (staging_cond, staging_mutex);
 	staging_submitting = false;
 	SDL_CondBroadcast (staging_cond);
@@ -500,10 +556,19 @@ static void R_SubmitStagingBuffer (int index)
 	memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
 	memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 	memory_barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-	vkCmdPipelineBarrier (
-		staging_buffers[index].command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memory_barrier, 0, NULL, 0, NULL);
 
-	vkEndCommandBuffer (staging_buffers[index].command_buffer);
+	VkCommandBuffer command_buffers[NUM_STAGING_SLOTS];
+	int             num_command_buffers = 0;
+	for (int slot = 0; slot < NUM_STAGING_SLOTS; ++slot)
+	{
+		stagingcommands_t *commands = &staging_buffer->commands[slot];
+		if (!commands->recording)
+			continue;
+		vkCmdPipelineBarrier (commands->command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memory_barrier, 0, NULL, 0, NULL);
+		vkEndCommandBuffer (commands->command_buffer);
+		commands->recording = false;
+		command_buffers[num_command_buffers++] = commands->command_buffer;
+	}
 
 	VkMappedMemoryRange range;
 	memset (&range, 0, sizeof (range));
@@ -515,12 +580,12 @@ static void R_SubmitStagingBuffer (int index)
 	VkSubmitInfo submit_info;
 	memset (&submit_info, 0, sizeof (submit_info));
 	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submit_info.commandBufferCount = 1;
-	submit_info.pCommandBuffers = &staging_buffers[index].command_buffer;
+	submit_info.commandBufferCount = num_command_buffers;
+	submit_info.pCommandBuffers = command_buffers;
 
-	vkQueueSubmit (vulkan_globals.queue, 1, &submit_info, staging_buffers[index].fence);
+	vkQueueSubmit (vulkan_globals.queue, 1, &submit_info, staging_buffer->fence);
 
-	staging_buffers[index].submitted = true;
+	staging_buffer->submitted = true;
 	current_staging_buffer = (current_staging_buffer + 1) % NUM_STAGING_BUFFERS;
 }
 
@@ -532,11 +597,8 @@ R_SubmitStagingBuffers
 void R_SubmitStagingBuffers ()
 {
 	SDL_LockMutex (staging_mutex);
-	if (staging_submitting)
-	{
-		while (staging_submitting || (num_stagings_in_flight > 0))
-			SDL_CondWait (staging_cond, staging_mutex);
-	}
+	while (staging_submitting)
+		SDL_CondWait (staging_cond, staging_mutex);
 
 	int i;
 	for (i = 0; i < NUM_STAGING_BUFFERS; ++i)
@@ -568,46 +630,53 @@ static void R_FlushStagingCommandBuffer (stagingbuffer_t *staging_buffer)
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkResetFences failed");
 
+	// command buffers are begun again lazily by the threads that need them
 	staging_buffer->current_offset = 0;
 	staging_buffer->submitted = false;
-
-	VkCommandBufferBeginInfo command_buffer_begin_info;
-	memset (&command_buffer_begin_info, 0, sizeof (command_buffer_begin_info));
-	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-	err = vkBeginCommandBuffer (staging_buffer->command_buffer, &command_buffer_begin_info);
-	if (err != VK_SUCCESS)
-		Sys_Error ("vkBeginCommandBuffer failed");
 }
 
 /*
 ===============
 R_StagingAllocate
+
+The returned command buffer belongs to the calling thread until R_StagingBeginCopy.
 ===============
 */
 byte *R_StagingAllocate (int size, int alignment, VkCommandBuffer *command_buffer, VkBuffer *buffer, int *buffer_offset)
 {
+	const int slot = Tasks_IsWorker () ? (1 + Tasks_GetWorkerIndex ()) : 0;
+	SDL_LockMutex (staging_slot_mutexes[slot]);
+
 	SDL_LockMutex (staging_mutex);
-	if (staging_submitting)
-	{
-		while (staging_submitting || (num_stagings_in_flight > 0))
-			SDL_CondWait (staging_cond, staging_mutex);
-	}
+	while (staging_submitting)
+		SDL_CondWait (staging_cond, staging_mutex);
 
 	vulkan_globals.device_idle = false;
 
 	if (size > vulkan_globals.staging_buffer_size)
 	{
-		R_SubmitStagingBuffers ();
+		// Every allocation has to finish copying before the buffers are replaced. staging_mutex
+		// is only held once here, so the waits release it for R_StagingEndCopy.
+		staging_submitting = true;
+		for (int i = 0; i < NUM_STAGING_BUFFERS; ++i)
+			while (staging_buffers[i].num_in_flight > 0)
+				SDL_CondWait (staging_cond, staging_mutex);
 
 		for (int i = 0; i < NUM_STAGING_BUFFERS; ++i)
+		{
+			if (!staging_buffers[i].submitted && staging_buffers[i].current_offset > 0)
+				R_SubmitStagingBuffer (i);
 			R_FlushStagingCommandBuffer (&staging_buffers[i]);
+		}
 
 		vulkan_globals.staging_buffer_size = size;
 
 		R_DestroyStagingBuffers ();
 		R_CreateStagingBuffers ();
+		current_staging_buffer = 0;
+
+		staging_submitting = false;
+		SDL_CondBroadcast (staging_cond);
 	}
 
 	stagingbuffer_t *staging_buffer = &staging_buffers[current_staging_buffer];
@@ -621,8 +690,6 @@ byte *R_StagingAllocate (int size, int alignment, VkCommandBuffer *command_buffe
 	staging_buffer = &staging_buffers[current_staging_buffer];
 	R_FlushStagingCommandBuffer (staging_buffer);
 
-	if (command_buffer)
-		*command_buffer = staging_buffer->command_buffer;
 	if (buffer)
 		*buffer = staging_buffer->buffer;
 	if (buffer_offset)
@@ -630,7 +697,15 @@ byte *R_StagingAllocate (int size, int alignment, VkCommandBuffer *command_buffe
 
 	unsigned char *data = staging_buffer->data + staging_buffer->current_offset;
 	staging_buffer->current_offset += size;
-	num_stagings_in_flight += 1;
+	staging_buffer->num_in_flight += 1;
+	SDL_UnlockMutex (staging_mutex);
+
+	// the buffer can't be submitted while this allocation is in flight, so recording needs no global lock
+	staging_thread_buffer = staging_buffer;
+	staging_thread_slot = slot;
+	VkCommandBuffer slot_command_buffer = R_BeginStagingCommands (staging_buffer, slot);
+	if (command_buffer)
+		*command_buffer = slot_command_buffer;
 
 	return data;
 }
@@ -642,7 +717,7 @@ R_StagingBeginCopy
 */
 void R_StagingBeginCopy ()
 {
-	SDL_UnlockMutex (staging_mutex);
+	SDL_UnlockMutex (staging_slot_mutexes[staging_thread_slot]);
 }
 
 /*
@@ -653,7 +728,7 @@ R_StagingEndCopy
 void R_StagingEndCopy ()
 {
 	SDL_LockMutex (staging_mutex);
-	num_stagings_in_flight -= 1;
+	staging_thread_buffer->num_in_flight -= 1;
 	SDL_CondBroadcast (staging_cond);
 	SDL_UnlockMutex (staging_mutex);
 }
@@ -740,7 +815,7 @@ static void R_InitDynamicIndexBuffers ()
 	memset (&buffer_create_info, 0, sizeof (buffer_create_info));
 	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	buffer_create_info.size = current_dyn_index_buffer_size;
-	buffer_create_info.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+	buffer_create_info.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
 
 	for (i = 0; i < NUM_DYNAMIC_BUFFERS; ++i)
 	{
@@ -1340,7 +1415,7 @@ void R_CreateDescriptorSetLayouts ()
 		lightmap_compute_layout_bindings[5].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 		lightmap_compute_layout_bindings[6].binding = 6;
 		lightmap_compute_layout_bindings[6].descriptorCount = 1;
-		lightmap_compute_layout_bindings[6].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		lightmap_compute_layout_bindings[6].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
 		lightmap_compute_layout_bindings[6].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
 		descriptor_set_layout_create_info.bindingCount = 7;
@@ -1349,13 +1424,135 @@ void R_CreateDescriptorSetLayouts ()
 		memset (&vulkan_globals.lightmap_compute_set_layout, 0, sizeof (vulkan_globals.lightmap_compute_set_layout));
 		vulkan_globals.lightmap_compute_set_layout.num_storage_images = 1;
 		vulkan_globals.lightmap_compute_set_layout.num_combined_image_samplers = 1 + MAXLIGHTMAPS;
-		vulkan_globals.lightmap_compute_set_layout.num_storage_buffers = 2;
-		vulkan_globals.lightmap_compute_set_layout.num_ubos_dynamic = 2;
+		vulkan_globals.lightmap_compute_set_layout.num_storage_buffers = 3;
+		vulkan_globals.lightmap_compute_set_layout.num_ubos_dynamic = 1;
 
 		err = vkCreateDescriptorSetLayout (vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.lightmap_compute_set_layout.handle);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkCreateDescriptorSetLayout failed");
 	}
+
+	{
+		VkDescriptorSetLayoutBinding occlusion_cull_layout_bindings[2];
+		memset (&occlusion_cull_layout_bindings, 0, sizeof (occlusion_cull_layout_bindings));
+		occlusion_cull_layout_bindings[0].binding = 0;
+		occlusion_cull_layout_bindings[0].descriptorCount = 1;
+		occlusion_cull_layout_bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		occlusion_cull_layout_bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		occlusion_cull_layout_bindings[1].binding = 1;
+		occlusion_cull_layout_bindings[1].descriptorCount = 1;
+		occlusion_cull_layout_bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		occlusion_cull_layout_bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+		descriptor_set_layout_create_info.bindingCount = 2;
+		descriptor_set_layout_create_info.pBindings = occlusion_cull_layout_bindings;
+
+		memset (&vulkan_globals.occlusion_cull_set_layout, 0, sizeof (vulkan_globals.occlusion_cull_set_layout));
+		vulkan_globals.occlusion_cull_set_layout.num_storage_buffers = 2;
+
+		err = vkCreateDescriptorSetLayout (vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.occlusion_cull_set_layout.handle);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkCreateDescriptorSetLayout failed");
+	}
+
+	{
+		VkDescriptorSetLayoutBinding particle_compute_layout_bindings[5];
+		memset (&particle_compute_layout_bindings, 0, sizeof (particle_compute_layout_bindings));
+		for (int i = 0; i < 5; ++i)
+		{
+			particle_compute_layout_bindings[i].binding = i;
+			particle_compute_layout_bindings[i].descriptorCount = 1;
+			particle_compute_layout_bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			particle_compute_layout_bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+
+		descriptor_set_layout_create_info.bindingCount = 5;
+		descriptor_set_layout_create_info.pBindings = particle_compute_layout_bindings;
+
+		memset (&vulkan_globals.particle_compute_set_layout, 0, sizeof (vulkan_globals.particle_compute_set_layout));
+		vulkan_globals.particle_compute_set_layout.num_storage_buffers = 5;
+
+		err = vkCreateDescriptorSetLayout (vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.particle_compute_set_layout.handle);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkCreateDescriptorSetLayout failed");
+	}
+
+	{
+		VkDescriptorSetLayoutBinding world_cull_layout_bindings[4];
+		memset (&world_cull_layout_bindings, 0, sizeof (world_cull_layout_bindings));
+		for (int i = 0; i < 4; ++i)
+		{
+			world_cull_layout_bindings[i].binding = i;
+			world_cull_layout_bindings[i].descriptorCount = 1;
+			world_cull_layout_bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			world_cull_layout_bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+
+		descriptor_set_layout_create_info.bindingCount = 4;
+		descriptor_set_layout_create_info.pBindings = world_cull_layout_bindings;
+
+		memset (&vulkan_globals.world_cull_set_layout, 0, sizeof (vulkan_globals.world_cull_set_layout));
+		vulkan_globals.world_cull_set_layout.num_storage_buffers = 4;
+
+		err = vkCreateDescriptorSetLayout (vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.world_cull_set_layout.handle);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkCreateDescriptorSetLayout failed");
+	}
+
+	{
+		VkDescriptorSetLayoutBinding world_materials_layout_binding;
+		memset (&world_materials_layout_binding, 0, sizeof (world_materials_layout_binding));
+		world_materials_layout_binding.binding = 0;
+		world_materials_layout_binding.descriptorCount = 1;
+		world_materials_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		world_materials_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+		descriptor_set_layout_create_info.bindingCount = 1;
+		descriptor_set_layout_create_info.pBindings = &world_materials_layout_binding;
+
+		memset (&vulkan_globals.world_materials_set_layout, 0, sizeof (vulkan_globals.world_materials_set_layout));
+		vulkan_globals.world_materials_set_layout.num_storage_buffers = 1;
+
+		err = vkCreateDescriptorSetLayout (vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.world_materials_set_layout.handle);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkCreateDescriptorSetLayout failed");
+	}
+
+#if defined(VK_EXT_descriptor_indexing)
+	if (vulkan_globals.bindless_textures)
+	{
+		// Every gltexture_t slot, only the ones a draw indexes need to be valid
+		VkDescriptorSetLayoutBinding bindless_textures_layout_binding;
+		memset (&bindless_textures_layout_binding, 0, sizeof (bindless_textures_layout_binding));
+		bindless_textures_layout_binding.binding = 0;
+		bindless_textures_layout_binding.descriptorCount = MAX_GLTEXTURES;
+		bindless_textures_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		bindless_textures_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		const VkDescriptorBindingFlagsEXT binding_flags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+		                                                  VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+		VkDescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags_create_info;
+		memset (&binding_flags_create_info, 0, sizeof (binding_flags_create_info));
+		binding_flags_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+		binding_flags_create_info.bindingCount = 1;
+		binding_flags_create_info.pBindingFlags = &binding_flags;
+
+		descriptor_set_layout_create_info.pNext = &binding_flags_create_info;
+		descriptor_set_layout_create_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+		descriptor_set_layout_create_info.bindingCount = 1;
+		descriptor_set_layout_create_info.pBindings = &bindless_textures_layout_binding;
+
+		memset (&vulkan_globals.bindless_textures_set_layout, 0, sizeof (vulkan_globals.bindless_textures_set_layout));
+		vulkan_globals.bindless_textures_set_layout.num_combined_image_samplers = MAX_GLTEXTURES;
+
+		err = vkCreateDescriptorSetLayout (
+			vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.bindless_textures_set_layout.handle);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkCreateDescriptorSetLayout failed");
+		descriptor_set_layout_create_info.pNext = NULL;
+		descriptor_set_layout_create_info.flags = 0;
+	}
+#endif
 }
 
 /*
@@ -1365,31 +1562,66 @@ R_CreateDescriptorPool
 */
 void R_CreateDescriptorPool ()
 {
-	VkDescriptorPoolSize pool_sizes[7];
+	VkDescriptorPoolSize pool_sizes[8];
 	pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	pool_sizes[0].descriptorCount = 32 + (MAX_SANITY_LIGHTMAPS * 2) + (MAX_GLTEXTURES + 1);
 	pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-	pool_sizes[1].descriptorCount = 32 + MAX_GLTEXTURES + MAX_SANITY_LIGHTMAPS;
+	pool_sizes[1].descriptorCount = 32 + MAX_GLTEXTURES + MAX_SANITY_LIGHTMAPS + MAX_HIZ_LEVELS;
 	pool_sizes[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
 	pool_sizes[2].descriptorCount = 32;
 	pool_sizes[3].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	pool_sizes[3].descriptorCount = 32;
 	pool_sizes[4].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	pool_sizes[4].descriptorCount = 32 + MAX_SANITY_LIGHTMAPS * 2;
+	pool_sizes[4].descriptorCount = 32 + MAX_SANITY_LIGHTMAPS * 2 + DOUBLE_BUFFERED * (2 + 5 + 4 + 1);
 	pool_sizes[5].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	pool_sizes[5].descriptorCount = 32 + (MAX_SANITY_LIGHTMAPS * 2);
 	pool_sizes[6].type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
 	pool_sizes[6].descriptorCount = 32;
+	pool_sizes[7].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	pool_sizes[7].descriptorCount = 32 + MAX_SANITY_LIGHTMAPS;
 
 	VkDescriptorPoolCreateInfo descriptor_pool_create_info;
 	memset (&descriptor_pool_create_info, 0, sizeof (descriptor_pool_create_info));
 	descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	descriptor_pool_create_info.maxSets = MAX_GLTEXTURES + MAX_SANITY_LIGHTMAPS + 32;
-	descriptor_pool_create_info.poolSizeCount = 7;
+	descriptor_pool_create_info.maxSets = MAX_GLTEXTURES + MAX_SANITY_LIGHTMAPS + MAX_HIZ_LEVELS + 32;
+	descriptor_pool_create_info.poolSizeCount = 8;
 	descriptor_pool_create_info.pPoolSizes = pool_sizes;
 	descriptor_pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 
 	vkCreateDescriptorPool (vulkan_globals.device, &descriptor_pool_create_info, NULL, &vulkan_globals.descriptor_pool);
+
+#if defined(VK_EXT_descriptor_indexing)
+	if (vulkan_globals.bindless_textures)
+	{
+		// The bindless texture set is written after it was bound, which needs a pool of its own
+		VkDescriptorPoolSize bindless_pool_size;
+		bindless_pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		bindless_pool_size.descriptorCount = MAX_GLTEXTURES;
+
+		memset (&descriptor_pool_create_info, 0, sizeof (descriptor_pool_create_info));
+		descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		descriptor_pool_create_info.maxSets = 1;
+		descriptor_pool_create_info.poolSizeCount = 1;
+		descriptor_pool_create_info.pPoolSizes = &bindless_pool_size;
+		descriptor_pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+
+		VkResult err = vkCreateDescriptorPool (vulkan_globals.device, &descriptor_pool_create_info, NULL, &vulkan_globals.bindless_descriptor_pool);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkCreateDescriptorPool failed");
+
+		VkDescriptorSetAllocateInfo descriptor_set_allocate_info;
+		memset (&descriptor_set_allocate_info, 0, sizeof (descriptor_set_allocate_info));
+		descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		descriptor_set_allocate_info.descriptorPool = vulkan_globals.bindless_descriptor_pool;
+		descriptor_set_allocate_info.descriptorSetCount = 1;
+		descriptor_set_allocate_info.pSetLayouts = &vulkan_globals.bindless_textures_set_layout.handle;
+
+		err = vkAllocateDescriptorSets (vulkan_globals.device, &descriptor_set_allocate_info, &vulkan_globals.bindless_textures_desc_set);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkAllocateDescriptorSets failed");
+		GL_SetObjectName ((uint64_t)vulkan_globals.bindless_textures_desc_set, VK_OBJECT_TYPE_DESCRIPTOR_SET, "Bindless Textures");
+	}
+#endif
 }
 
 /*
@@ -1439,6 +1671,22 @@ void R_CreatePipelineLayouts ()
 	GL_SetObjectName ((uint64_t)vulkan_globals.world_pipeline_layout.handle, VK_OBJECT_TYPE_PIPELINE_LAYOUT, "world_pipeline_layout");
 	vulkan_globals.world_pipeline_layout.push_constant_range = push_constant_range;
 
+	// World with bindless textures
+	if (vulkan_globals.bindless_textures)
+	{
+		VkDescriptorSetLayout world_bindless_descriptor_set_layouts[2] = {
+			vulkan_globals.bindless_textures_set_layout.handle, vulkan_globals.world_materials_set_layout.handle};
+
+		pipeline_layout_create_info.setLayoutCount = 2;
+		pipeline_layout_create_info.pSetLayouts = world_bindless_descriptor_set_layouts;
+
+		err = vkCreatePipelineLayout (vulkan_globals.device, &pipeline_layout_create_info, NULL, &vulkan_globals.world_bindless_pipeline_layout.handle);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkCreatePipelineLayout failed");
+		GL_SetObjectName ((uint64_t)vulkan_globals.world_bindless_pipeline_layout.handle, VK_OBJECT_TYPE_PIPELINE_LAYOUT, "world_bindless_pipeline_layout");
+		vulkan_globals.world_bindless_pipeline_layout.push_constant_range = push_constant_range;
+	}
+
 	// Alias
 	VkDescriptorSetLayout alias_descriptor_set_layouts[3] = {
 		vulkan_globals.single_texture_set_layout.handle, vulkan_globals.single_texture_set_layout.handle, vulkan_globals.ubo_set_layout.handle};
@@ -1566,6 +1814,95 @@ void R_CreatePipelineLayouts ()
 		Sys_Error ("vkCreatePipelineLayout failed");
 	GL_SetObjectName ((uint64_t)vulkan_globals.update_lightmap_pipeline.layout.handle, VK_OBJECT_TYPE_PIPELINE_LAYOUT, "update_lightmap_pipeline_layout");
 	vulkan_globals.update_lightmap_pipeline.layout.push_constant_range = push_constant_range;
+
+	// Hi-Z
+	VkDescriptorSetLayout hiz_reduce_descriptor_set_layouts[2] = {
+		vulkan_globals.single_texture_set_layout.handle,
+		vulkan_globals.single_texture_cs_write_set_layout.handle,
+	};
+
+	memset (&push_constant_range, 0, sizeof (push_constant_range));
+	push_constant_range.offset = 0;
+	push_constant_range.size = 1 * sizeof (uint32_t);
+	push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	pipeline_layout_create_info.setLayoutCount = 2;
+	pipeline_layout_create_info.pSetLayouts = hiz_reduce_descriptor_set_layouts;
+	pipeline_layout_create_info.pushConstantRangeCount = 1;
+	pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+	err = vkCreatePipelineLayout (vulkan_globals.device, &pipeline_layout_create_info, NULL, &vulkan_globals.hiz_reduce_pipeline.layout.handle);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreatePipelineLayout failed");
+	GL_SetObjectName ((uint64_t)vulkan_globals.hiz_reduce_pipeline.layout.handle, VK_OBJECT_TYPE_PIPELINE_LAYOUT, "hiz_reduce_pipeline_layout");
+	vulkan_globals.hiz_reduce_pipeline.layout.push_constant_range = push_constant_range;
+
+	vulkan_globals.hiz_reduce_ms_pipeline.layout.handle = vulkan_globals.hiz_reduce_pipeline.layout.handle;
+	vulkan_globals.hiz_reduce_ms_pipeline.layout.push_constant_range = push_constant_range;
+
+	// Occlusion culling
+	VkDescriptorSetLayout occlusion_cull_descriptor_set_layouts[2] = {
+		vulkan_globals.single_texture_set_layout.handle,
+		vulkan_globals.occlusion_cull_set_layout.handle,
+	};
+
+	memset (&push_constant_range, 0, sizeof (push_constant_range));
+	push_constant_range.offset = 0;
+	push_constant_range.size = 20 * sizeof (float) + 2 * sizeof (uint32_t);
+	push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	pipeline_layout_create_info.setLayoutCount = 2;
+	pipeline_layout_create_info.pSetLayouts = occlusion_cull_descriptor_set_layouts;
+	pipeline_layout_create_info.pushConstantRangeCount = 1;
+	pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+	err = vkCreatePipelineLayout (vulkan_globals.device, &pipeline_layout_create_info, NULL, &vulkan_globals.occlusion_cull_pipeline.layout.handle);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreatePipelineLayout failed");
+	GL_SetObjectName ((uint64_t)vulkan_globals.occlusion_cull_pipeline.layout.handle, VK_OBJECT_TYPE_PIPELINE_LAYOUT, "occlusion_cull_pipeline_layout");
+	vulkan_globals.occlusion_cull_pipeline.layout.push_constant_range = push_constant_range;
+
+	// Particle simulation
+	VkDescriptorSetLayout particle_update_descriptor_set_layouts[1] = {
+		vulkan_globals.particle_compute_set_layout.handle,
+	};
+
+	memset (&push_constant_range, 0, sizeof (push_constant_range));
+	push_constant_range.offset = 0;
+	push_constant_range.size = 1 * sizeof (uint32_t);
+	push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	pipeline_layout_create_info.setLayoutCount = 1;
+	pipeline_layout_create_info.pSetLayouts = particle_update_descriptor_set_layouts;
+	pipeline_layout_create_info.pushConstantRangeCount = 1;
+	pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+	err = vkCreatePipelineLayout (vulkan_globals.device, &pipeline_layout_create_info, NULL, &vulkan_globals.particle_update_pipeline.layout.handle);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreatePipelineLayout failed");
+	GL_SetObjectName ((uint64_t)vulkan_globals.particle_update_pipeline.layout.handle, VK_OBJECT_TYPE_PIPELINE_LAYOUT, "particle_update_pipeline_layout");
+	vulkan_globals.particle_update_pipeline.layout.push_constant_range = push_constant_range;
+
+	// World culling
+	VkDescriptorSetLayout world_cull_descriptor_set_layouts[1] = {
+		vulkan_globals.world_cull_set_layout.handle,
+	};
+
+	memset (&push_constant_range, 0, sizeof (push_constant_range));
+	push_constant_range.offset = 0;
+	push_constant_range.size = 20 * sizeof (float) + 2 * sizeof (uint32_t);
+	push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	pipeline_layout_create_info.setLayoutCount = 1;
+	pipeline_layout_create_info.pSetLayouts = world_cull_descriptor_set_layouts;
+	pipeline_layout_create_info.pushConstantRangeCount = 1;
+	pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+	err = vkCreatePipelineLayout (vulkan_globals.device, &pipeline_layout_create_info, NULL, &vulkan_globals.world_cull_pipeline.layout.handle);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreatePipelineLayout failed");
+	GL_SetObjectName ((uint64_t)vulkan_globals.world_cull_pipeline.layout.handle, VK_OBJECT_TYPE_PIPELINE_LAYOUT, "world_cull_pipeline_layout");
+	vulkan_globals.world_cull_pipeline.layout.push_constant_range = push_constant_range;
 }
 
 /*
@@ -1726,6 +2063,215 @@ void R_InitSamplers ()
 	TexMgr_UpdateTextureDescriptorSets ();
 }
 
+/*
+===============================================================================
+
+PIPELINE CACHE
+
+The cache is created once per device and kept across vid_restart. It is
+loaded from the user directory if it was written by the same device, driver
+and set of embedded shaders, and written back on a worker task whenever
+pipeline creation added to it.
+
+===============================================================================
+*/
+
+#define PIPELINE_CACHE_MAGIC   "VKPC"
+#define PIPELINE_CACHE_VERSION 1
+#define PIPELINE_CACHE_FILE    "pipelines.cache"
+
+typedef struct
+{
+	char     magic[4];
+	uint32_t version;
+	uint32_t vendor_id;
+	uint32_t device_id;
+	uint32_t driver_version;
+	uint8_t  uuid[VK_UUID_SIZE];
+	uint32_t spirv_hash;
+	uint32_t data_size;
+	uint32_t data_hash;
+} pipeline_cache_header_t;
+
+static uint32_t      pipeline_cache_spirv_hash;
+static size_t        pipeline_cache_saved_size;
+static task_handle_t pipeline_cache_save_task = INVALID_TASK_HANDLE;
+
+/*
+===============
+R_InitPipelineCacheHeader
+===============
+*/
+static void R_InitPipelineCacheHeader (pipeline_cache_header_t *header)
+{
+	memset (header, 0, sizeof (*header));
+	memcpy (header->magic, PIPELINE_CACHE_MAGIC, 4);
+	header->version = PIPELINE_CACHE_VERSION;
+	header->vendor_id = vulkan_globals.device_properties.vendorID;
+	header->device_id = vulkan_globals.device_properties.deviceID;
+	header->driver_version = vulkan_globals.device_properties.driverVersion;
+	memcpy (header->uuid, vulkan_globals.device_properties.pipelineCacheUUID, VK_UUID_SIZE);
+	header->spirv_hash = pipeline_cache_spirv_hash;
+}
+
+/*
+===============
+R_LoadPipelineCache
+
+Returns the cached data if the file matches this device and these shaders.
+===============
+*/
+static byte *R_LoadPipelineCache (size_t *size)
+{
+	pipeline_cache_header_t header, expected;
+	byte                   *data;
+	FILE                   *f;
+
+	f = fopen (va ("%s/%s", host_parms->userdir, PIPELINE_CACHE_FILE), "rb");
+	if (!f)
+		return NULL;
+
+	R_InitPipelineCacheHeader (&expected);
+	if (fread (&header, sizeof (header), 1, f) != 1 || memcmp (&header, &expected, offsetof (pipeline_cache_header_t, data_size)) != 0)
+	{
+		Con_DPrintf ("Pipeline cache is from a different device, driver or build\n");
+		fclose (f);
+		return NULL;
+	}
+
+	data = (byte *)Mem_Alloc (q_max (header.data_size, 1));
+	if (fread (data, header.data_size, 1, f) != 1 || COM_HashBlock (data, header.data_size) != header.data_hash)
+	{
+		Con_DPrintf ("Pipeline cache is corrupt\n");
+		Mem_Free (data);
+		fclose (f);
+		return NULL;
+	}
+
+	fclose (f);
+	*size = header.data_size;
+	return data;
+}
+
+/*
+===============
+R_SavePipelineCacheTask
+===============
+*/
+static void R_SavePipelineCacheTask (void *unused)
+{
+	pipeline_cache_header_t header;
+	char                    path[MAX_OSPATH];
+	char                    temppath[MAX_OSPATH];
+	size_t                  size = 0;
+	byte                   *data;
+	FILE                   *f;
+
+	if (vkGetPipelineCacheData (vulkan_globals.device, vulkan_globals.pipeline_cache, &size, NULL) != VK_SUCCESS || size == pipeline_cache_saved_size)
+		return;
+	data = (byte *)Mem_Alloc (size);
+	if (vkGetPipelineCacheData (vulkan_globals.device, vulkan_globals.pipeline_cache, &size, data) != VK_SUCCESS)
+	{
+		Mem_Free (data);
+		return;
+	}
+
+	R_InitPipelineCacheHeader (&header);
+	header.data_size = size;
+	header.data_hash = COM_HashBlock (data, size);
+
+	// write to a temporary file so a crash never leaves a truncated cache behind
+	q_snprintf (path, sizeof (path), "%s/%s", host_parms->userdir, PIPELINE_CACHE_FILE);
+	q_snprintf (temppath, sizeof (temppath), "%s.tmp", path);
+	f = fopen (temppath, "wb");
+	if (f)
+	{
+		qboolean ok = fwrite (&header, sizeof (header), 1, f) == 1 && fwrite (data, size, 1, f) == 1;
+		ok = (fclose (f) == 0) && ok;
+		remove (path);
+		if (ok && rename (temppath, path) == 0)
+			pipeline_cache_saved_size = size;
+		else
+			remove (temppath);
+	}
+
+	Mem_Free (data);
+}
+
+/*
+===============
+R_CreatePipelineCache
+===============
+*/
+static void R_CreatePipelineCache (void)
+{
+	VkPipelineCacheCreateInfo cache_create_info;
+	VkResult                  err;
+	size_t                    size = 0;
+	byte                     *data = NULL;
+
+	if (vulkan_globals.pipeline_cache != VK_NULL_HANDLE)
+		return;
+
+	if (!COM_CheckParm ("-nopipelinecache"))
+		data = R_LoadPipelineCache (&size);
+
+	memset (&cache_create_info, 0, sizeof (cache_create_info));
+	cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cache_create_info.initialDataSize = size;
+	cache_create_info.pInitialData = data;
+
+	err = vkCreatePipelineCache (vulkan_globals.device, &cache_create_info, NULL, &vulkan_globals.pipeline_cache);
+	if ((err != VK_SUCCESS) && data)
+	{
+		// the driver may still reject data that passed our own checks
+		cache_create_info.initialDataSize = 0;
+		cache_create_info.pInitialData = NULL;
+		size = 0;
+		err = vkCreatePipelineCache (vulkan_globals.device, &cache_create_info, NULL, &vulkan_globals.pipeline_cache);
+	}
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreatePipelineCache failed");
+
+	Con_DPrintf ("Pipeline cache: loaded %u bytes\n", (unsigned)size);
+	pipeline_cache_saved_size = size;
+	Mem_Free (data);
+}
+
+/*
+===============
+R_WaitPipelineCache
+
+Waits for a pending write of the pipeline cache.
+===============
+*/
+void R_WaitPipelineCache (void)
+{
+	if (pipeline_cache_save_task == INVALID_TASK_HANDLE)
+		return;
+	Task_Join (pipeline_cache_save_task, SDL_MUTEX_MAXWAIT);
+	pipeline_cache_save_task = INVALID_TASK_HANDLE;
+}
+
+/*
+===============
+R_DestroyPipelineCache
+
+Writes out what was added since the last save and destroys the cache.
+===============
+*/
+void R_DestroyPipelineCache (void)
+{
+	R_WaitPipelineCache ();
+	if (vulkan_globals.pipeline_cache == VK_NULL_HANDLE)
+		return;
+
+	if (!COM_CheckParm ("-nopipelinecache"))
+		R_SavePipelineCacheTask (NULL);
+	vkDestroyPipelineCache (vulkan_globals.device, vulkan_globals.pipeline_cache, NULL);
+	vulkan_globals.pipeline_cache = VK_NULL_HANDLE;
+}
+
 /*
 ===============
 R_CreateShaderModule
@@ -1746,6 +2292,7 @@ static VkShaderModule R_CreateShaderModule (const byte *code, const int size, co
 		Sys_Error ("vkCreateShaderModule failed");
 
 	GL_SetObjectName ((uint64_t)module, VK_OBJECT_TYPE_SHADER_MODULE, name);
+	pipeline_cache_spirv_hash = (pipeline_cache_spirv_hash * 0x01000193u) ^ COM_HashBlock (code, size);
 
 	return module;
 }
@@ -1771,8 +2318,8 @@ static VkVertexInputAttributeDescription basic_vertex_input_attribute_descriptio
 static VkVertexInputBindingDescription   basic_vertex_binding_description;
 static VkVertexInputAttributeDescription world_vertex_input_attribute_descriptions[3];
 static VkVertexInputBindingDescription   world_vertex_binding_description;
-static VkVertexInputAttributeDescription alias_vertex_input_attribute_descriptions[5];
-static VkVertexInputBindingDescription   alias_vertex_binding_descriptions[3];
+static VkVertexInputAttributeDescription alias_vertex_input_attribute_descriptions[12];
+static VkVertexInputBindingDescription   alias_vertex_binding_descriptions[4];
 
 #define DECLARE_SHADER_MODULE(name) static VkShaderModule name##_module
 #define CREATE_SHADER_MODULE(name)                                                 \
@@ -1799,9 +2346,13 @@ DECLARE_SHADER_MODULE (basic_alphatest_frag);
 DECLARE_SHADER_MODULE (basic_notex_frag);
 DECLARE_SHADER_MODULE (world_vert);
 DECLARE_SHADER_MODULE (world_frag);
+DECLARE_SHADER_MODULE (world_bindless_vert);
+DECLARE_SHADER_MODULE (world_bindless_frag);
 DECLARE_SHADER_MODULE (alias_vert);
 DECLARE_SHADER_MODULE (alias_frag);
 DECLARE_SHADER_MODULE (alias_alphatest_frag);
+DECLARE_SHADER_MODULE (alias_instanced_vert);
+DECLARE_SHADER_MODULE (alias_instanced_frag);
 DECLARE_SHADER_MODULE (sky_layer_vert);
 DECLARE_SHADER_MODULE (sky_layer_frag);
 DECLARE_SHADER_MODULE (sky_box_frag);
@@ -1817,6 +2368,11 @@ DECLARE_SHADER_MODULE (cs_tex_warp_comp);
 DECLARE_SHADER_MODULE (showtris_vert);
 DECLARE_SHADER_MODULE (showtris_frag);
 DECLARE_SHADER_MODULE (update_lightmap_comp);
+DECLARE_SHADER_MODULE (hiz_reduce_comp);
+DECLARE_SHADER_MODULE (hiz_reduce_ms_comp);
+DECLARE_SHADER_MODULE (occlusion_cull_comp);
+DECLARE_SHADER_MODULE (particle_update_comp);
+DECLARE_SHADER_MODULE (world_cull_comp);
 
 /*
 ===============
@@ -1889,6 +2445,23 @@ static void R_InitVertexAttributes ()
 	alias_vertex_binding_descriptions[2].binding = 2;
 	alias_vertex_binding_descriptions[2].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 	alias_vertex_binding_descriptions[2].stride = 8;
+
+	// per instance data of the instanced pipelines, laid out like the alias UBO
+	for (int i = 0; i < 6; ++i)
+	{
+		alias_vertex_input_attribute_descriptions[5 + i].binding = 3;
+		alias_vertex_input_attribute_descriptions[5 + i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+		alias_vertex_input_attribute_descriptions[5 + i].location = 5 + i;
+		alias_vertex_input_attribute_descriptions[5 + i].offset = i * 16;
+	}
+	alias_vertex_input_attribute_descriptions[11].binding = 3;
+	alias_vertex_input_attribute_descriptions[11].format = VK_FORMAT_R32_UINT;
+	alias_vertex_input_attribute_descriptions[11].location = 11;
+	alias_vertex_input_attribute_descriptions[11].offset = 96;
+
+	alias_vertex_binding_descriptions[3].binding = 3;
+	alias_vertex_binding_descriptions[3].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+	alias_vertex_binding_descriptions[3].stride = 100;
 }
 
 /*
@@ -2006,7 +2579,7 @@ static void R_CreateBasicPipelines ()
 
 		assert (vulkan_globals.basic_alphatest_pipeline[render_pass].handle == VK_NULL_HANDLE);
 		err = vkCreateGraphicsPipelines (
-			vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.basic_alphatest_pipeline[render_pass].handle);
+			vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.basic_alphatest_pipeline[render_pass].handle);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkCreateGraphicsPipelines failed");
 		vulkan_globals.basic_alphatest_pipeline[render_pass].layout = vulkan_globals.basic_pipeline_layout;
@@ -2023,7 +2596,7 @@ static void R_CreateBasicPipelines ()
 
 		assert (vulkan_globals.basic_notex_blend_pipeline[render_pass].handle == VK_NULL_HANDLE);
 		err = vkCreateGraphicsPipelines (
-			vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.basic_notex_blend_pipeline[render_pass].handle);
+			vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.basic_notex_blend_pipeline[render_pass].handle);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkCreateGraphicsPipelines failed");
 		vulkan_globals.basic_notex_blend_pipeline[render_pass].layout = vulkan_globals.basic_pipeline_layout;
@@ -2043,7 +2616,7 @@ static void R_CreateBasicPipelines ()
 
 		assert (vulkan_globals.basic_blend_pipeline[render_pass].handle == VK_NULL_HANDLE);
 		err = vkCreateGraphicsPipelines (
-			vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.basic_blend_pipeline[render_pass].handle);
+			vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.basic_blend_pipeline[render_pass].handle);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkCreateGraphicsPipelines failed");
 		vulkan_globals.basic_blend_pipeline[render_pass].layout = vulkan_globals.basic_pipeline_layout;
@@ -2075,7 +2648,7 @@ static void R_CreateWarpPipelines ()
 	infos.graphics_pipeline.renderPass = vulkan_globals.warp_render_pass;
 
 	assert (vulkan_globals.raster_tex_warp_pipeline.handle == VK_NULL_HANDLE);
-	err = vkCreateGraphicsPipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.raster_tex_warp_pipeline.handle);
+	err = vkCreateGraphicsPipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.raster_tex_warp_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateGraphicsPipelines failed (raster_tex_warp_pipeline)");
 	vulkan_globals.raster_tex_warp_pipeline.layout = vulkan_globals.basic_pipeline_layout;
@@ -2094,7 +2667,7 @@ static void R_CreateWarpPipelines ()
 	infos.compute_pipeline.layout = vulkan_globals.cs_tex_warp_pipeline.layout.handle;
 
 	assert (vulkan_globals.cs_tex_warp_pipeline.handle == VK_NULL_HANDLE);
-	err = vkCreateComputePipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.compute_pipeline, NULL, &vulkan_globals.cs_tex_warp_pipeline.handle);
+	err = vkCreateComputePipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.compute_pipeline, NULL, &vulkan_globals.cs_tex_warp_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateComputePipelines failed (cs_tex_warp_pipeline)");
 	GL_SetObjectName ((uint64_t)vulkan_globals.cs_tex_warp_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "cs_tex_warp");
@@ -2119,11 +2692,30 @@ static void R_CreateParticlesPipelines ()
 	infos.blend_attachment_state.blendEnable = VK_TRUE;
 
 	assert (vulkan_globals.particle_pipeline.handle == VK_NULL_HANDLE);
-	err = vkCreateGraphicsPipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.particle_pipeline.handle);
+	err = vkCreateGraphicsPipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.particle_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateGraphicsPipelines failed");
 	vulkan_globals.particle_pipeline.layout = vulkan_globals.basic_pipeline_layout;
 	GL_SetObjectName ((uint64_t)vulkan_globals.particle_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "particles");
+
+	VkPipelineShaderStageCreateInfo compute_shader_stage;
+	memset (&compute_shader_stage, 0, sizeof (compute_shader_stage));
+	compute_shader_stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	compute_shader_stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	compute_shader_stage.module = particle_update_comp_module;
+	compute_shader_stage.pName = "main";
+
+	memset (&infos.compute_pipeline, 0, sizeof (infos.compute_pipeline));
+	infos.compute_pipeline.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	infos.compute_pipeline.stage = compute_shader_stage;
+	infos.compute_pipeline.layout = vulkan_globals.particle_update_pipeline.layout.handle;
+
+	assert (vulkan_globals.particle_update_pipeline.handle == VK_NULL_HANDLE);
+	err = vkCreateComputePipelines (
+		vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.compute_pipeline, NULL, &vulkan_globals.particle_update_pipeline.handle);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreateComputePipelines failed (particle_update_pipeline)");
+	GL_SetObjectName ((uint64_t)vulkan_globals.particle_update_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "particle_update");
 }
 
 /*
@@ -2200,7 +2792,7 @@ static void R_CreateFTEParticlesPipelines ()
 
 		assert (vulkan_globals.fte_particle_pipelines[i].handle == VK_NULL_HANDLE);
 		err = vkCreateGraphicsPipelines (
-			vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.fte_particle_pipelines[i].handle);
+			vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.fte_particle_pipelines[i].handle);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkCreateGraphicsPipelines failed (fte_particle_pipelines[%d]", i);
 		vulkan_globals.fte_particle_pipelines[i].layout = vulkan_globals.basic_pipeline_layout;
@@ -2213,7 +2805,7 @@ static void R_CreateFTEParticlesPipelines ()
 
 			assert (vulkan_globals.fte_particle_pipelines[i + 8].handle == VK_NULL_HANDLE);
 			err = vkCreateGraphicsPipelines (
-				vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.fte_particle_pipelines[i + 8].handle);
+				vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.fte_particle_pipelines[i + 8].handle);
 			if (err != VK_SUCCESS)
 				Sys_Error ("vkCreateGraphicsPipelines failed (vulkan_globals.fte_particle_pipelines[%d])", i + 8);
 			vulkan_globals.fte_particle_pipelines[i + 8].layout = vulkan_globals.basic_pipeline_layout;
@@ -2243,7 +2835,7 @@ static void R_CreateSpritesPipelines ()
 	infos.dynamic_states[infos.dynamic_state.dynamicStateCount++] = VK_DYNAMIC_STATE_DEPTH_BIAS;
 
 	assert (vulkan_globals.sprite_pipeline.handle == VK_NULL_HANDLE);
-	err = vkCreateGraphicsPipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.sprite_pipeline.handle);
+	err = vkCreateGraphicsPipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.sprite_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateGraphicsPipelines failed (sprite_pipeline)");
 	vulkan_globals.sprite_pipeline.layout = vulkan_globals.basic_pipeline_layout;
@@ -2280,7 +2872,7 @@ static void R_CreateSkyPipelines ()
 	infos.blend_attachment_state.colorWriteMask = 0; // We only want to write stencil
 
 	assert (vulkan_globals.sky_stencil_pipeline.handle == VK_NULL_HANDLE);
-	err = vkCreateGraphicsPipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.sky_stencil_pipeline.handle);
+	err = vkCreateGraphicsPipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.sky_stencil_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateGraphicsPipelines failed (sky_stencil_pipeline)");
 	vulkan_globals.sky_stencil_pipeline.layout = vulkan_globals.basic_pipeline_layout;
@@ -2293,7 +2885,7 @@ static void R_CreateSkyPipelines ()
 	infos.shader_stages[1].module = basic_notex_frag_module;
 
 	assert (vulkan_globals.sky_color_pipeline.handle == VK_NULL_HANDLE);
-	err = vkCreateGraphicsPipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.sky_color_pipeline.handle);
+	err = vkCreateGraphicsPipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.sky_color_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateGraphicsPipelines failed (sky_color_pipeline)");
 	vulkan_globals.sky_color_pipeline.layout = vulkan_globals.basic_pipeline_layout;
@@ -2312,7 +2904,7 @@ static void R_CreateSkyPipelines ()
 	infos.shader_stages[1].module = sky_box_frag_module;
 
 	assert (vulkan_globals.sky_box_pipeline.handle == VK_NULL_HANDLE);
-	err = vkCreateGraphicsPipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.sky_box_pipeline.handle);
+	err = vkCreateGraphicsPipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.sky_box_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateGraphicsPipelines failed (sky_box_pipeline)");
 	GL_SetObjectName ((uint64_t)vulkan_globals.sky_box_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "sky_box");
@@ -2354,7 +2946,7 @@ static void R_CreateSkyPipelines ()
 	infos.graphics_pipeline.layout = vulkan_globals.sky_layer_pipeline.layout.handle;
 
 	assert (vulkan_globals.sky_layer_pipeline.handle == VK_NULL_HANDLE);
-	err = vkCreateGraphicsPipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.sky_layer_pipeline.handle);
+	err = vkCreateGraphicsPipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.sky_layer_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateGraphicsPipelines failed (sky_layer_pipeline)");
 	GL_SetObjectName ((uint64_t)vulkan_globals.sky_layer_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "sky_layer");
@@ -2401,7 +2993,7 @@ static void R_CreateShowTrisPipelines ()
 		infos.graphics_pipeline.layout = vulkan_globals.basic_pipeline_layout.handle;
 
 		assert (vulkan_globals.showtris_pipeline.handle == VK_NULL_HANDLE);
-		err = vkCreateGraphicsPipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.showtris_pipeline.handle);
+		err = vkCreateGraphicsPipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.showtris_pipeline.handle);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkCreateGraphicsPipelines failed (showtris_pipeline)");
 		vulkan_globals.showtris_pipeline.layout = vulkan_globals.basic_pipeline_layout;
@@ -2414,7 +3006,7 @@ static void R_CreateShowTrisPipelines ()
 
 		assert (vulkan_globals.showtris_depth_test_pipeline.handle == VK_NULL_HANDLE);
 		err = vkCreateGraphicsPipelines (
-			vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.showtris_depth_test_pipeline.handle);
+			vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.showtris_depth_test_pipeline.handle);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkCreateGraphicsPipelines failed (showtris_depth_test_pipeline)");
 		vulkan_globals.showtris_depth_test_pipeline.layout = vulkan_globals.basic_pipeline_layout;
@@ -2425,7 +3017,7 @@ static void R_CreateShowTrisPipelines ()
 		infos.rasterization_state.depthBiasEnable = VK_FALSE;
 		infos.input_assembly_state.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
 		assert (vulkan_globals.showbboxes_pipeline.handle == VK_NULL_HANDLE);
-		err = vkCreateGraphicsPipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.showbboxes_pipeline.handle);
+		err = vkCreateGraphicsPipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.showbboxes_pipeline.handle);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkCreateGraphicsPipelines failed (showtris_depth_test)");
 		vulkan_globals.showbboxes_pipeline.layout = vulkan_globals.basic_pipeline_layout;
@@ -2525,7 +3117,7 @@ static void R_CreateWorldPipelines ()
 
 					assert (vulkan_globals.world_pipelines[pipeline_index].handle == VK_NULL_HANDLE);
 					err = vkCreateGraphicsPipelines (
-						vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.world_pipelines[pipeline_index].handle);
+						vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.world_pipelines[pipeline_index].handle);
 					if (err != VK_SUCCESS)
 						Sys_Error ("vkCreateGraphicsPipelines failed (world_pipelines[%d])", pipeline_index);
 					GL_SetObjectName (
@@ -2535,6 +3127,61 @@ static void R_CreateWorldPipelines ()
 			}
 		}
 	}
+
+	if (vulkan_globals.bindless_textures)
+	{
+		// Opaque only, fullbrights are looked up per draw
+		infos.graphics_pipeline.layout = vulkan_globals.world_bindless_pipeline_layout.handle;
+		infos.graphics_pipeline.flags = 0;
+		infos.graphics_pipeline.basePipelineHandle = VK_NULL_HANDLE;
+		infos.shader_stages[0].module = world_bindless_vert_module;
+		infos.shader_stages[1].module = world_bindless_frag_module;
+		infos.blend_attachment_state.blendEnable = VK_FALSE;
+		infos.depth_stencil_state.depthWriteEnable = VK_TRUE;
+		specialization_data[0] = 0;
+		specialization_data[2] = 0;
+
+		for (alpha_test = 0; alpha_test < 2; ++alpha_test)
+		{
+			for (quantize_lm = 0; quantize_lm < 2; ++quantize_lm)
+			{
+				int pipeline_index = alpha_test + (quantize_lm * 2);
+
+				specialization_data[1] = alpha_test;
+				specialization_data[3] = quantize_lm;
+
+				assert (vulkan_globals.world_bindless_pipelines[pipeline_index].handle == VK_NULL_HANDLE);
+				err = vkCreateGraphicsPipelines (
+					vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL,
+					&vulkan_globals.world_bindless_pipelines[pipeline_index].handle);
+				if (err != VK_SUCCESS)
+					Sys_Error ("vkCreateGraphicsPipelines failed (world_bindless_pipelines[%d])", pipeline_index);
+				GL_SetObjectName (
+					(uint64_t)vulkan_globals.world_bindless_pipelines[pipeline_index].handle, VK_OBJECT_TYPE_PIPELINE,
+					va ("world bindless %d", pipeline_index));
+				vulkan_globals.world_bindless_pipelines[pipeline_index].layout = vulkan_globals.world_bindless_pipeline_layout;
+			}
+		}
+	}
+
+	VkPipelineShaderStageCreateInfo compute_shader_stage;
+	memset (&compute_shader_stage, 0, sizeof (compute_shader_stage));
+	compute_shader_stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	compute_shader_stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	compute_shader_stage.module = world_cull_comp_module;
+	compute_shader_stage.pName = "main";
+
+	memset (&infos.compute_pipeline, 0, sizeof (infos.compute_pipeline));
+	infos.compute_pipeline.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	infos.compute_pipeline.stage = compute_shader_stage;
+	infos.compute_pipeline.layout = vulkan_globals.world_cull_pipeline.layout.handle;
+
+	assert (vulkan_globals.world_cull_pipeline.handle == VK_NULL_HANDLE);
+	err = vkCreateComputePipelines (
+		vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.compute_pipeline, NULL, &vulkan_globals.world_cull_pipeline.handle);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreateComputePipelines failed (world_cull_pipeline)");
+	GL_SetObjectName ((uint64_t)vulkan_globals.world_cull_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "world_cull");
 }
 
 /*
@@ -2565,7 +3212,7 @@ static void R_CreateAliasPipelines ()
 	infos.graphics_pipeline.layout = vulkan_globals.alias_pipeline.layout.handle;
 
 	assert (vulkan_globals.alias_pipeline.handle == VK_NULL_HANDLE);
-	err = vkCreateGraphicsPipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.alias_pipeline.handle);
+	err = vkCreateGraphicsPipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.alias_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateGraphicsPipelines failed (alias_pipeline)");
 	GL_SetObjectName ((uint64_t)vulkan_globals.alias_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "alias");
@@ -2573,7 +3220,7 @@ static void R_CreateAliasPipelines ()
 	infos.shader_stages[1].module = alias_alphatest_frag_module;
 
 	assert (vulkan_globals.alias_alphatest_pipeline.handle == VK_NULL_HANDLE);
-	err = vkCreateGraphicsPipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.alias_alphatest_pipeline.handle);
+	err = vkCreateGraphicsPipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.alias_alphatest_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateGraphicsPipelines failed (alias_alphatest_pipeline)");
 	GL_SetObjectName ((uint64_t)vulkan_globals.alias_alphatest_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "alias_alphatest");
@@ -2584,7 +3231,7 @@ static void R_CreateAliasPipelines ()
 	infos.shader_stages[1].module = alias_frag_module;
 
 	assert (vulkan_globals.alias_blend_pipeline.handle == VK_NULL_HANDLE);
-	err = vkCreateGraphicsPipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.alias_blend_pipeline.handle);
+	err = vkCreateGraphicsPipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.alias_blend_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateGraphicsPipelines failed (alias_blend_pipeline)");
 	GL_SetObjectName ((uint64_t)vulkan_globals.alias_blend_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "alias_blend");
@@ -2594,12 +3241,52 @@ static void R_CreateAliasPipelines ()
 
 	assert (vulkan_globals.alias_alphatest_blend_pipeline.handle == VK_NULL_HANDLE);
 	err = vkCreateGraphicsPipelines (
-		vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.alias_alphatest_blend_pipeline.handle);
+		vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.alias_alphatest_blend_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateGraphicsPipelines failed");
 	GL_SetObjectName ((uint64_t)vulkan_globals.alias_alphatest_blend_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "alias_alphatest_blend");
 	vulkan_globals.alias_alphatest_blend_pipeline.layout = vulkan_globals.alias_pipeline.layout;
 
+	// opaque only, the per instance data replaces the UBO
+	VkSpecializationMapEntry specialization_entry;
+	specialization_entry.constantID = 0;
+	specialization_entry.offset = 0;
+	specialization_entry.size = 4;
+	uint32_t             specialization_data = 0; // alpha test
+	VkSpecializationInfo specialization_info;
+	specialization_info.mapEntryCount = 1;
+	specialization_info.pMapEntries = &specialization_entry;
+	specialization_info.dataSize = 4;
+	specialization_info.pData = &specialization_data;
+
+	infos.depth_stencil_state.depthWriteEnable = VK_TRUE;
+	infos.blend_attachment_state.blendEnable = VK_FALSE;
+	infos.vertex_input_state.vertexAttributeDescriptionCount = 12;
+	infos.vertex_input_state.vertexBindingDescriptionCount = 4;
+	infos.shader_stages[0].module = alias_instanced_vert_module;
+	infos.shader_stages[1].module = alias_instanced_frag_module;
+	infos.shader_stages[1].pSpecializationInfo = &specialization_info;
+
+	for (int alpha_test = 0; alpha_test < 2; ++alpha_test)
+	{
+		specialization_data = alpha_test;
+
+		assert (vulkan_globals.alias_instanced_pipelines[alpha_test].handle == VK_NULL_HANDLE);
+		err = vkCreateGraphicsPipelines (
+			vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL,
+			&vulkan_globals.alias_instanced_pipelines[alpha_test].handle);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkCreateGraphicsPipelines failed (alias_instanced_pipelines[%d])", alpha_test);
+		GL_SetObjectName (
+			(uint64_t)vulkan_globals.alias_instanced_pipelines[alpha_test].handle, VK_OBJECT_TYPE_PIPELINE,
+			alpha_test ? "alias_instanced_alphatest" : "alias_instanced");
+		vulkan_globals.alias_instanced_pipelines[alpha_test].layout = vulkan_globals.alias_pipeline.layout;
+	}
+
+	infos.vertex_input_state.vertexAttributeDescriptionCount = 5;
+	infos.vertex_input_state.vertexBindingDescriptionCount = 3;
+	infos.shader_stages[1].pSpecializationInfo = NULL;
+
 	if (vulkan_globals.non_solid_fill)
 	{
 		infos.rasterization_state.cullMode = VK_CULL_MODE_NONE;
@@ -2616,7 +3303,7 @@ static void R_CreateAliasPipelines ()
 
 		assert (vulkan_globals.alias_showtris_pipeline.handle == VK_NULL_HANDLE);
 		err = vkCreateGraphicsPipelines (
-			vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.alias_showtris_pipeline.handle);
+			vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.alias_showtris_pipeline.handle);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkCreateGraphicsPipelines failed");
 		GL_SetObjectName ((uint64_t)vulkan_globals.alias_showtris_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "alias_showtris");
@@ -2629,7 +3316,7 @@ static void R_CreateAliasPipelines ()
 
 		assert (vulkan_globals.alias_showtris_depth_test_pipeline.handle == VK_NULL_HANDLE);
 		err = vkCreateGraphicsPipelines (
-			vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.alias_showtris_depth_test_pipeline.handle);
+			vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.alias_showtris_depth_test_pipeline.handle);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkCreateGraphicsPipelines failed");
 		GL_SetObjectName ((uint64_t)vulkan_globals.alias_showtris_depth_test_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "alias_showtris_depth_test");
@@ -2669,7 +3356,7 @@ static void R_CreatePostprocessPipelines ()
 	infos.graphics_pipeline.subpass = 1;
 
 	assert (vulkan_globals.postprocess_pipeline.handle == VK_NULL_HANDLE);
-	err = vkCreateGraphicsPipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.postprocess_pipeline.handle);
+	err = vkCreateGraphicsPipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.graphics_pipeline, NULL, &vulkan_globals.postprocess_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateGraphicsPipelines failed (postprocess_pipeline)");
 	GL_SetObjectName ((uint64_t)vulkan_globals.postprocess_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "postprocess");
@@ -2700,7 +3387,7 @@ static void R_CreateScreenEffectsPipelines ()
 	infos.compute_pipeline.layout = vulkan_globals.screen_effects_pipeline.layout.handle;
 
 	assert (vulkan_globals.screen_effects_pipeline.handle == VK_NULL_HANDLE);
-	err = vkCreateComputePipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.compute_pipeline, NULL, &vulkan_globals.screen_effects_pipeline.handle);
+	err = vkCreateComputePipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.compute_pipeline, NULL, &vulkan_globals.screen_effects_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateComputePipelines failed (screen_effects_pipeline)");
 	GL_SetObjectName ((uint64_t)vulkan_globals.screen_effects_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "screen_effects");
@@ -2710,7 +3397,7 @@ static void R_CreateScreenEffectsPipelines ()
 	infos.compute_pipeline.stage = compute_shader_stage;
 	assert (vulkan_globals.screen_effects_scale_pipeline.handle == VK_NULL_HANDLE);
 	err = vkCreateComputePipelines (
-		vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.compute_pipeline, NULL, &vulkan_globals.screen_effects_scale_pipeline.handle);
+		vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.compute_pipeline, NULL, &vulkan_globals.screen_effects_scale_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateComputePipelines failed (screen_effects_scale_pipeline)");
 	GL_SetObjectName ((uint64_t)vulkan_globals.screen_effects_scale_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "screen_effects_scale");
@@ -2725,7 +3412,7 @@ static void R_CreateScreenEffectsPipelines ()
 		infos.compute_pipeline.stage = compute_shader_stage;
 		assert (vulkan_globals.screen_effects_scale_sops_pipeline.handle == VK_NULL_HANDLE);
 		err = vkCreateComputePipelines (
-			vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.compute_pipeline, NULL, &vulkan_globals.screen_effects_scale_sops_pipeline.handle);
+			vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.compute_pipeline, NULL, &vulkan_globals.screen_effects_scale_sops_pipeline.handle);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkCreateComputePipelines failed (screen_effects_scale_sops_pipeline)");
 		GL_SetObjectName ((uint64_t)vulkan_globals.screen_effects_scale_sops_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "screen_effects_scale_sops");
@@ -2770,12 +3457,64 @@ static void R_CreateUpdateLightmapPipelines ()
 	infos.compute_pipeline.layout = vulkan_globals.update_lightmap_pipeline.layout.handle;
 
 	assert (vulkan_globals.update_lightmap_pipeline.handle == VK_NULL_HANDLE);
-	err = vkCreateComputePipelines (vulkan_globals.device, VK_NULL_HANDLE, 1, &infos.compute_pipeline, NULL, &vulkan_globals.update_lightmap_pipeline.handle);
+	err = vkCreateComputePipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.compute_pipeline, NULL, &vulkan_globals.update_lightmap_pipeline.handle);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateComputePipelines failed (update_lightmap_pipeline)");
 	GL_SetObjectName ((uint64_t)vulkan_globals.update_lightmap_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "update_lightmap");
 }
 
+/*
+===============
+R_CreateOcclusionCullPipelines
+===============
+*/
+static void R_CreateOcclusionCullPipelines ()
+{
+	VkResult                err;
+	pipeline_create_infos_t infos;
+	R_InitDefaultStates (&infos);
+
+	VkPipelineShaderStageCreateInfo compute_shader_stage;
+	memset (&compute_shader_stage, 0, sizeof (compute_shader_stage));
+	compute_shader_stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	compute_shader_stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	compute_shader_stage.module = hiz_reduce_comp_module;
+	compute_shader_stage.pName = "main";
+
+	memset (&infos.compute_pipeline, 0, sizeof (infos.compute_pipeline));
+	infos.compute_pipeline.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	infos.compute_pipeline.stage = compute_shader_stage;
+	infos.compute_pipeline.layout = vulkan_globals.hiz_reduce_pipeline.layout.handle;
+
+	assert (vulkan_globals.hiz_reduce_pipeline.handle == VK_NULL_HANDLE);
+	err = vkCreateComputePipelines (vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.compute_pipeline, NULL, &vulkan_globals.hiz_reduce_pipeline.handle);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreateComputePipelines failed (hiz_reduce_pipeline)");
+	GL_SetObjectName ((uint64_t)vulkan_globals.hiz_reduce_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "hiz_reduce");
+
+	compute_shader_stage.module = hiz_reduce_ms_comp_module;
+	infos.compute_pipeline.stage = compute_shader_stage;
+	infos.compute_pipeline.layout = vulkan_globals.hiz_reduce_ms_pipeline.layout.handle;
+
+	assert (vulkan_globals.hiz_reduce_ms_pipeline.handle == VK_NULL_HANDLE);
+	err = vkCreateComputePipelines (
+		vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.compute_pipeline, NULL, &vulkan_globals.hiz_reduce_ms_pipeline.handle);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreateComputePipelines failed (hiz_reduce_ms_pipeline)");
+	GL_SetObjectName ((uint64_t)vulkan_globals.hiz_reduce_ms_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "hiz_reduce_ms");
+
+	compute_shader_stage.module = occlusion_cull_comp_module;
+	infos.compute_pipeline.stage = compute_shader_stage;
+	infos.compute_pipeline.layout = vulkan_globals.occlusion_cull_pipeline.layout.handle;
+
+	assert (vulkan_globals.occlusion_cull_pipeline.handle == VK_NULL_HANDLE);
+	err = vkCreateComputePipelines (
+		vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &infos.compute_pipeline, NULL, &vulkan_globals.occlusion_cull_pipeline.handle);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreateComputePipelines failed (occlusion_cull_pipeline)");
+	GL_SetObjectName ((uint64_t)vulkan_globals.occlusion_cull_pipeline.handle, VK_OBJECT_TYPE_PIPELINE, "occlusion_cull");
+}
+
 /*
 ===============
 R_CreateShaderModules
@@ -2789,9 +3528,13 @@ static void R_CreateShaderModules ()
 	CREATE_SHADER_MODULE (basic_notex_frag);
 	CREATE_SHADER_MODULE (world_vert);
 	CREATE_SHADER_MODULE (world_frag);
+	CREATE_SHADER_MODULE_COND (world_bindless_vert, vulkan_globals.bindless_textures);
+	CREATE_SHADER_MODULE_COND (world_bindless_frag, vulkan_globals.bindless_textures);
 	CREATE_SHADER_MODULE (alias_vert);
 	CREATE_SHADER_MODULE (alias_frag);
 	CREATE_SHADER_MODULE (alias_alphatest_frag);
+	CREATE_SHADER_MODULE (alias_instanced_vert);
+	CREATE_SHADER_MODULE (alias_instanced_frag);
 	CREATE_SHADER_MODULE (sky_layer_vert);
 	CREATE_SHADER_MODULE (sky_layer_frag);
 	CREATE_SHADER_MODULE (sky_box_frag);
@@ -2807,6 +3550,11 @@ static void R_CreateShaderModules ()
 	CREATE_SHADER_MODULE (showtris_vert);
 	CREATE_SHADER_MODULE (showtris_frag);
 	CREATE_SHADER_MODULE (update_lightmap_comp);
+	CREATE_SHADER_MODULE (hiz_reduce_comp);
+	CREATE_SHADER_MODULE (hiz_reduce_ms_comp);
+	CREATE_SHADER_MODULE (occlusion_cull_comp);
+	CREATE_SHADER_MODULE (particle_update_comp);
+	CREATE_SHADER_MODULE (world_cull_comp);
 }
 
 /*
@@ -2822,9 +3570,13 @@ static void R_DestroyShaderModules ()
 	DESTROY_SHADER_MODULE (basic_notex_frag);
 	DESTROY_SHADER_MODULE (world_vert);
 	DESTROY_SHADER_MODULE (world_frag);
+	DESTROY_SHADER_MODULE (world_bindless_vert);
+	DESTROY_SHADER_MODULE (world_bindless_frag);
 	DESTROY_SHADER_MODULE (alias_vert);
 	DESTROY_SHADER_MODULE (alias_frag);
 	DESTROY_SHADER_MODULE (alias_alphatest_frag);
+	DESTROY_SHADER_MODULE (alias_instanced_vert);
+	DESTROY_SHADER_MODULE (alias_instanced_frag);
 	DESTROY_SHADER_MODULE (sky_layer_vert);
 	DESTROY_SHADER_MODULE (sky_layer_frag);
 	DESTROY_SHADER_MODULE (sky_box_frag);
@@ -2840,6 +3592,29 @@ static void R_DestroyShaderModules ()
 	DESTROY_SHADER_MODULE (showtris_vert);
 	DESTROY_SHADER_MODULE (showtris_frag);
 	DESTROY_SHADER_MODULE (update_lightmap_comp);
+	DESTROY_SHADER_MODULE (hiz_reduce_comp);
+	DESTROY_SHADER_MODULE (hiz_reduce_ms_comp);
+	DESTROY_SHADER_MODULE (occlusion_cull_comp);
+	DESTROY_SHADER_MODULE (particle_update_comp);
+	DESTROY_SHADER_MODULE (world_cull_comp);
+}
+
+// each group only writes its own pipelines, so they can be compiled concurrently
+static void (*const pipeline_create_funcs[]) (void) = {
+	R_CreateWorldPipelines,     R_CreateAliasPipelines,       R_CreateFTEParticlesPipelines,  R_CreateBasicPipelines,
+	R_CreateSkyPipelines,       R_CreateShowTrisPipelines,    R_CreateScreenEffectsPipelines, R_CreateWarpPipelines,
+	R_CreateParticlesPipelines, R_CreateSpritesPipelines,     R_CreatePostprocessPipelines,   R_CreateUpdateLightmapPipelines,
+	R_CreateOcclusionCullPipelines,
+};
+
+/*
+===============
+R_CreatePipelinesTask
+===============
+*/
+static void R_CreatePipelinesTask (int index, void *unused)
+{
+	pipeline_create_funcs[index]();
 }
 
 /*
@@ -2849,25 +3624,26 @@ R_CreatePipelines
 */
 void R_CreatePipelines ()
 {
+	double        start;
+	task_handle_t create_task;
+
 	Sys_Printf ("Creating pipelines\n");
+	start = Sys_DoubleTime ();
 
+	R_WaitPipelineCache ();
+	pipeline_cache_spirv_hash = 0;
 	R_CreateShaderModules ();
+	R_CreatePipelineCache ();
 	R_InitVertexAttributes ();
 
-	R_CreateBasicPipelines ();
-	R_CreateWarpPipelines ();
-	R_CreateParticlesPipelines ();
-	R_CreateFTEParticlesPipelines ();
-	R_CreateSpritesPipelines ();
-	R_CreateSkyPipelines ();
-	R_CreateShowTrisPipelines ();
-	R_CreateWorldPipelines ();
-	R_CreateAliasPipelines ();
-	R_CreatePostprocessPipelines ();
-	R_CreateScreenEffectsPipelines ();
-	R_CreateUpdateLightmapPipelines ();
+	create_task = Task_AllocateAssignIndexedFuncAndSubmit (R_CreatePipelinesTask, countof (pipeline_create_funcs), NULL, 0);
+	Task_Join (create_task, SDL_MUTEX_MAXWAIT);
 
 	R_DestroyShaderModules ();
+	Con_DPrintf ("Created pipelines in %.1f ms\n", (Sys_DoubleTime () - start) * 1000.0);
+
+	if (!COM_CheckParm ("-nopipelinecache"))
+		pipeline_cache_save_task = Task_AllocateAssignFuncAndSubmit (R_SavePipelineCacheTask, NULL, 0);
 }
 
 /*
@@ -2892,10 +3668,19 @@ void R_DestroyPipelines (void)
 		vkDestroyPipeline (vulkan_globals.device, vulkan_globals.world_pipelines[i].handle, NULL);
 		vulkan_globals.world_pipelines[i].handle = VK_NULL_HANDLE;
 	}
+	for (i = 0; i < WORLD_BINDLESS_PIPELINE_COUNT; ++i)
+	{
+		vkDestroyPipeline (vulkan_globals.device, vulkan_globals.world_bindless_pipelines[i].handle, NULL);
+		vulkan_globals.world_bindless_pipelines[i].handle = VK_NULL_HANDLE;
+	}
+	vkDestroyPipeline (vulkan_globals.device, vulkan_globals.world_cull_pipeline.handle, NULL);
+	vulkan_globals.world_cull_pipeline.handle = VK_NULL_HANDLE;
 	vkDestroyPipeline (vulkan_globals.device, vulkan_globals.raster_tex_warp_pipeline.handle, NULL);
 	vulkan_globals.raster_tex_warp_pipeline.handle = VK_NULL_HANDLE;
 	vkDestroyPipeline (vulkan_globals.device, vulkan_globals.particle_pipeline.handle, NULL);
 	vulkan_globals.particle_pipeline.handle = VK_NULL_HANDLE;
+	vkDestroyPipeline (vulkan_globals.device, vulkan_globals.particle_update_pipeline.handle, NULL);
+	vulkan_globals.particle_update_pipeline.handle = VK_NULL_HANDLE;
 #ifdef PSET_SCRIPT
 	for (i = 0; i < 8; ++i)
 	{
@@ -2924,6 +3709,11 @@ void R_DestroyPipelines (void)
 	vulkan_globals.alias_alphatest_pipeline.handle = VK_NULL_HANDLE;
 	vkDestroyPipeline (vulkan_globals.device, vulkan_globals.alias_alphatest_blend_pipeline.handle, NULL);
 	vulkan_globals.alias_alphatest_blend_pipeline.handle = VK_NULL_HANDLE;
+	for (i = 0; i < 2; ++i)
+	{
+		vkDestroyPipeline (vulkan_globals.device, vulkan_globals.alias_instanced_pipelines[i].handle, NULL);
+		vulkan_globals.alias_instanced_pipelines[i].handle = VK_NULL_HANDLE;
+	}
 	vkDestroyPipeline (vulkan_globals.device, vulkan_globals.alias_blend_pipeline.handle, NULL);
 	vulkan_globals.alias_blend_pipeline.handle = VK_NULL_HANDLE;
 	vkDestroyPipeline (vulkan_globals.device, vulkan_globals.postprocess_pipeline.handle, NULL);
@@ -2957,6 +3747,12 @@ void R_DestroyPipelines (void)
 	}
 	vkDestroyPipeline (vulkan_globals.device, vulkan_globals.update_lightmap_pipeline.handle, NULL);
 	vulkan_globals.update_lightmap_pipeline.handle = VK_NULL_HANDLE;
+	vkDestroyPipeline (vulkan_globals.device, vulkan_globals.hiz_reduce_pipeline.handle, NULL);
+	vulkan_globals.hiz_reduce_pipeline.handle = VK_NULL_HANDLE;
+	vkDestroyPipeline (vulkan_globals.device, vulkan_globals.hiz_reduce_ms_pipeline.handle, NULL);
+	vulkan_globals.hiz_reduce_ms_pipeline.handle = VK_NULL_HANDLE;
+	vkDestroyPipeline (vulkan_globals.device, vulkan_globals.occlusion_cull_pipeline.handle, NULL);
+	vulkan_globals.occlusion_cull_pipeline.handle = VK_NULL_HANDLE;
 }
 
 /*
@@ -3035,7 +3831,12 @@ void R_Init (void)
 
 	Cvar_RegisterVariable (&r_gpulightmapupdate);
 	Cvar_RegisterVariable (&r_tasks);
+	Cvar_RegisterVariable (&r_occlusioncull);
+	Cvar_RegisterVariable (&r_aliasinstancing);
 	Cvar_RegisterVariable (&r_parallelmark);
+	Cvar_RegisterVariable (&r_drawindirect);
+	Cvar_RegisterVariable (&r_gpuworldcull);
+	Cvar_RegisterVariable (&r_bindless);
 	Cvar_RegisterVariable (&r_usesops);
 
 	R_InitParticles ();
@@ -3045,6 +3846,7 @@ void R_Init (void)
 	Fog_Init (); // johnfitz
 
 	R_AllocateLightmapComputeBuffers ();
+	R_InitOcclusionCulling ();
 
 	staging_mutex = SDL_CreateMutex ();
 }
@@ -3126,6 +3928,9 @@ void R_TranslateNewPlayerSkin (int playernum)
 	aliashdr_t *paliashdr;
 	int         skinnum;
 
+	if (isDedicated)
+		return; // headless demo analysis, no textures
+
 	// get correct texture pixels
 	entity_t *currententity = &cl.entities[1 + playernum];
 
@@ -3242,15 +4047,22 @@ void R_NewMap (void)
 		cl.worldmodel->leafs[i].efrags = NULL;
 
 	r_viewleaf = NULL;
+	R_InvalidateMarkSurfacesCache ();
 	R_ClearParticles ();
 #ifdef PSET_SCRIPT
 	PScript_ClearParticles (true);
 #endif
+
+	if (isDedicated)
+		return; // headless demo analysis, no renderer
+
 	GL_DeleteBModelVertexBuffer ();
+	R_DeleteWorldCull ();
 
 	GL_BuildLightmaps ();
 	GL_BuildBModelVertexBuffer ();
 	GL_PrepareSIMDData ();
+	R_BuildWorldCull ();
 	// ericw -- no longer load alias models into a VBO here, it's done in Mod_LoadAliasModel
 
 	r_framecount = 0;    // johnfitz -- paranoid?
@@ -227,9 +227,8 @@ Sky_LoadSkyBox
 const char *suf[6] = {"rt", "bk", "lf", "ft", "up", "dn"};
 void        Sky_LoadSkyBox (const char *name)
 {
-	int      i, width, height;
+	int      i;
 	char     filename[MAX_OSPATH];
-	byte    *data;
 	qboolean nonefound = true;
 
 	if (strcmp (skybox_name, name) == 0)
@@ -254,13 +253,9 @@ void        Sky_LoadSkyBox (const char *name)
 	for (i = 0; i < 6; i++)
 	{
 		q_snprintf (filename, sizeof (filename), "gfx/env/%s%s", name, suf[i]);
-		data = Image_LoadImage (filename, &width, &height);
-		if (data)
-		{
-			skybox_textures[i] = TexMgr_LoadImage (cl.worldmodel, filename, width, height, SRC_RGBA, data, filename, 0, TEXPREF_NONE);
+		skybox_textures[i] = TexMgr_LoadImageFile (cl.worldmodel, filename, TEXPREF_NONE);
+		if (skybox_textures[i])
 			nonefound = false;
-			Mem_Free (data);
-		}
 		else
 		{
 			Con_Printf ("Couldn't load %s\n", filename);
@@ -830,7 +825,7 @@ void Sky_DrawSkyBox (cb_context_t *cbx, int *skypolys)
 
 		vkCmdBindVertexBuffers (cbx->cb, 0, 1, &buffer, &buffer_offset);
 		R_BindPipeline (cbx, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.sky_box_pipeline);
-		vkCmdDrawIndexed (cbx->cb, 6, 1, 0, 0, 0);
+		vulkan_globals.vk_cmd_draw_indexed (cbx->cb, 6, 1, 0, 0, 0);
 
 		++(*skypolys);
 	}
@@ -921,7 +916,7 @@ void Sky_DrawFaceQuad (cb_context_t *cbx, glpoly_t *p, float alpha)
 	}
 
 	vkCmdBindVertexBuffers (cbx->cb, 0, 1, &vertex_buffer, &vertex_buffer_offset);
-	vkCmdDrawIndexed (cbx->cb, 6, 1, 0, 0, 0);
+	vulkan_globals.vk_cmd_draw_indexed (cbx->cb, 6, 1, 0, 0, 0);
 }
 
 /*
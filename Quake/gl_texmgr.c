@@ -25,6 +25,12 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 #include "gl_heap.h"
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <dirent.h>
+#else
+#include <windows.h>
+#endif
 
 #if defined(SDL_FRAMEWORK) || defined(NO_SDL_CONFIG)
 #include <SDL2/SDL.h>
@@ -50,6 +56,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 static cvar_t gl_max_size = {"gl_max_size", "0", CVAR_NONE};
 static cvar_t gl_picmip = {"gl_picmip", "0", CVAR_NONE};
+static cvar_t gl_gpumipmaps = {"gl_gpumipmaps", "1", CVAR_NONE};
+static cvar_t gl_texturecache = {"gl_texturecache", "1", CVAR_ARCHIVE};
+static cvar_t gl_texturecache_size = {"gl_texturecache_size", "512", CVAR_ARCHIVE}; // megabytes
 
 extern cvar_t vid_filter;
 extern cvar_t vid_anisotropic;
@@ -57,6 +66,7 @@ extern cvar_t vid_anisotropic;
 #define MAX_MIPS 16
 static int          numgltextures;
 static gltexture_t *active_gltextures, *free_gltextures;
+static gltexture_t *gltexture_slots; // MAX_GLTEXTURES, a slot is the element of its texture in the bindless set
 gltexture_t        *notexture, *nulltexture, *whitetexture, *greytexture, *greylightmap, *bluenoisetexture;
 
 unsigned int d_8to24table[256];
@@ -76,6 +86,47 @@ static int        num_texmgr_heaps;
 
 SDL_mutex *texmgr_mutex;
 
+// (owner, name) index for TexMgr_FindTexture. Buckets are guarded by striped locks
+// instead of texmgr_mutex, which is held during image creation.
+#define TEXTURE_HASH_SIZE  4096
+#define TEXTURE_HASH_LOCKS 64
+
+static gltexture_t *texture_hash[TEXTURE_HASH_SIZE];
+static SDL_mutex   *texture_hash_locks[TEXTURE_HASH_LOCKS];
+
+// Texture cache
+#define TEXCACHE_DIR        "texcache"
+#define TEXCACHE_MAGIC      "VKTC"
+#define TEXCACHE_VERSION    2
+#define TEXCACHE_MIN_PIXELS (64 * 64) // smaller images aren't worth a file
+
+typedef struct
+{
+	uint64_t source_hash;   // source pixels, or location and version of the file they are decoded from
+	uint64_t params_hash;   // everything else that changes the processed result
+	uint32_t source_size;   // bytes of source pixels or of the file
+	uint32_t source_width;  // zero for a file that hasn't been decoded yet
+	uint32_t source_height;
+} texcachekey_t;
+
+typedef struct
+{
+	char     name[MAX_QPATH];
+	uint64_t size;
+	int64_t  mtime;
+} texcachefile_t;
+
+static uint32_t         texcache_palette_hash;
+static atomic_uint32_t  texcache_lookups;
+static atomic_uint32_t  texcache_hits;
+static atomic_uint64_t  texcache_bytes_read;
+static atomic_uint64_t  texcache_bytes_saved;
+static atomic_uint64_t  texcache_bytes_written;
+static atomic_uint64_t  texcache_total_bytes; // size of the cache directory once measured
+static atomic_uint32_t  texcache_measured;
+static atomic_uint32_t  texcache_trimming;
+static void             TexMgr_TextureCache_f (void);
+
 static byte bluenoise_data[4096] = {
 	0x27, 0x62, 0x08, 0x4C, 0xDE, 0xBA, 0x05, 0xEF, 0x2A, 0xA1, 0xF7, 0x4A, 0x5F, 0x29, 0xE8, 0x34, 0xA9, 0xCB, 0x40, 0x60, 0xD5, 0x87, 0x70, 0xD0, 0x61, 0x8A,
 	0xDF, 0xB2, 0xD8, 0xFA, 0x07, 0x74, 0x31, 0x56, 0x1A, 0x4B, 0xAA, 0x36, 0xD4, 0x16, 0x95, 0x2F, 0x68, 0x8E, 0x77, 0x25, 0x49, 0xE3, 0x12, 0x6C, 0x9F, 0xD7,
@@ -278,6 +329,26 @@ static void TexMgr_SetFilterModes (gltexture_t *glt)
 	texture_write.pImageInfo = &image_info;
 
 	vkUpdateDescriptorSets (vulkan_globals.device, 1, &texture_write, 0, NULL);
+
+	if (vulkan_globals.bindless_textures_desc_set != VK_NULL_HANDLE)
+	{
+		// textures are created from worker threads and all of them share the bindless set
+		texture_write.dstSet = vulkan_globals.bindless_textures_desc_set;
+		texture_write.dstArrayElement = TexMgr_BindlessIndex (glt);
+		SDL_LockMutex (texmgr_mutex);
+		vkUpdateDescriptorSets (vulkan_globals.device, 1, &texture_write, 0, NULL);
+		SDL_UnlockMutex (texmgr_mutex);
+	}
+}
+
+/*
+===============
+TexMgr_BindlessIndex
+===============
+*/
+uint32_t TexMgr_BindlessIndex (gltexture_t *glt)
+{
+	return glt - gltexture_slots;
 }
 
 /*
@@ -325,6 +396,17 @@ static void TexMgr_Imagelist_f (void)
 ================================================================================
 */
 
+/*
+================
+TexMgr_HashName
+================
+*/
+static unsigned TexMgr_HashName (qmodel_t *owner, const char *name)
+{
+	const uintptr_t owner_bits = (uintptr_t)owner;
+	return (COM_HashString (name) ^ (unsigned)(owner_bits >> 4) ^ (unsigned)((uint64_t)owner_bits >> 32)) & (TEXTURE_HASH_SIZE - 1);
+}
+
 /*
 ================
 TexMgr_FindTexture
@@ -332,23 +414,65 @@ TexMgr_FindTexture
 */
 gltexture_t *TexMgr_FindTexture (qmodel_t *owner, const char *name)
 {
-	SDL_LockMutex (texmgr_mutex);
-	gltexture_t *glt = NULL;
+	gltexture_t *glt;
+
+	if (!name)
+		return NULL;
 
-	if (name)
+	const unsigned bucket = TexMgr_HashName (owner, name);
+	SDL_LockMutex (texture_hash_locks[bucket % TEXTURE_HASH_LOCKS]);
+	for (glt = texture_hash[bucket]; glt; glt = glt->hash_next)
 	{
-		for (glt = active_gltextures; glt; glt = glt->next)
-		{
-			if (glt->owner == owner && !strcmp (glt->name, name))
-				goto unlock_mutex;
-		}
+		if (glt->owner == owner && !strcmp (glt->name, name))
+			break;
 	}
+	SDL_UnlockMutex (texture_hash_locks[bucket % TEXTURE_HASH_LOCKS]);
 
-unlock_mutex:
-	SDL_UnlockMutex (texmgr_mutex);
 	return glt;
 }
 
+/*
+================
+TexMgr_UnlinkName
+================
+*/
+static void TexMgr_UnlinkName (gltexture_t *glt)
+{
+	if (!glt->hash_pprev)
+		return;
+
+	const unsigned bucket = TexMgr_HashName (glt->owner, glt->name);
+	SDL_LockMutex (texture_hash_locks[bucket % TEXTURE_HASH_LOCKS]);
+	*glt->hash_pprev = glt->hash_next;
+	if (glt->hash_next)
+		glt->hash_next->hash_pprev = glt->hash_pprev;
+	glt->hash_next = NULL;
+	glt->hash_pprev = NULL;
+	SDL_UnlockMutex (texture_hash_locks[bucket % TEXTURE_HASH_LOCKS]);
+}
+
+/*
+================
+TexMgr_SetName -- the only place owner and name change, keeps the index in sync
+================
+*/
+static void TexMgr_SetName (gltexture_t *glt, qmodel_t *owner, const char *name)
+{
+	TexMgr_UnlinkName (glt);
+
+	glt->owner = owner;
+	q_strlcpy (glt->name, name, sizeof (glt->name));
+
+	const unsigned bucket = TexMgr_HashName (owner, glt->name);
+	SDL_LockMutex (texture_hash_locks[bucket % TEXTURE_HASH_LOCKS]);
+	glt->hash_next = texture_hash[bucket];
+	if (glt->hash_next)
+		glt->hash_next->hash_pprev = &glt->hash_next;
+	glt->hash_pprev = &texture_hash[bucket];
+	texture_hash[bucket] = glt;
+	SDL_UnlockMutex (texture_hash_locks[bucket % TEXTURE_HASH_LOCKS]);
+}
+
 /*
 ================
 TexMgr_NewTexture
@@ -387,6 +511,8 @@ void TexMgr_FreeTexture (gltexture_t *kill)
 		goto unlock_mutex;
 	}
 
+	TexMgr_UnlinkName (kill);
+
 	if (active_gltextures == kill)
 	{
 		active_gltextures = kill->next;
@@ -557,6 +683,8 @@ void TexMgr_LoadPalette (void)
 	// conchars palette, 0 and 255 are transparent
 	memcpy (d_8to24table_conchars, d_8to24table, 256 * 4);
 	((byte *)&d_8to24table_conchars[0])[3] = 0;
+
+	texcache_palette_hash = COM_HashBlock (d_8to24table, sizeof (d_8to24table));
 }
 
 /*
@@ -587,9 +715,12 @@ void TexMgr_Init (void)
 	extern texture_t *r_notexture_mip, *r_notexture_mip2;
 
 	texmgr_mutex = SDL_CreateMutex ();
+	for (i = 0; i < TEXTURE_HASH_LOCKS; i++)
+		texture_hash_locks[i] = SDL_CreateMutex ();
 
 	// init texture list
 	free_gltextures = (gltexture_t *)Mem_Alloc (MAX_GLTEXTURES * sizeof (gltexture_t));
+	gltexture_slots = free_gltextures;
 	active_gltextures = NULL;
 	for (i = 0; i < MAX_GLTEXTURES - 1; i++)
 		free_gltextures[i].next = &free_gltextures[i + 1];
@@ -601,7 +732,13 @@ void TexMgr_Init (void)
 
 	Cvar_RegisterVariable (&gl_max_size);
 	Cvar_RegisterVariable (&gl_picmip);
+	Cvar_RegisterVariable (&gl_gpumipmaps);
+	Cvar_RegisterVariable (&gl_texturecache);
+	Cvar_RegisterVariable (&gl_texturecache_size);
 	Cmd_AddCommand ("imagelist", &TexMgr_Imagelist_f);
+	Cmd_AddCommand ("texcache", &TexMgr_TextureCache_f);
+	if (!isDedicated)
+		Sys_mkdir (va ("%s/" TEXCACHE_DIR, host_parms->userdir));
 
 	// load notexture images
 	notexture = TexMgr_LoadImage (
@@ -827,64 +964,43 @@ static void TexMgr_PreMultiply32 (byte *in, size_t width, size_t height)
 
 /*
 ================
-TexMgr_LoadImage32 -- handles 32bit source data
+TexMgr_CreateImageView
 ================
 */
-static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
+static VkImageView TexMgr_CreateImageView (gltexture_t *glt, VkFormat format, int num_mips)
 {
-	GL_DeleteTexture (glt);
-
-	// do this before any rescaling
-	if (glt->flags & TEXPREF_PREMULTIPLY)
-		TexMgr_PreMultiply32 ((byte *)data, glt->width, glt->height);
-
-	// mipmap down
-	int picmip = (glt->flags & TEXPREF_NOPICMIP) ? 0 : q_max ((int)gl_picmip.value, 0);
-	int mipwidth = q_max (glt->width >> picmip, 1);
-	int mipheight = q_max (glt->height >> picmip, 1);
-
-	int maxsize = (int)vulkan_globals.device_properties.limits.maxImageDimension2D;
-	if ((mipwidth > maxsize) || (mipheight > maxsize))
-	{
-		if (mipwidth >= mipheight)
-		{
-			mipheight = q_max ((mipheight * maxsize) / mipwidth, 1);
-			mipwidth = maxsize;
-		}
-		else
-		{
-			mipwidth = q_max ((mipwidth * maxsize) / mipheight, 1);
-			mipheight = maxsize;
-		}
-	}
-
-	if ((int)glt->width != mipwidth || (int)glt->height != mipheight)
-	{
-		TexMgr_Downsample (data, glt->width, glt->height, mipwidth, mipheight);
-		glt->width = mipwidth;
-		glt->height = mipheight;
-		if (glt->flags & TEXPREF_ALPHA)
-			TexMgr_AlphaEdgeFix ((byte *)data, glt->width, glt->height);
-	}
-	int num_mips = (glt->flags & TEXPREF_MIPMAP) ? TexMgr_DeriveNumMips (glt->width, glt->height) : 1;
-
-	SDL_LockMutex (texmgr_mutex);
-	const qboolean warp_image = (glt->flags & TEXPREF_WARPIMAGE);
-	if (warp_image)
-		num_mips = WARPIMAGEMIPS;
-
-	// Check for sanity. This should never be reached.
-	if (num_mips > MAX_MIPS)
-		Sys_Error ("Texture has over %d mips", MAX_MIPS);
+	VkImageViewCreateInfo image_view_create_info;
+	memset (&image_view_create_info, 0, sizeof (image_view_create_info));
+	image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	image_view_create_info.image = glt->image;
+	image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	image_view_create_info.format = format;
+	image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_R;
+	image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_G;
+	image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_B;
+	image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_A;
+	image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	image_view_create_info.subresourceRange.baseMipLevel = 0;
+	image_view_create_info.subresourceRange.levelCount = num_mips;
+	image_view_create_info.subresourceRange.baseArrayLayer = 0;
+	image_view_create_info.subresourceRange.layerCount = 1;
 
-	const qboolean lightmap = glt->source_format == SRC_LIGHTMAP;
-	const qboolean surface_indices = glt->source_format == SRC_SURF_INDICES;
-	const qboolean ten_bit = lightmap && vulkan_globals.color_format == VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+	VkImageView image_view;
+	VkResult    err = vkCreateImageView (vulkan_globals.device, &image_view_create_info, NULL, &image_view);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreateImageView failed");
+	return image_view;
+}
 
+/*
+================
+TexMgr_CreateImage -- creates the image, its memory, view and descriptor set. texmgr_mutex must be held
+================
+*/
+static void TexMgr_CreateImage (gltexture_t *glt, VkFormat format, int num_mips, VkImageUsageFlags usage)
+{
 	VkResult err;
 
-	const VkFormat format = surface_indices ? VK_FORMAT_R32_UINT : ten_bit ? VK_FORMAT_A2B10G10R10_UNORM_PACK32 : VK_FORMAT_R8G8B8A8_UNORM;
-
 	VkImageCreateInfo image_create_info;
 	memset (&image_create_info, 0, sizeof (image_create_info));
 	image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -897,15 +1013,7 @@ static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
 	image_create_info.arrayLayers = 1;
 	image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
 	image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
-	if (warp_image)
-		image_create_info.usage =
-			(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
-		     VK_IMAGE_USAGE_STORAGE_BIT);
-	else if (lightmap)
-		image_create_info.usage = (VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT);
-	else
-		image_create_info.usage = (VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
-
+	image_create_info.usage = usage;
 	image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 	image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
@@ -926,25 +1034,7 @@ static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkBindImageMemory failed");
 
-	VkImageViewCreateInfo image_view_create_info;
-	memset (&image_view_create_info, 0, sizeof (image_view_create_info));
-	image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-	image_view_create_info.image = glt->image;
-	image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-	image_view_create_info.format = format;
-	image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_R;
-	image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_G;
-	image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_B;
-	image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_A;
-	image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	image_view_create_info.subresourceRange.baseMipLevel = 0;
-	image_view_create_info.subresourceRange.levelCount = num_mips;
-	image_view_create_info.subresourceRange.baseArrayLayer = 0;
-	image_view_create_info.subresourceRange.layerCount = 1;
-
-	err = vkCreateImageView (vulkan_globals.device, &image_view_create_info, NULL, &glt->image_view);
-	if (err != VK_SUCCESS)
-		Sys_Error ("vkCreateImageView failed");
+	glt->image_view = TexMgr_CreateImageView (glt, format, num_mips);
 	GL_SetObjectName ((uint64_t)glt->image_view, VK_OBJECT_TYPE_IMAGE_VIEW, va ("%s image view", glt->name));
 
 	// Allocate and update descriptor for this texture
@@ -952,119 +1042,100 @@ static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
 	GL_SetObjectName ((uint64_t)glt->descriptor_set, VK_OBJECT_TYPE_DESCRIPTOR_SET, va ("%s desc set", glt->name));
 
 	TexMgr_SetFilterModes (glt);
+}
 
-	if (warp_image || lightmap)
-	{
-		image_view_create_info.subresourceRange.levelCount = 1;
-		err = vkCreateImageView (vulkan_globals.device, &image_view_create_info, NULL, &glt->target_image_view);
-		if (err != VK_SUCCESS)
-			Sys_Error ("vkCreateImageView failed");
-		GL_SetObjectName ((uint64_t)glt->target_image_view, VK_OBJECT_TYPE_IMAGE_VIEW, va ("%s target image view", glt->name));
-	}
-	else
-	{
-		glt->target_image_view = VK_NULL_HANDLE;
-	}
+/*
+================
+TexMgr_GenerateMipmaps
 
-	// Don't upload data for warp image, will be updated by rendering
-	if (warp_image)
+fills levels 1..num_mips-1 from level 0 with linear blits. expects all levels in
+TRANSFER_DST_OPTIMAL with level 0 written, leaves all of them SHADER_READ_ONLY_OPTIMAL
+================
+*/
+static void TexMgr_GenerateMipmaps (VkCommandBuffer command_buffer, gltexture_t *glt, int num_mips)
+{
+	VkImageMemoryBarrier image_memory_barriers[2];
+	memset (&image_memory_barriers, 0, sizeof (image_memory_barriers));
+	for (int i = 0; i < 2; ++i)
 	{
-		VkFramebufferCreateInfo framebuffer_create_info;
-		memset (&framebuffer_create_info, 0, sizeof (framebuffer_create_info));
-		framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		framebuffer_create_info.renderPass = vulkan_globals.warp_render_pass;
-		framebuffer_create_info.attachmentCount = 1;
-		framebuffer_create_info.pAttachments = &glt->target_image_view;
-		framebuffer_create_info.width = glt->width;
-		framebuffer_create_info.height = glt->height;
-		framebuffer_create_info.layers = 1;
-		err = vkCreateFramebuffer (vulkan_globals.device, &framebuffer_create_info, NULL, &glt->frame_buffer);
-		if (err != VK_SUCCESS)
-			Sys_Error ("vkCreateFramebuffer failed");
-		GL_SetObjectName ((uint64_t)glt->frame_buffer, VK_OBJECT_TYPE_FRAMEBUFFER, va ("%s framebuffer", glt->name));
+		image_memory_barriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		image_memory_barriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		image_memory_barriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		image_memory_barriers[i].image = glt->image;
+		image_memory_barriers[i].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		image_memory_barriers[i].subresourceRange.levelCount = 1;
+		image_memory_barriers[i].subresourceRange.layerCount = 1;
 	}
 
-	if (warp_image)
-	{
-		// Allocate and update descriptor for this texture
-		glt->storage_descriptor_set = R_AllocateDescriptorSet (&vulkan_globals.single_texture_cs_write_set_layout);
-		GL_SetObjectName ((uint64_t)glt->storage_descriptor_set, VK_OBJECT_TYPE_DESCRIPTOR_SET, va ("%s storage desc set", glt->name));
-
-		VkDescriptorImageInfo output_image_info;
-		memset (&output_image_info, 0, sizeof (output_image_info));
-		output_image_info.imageView = glt->target_image_view;
-		output_image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
-		VkWriteDescriptorSet storage_image_write;
-		memset (&storage_image_write, 0, sizeof (storage_image_write));
-		storage_image_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		storage_image_write.dstBinding = 0;
-		storage_image_write.dstArrayElement = 0;
-		storage_image_write.descriptorCount = 1;
-		storage_image_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-		storage_image_write.dstSet = glt->storage_descriptor_set;
-		storage_image_write.pImageInfo = &output_image_info;
-
-		vkUpdateDescriptorSets (vulkan_globals.device, 1, &storage_image_write, 0, NULL);
-	}
-	else
+	for (int i = 1; i < num_mips; ++i)
 	{
-		glt->storage_descriptor_set = VK_NULL_HANDLE;
+		image_memory_barriers[0].subresourceRange.baseMipLevel = i - 1;
+		image_memory_barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		image_memory_barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		image_memory_barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		image_memory_barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier (command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, image_memory_barriers);
+
+		VkImageBlit blit;
+		memset (&blit, 0, sizeof (blit));
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.mipLevel = i - 1;
+		blit.srcSubresource.layerCount = 1;
+		blit.srcOffsets[1].x = glt->width >> (i - 1);
+		blit.srcOffsets[1].y = glt->height >> (i - 1);
+		blit.srcOffsets[1].z = 1;
+		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.dstSubresource.mipLevel = i;
+		blit.dstSubresource.layerCount = 1;
+		blit.dstOffsets[1].x = glt->width >> i;
+		blit.dstOffsets[1].y = glt->height >> i;
+		blit.dstOffsets[1].z = 1;
+		vkCmdBlitImage (
+			command_buffer, glt->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, glt->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
 	}
 
-	SDL_UnlockMutex (texmgr_mutex);
-
-	// Don't upload data for warp image, will be updated by rendering
-	if (warp_image)
-		return;
+	// every level but the last was a blit source
+	image_memory_barriers[0].subresourceRange.baseMipLevel = 0;
+	image_memory_barriers[0].subresourceRange.levelCount = num_mips - 1;
+	image_memory_barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	image_memory_barriers[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	image_memory_barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	image_memory_barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	image_memory_barriers[1].subresourceRange.baseMipLevel = num_mips - 1;
+	image_memory_barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	image_memory_barriers[1].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	image_memory_barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	image_memory_barriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier (command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 2, image_memory_barriers);
+}
 
-	glt->frame_buffer = VK_NULL_HANDLE;
+/*
+================
+TexMgr_RecordUpload
 
-	// Upload
+copies num_levels tightly packed levels from the staging buffer into a freshly created
+image, then blits the rest of the chain when gpu_mips is set. leaves every level
+SHADER_READ_ONLY_OPTIMAL
+================
+*/
+static void TexMgr_RecordUpload (
+	VkCommandBuffer command_buffer, VkBuffer staging_buffer, int staging_offset, gltexture_t *glt, int num_mips, int num_levels, qboolean gpu_mips)
+{
 	VkBufferImageCopy regions[MAX_MIPS];
 	memset (&regions, 0, sizeof (regions));
-
-	int staging_size = (glt->flags & TEXPREF_MIPMAP) ? TexMgr_DeriveStagingSize (mipwidth, mipheight) : (mipwidth * mipheight * 4);
-
-	VkBuffer        staging_buffer;
-	VkCommandBuffer command_buffer;
-	int             staging_offset;
-	unsigned char  *staging_memory = R_StagingAllocate (staging_size, 4, &command_buffer, &staging_buffer, &staging_offset);
-
-	int num_regions = 0;
-
-	if (glt->flags & TEXPREF_MIPMAP)
-	{
-		int mip_offset = 0;
-		mipwidth = glt->width;
-		mipheight = glt->height;
-
-		while (mipwidth >= 1 && mipheight >= 1)
-		{
-			regions[num_regions].bufferOffset = staging_offset + mip_offset;
-			regions[num_regions].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			regions[num_regions].imageSubresource.layerCount = 1;
-			regions[num_regions].imageSubresource.mipLevel = num_regions;
-			regions[num_regions].imageExtent.width = mipwidth;
-			regions[num_regions].imageExtent.height = mipheight;
-			regions[num_regions].imageExtent.depth = 1;
-
-			mip_offset += mipwidth * mipheight * 4;
-			num_regions += 1;
-
-			mipwidth /= 2;
-			mipheight /= 2;
-		}
-	}
-	else
+	int mip_offset = 0;
+	for (int i = 0; i < num_levels; ++i)
 	{
-		regions[0].bufferOffset = staging_offset;
-		regions[0].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		regions[0].imageSubresource.layerCount = 1;
-		regions[0].imageSubresource.mipLevel = 0;
-		regions[0].imageExtent.width = mipwidth;
-		regions[0].imageExtent.height = mipheight;
-		regions[0].imageExtent.depth = 1;
+		const int mipwidth = glt->width >> i;
+		const int mipheight = glt->height >> i;
+		regions[i].bufferOffset = staging_offset + mip_offset;
+		regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		regions[i].imageSubresource.layerCount = 1;
+		regions[i].imageSubresource.mipLevel = i;
+		regions[i].imageExtent.width = mipwidth;
+		regions[i].imageExtent.height = mipheight;
+		regions[i].imageExtent.depth = 1;
+		mip_offset += mipwidth * mipheight * 4;
 	}
 
 	VkImageMemoryBarrier image_memory_barrier;
@@ -1085,16 +1156,561 @@ static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
 	image_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 	vkCmdPipelineBarrier (command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &image_memory_barrier);
 
-	vkCmdCopyBufferToImage (command_buffer, staging_buffer, glt->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, num_mips, regions);
-
-	image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-	image_memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-	image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	vkCmdPipelineBarrier (command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &image_memory_barrier);
+	vkCmdCopyBufferToImage (command_buffer, staging_buffer, glt->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, num_levels, regions);
 
-	R_StagingBeginCopy ();
-	if (glt->flags & TEXPREF_MIPMAP)
+	if (gpu_mips)
+		TexMgr_GenerateMipmaps (command_buffer, glt, num_mips);
+	else
+	{
+		image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		image_memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		vkCmdPipelineBarrier (
+			command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &image_memory_barrier);
+	}
+}
+
+/*
+================================================================================
+
+    TEXTURE CACHE
+
+Processed images (palette converted, premultiplied, edge fixed, picmipped and,
+without gl_gpumipmaps, the whole CPU mip chain) are written to the user
+directory under a name derived from the source and every setting that
+affects processing. Later loads read the file straight into staging memory.
+
+Images loaded from tga/pcx files are keyed on the file's location, size and
+modification time, so a hit skips decoding them. Everything else is keyed on
+its pixels. Once the directory grows past gl_texturecache_size megabytes the
+oldest files are removed.
+
+================================================================================
+*/
+
+typedef struct
+{
+	char     magic[4];
+	uint32_t version;
+	uint64_t source_hash;
+	uint64_t params_hash;
+	uint32_t source_size;
+	uint32_t source_width;
+	uint32_t source_height;
+	uint32_t width;
+	uint32_t height;
+	uint32_t flags;
+	uint32_t num_levels;
+	uint32_t data_size;
+} texcache_header_t;
+
+/*
+================
+TexMgr_CacheParams -- returns false for images that are never cached
+================
+*/
+static qboolean TexMgr_CacheParams (enum srcformat format, unsigned flags, texcachekey_t *key)
+{
+	extern cvar_t gl_fullbrights;
+	struct
+	{
+		uint32_t format;
+		uint32_t flags;
+		uint32_t picmip;
+		uint32_t maxsize;
+		uint32_t palette_hash;
+		uint32_t fullbrights;
+		uint32_t gpu_mips;
+	} params;
+
+	if ((gl_texturecache.value == 0.0f) || (flags & TEXPREF_WARPIMAGE) || ((format != SRC_INDEXED) && (format != SRC_RGBA)))
+		return false;
+
+	memset (&params, 0, sizeof (params));
+	params.format = format;
+	params.flags = flags;
+	params.picmip = (flags & TEXPREF_NOPICMIP) ? 0 : q_max ((int)gl_picmip.value, 0);
+	params.maxsize = vulkan_globals.device_properties.limits.maxImageDimension2D;
+	params.palette_hash = (format == SRC_INDEXED) ? texcache_palette_hash : 0;
+	params.fullbrights = (gl_fullbrights.value != 0.0f);
+	params.gpu_mips = (gl_gpumipmaps.value != 0.0f);
+	key->params_hash = COM_HashBlock64 (&params, sizeof (params));
+	return true;
+}
+
+/*
+================
+TexMgr_DataCacheKey -- keys an image on its source pixels
+================
+*/
+static qboolean TexMgr_DataCacheKey (gltexture_t *glt, byte *data, texcachekey_t *key)
+{
+	if (!data || (glt->width * glt->height < TEXCACHE_MIN_PIXELS) || !TexMgr_CacheParams (glt->source_format, glt->flags, key))
+		return false;
+
+	key->source_size = glt->width * glt->height * ((glt->source_format == SRC_INDEXED) ? 1 : 4);
+	key->source_width = glt->width;
+	key->source_height = glt->height;
+	key->source_hash = COM_HashBlock64 (data, key->source_size);
+	return true;
+}
+
+/*
+================
+TexMgr_FileCacheKey -- keys an image on the file COM_FindFile last found, before it is decoded
+================
+*/
+static qboolean TexMgr_FileCacheKey (unsigned flags, texcachekey_t *key)
+{
+	// TEXPREF_OVERWRITE compares checksums of the decoded pixels
+	if (!com_filestamp || (com_filesize <= 0) || (flags & TEXPREF_OVERWRITE) || !TexMgr_CacheParams (SRC_RGBA, flags, key))
+		return false;
+
+	key->source_hash = com_filestamp;
+	key->source_size = com_filesize;
+	key->source_width = 0;
+	key->source_height = 0;
+	return true;
+}
+
+/*
+================
+TexMgr_CachePath
+================
+*/
+static const char *TexMgr_CachePath (const texcachekey_t *key, char *path, size_t size)
+{
+	q_snprintf (
+		path, size, "%s/" TEXCACHE_DIR "/%016" SDL_PRIx64 "%016" SDL_PRIx64 ".tex", host_parms->userdir, key->source_hash, key->params_hash);
+	return path;
+}
+
+/*
+================
+TexMgr_OpenCachedImage -- returns NULL on a cache miss, otherwise the file positioned
+at the image data. Fills in the source dimensions of file keys.
+================
+*/
+static FILE *TexMgr_OpenCachedImage (texcachekey_t *key, texcache_header_t *header)
+{
+	const uint32_t maxsize = vulkan_globals.device_properties.limits.maxImageDimension2D;
+	char           path[MAX_OSPATH];
+	FILE          *f;
+
+	Atomic_IncrementUInt32 (&texcache_lookups);
+	f = fopen (TexMgr_CachePath (key, path, sizeof (path)), "rb");
+	if (!f)
+		return NULL;
+
+	if (fread (header, sizeof (*header), 1, f) != 1 || memcmp (header->magic, TEXCACHE_MAGIC, 4) || header->version != TEXCACHE_VERSION ||
+		header->source_hash != key->source_hash || header->params_hash != key->params_hash || header->source_size != key->source_size ||
+		(key->source_width && (header->source_width != key->source_width || header->source_height != key->source_height)) ||
+		!header->source_width || !header->source_height || !header->width || !header->height || header->width > maxsize || header->height > maxsize)
+	{
+		fclose (f);
+		return NULL;
+	}
+
+	const int num_mips = (header->flags & TEXPREF_MIPMAP) ? TexMgr_DeriveNumMips (header->width, header->height) : 1;
+	const int data_size = (header->num_levels == 1) ? (header->width * header->height * 4) : TexMgr_DeriveStagingSize (header->width, header->height);
+	long      file_size;
+	fseek (f, 0, SEEK_END);
+	file_size = ftell (f);
+	fseek (f, sizeof (*header), SEEK_SET);
+	if (((header->num_levels != 1) && (header->num_levels != num_mips)) || (header->data_size != data_size) ||
+		(file_size != (long)(sizeof (*header) + data_size)))
+	{
+		fclose (f);
+		return NULL;
+	}
+
+	key->source_width = header->source_width;
+	key->source_height = header->source_height;
+	return f;
+}
+
+/*
+================
+TexMgr_UploadCachedImage -- uploads the image data of a file opened by TexMgr_OpenCachedImage and closes it
+================
+*/
+static void TexMgr_UploadCachedImage (gltexture_t *glt, FILE *f, const texcache_header_t *header)
+{
+	const int num_mips = (header->flags & TEXPREF_MIPMAP) ? TexMgr_DeriveNumMips (header->width, header->height) : 1;
+	const int data_size = header->data_size;
+
+	GL_DeleteTexture (glt);
+	glt->width = header->width;
+	glt->height = header->height;
+	glt->flags = header->flags;
+
+	const qboolean gpu_mips = (int)header->num_levels < num_mips;
+	SDL_LockMutex (texmgr_mutex);
+	TexMgr_CreateImage (
+		glt, VK_FORMAT_R8G8B8A8_UNORM, num_mips,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | (gpu_mips ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0));
+	glt->target_image_view = VK_NULL_HANDLE;
+	glt->frame_buffer = VK_NULL_HANDLE;
+	glt->storage_descriptor_set = VK_NULL_HANDLE;
+	SDL_UnlockMutex (texmgr_mutex);
+
+	VkBuffer        staging_buffer;
+	VkCommandBuffer command_buffer;
+	int             staging_offset;
+	unsigned char  *staging_memory = R_StagingAllocate (data_size, 4, &command_buffer, &staging_buffer, &staging_offset);
+
+	TexMgr_RecordUpload (command_buffer, staging_buffer, staging_offset, glt, num_mips, header->num_levels, gpu_mips);
+
+	R_StagingBeginCopy ();
+	if (fread (staging_memory, data_size, 1, f) != 1)
+	{
+		// size was checked when opening, so this is an I/O error
+		memset (staging_memory, 0, data_size);
+		Con_Warning ("Couldn't read cached image for %s\n", glt->name);
+	}
+	R_StagingEndCopy ();
+	fclose (f);
+
+	Atomic_IncrementUInt32 (&texcache_hits);
+	Atomic_AddUInt64 (&texcache_bytes_read, data_size);
+	Atomic_AddUInt64 (&texcache_bytes_saved, header->source_size);
+}
+
+/*
+================
+TexMgr_AddCacheFile
+================
+*/
+static void TexMgr_AddCacheFile (texcachefile_t **files, int *num_files, int *max_files, const char *name, uint64_t size, int64_t mtime)
+{
+	if (*num_files == *max_files)
+	{
+		*max_files = q_max (*max_files * 2, 256);
+		*files = (texcachefile_t *)Mem_Realloc (*files, *max_files * sizeof (texcachefile_t));
+	}
+	q_strlcpy ((*files)[*num_files].name, name, sizeof ((*files)[*num_files].name));
+	(*files)[*num_files].size = size;
+	(*files)[*num_files].mtime = mtime;
+	*num_files += 1;
+}
+
+static int TexMgr_CompareCacheFiles (const void *a, const void *b)
+{
+	const int64_t mtime_a = ((const texcachefile_t *)a)->mtime;
+	const int64_t mtime_b = ((const texcachefile_t *)b)->mtime;
+	return (mtime_a > mtime_b) - (mtime_a < mtime_b);
+}
+
+/*
+================
+TexMgr_TrimTextureCache -- measures the cache directory and removes the oldest files while it is over limit
+================
+*/
+static void TexMgr_TrimTextureCache (uint64_t limit)
+{
+	texcachefile_t *files = NULL;
+	int             num_files = 0;
+	int             max_files = 0;
+	uint64_t        total = 0;
+	char            path[MAX_OSPATH];
+	int             i;
+
+#ifdef _WIN32
+	WIN32_FIND_DATA fdat;
+	HANDLE          fhnd;
+
+	q_snprintf (path, sizeof (path), "%s/" TEXCACHE_DIR "/*.tex", host_parms->userdir);
+	fhnd = FindFirstFile (path, &fdat);
+	if (fhnd != INVALID_HANDLE_VALUE)
+	{
+		do
+		{
+			TexMgr_AddCacheFile (
+				&files, &num_files, &max_files, fdat.cFileName, ((uint64_t)fdat.nFileSizeHigh << 32) | fdat.nFileSizeLow,
+				((int64_t)fdat.ftLastWriteTime.dwHighDateTime << 32) | fdat.ftLastWriteTime.dwLowDateTime);
+		} while (FindNextFile (fhnd, &fdat));
+		FindClose (fhnd);
+	}
+#else
+	DIR           *dir_p;
+	struct dirent *dir_t;
+	struct stat    st;
+
+	q_snprintf (path, sizeof (path), "%s/" TEXCACHE_DIR, host_parms->userdir);
+	dir_p = opendir (path);
+	if (dir_p)
+	{
+		while ((dir_t = readdir (dir_p)) != NULL)
+		{
+			if (strcmp (COM_FileGetExtension (dir_t->d_name), "tex") != 0)
+				continue;
+			q_snprintf (path, sizeof (path), "%s/" TEXCACHE_DIR "/%s", host_parms->userdir, dir_t->d_name);
+			if (stat (path, &st) == 0)
+				TexMgr_AddCacheFile (&files, &num_files, &max_files, dir_t->d_name, st.st_size, st.st_mtime);
+		}
+		closedir (dir_p);
+	}
+#endif
+
+	for (i = 0; i < num_files; ++i)
+		total += files[i].size;
+
+	if (total > limit)
+	{
+		// trim below the limit so that the next few stores don't rescan the directory
+		const uint64_t target = limit - limit / 4;
+		qsort (files, num_files, sizeof (texcachefile_t), TexMgr_CompareCacheFiles);
+		for (i = 0; (i < num_files) && (total > target); ++i)
+		{
+			q_snprintf (path, sizeof (path), "%s/" TEXCACHE_DIR "/%s", host_parms->userdir, files[i].name);
+			if (remove (path) == 0)
+				total -= files[i].size;
+		}
+	}
+
+	Atomic_StoreUInt64 (&texcache_total_bytes, total);
+	Mem_Free (files);
+}
+
+/*
+================
+TexMgr_CacheFileWritten
+================
+*/
+static void TexMgr_CacheFileWritten (uint64_t size)
+{
+	const uint64_t limit = (uint64_t)q_max (gl_texturecache_size.value, 0.0f) * 1024 * 1024;
+	const uint64_t total = Atomic_AddUInt64 (&texcache_total_bytes, size) + size;
+	uint32_t       idle = 0;
+
+	Atomic_AddUInt64 (&texcache_bytes_written, size);
+
+	// the first store of a session also measures what earlier sessions left behind
+	if ((!Atomic_LoadUInt32 (&texcache_measured) || (total > limit)) && Atomic_CompareExchangeUInt32 (&texcache_trimming, &idle, 1))
+	{
+		TexMgr_TrimTextureCache (limit);
+		Atomic_StoreUInt32 (&texcache_measured, 1);
+		Atomic_StoreUInt32 (&texcache_trimming, 0);
+	}
+}
+
+/*
+================
+TexMgr_StoreCachedImage
+================
+*/
+static void TexMgr_StoreCachedImage (gltexture_t *glt, const texcachekey_t *key, const byte *data, int num_levels, int data_size)
+{
+	texcache_header_t header;
+	char              path[MAX_OSPATH];
+	char              temppath[MAX_OSPATH];
+	FILE             *f;
+
+	memset (&header, 0, sizeof (header));
+	memcpy (header.magic, TEXCACHE_MAGIC, 4);
+	header.version = TEXCACHE_VERSION;
+	header.source_hash = key->source_hash;
+	header.params_hash = key->params_hash;
+	header.source_size = key->source_size;
+	header.source_width = key->source_width;
+	header.source_height = key->source_height;
+	header.width = glt->width;
+	header.height = glt->height;
+	header.flags = glt->flags;
+	header.num_levels = num_levels;
+	header.data_size = data_size;
+
+	// loader tasks may store identical images concurrently, give each its own temporary file
+	TexMgr_CachePath (key, path, sizeof (path));
+	q_snprintf (temppath, sizeof (temppath), "%s.%lx.tmp", path, (unsigned long)SDL_ThreadID ());
+	f = fopen (temppath, "wb");
+	if (!f)
+		return;
+	qboolean ok = fwrite (&header, sizeof (header), 1, f) == 1 && fwrite (data, data_size, 1, f) == 1;
+	ok = (fclose (f) == 0) && ok;
+	remove (path);
+	if (ok && rename (temppath, path) == 0)
+		TexMgr_CacheFileWritten (sizeof (header) + data_size);
+	else
+		remove (temppath);
+}
+
+/*
+================
+TexMgr_TextureCache_f -- report texture cache efficiency
+================
+*/
+static void TexMgr_TextureCache_f (void)
+{
+	const uint32_t lookups = Atomic_LoadUInt32 (&texcache_lookups);
+	const uint32_t hits = Atomic_LoadUInt32 (&texcache_hits);
+
+	Con_Printf ("texture cache %s\n", (gl_texturecache.value != 0.0f) ? "enabled" : "disabled");
+	Con_Printf ("%u of %u lookups hit (%.1f%%)\n", hits, lookups, lookups ? (100.0 * hits / lookups) : 0.0);
+	Con_Printf ("%.1f MB read from cache\n", Atomic_LoadUInt64 (&texcache_bytes_read) / (1024.0 * 1024.0));
+	Con_Printf ("%.1f MB of source data not reprocessed\n", Atomic_LoadUInt64 (&texcache_bytes_saved) / (1024.0 * 1024.0));
+	Con_Printf ("%.1f MB written to cache\n", Atomic_LoadUInt64 (&texcache_bytes_written) / (1024.0 * 1024.0));
+	if (Atomic_LoadUInt32 (&texcache_measured))
+		Con_Printf ("%.1f of %.0f MB on disk\n", Atomic_LoadUInt64 (&texcache_total_bytes) / (1024.0 * 1024.0), gl_texturecache_size.value);
+}
+
+/*
+================
+TexMgr_LoadImage32 -- handles 32bit source data
+================
+*/
+static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data, const texcachekey_t *cache_key)
+{
+	GL_DeleteTexture (glt);
+
+	// do this before any rescaling
+	if (glt->flags & TEXPREF_PREMULTIPLY)
+		TexMgr_PreMultiply32 ((byte *)data, glt->width, glt->height);
+
+	// mipmap down
+	int picmip = (glt->flags & TEXPREF_NOPICMIP) ? 0 : q_max ((int)gl_picmip.value, 0);
+	int mipwidth = q_max (glt->width >> picmip, 1);
+	int mipheight = q_max (glt->height >> picmip, 1);
+
+	int maxsize = (int)vulkan_globals.device_properties.limits.maxImageDimension2D;
+	if ((mipwidth > maxsize) || (mipheight > maxsize))
+	{
+		if (mipwidth >= mipheight)
+		{
+			mipheight = q_max ((mipheight * maxsize) / mipwidth, 1);
+			mipwidth = maxsize;
+		}
+		else
+		{
+			mipwidth = q_max ((mipwidth * maxsize) / mipheight, 1);
+			mipheight = maxsize;
+		}
+	}
+
+	if ((int)glt->width != mipwidth || (int)glt->height != mipheight)
+	{
+		TexMgr_Downsample (data, glt->width, glt->height, mipwidth, mipheight);
+		glt->width = mipwidth;
+		glt->height = mipheight;
+		if (glt->flags & TEXPREF_ALPHA)
+			TexMgr_AlphaEdgeFix ((byte *)data, glt->width, glt->height);
+	}
+	int num_mips = (glt->flags & TEXPREF_MIPMAP) ? TexMgr_DeriveNumMips (glt->width, glt->height) : 1;
+
+	SDL_LockMutex (texmgr_mutex);
+	const qboolean warp_image = (glt->flags & TEXPREF_WARPIMAGE);
+	if (warp_image)
+		num_mips = WARPIMAGEMIPS;
+
+	// Check for sanity. This should never be reached.
+	if (num_mips > MAX_MIPS)
+		Sys_Error ("Texture has over %d mips", MAX_MIPS);
+
+	const qboolean lightmap = glt->source_format == SRC_LIGHTMAP;
+	const qboolean surface_indices = glt->source_format == SRC_SURF_INDICES;
+	const qboolean ten_bit = lightmap && vulkan_globals.color_format == VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+
+	VkResult err;
+
+	const VkFormat format = surface_indices ? VK_FORMAT_R32_UINT : ten_bit ? VK_FORMAT_A2B10G10R10_UNORM_PACK32 : VK_FORMAT_R8G8B8A8_UNORM;
+
+	// only level 0 is staged, the rest of the chain is blitted on the GPU
+	const qboolean gpu_mips = !warp_image && (num_mips > 1) && (format == VK_FORMAT_R8G8B8A8_UNORM) && (gl_gpumipmaps.value != 0.0f);
+
+	VkImageUsageFlags usage;
+	if (warp_image)
+		usage =
+			(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+		     VK_IMAGE_USAGE_STORAGE_BIT);
+	else if (lightmap)
+		usage = (VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT);
+	else if (gpu_mips)
+		usage = (VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+	else
+		usage = (VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+
+	TexMgr_CreateImage (glt, format, num_mips, usage);
+
+	if (warp_image || lightmap)
+	{
+		glt->target_image_view = TexMgr_CreateImageView (glt, format, 1);
+		GL_SetObjectName ((uint64_t)glt->target_image_view, VK_OBJECT_TYPE_IMAGE_VIEW, va ("%s target image view", glt->name));
+	}
+	else
+	{
+		glt->target_image_view = VK_NULL_HANDLE;
+	}
+
+	// Don't upload data for warp image, will be updated by rendering
+	if (warp_image)
+	{
+		VkFramebufferCreateInfo framebuffer_create_info;
+		memset (&framebuffer_create_info, 0, sizeof (framebuffer_create_info));
+		framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebuffer_create_info.renderPass = vulkan_globals.warp_render_pass;
+		framebuffer_create_info.attachmentCount = 1;
+		framebuffer_create_info.pAttachments = &glt->target_image_view;
+		framebuffer_create_info.width = glt->width;
+		framebuffer_create_info.height = glt->height;
+		framebuffer_create_info.layers = 1;
+		err = vkCreateFramebuffer (vulkan_globals.device, &framebuffer_create_info, NULL, &glt->frame_buffer);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkCreateFramebuffer failed");
+		GL_SetObjectName ((uint64_t)glt->frame_buffer, VK_OBJECT_TYPE_FRAMEBUFFER, va ("%s framebuffer", glt->name));
+	}
+
+	if (warp_image)
+	{
+		// Allocate and update descriptor for this texture
+		glt->storage_descriptor_set = R_AllocateDescriptorSet (&vulkan_globals.single_texture_cs_write_set_layout);
+		GL_SetObjectName ((uint64_t)glt->storage_descriptor_set, VK_OBJECT_TYPE_DESCRIPTOR_SET, va ("%s storage desc set", glt->name));
+
+		VkDescriptorImageInfo output_image_info;
+		memset (&output_image_info, 0, sizeof (output_image_info));
+		output_image_info.imageView = glt->target_image_view;
+		output_image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkWriteDescriptorSet storage_image_write;
+		memset (&storage_image_write, 0, sizeof (storage_image_write));
+		storage_image_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		storage_image_write.dstBinding = 0;
+		storage_image_write.dstArrayElement = 0;
+		storage_image_write.descriptorCount = 1;
+		storage_image_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		storage_image_write.dstSet = glt->storage_descriptor_set;
+		storage_image_write.pImageInfo = &output_image_info;
+
+		vkUpdateDescriptorSets (vulkan_globals.device, 1, &storage_image_write, 0, NULL);
+	}
+	else
+	{
+		glt->storage_descriptor_set = VK_NULL_HANDLE;
+	}
+
+	SDL_UnlockMutex (texmgr_mutex);
+
+	// Don't upload data for warp image, will be updated by rendering
+	if (warp_image)
+		return;
+
+	glt->frame_buffer = VK_NULL_HANDLE;
+
+	// Upload
+	int staging_size = ((glt->flags & TEXPREF_MIPMAP) && !gpu_mips) ? TexMgr_DeriveStagingSize (mipwidth, mipheight) : (mipwidth * mipheight * 4);
+
+	VkBuffer        staging_buffer;
+	VkCommandBuffer command_buffer;
+	int             staging_offset;
+	unsigned char  *staging_memory = R_StagingAllocate (staging_size, 4, &command_buffer, &staging_buffer, &staging_offset);
+
+	// the CPU mip chain is built in place, keep a copy for the cache
+	byte *cache_data = (cache_key && (glt->flags & TEXPREF_MIPMAP) && !gpu_mips) ? (byte *)Mem_Alloc (staging_size) : NULL;
+
+	TexMgr_RecordUpload (command_buffer, staging_buffer, staging_offset, glt, num_mips, gpu_mips ? 1 : num_mips, gpu_mips);
+
+	R_StagingBeginCopy ();
+	if ((glt->flags & TEXPREF_MIPMAP) && !gpu_mips)
 	{
 		int mip_offset = 0;
 		mipwidth = glt->width;
@@ -1103,9 +1719,10 @@ static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
 		while (mipwidth >= 1 && mipheight >= 1)
 		{
 			memcpy (staging_memory + mip_offset, data, mipwidth * mipheight * 4);
+			if (cache_data)
+				memcpy (cache_data + mip_offset, data, mipwidth * mipheight * 4);
 
 			mip_offset += mipwidth * mipheight * 4;
-			num_regions += 1;
 
 			if (mipwidth > 1 && mipheight > 1)
 				TexMgr_Downsample (data, mipwidth, mipheight, mipwidth / 2, mipheight / 2);
@@ -1123,6 +1740,14 @@ static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
 				*(unsigned *)staging_memory = p[0] | p[1] << 10 | p[2] << 20;
 	}
 	R_StagingEndCopy ();
+
+	if (cache_data)
+	{
+		TexMgr_StoreCachedImage (glt, cache_key, cache_data, num_mips, staging_size);
+		Mem_Free (cache_data);
+	}
+	else if (cache_key)
+		TexMgr_StoreCachedImage (glt, cache_key, (byte *)data, 1, glt->width * glt->height * 4);
 }
 
 /*
@@ -1130,7 +1755,7 @@ static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
 TexMgr_LoadImage8 -- handles 8bit source data, then passes it to LoadImage32
 ================
 */
-static void TexMgr_LoadImage8 (gltexture_t *glt, byte *data)
+static void TexMgr_LoadImage8 (gltexture_t *glt, byte *data, const texcachekey_t *cache_key)
 {
 	GL_DeleteTexture (glt);
 
@@ -1191,7 +1816,7 @@ static void TexMgr_LoadImage8 (gltexture_t *glt, byte *data)
 		TexMgr_AlphaEdgeFix ((byte *)converted, glt->width, glt->height);
 
 	// upload it
-	TexMgr_LoadImage32 (glt, (unsigned *)converted);
+	TexMgr_LoadImage32 (glt, (unsigned *)converted, cache_key);
 
 	TEMP_FREE (converted);
 }
@@ -1203,24 +1828,104 @@ TexMgr_LoadLightmap -- handles lightmap data
 */
 static void TexMgr_LoadLightmap (gltexture_t *glt, byte *data)
 {
-	TexMgr_LoadImage32 (glt, (unsigned *)data);
+	TexMgr_LoadImage32 (glt, (unsigned *)data, NULL);
 }
 
 /*
 ================
-TexMgr_LoadImage -- the one entry point for loading all textures
+TexMgr_LoadCompressed -- handles block compressed data, uploaded as is
 ================
 */
-gltexture_t *TexMgr_LoadImage (
+static void TexMgr_LoadCompressed (gltexture_t *glt, compressedimage_t *image)
+{
+	static const VkFormat formats[] = {VK_FORMAT_BC1_RGBA_UNORM_BLOCK, VK_FORMAT_BC3_UNORM_BLOCK, VK_FORMAT_BC7_UNORM_BLOCK};
+
+	GL_DeleteTexture (glt);
+
+	// picmip and the size limit can only drop whole levels, there is nothing to resample on the CPU
+	const int picmip = (glt->flags & TEXPREF_NOPICMIP) ? 0 : q_max ((int)gl_picmip.value, 0);
+	const int maxsize = (int)vulkan_globals.device_properties.limits.maxImageDimension2D;
+	int       base = 0;
+	while ((base + 1 < image->num_mips) && ((base < picmip) || ((image->width >> base) > maxsize) || ((image->height >> base) > maxsize)))
+		++base;
+
+	glt->width = q_max (image->width >> base, 1);
+	glt->height = q_max (image->height >> base, 1);
+	const int num_mips = (glt->flags & TEXPREF_MIPMAP) ? q_min (image->num_mips - base, TexMgr_DeriveNumMips (glt->width, glt->height)) : 1;
+	const VkFormat format = formats[image->format];
+
+	SDL_LockMutex (texmgr_mutex);
+	TexMgr_CreateImage (glt, format, num_mips, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+	glt->target_image_view = VK_NULL_HANDLE;
+	glt->frame_buffer = VK_NULL_HANDLE;
+	glt->storage_descriptor_set = VK_NULL_HANDLE;
+	SDL_UnlockMutex (texmgr_mutex);
+
+	// Upload
+	const size_t first = image->mip_offsets[base];
+	const size_t last = (base + num_mips < image->num_mips) ? image->mip_offsets[base + num_mips] : image->size;
+
+	VkBuffer        staging_buffer;
+	VkCommandBuffer command_buffer;
+	int             staging_offset;
+	unsigned char  *staging_memory = R_StagingAllocate (last - first, 16, &command_buffer, &staging_buffer, &staging_offset);
+
+	VkBufferImageCopy regions[MAX_MIPS];
+	memset (&regions, 0, sizeof (regions));
+	for (int i = 0; i < num_mips; ++i)
+	{
+		regions[i].bufferOffset = staging_offset + image->mip_offsets[base + i] - first;
+		regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		regions[i].imageSubresource.layerCount = 1;
+		regions[i].imageSubresource.mipLevel = i;
+		regions[i].imageExtent.width = q_max (glt->width >> i, 1);
+		regions[i].imageExtent.height = q_max (glt->height >> i, 1);
+		regions[i].imageExtent.depth = 1;
+	}
+
+	VkImageMemoryBarrier image_memory_barrier;
+	memset (&image_memory_barrier, 0, sizeof (image_memory_barrier));
+	image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	image_memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_memory_barrier.image = glt->image;
+	image_memory_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	image_memory_barrier.subresourceRange.baseMipLevel = 0;
+	image_memory_barrier.subresourceRange.levelCount = num_mips;
+	image_memory_barrier.subresourceRange.baseArrayLayer = 0;
+	image_memory_barrier.subresourceRange.layerCount = 1;
+
+	image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	image_memory_barrier.srcAccessMask = 0;
+	image_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier (command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &image_memory_barrier);
+
+	vkCmdCopyBufferToImage (command_buffer, staging_buffer, glt->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, num_mips, regions);
+
+	image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	image_memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	vkCmdPipelineBarrier (command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &image_memory_barrier);
+
+	R_StagingBeginCopy ();
+	memcpy (staging_memory, image->data + first, last - first);
+	R_StagingEndCopy ();
+}
+
+/*
+================
+TexMgr_LoadImageKeyed -- loads an image, storing it in the texture cache under file_key if that is set
+================
+*/
+static gltexture_t *TexMgr_LoadImageKeyed (
 	qmodel_t *owner, const char *name, int width, int height, enum srcformat format, byte *data, const char *source_file, src_offset_t source_offset,
-	unsigned flags)
+	unsigned flags, texcachekey_t *file_key)
 {
 	unsigned short crc = 0;
 	gltexture_t   *glt;
 
-	if (isDedicated)
-		return NULL;
-
 	// cache check
 	if (flags & TEXPREF_OVERWRITE)
 		switch (format)
@@ -1246,8 +1951,7 @@ gltexture_t *TexMgr_LoadImage (
 		glt = TexMgr_NewTexture ();
 
 	// copy data
-	glt->owner = owner;
-	q_strlcpy (glt->name, name, sizeof (glt->name));
+	TexMgr_SetName (glt, owner, name);
 	glt->width = width;
 	glt->height = height;
 	glt->flags = flags;
@@ -1260,24 +1964,135 @@ gltexture_t *TexMgr_LoadImage (
 	glt->source_height = height;
 	glt->source_crc = crc;
 
-	// upload it
+	// a hit skips the upload, a file key has already missed
+	texcachekey_t     data_key;
+	texcachekey_t    *cache_key = NULL;
+	texcache_header_t header;
+	FILE             *cache;
+	if (file_key)
+	{
+		file_key->source_width = width;
+		file_key->source_height = height;
+		if (width * height >= TEXCACHE_MIN_PIXELS)
+			cache_key = file_key;
+	}
+	else if (TexMgr_DataCacheKey (glt, data, &data_key))
+	{
+		if ((cache = TexMgr_OpenCachedImage (&data_key, &header)))
+		{
+			TexMgr_UploadCachedImage (glt, cache, &header);
+			return glt;
+		}
+		cache_key = &data_key;
+	}
+
 	switch (glt->source_format)
 	{
 	case SRC_INDEXED:
-		TexMgr_LoadImage8 (glt, data);
+		TexMgr_LoadImage8 (glt, data, cache_key);
 		break;
 	case SRC_LIGHTMAP:
 		TexMgr_LoadLightmap (glt, data);
 		break;
 	case SRC_RGBA:
 	case SRC_SURF_INDICES:
-		TexMgr_LoadImage32 (glt, (unsigned *)data);
+		TexMgr_LoadImage32 (glt, (unsigned *)data, cache_key);
+		break;
+	case SRC_COMPRESSED:
+		TexMgr_LoadCompressed (glt, (compressedimage_t *)data);
 		break;
 	}
 
 	return glt;
 }
 
+/*
+================
+TexMgr_LoadImage -- the one entry point for loading all textures
+================
+*/
+gltexture_t *TexMgr_LoadImage (
+	qmodel_t *owner, const char *name, int width, int height, enum srcformat format, byte *data, const char *source_file, src_offset_t source_offset,
+	unsigned flags)
+{
+	if (isDedicated)
+		return NULL;
+
+	return TexMgr_LoadImageKeyed (owner, name, width, height, format, data, source_file, source_offset, flags, NULL);
+}
+
+/*
+================
+TexMgr_LoadImageFile -- loads name.tga or name.pcx, a texture cache hit skips decoding it
+================
+*/
+gltexture_t *TexMgr_LoadImageFile (qmodel_t *owner, const char *name, unsigned flags)
+{
+	texcachekey_t     cache_key;
+	texcache_header_t header;
+	imagetype_t       type;
+	gltexture_t      *glt;
+	FILE             *f;
+	FILE             *cache;
+	byte             *data;
+	int               width, height;
+
+	if (isDedicated)
+		return NULL;
+
+	f = Image_OpenImage (name, &type);
+	if (!f)
+		return NULL;
+
+	const qboolean cacheable = TexMgr_FileCacheKey (flags, &cache_key);
+	if (cacheable && (cache = TexMgr_OpenCachedImage (&cache_key, &header)))
+	{
+		fclose (f);
+		glt = TexMgr_NewTexture ();
+		TexMgr_SetName (glt, owner, name);
+		glt->flags = flags;
+		glt->shirt = -1;
+		glt->pants = -1;
+		q_strlcpy (glt->source_file, name, sizeof (glt->source_file));
+		glt->source_offset = 0;
+		glt->source_format = SRC_RGBA;
+		glt->source_width = cache_key.source_width;
+		glt->source_height = cache_key.source_height;
+		glt->source_crc = 0;
+		TexMgr_UploadCachedImage (glt, cache, &header);
+		return glt;
+	}
+
+	data = Image_ReadImage (f, type, name, &width, &height);
+	if (!data)
+		return NULL;
+	glt = TexMgr_LoadImageKeyed (owner, name, width, height, SRC_RGBA, data, name, 0, flags, cacheable ? &cache_key : NULL);
+	Mem_Free (data);
+	return glt;
+}
+
+/*
+================
+TexMgr_LoadCompressedImage -- loads name.dds or name.ktx2, returns NULL if there is none or the device can't sample it
+================
+*/
+gltexture_t *TexMgr_LoadCompressedImage (qmodel_t *owner, const char *name, unsigned flags)
+{
+	compressedimage_t image;
+	gltexture_t      *glt;
+
+	// premultiplying would need a decode, leave those to the RGBA path
+	if (isDedicated || !vulkan_globals.texture_compression_bc || (flags & TEXPREF_PREMULTIPLY))
+		return NULL;
+
+	if (!Image_LoadCompressedImage (name, (int)vulkan_globals.device_properties.limits.maxImageDimension2D, &image))
+		return NULL;
+
+	glt = TexMgr_LoadImage (owner, name, image.width, image.height, SRC_COMPRESSED, (byte *)&image, name, 0, flags);
+	Mem_Free (image.data);
+	return glt;
+}
+
 /*
 ================================================================================
 
@@ -1296,6 +2111,20 @@ void TexMgr_ReloadImage (gltexture_t *glt, int shirt, int pants)
 	byte  translation[256];
 	byte *src, *dst, *data = NULL, *allocated = NULL, *translated = NULL;
 	int   size, i;
+
+	// compressed images can't be colormapped, just upload them again
+	if (glt->source_format == SRC_COMPRESSED)
+	{
+		compressedimage_t image;
+		if (Image_LoadCompressedImage (glt->source_file, (int)vulkan_globals.device_properties.limits.maxImageDimension2D, &image))
+		{
+			TexMgr_LoadCompressed (glt, &image);
+			Mem_Free (image.data);
+		}
+		else
+			Con_Printf ("TexMgr_ReloadImage: invalid source for %s\n", glt->name);
+		return;
+	}
 	//
 	// get source data
 	//
@@ -1401,14 +2230,16 @@ void TexMgr_ReloadImage (gltexture_t *glt, int shirt, int pants)
 	switch (glt->source_format)
 	{
 	case SRC_INDEXED:
-		TexMgr_LoadImage8 (glt, data);
+		TexMgr_LoadImage8 (glt, data, NULL);
 		break;
 	case SRC_LIGHTMAP:
 		TexMgr_LoadLightmap (glt, data);
 		break;
 	case SRC_RGBA:
 	case SRC_SURF_INDICES:
-		TexMgr_LoadImage32 (glt, (unsigned *)data);
+		TexMgr_LoadImage32 (glt, (unsigned *)data, NULL);
+		break;
+	case SRC_COMPRESSED: // handled above
 		break;
 	}
 
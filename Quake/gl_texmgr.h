@@ -48,7 +48,8 @@ enum srcformat
 	SRC_INDEXED,
 	SRC_LIGHTMAP,
 	SRC_RGBA,
-	SRC_SURF_INDICES
+	SRC_SURF_INDICES,
+	SRC_COMPRESSED // compressedimage_t, BC1/BC3/BC7 blocks
 };
 
 struct glheap_s;
@@ -58,6 +59,8 @@ typedef struct gltexture_s
 {
 	// managed by texture manager
 	struct gltexture_s  *next;
+	struct gltexture_s  *hash_next;  // next in the same (owner, name) bucket
+	struct gltexture_s **hash_pprev; // link pointing at this texture, NULL if not in the index
 	qmodel_t            *owner;
 	// managed by image loading
 	char                 name[64];
@@ -114,9 +117,12 @@ void         TexMgr_LoadPalette (void);
 gltexture_t *TexMgr_LoadImage (
 	qmodel_t *owner, const char *name, int width, int height, enum srcformat format, byte *data, const char *source_file, src_offset_t source_offset,
 	unsigned flags);
-void TexMgr_ReloadImage (gltexture_t *glt, int shirt, int pants);
-void TexMgr_ReloadNobrightImages (void);
+gltexture_t *TexMgr_LoadCompressedImage (qmodel_t *owner, const char *name, unsigned flags);
+gltexture_t *TexMgr_LoadImageFile (qmodel_t *owner, const char *name, unsigned flags);
+void         TexMgr_ReloadImage (gltexture_t *glt, int shirt, int pants);
+void         TexMgr_ReloadNobrightImages (void);
 
-void TexMgr_UpdateTextureDescriptorSets (void);
+void     TexMgr_UpdateTextureDescriptorSets (void);
+uint32_t TexMgr_BindlessIndex (gltexture_t *glt);
 
 #endif /* _GL_TEXMAN_H */
@@ -81,6 +81,11 @@ static void GL_InitInstance (void);
 static void GL_InitDevice (void);
 static void GL_CreateFrameBuffers (void);
 static void GL_DestroyRenderResources (void);
+static void GL_CaptureScreenShots (VkCommandBuffer command_buffer, int cb_index, int width, int height);
+static void GL_EncodeScreenShots (int cb_index);
+static void GL_CreateScreenShotRing (void);
+static void GL_DestroyScreenShotRing (void);
+static void GL_FlushScreenShots (void);
 
 viddef_t        vid; // global video state
 modestate_t     modestate = MS_UNINIT;
@@ -132,6 +137,16 @@ static VkImageView     swapchain_images_views[MAX_SWAP_CHAIN_IMAGES];
 static VkImage         depth_buffer;
 static vulkan_memory_t depth_buffer_memory;
 static VkImageView     depth_buffer_view;
+static VkDescriptorSet depth_buffer_desc_set;
+static VkImage         hiz_image;
+static vulkan_memory_t hiz_memory;
+static VkImageView     hiz_view;
+static VkImageView     hiz_level_views[MAX_HIZ_LEVELS];
+static VkDescriptorSet hiz_level_desc_sets[MAX_HIZ_LEVELS];
+static int             hiz_num_levels;
+static int             hiz_width;
+static int             hiz_height;
+static qboolean        hiz_ready; // built from the depth of the last frame
 static vulkan_memory_t color_buffers_memory[NUM_COLOR_BUFFERS];
 static VkImageView     color_buffers_view[NUM_COLOR_BUFFERS];
 static VkImage         msaa_color_buffer;
@@ -180,6 +195,47 @@ static uint32_t current_swapchain_buffer;
 
 task_handle_t prev_end_rendering_task = INVALID_TASK_HANDLE;
 
+// Screenshots and demo capture frames in flight, each one goes FREE -> REQUESTED -> CAPTURED -> ENCODING -> FREE
+#define MAX_PENDING_SCREENSHOTS 8
+
+typedef enum
+{
+	SCREENSHOT_FREE,
+	SCREENSHOT_REQUESTED, // waiting for the end of the next frame
+	SCREENSHOT_CAPTURED,  // copy recorded, waiting for the frame fence
+	SCREENSHOT_ENCODING,  // owned by an encoder task
+} screenshot_state_t;
+
+typedef struct
+{
+	atomic_uint32_t state;
+	qboolean        video; // demo capture frame instead of a screenshot file
+	task_handle_t   write_task;
+	char            name[16];
+	char            ext[4];
+	int             quality;
+	qboolean        bgra;
+	int             width;
+	int             height;
+	int             cb_index;
+} screenshot_t;
+
+static screenshot_t    screenshots[MAX_PENDING_SCREENSHOTS];
+static task_handle_t   prev_video_write_task = INVALID_TASK_HANDLE;
+static atomic_uint32_t capture_frames_recorded;
+
+// Persistently mapped readback memory with one swap chain sized slot per screenshot,
+// created by the first request and kept until the swap chain goes away
+static struct
+{
+	VkBuffer        buffer;
+	vulkan_memory_t memory;
+	byte           *data;
+	int             width;
+	int             height;
+	VkDeviceSize    slot_size;
+} screenshot_ring;
+
 #define GET_INSTANCE_PROC_ADDR(entrypoint)                                                              \
 	{                                                                                                   \
 		fp##entrypoint = (PFN_vk##entrypoint)fpGetInstanceProcAddr (vulkan_instance, "vk" #entrypoint); \
@@ -825,6 +881,43 @@ static const char *GetDeviceVendorFromDeviceProperties (void)
 	return NULL;
 }
 
+/*
+===============
+GL_DiscardCmd*
+
+Used with -discarddraws: draws and dispatches are dropped while everything else,
+including all CPU side renderer work and buffer writes, still runs. This is
+not headless, command buffers are still recorded and submitted and the
+swap chain is still presented, so a window and a Vulkan device are needed.
+===============
+*/
+static VKAPI_ATTR void VKAPI_CALL GL_DiscardCmdDraw (
+	VkCommandBuffer commandBuffer, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+}
+
+static VKAPI_ATTR void VKAPI_CALL GL_DiscardCmdDrawIndexed (
+	VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+{
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+GL_DiscardCmdDrawIndexedIndirect (VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
+{
+}
+
+#if defined(VK_KHR_draw_indirect_count)
+static VKAPI_ATTR void VKAPI_CALL GL_DiscardCmdDrawIndexedIndirectCount (
+	VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount,
+	uint32_t stride)
+{
+}
+#endif
+
+static VKAPI_ATTR void VKAPI_CALL GL_DiscardCmdDispatch (VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+}
+
 /*
 ===============
 GL_InitDevice
@@ -840,6 +933,12 @@ static void GL_InitDevice (void)
 #if defined(VK_EXT_subgroup_size_control)
 	qboolean subgroup_size_control = false;
 #endif
+#if defined(VK_EXT_conditional_rendering)
+	qboolean conditional_rendering = false;
+#endif
+#if defined(VK_EXT_descriptor_indexing)
+	qboolean descriptor_indexing = false;
+#endif
 
 	uint32_t physical_device_count;
 	err = vkEnumeratePhysicalDevices (vulkan_instance, &physical_device_count, NULL);
@@ -863,6 +962,9 @@ static void GL_InitDevice (void)
 	vulkan_globals.full_screen_exclusive = false;
 	vulkan_globals.swap_chain_full_screen_acquired = false;
 	vulkan_globals.screen_effects_sops = false;
+	vulkan_globals.conditional_rendering = false;
+	vulkan_globals.draw_indirect_count = false;
+	vulkan_globals.bindless_textures = false;
 
 	vkGetPhysicalDeviceMemoryProperties (vulkan_physical_device, &vulkan_globals.memory_properties);
 	vkGetPhysicalDeviceProperties (vulkan_physical_device, &vulkan_globals.device_properties);
@@ -895,6 +997,18 @@ static void GL_InitDevice (void)
 #if defined(VK_EXT_full_screen_exclusive)
 			if (strcmp (VK_EXT_FULL_SCREEN_EXCLUSIVE_EXTENSION_NAME, device_extensions[i].extensionName) == 0)
 				vulkan_globals.full_screen_exclusive = true;
+#endif
+#if defined(VK_EXT_conditional_rendering)
+			if (strcmp (VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME, device_extensions[i].extensionName) == 0)
+				conditional_rendering = true;
+#endif
+#if defined(VK_KHR_draw_indirect_count)
+			if (strcmp (VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME, device_extensions[i].extensionName) == 0)
+				vulkan_globals.draw_indirect_count = true;
+#endif
+#if defined(VK_EXT_descriptor_indexing)
+			if (strcmp (VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME, device_extensions[i].extensionName) == 0)
+				descriptor_indexing = true;
 #endif
 		}
 
@@ -1025,7 +1139,74 @@ static void GL_InitDevice (void)
 		Con_Printf ("Using subgroup operations\n");
 #endif
 
-	const char *device_extensions[6] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+#if defined(VK_EXT_conditional_rendering)
+	VkPhysicalDeviceConditionalRenderingFeaturesEXT conditional_rendering_features;
+	memset (&conditional_rendering_features, 0, sizeof (conditional_rendering_features));
+	if (vulkan_globals.vulkan_1_1_available && conditional_rendering)
+	{
+		conditional_rendering_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_CONDITIONAL_RENDERING_FEATURES_EXT;
+		VkPhysicalDeviceFeatures2 physical_device_features_2;
+		memset (&physical_device_features_2, 0, sizeof (physical_device_features_2));
+		physical_device_features_2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		physical_device_features_2.pNext = &conditional_rendering_features;
+		vkGetPhysicalDeviceFeatures2 (vulkan_physical_device, &physical_device_features_2);
+
+		// predicates are only used from the command buffers that draw
+		conditional_rendering_features.inheritedConditionalRendering = VK_FALSE;
+	}
+	vulkan_globals.conditional_rendering = conditional_rendering_features.conditionalRendering == VK_TRUE;
+
+	if (vulkan_globals.conditional_rendering)
+		Con_Printf ("Using conditional rendering\n");
+#endif
+
+#if defined(VK_EXT_descriptor_indexing)
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptor_indexing_features;
+	memset (&descriptor_indexing_features, 0, sizeof (descriptor_indexing_features));
+	if (vulkan_globals.vulkan_1_1_available && descriptor_indexing)
+	{
+		descriptor_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		VkPhysicalDeviceFeatures2 physical_device_features_2;
+		memset (&physical_device_features_2, 0, sizeof (physical_device_features_2));
+		physical_device_features_2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		physical_device_features_2.pNext = &descriptor_indexing_features;
+		vkGetPhysicalDeviceFeatures2 (vulkan_physical_device, &physical_device_features_2);
+
+		VkPhysicalDeviceDescriptorIndexingPropertiesEXT descriptor_indexing_properties;
+		memset (&descriptor_indexing_properties, 0, sizeof (descriptor_indexing_properties));
+		descriptor_indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+		VkPhysicalDeviceProperties2 physical_device_properties_2;
+		memset (&physical_device_properties_2, 0, sizeof (physical_device_properties_2));
+		physical_device_properties_2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		physical_device_properties_2.pNext = &descriptor_indexing_properties;
+		vkGetPhysicalDeviceProperties2 (vulkan_physical_device, &physical_device_properties_2);
+
+		// one combined image sampler per gltexture_t slot, written while frames that don't use it are in flight.
+		// VK_KHR_maintenance3 is only core on 1.1 devices.
+		vulkan_globals.bindless_textures =
+			(vulkan_globals.device_properties.apiVersion >= VK_API_VERSION_1_1) && descriptor_indexing_features.shaderSampledImageArrayNonUniformIndexing &&
+			descriptor_indexing_features.descriptorBindingPartiallyBound && descriptor_indexing_features.descriptorBindingSampledImageUpdateAfterBind &&
+			descriptor_indexing_features.descriptorBindingUpdateUnusedWhilePending &&
+			vulkan_physical_device_features.drawIndirectFirstInstance && vulkan_physical_device_features.multiDrawIndirect &&
+			(descriptor_indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers >= MAX_GLTEXTURES) &&
+			(descriptor_indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages >= MAX_GLTEXTURES) &&
+			(descriptor_indexing_properties.maxPerStageUpdateAfterBindResources >= MAX_GLTEXTURES + 1) &&
+			(descriptor_indexing_properties.maxDescriptorSetUpdateAfterBindSamplers >= MAX_GLTEXTURES) &&
+			(descriptor_indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages >= MAX_GLTEXTURES);
+
+		memset (&descriptor_indexing_features, 0, sizeof (descriptor_indexing_features));
+		descriptor_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		descriptor_indexing_features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		descriptor_indexing_features.descriptorBindingPartiallyBound = VK_TRUE;
+		descriptor_indexing_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		descriptor_indexing_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+	}
+
+	if (vulkan_globals.bindless_textures)
+		Con_Printf ("Using bindless textures\n");
+#endif
+
+	const char *device_extensions[8] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 	uint32_t    numEnabledExtensions = 1;
 	if (vulkan_globals.dedicated_allocation)
 	{
@@ -1042,6 +1223,18 @@ static void GL_InitDevice (void)
 		device_extensions[numEnabledExtensions++] = VK_EXT_FULL_SCREEN_EXCLUSIVE_EXTENSION_NAME;
 	}
 #endif
+#if defined(VK_EXT_conditional_rendering)
+	if (vulkan_globals.conditional_rendering)
+		device_extensions[numEnabledExtensions++] = VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME;
+#endif
+#if defined(VK_KHR_draw_indirect_count)
+	if (vulkan_globals.draw_indirect_count)
+		device_extensions[numEnabledExtensions++] = VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME;
+#endif
+#if defined(VK_EXT_descriptor_indexing)
+	if (vulkan_globals.bindless_textures)
+		device_extensions[numEnabledExtensions++] = VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME;
+#endif
 
 	const VkBool32 extended_format_support = vulkan_physical_device_features.shaderStorageImageExtendedFormats;
 	const VkBool32 sampler_anisotropic = vulkan_physical_device_features.samplerAnisotropy;
@@ -1052,14 +1245,33 @@ static void GL_InitDevice (void)
 	device_features.samplerAnisotropy = sampler_anisotropic;
 	device_features.sampleRateShading = vulkan_physical_device_features.sampleRateShading;
 	device_features.fillModeNonSolid = vulkan_physical_device_features.fillModeNonSolid;
+	device_features.textureCompressionBC = vulkan_physical_device_features.textureCompressionBC;
+	device_features.multiDrawIndirect = vulkan_physical_device_features.multiDrawIndirect;
+	device_features.drawIndirectFirstInstance = vulkan_globals.bindless_textures ? VK_TRUE : VK_FALSE;
 
 	vulkan_globals.non_solid_fill = (device_features.fillModeNonSolid == VK_TRUE) ? true : false;
+	vulkan_globals.texture_compression_bc = (device_features.textureCompressionBC == VK_TRUE) ? true : false;
+	vulkan_globals.multi_draw_indirect = (device_features.multiDrawIndirect == VK_TRUE) ? true : false;
 
 	VkDeviceCreateInfo device_create_info;
 	memset (&device_create_info, 0, sizeof (device_create_info));
 	device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 #if defined(VK_EXT_subgroup_size_control)
 	device_create_info.pNext = vulkan_globals.screen_effects_sops ? &subgroup_size_control_features : NULL;
+#endif
+#if defined(VK_EXT_conditional_rendering)
+	if (vulkan_globals.conditional_rendering)
+	{
+		conditional_rendering_features.pNext = (void *)device_create_info.pNext;
+		device_create_info.pNext = &conditional_rendering_features;
+	}
+#endif
+#if defined(VK_EXT_descriptor_indexing)
+	if (vulkan_globals.bindless_textures)
+	{
+		descriptor_indexing_features.pNext = (void *)device_create_info.pNext;
+		device_create_info.pNext = &descriptor_indexing_features;
+	}
 #endif
 	device_create_info.queueCreateInfoCount = 1;
 	device_create_info.pQueueCreateInfos = &queue_create_info;
@@ -1148,8 +1360,34 @@ static void GL_InitDevice (void)
 	GET_GLOBAL_DEVICE_PROC_ADDR (vk_cmd_bind_vertex_buffers, vkCmdBindVertexBuffers);
 	GET_GLOBAL_DEVICE_PROC_ADDR (vk_cmd_draw, vkCmdDraw);
 	GET_GLOBAL_DEVICE_PROC_ADDR (vk_cmd_draw_indexed, vkCmdDrawIndexed);
+	GET_GLOBAL_DEVICE_PROC_ADDR (vk_cmd_draw_indexed_indirect, vkCmdDrawIndexedIndirect);
+	GET_GLOBAL_DEVICE_PROC_ADDR (vk_cmd_dispatch, vkCmdDispatch);
 	GET_GLOBAL_DEVICE_PROC_ADDR (vk_cmd_pipeline_barrier, vkCmdPipelineBarrier);
 	GET_GLOBAL_DEVICE_PROC_ADDR (vk_cmd_copy_buffer_to_image, vkCmdCopyBufferToImage);
+#if defined(VK_EXT_conditional_rendering)
+	if (vulkan_globals.conditional_rendering)
+	{
+		GET_GLOBAL_DEVICE_PROC_ADDR (vk_cmd_begin_conditional_rendering, vkCmdBeginConditionalRenderingEXT);
+		GET_GLOBAL_DEVICE_PROC_ADDR (vk_cmd_end_conditional_rendering, vkCmdEndConditionalRenderingEXT);
+	}
+#endif
+#if defined(VK_KHR_draw_indirect_count)
+	if (vulkan_globals.draw_indirect_count)
+		GET_GLOBAL_DEVICE_PROC_ADDR (vk_cmd_draw_indexed_indirect_count, vkCmdDrawIndexedIndirectCountKHR);
+#endif
+
+	vulkan_globals.discard_draws = COM_CheckParm ("-discarddraws") != 0;
+	if (vulkan_globals.discard_draws)
+	{
+		Con_Printf ("Discarding draw and dispatch commands, command buffers are still submitted\n");
+		vulkan_globals.vk_cmd_draw = GL_DiscardCmdDraw;
+		vulkan_globals.vk_cmd_draw_indexed = GL_DiscardCmdDrawIndexed;
+		vulkan_globals.vk_cmd_draw_indexed_indirect = GL_DiscardCmdDrawIndexedIndirect;
+#if defined(VK_KHR_draw_indirect_count)
+		vulkan_globals.vk_cmd_draw_indexed_indirect_count = GL_DiscardCmdDrawIndexedIndirectCount;
+#endif
+		vulkan_globals.vk_cmd_dispatch = GL_DiscardCmdDispatch;
+	}
 }
 
 /*
@@ -1261,7 +1499,7 @@ static void GL_CreateRenderPasses ()
 		attachment_descriptions[1].samples = vulkan_globals.sample_count;
 		attachment_descriptions[1].format = vulkan_globals.depth_format;
 		attachment_descriptions[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		attachment_descriptions[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachment_descriptions[1].storeOp = vulkan_globals.occlusion_culling ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		attachment_descriptions[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 		attachment_descriptions[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
@@ -1294,6 +1532,18 @@ static void GL_CreateRenderPasses ()
 		if (resolve)
 			subpass_description.pResolveAttachments = &resolve_attachment_reference;
 
+		// the depth buffer of the last frame is still read by the Hi-Z build when it is cleared
+		VkSubpassDependency hiz_dependency;
+		memset (&hiz_dependency, 0, sizeof (hiz_dependency));
+		hiz_dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+		hiz_dependency.dstSubpass = 0;
+		hiz_dependency.srcStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		hiz_dependency.dstStageMask =
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		hiz_dependency.srcAccessMask = 0;
+		hiz_dependency.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+		                               VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
 		VkRenderPassCreateInfo render_pass_create_info;
 		memset (&render_pass_create_info, 0, sizeof (render_pass_create_info));
 		render_pass_create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -1301,6 +1551,11 @@ static void GL_CreateRenderPasses ()
 		render_pass_create_info.pAttachments = attachment_descriptions;
 		render_pass_create_info.subpassCount = 1;
 		render_pass_create_info.pSubpasses = &subpass_description;
+		if (vulkan_globals.occlusion_culling)
+		{
+			render_pass_create_info.dependencyCount = 1;
+			render_pass_create_info.pDependencies = &hiz_dependency;
+		}
 
 		for (int cbx_index = CBX_WORLD_0; cbx_index <= CBX_VIEW_MODEL; ++cbx_index)
 			assert (vulkan_globals.secondary_cb_contexts[cbx_index].render_pass == VK_NULL_HANDLE);
@@ -1459,6 +1714,13 @@ static void GL_CreateDepthBuffer (void)
 
 	VkResult err;
 
+	// occlusion culling builds its Hi-Z pyramid from the depth buffer
+	VkFormatProperties format_properties;
+	vkGetPhysicalDeviceFormatProperties (vulkan_physical_device, vulkan_globals.depth_format, &format_properties);
+	vulkan_globals.occlusion_culling = vulkan_globals.conditional_rendering &&
+	                                   ((format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0) &&
+	                                   ((vulkan_globals.device_properties.limits.sampledImageDepthSampleCounts & vulkan_globals.sample_count) != 0);
+
 	VkImageCreateInfo image_create_info;
 	memset (&image_create_info, 0, sizeof (image_create_info));
 	image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -1473,6 +1735,8 @@ static void GL_CreateDepthBuffer (void)
 	image_create_info.samples = vulkan_globals.sample_count;
 	image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
 	image_create_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	if (vulkan_globals.occlusion_culling)
+		image_create_info.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
 
 	assert (depth_buffer == VK_NULL_HANDLE);
 	err = vkCreateImage (vulkan_globals.device, &image_create_info, NULL, &depth_buffer);
@@ -1528,6 +1792,99 @@ static void GL_CreateDepthBuffer (void)
 	GL_SetObjectName ((uint64_t)depth_buffer_view, VK_OBJECT_TYPE_IMAGE_VIEW, "Depth Buffer View");
 }
 
+/*
+===============
+GL_CreateHiZBuffer
+
+Min depth pyramid for occlusion culling. Level 0 is half the resolution of the depth buffer.
+===============
+*/
+static void GL_CreateHiZBuffer (void)
+{
+	hiz_ready = false;
+	if (!vulkan_globals.occlusion_culling)
+		return;
+
+	Sys_Printf ("Creating Hi-Z buffer\n");
+
+	VkResult err;
+
+	hiz_width = q_max (1, vid.width / 2);
+	hiz_height = q_max (1, vid.height / 2);
+	hiz_num_levels = 1;
+	while ((hiz_num_levels < MAX_HIZ_LEVELS) && (((hiz_width | hiz_height) >> hiz_num_levels) != 0))
+		++hiz_num_levels;
+
+	VkImageCreateInfo image_create_info;
+	memset (&image_create_info, 0, sizeof (image_create_info));
+	image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	image_create_info.imageType = VK_IMAGE_TYPE_2D;
+	image_create_info.format = VK_FORMAT_R32_SFLOAT;
+	image_create_info.extent.width = hiz_width;
+	image_create_info.extent.height = hiz_height;
+	image_create_info.extent.depth = 1;
+	image_create_info.mipLevels = hiz_num_levels;
+	image_create_info.arrayLayers = 1;
+	image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+	image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	image_create_info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	assert (hiz_image == VK_NULL_HANDLE);
+	err = vkCreateImage (vulkan_globals.device, &image_create_info, NULL, &hiz_image);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreateImage failed");
+
+	GL_SetObjectName ((uint64_t)hiz_image, VK_OBJECT_TYPE_IMAGE, "Hi-Z Buffer");
+
+	VkMemoryRequirements memory_requirements;
+	vkGetImageMemoryRequirements (vulkan_globals.device, hiz_image, &memory_requirements);
+
+	VkMemoryAllocateInfo memory_allocate_info;
+	memset (&memory_allocate_info, 0, sizeof (memory_allocate_info));
+	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memory_allocate_info.allocationSize = memory_requirements.size;
+	memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties (memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+
+	assert (hiz_memory.handle == VK_NULL_HANDLE);
+	Atomic_IncrementUInt32 (&num_vulkan_misc_allocations);
+	R_AllocateVulkanMemory (&hiz_memory, &memory_allocate_info, VULKAN_MEMORY_TYPE_DEVICE);
+	GL_SetObjectName ((uint64_t)hiz_memory.handle, VK_OBJECT_TYPE_DEVICE_MEMORY, "Hi-Z Buffer");
+
+	err = vkBindImageMemory (vulkan_globals.device, hiz_image, hiz_memory.handle, 0);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkBindImageMemory failed");
+
+	VkImageViewCreateInfo image_view_create_info;
+	memset (&image_view_create_info, 0, sizeof (image_view_create_info));
+	image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	image_view_create_info.format = VK_FORMAT_R32_SFLOAT;
+	image_view_create_info.image = hiz_image;
+	image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	image_view_create_info.subresourceRange.baseMipLevel = 0;
+	image_view_create_info.subresourceRange.levelCount = hiz_num_levels;
+	image_view_create_info.subresourceRange.baseArrayLayer = 0;
+	image_view_create_info.subresourceRange.layerCount = 1;
+	image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+
+	assert (hiz_view == VK_NULL_HANDLE);
+	err = vkCreateImageView (vulkan_globals.device, &image_view_create_info, NULL, &hiz_view);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreateImageView failed");
+	GL_SetObjectName ((uint64_t)hiz_view, VK_OBJECT_TYPE_IMAGE_VIEW, "Hi-Z Buffer View");
+
+	image_view_create_info.subresourceRange.levelCount = 1;
+	for (int i = 0; i < hiz_num_levels; ++i)
+	{
+		image_view_create_info.subresourceRange.baseMipLevel = i;
+		assert (hiz_level_views[i] == VK_NULL_HANDLE);
+		err = vkCreateImageView (vulkan_globals.device, &image_view_create_info, NULL, &hiz_level_views[i]);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkCreateImageView failed");
+		GL_SetObjectName ((uint64_t)hiz_level_views[i], VK_OBJECT_TYPE_IMAGE_VIEW, va ("Hi-Z Buffer Level %d", i));
+	}
+}
+
 /*
 ===============
 GL_CreateColorBuffer
@@ -1812,6 +2169,50 @@ static void GL_UpdateDescriptorSets (void)
 	screen_effects_writes[4].pBufferInfo = &palette_octree_info;
 
 	vkUpdateDescriptorSets (vulkan_globals.device, 5, screen_effects_writes, 0, NULL);
+
+	if (hiz_image != VK_NULL_HANDLE)
+	{
+		VkDescriptorImageInfo hiz_image_infos[MAX_HIZ_LEVELS + 2];
+		VkWriteDescriptorSet  hiz_writes[MAX_HIZ_LEVELS + 2];
+		memset (hiz_image_infos, 0, sizeof (hiz_image_infos));
+		memset (hiz_writes, 0, sizeof (hiz_writes));
+
+		assert (depth_buffer_desc_set == VK_NULL_HANDLE);
+		depth_buffer_desc_set = R_AllocateDescriptorSet (&vulkan_globals.single_texture_set_layout);
+		hiz_image_infos[0].imageView = depth_buffer_view;
+		hiz_image_infos[0].imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		hiz_image_infos[0].sampler = vulkan_globals.point_sampler;
+		hiz_writes[0].dstSet = depth_buffer_desc_set;
+		hiz_writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+		assert (vulkan_globals.hiz_desc_set == VK_NULL_HANDLE);
+		vulkan_globals.hiz_desc_set = R_AllocateDescriptorSet (&vulkan_globals.single_texture_set_layout);
+		hiz_image_infos[1].imageView = hiz_view;
+		hiz_image_infos[1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		hiz_image_infos[1].sampler = vulkan_globals.point_sampler;
+		hiz_writes[1].dstSet = vulkan_globals.hiz_desc_set;
+		hiz_writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+		for (int i = 0; i < hiz_num_levels; ++i)
+		{
+			assert (hiz_level_desc_sets[i] == VK_NULL_HANDLE);
+			hiz_level_desc_sets[i] = R_AllocateDescriptorSet (&vulkan_globals.single_texture_cs_write_set_layout);
+			hiz_image_infos[i + 2].imageView = hiz_level_views[i];
+			hiz_image_infos[i + 2].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			hiz_writes[i + 2].dstSet = hiz_level_desc_sets[i];
+			hiz_writes[i + 2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		}
+
+		for (int i = 0; i < hiz_num_levels + 2; ++i)
+		{
+			hiz_writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			hiz_writes[i].dstBinding = 0;
+			hiz_writes[i].dstArrayElement = 0;
+			hiz_writes[i].descriptorCount = 1;
+			hiz_writes[i].pImageInfo = &hiz_image_infos[i];
+		}
+		vkUpdateDescriptorSets (vulkan_globals.device, hiz_num_levels + 2, hiz_writes, 0, NULL);
+	}
 }
 
 /*
@@ -2154,11 +2555,17 @@ static void GL_CreateRenderResources (void)
 
 	GL_CreateColorBuffer ();
 	GL_CreateDepthBuffer ();
+	GL_CreateHiZBuffer ();
 	GL_CreateRenderPasses ();
 	GL_CreateFrameBuffers ();
 	R_CreatePipelines ();
 	GL_UpdateDescriptorSets ();
 
+	// screenshots requested before a vid_restart are taken from the new swap chain
+	for (int i = 0; i < MAX_PENDING_SCREENSHOTS; ++i)
+		if (Atomic_LoadUInt32 (&screenshots[i].state) == SCREENSHOT_REQUESTED)
+			GL_CreateScreenShotRing ();
+
 	render_resources_created = true;
 }
 
@@ -2175,6 +2582,10 @@ static void GL_DestroyRenderResources (void)
 
 	GL_WaitForDeviceIdle ();
 
+	// the readback slots are sized for this swap chain
+	GL_FlushScreenShots ();
+	GL_DestroyScreenShotRing ();
+
 	R_DestroyPipelines ();
 
 	R_FreeDescriptorSet (postprocess_descriptor_set, &vulkan_globals.input_attachment_set_layout);
@@ -2183,6 +2594,32 @@ static void GL_DestroyRenderResources (void)
 	R_FreeDescriptorSet (vulkan_globals.screen_effects_desc_set, &vulkan_globals.screen_effects_set_layout);
 	vulkan_globals.screen_effects_desc_set = VK_NULL_HANDLE;
 
+	if (hiz_image != VK_NULL_HANDLE)
+	{
+		R_FreeDescriptorSet (depth_buffer_desc_set, &vulkan_globals.single_texture_set_layout);
+		depth_buffer_desc_set = VK_NULL_HANDLE;
+		R_FreeDescriptorSet (vulkan_globals.hiz_desc_set, &vulkan_globals.single_texture_set_layout);
+		vulkan_globals.hiz_desc_set = VK_NULL_HANDLE;
+
+		for (i = 0; i < (uint32_t)hiz_num_levels; ++i)
+		{
+			R_FreeDescriptorSet (hiz_level_desc_sets[i], &vulkan_globals.single_texture_cs_write_set_layout);
+			hiz_level_desc_sets[i] = VK_NULL_HANDLE;
+			vkDestroyImageView (vulkan_globals.device, hiz_level_views[i], NULL);
+			hiz_level_views[i] = VK_NULL_HANDLE;
+		}
+
+		vkDestroyImageView (vulkan_globals.device, hiz_view, NULL);
+		vkDestroyImage (vulkan_globals.device, hiz_image, NULL);
+		Atomic_DecrementUInt32 (&num_vulkan_misc_allocations);
+		R_FreeVulkanMemory (&hiz_memory);
+
+		hiz_view = VK_NULL_HANDLE;
+		hiz_image = VK_NULL_HANDLE;
+		hiz_num_levels = 0;
+		hiz_ready = false;
+	}
+
 	if (msaa_color_buffer)
 	{
 		vkDestroyImageView (vulkan_globals.device, msaa_color_buffer_view, NULL);
@@ -2261,6 +2698,7 @@ void GL_BeginRenderingTask (void *unused)
 		err = vkWaitForFences (vulkan_globals.device, 1, &command_buffer_fences[current_cb_index], VK_TRUE, UINT64_MAX);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkWaitForFences failed");
+		GL_EncodeScreenShots (current_cb_index);
 	}
 
 	err = vkResetFences (vulkan_globals.device, 1, &command_buffer_fences[current_cb_index]);
@@ -2276,6 +2714,7 @@ void GL_BeginRenderingTask (void *unused)
 		cbx->cb = primary_command_buffers[current_cb_index];
 		cbx->current_canvas = CANVAS_INVALID;
 		memset (&cbx->current_pipeline, 0, sizeof (cbx->current_pipeline));
+		cbx->alias_model = NULL;
 
 		VkCommandBufferBeginInfo command_buffer_begin_info;
 		memset (&command_buffer_begin_info, 0, sizeof (command_buffer_begin_info));
@@ -2285,6 +2724,10 @@ void GL_BeginRenderingTask (void *unused)
 		err = vkBeginCommandBuffer (cbx->cb, &command_buffer_begin_info);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkBeginCommandBuffer failed");
+
+		R_BeginOcclusionCulling (current_cb_index);
+		R_BeginParticles (current_cb_index);
+		R_BeginWorldCulling (current_cb_index);
 	}
 
 	for (int cbx_index = 0; cbx_index < CBX_NUM; ++cbx_index)
@@ -2293,6 +2736,7 @@ void GL_BeginRenderingTask (void *unused)
 		cbx->cb = secondary_command_buffers[cbx_index][current_cb_index];
 		cbx->current_canvas = CANVAS_INVALID;
 		memset (&cbx->current_pipeline, 0, sizeof (cbx->current_pipeline));
+		cbx->alias_model = NULL;
 
 		VkCommandBufferInheritanceInfo inheritance_info;
 		memset (&inheritance_info, 0, sizeof (inheritance_info));
@@ -2468,6 +2912,7 @@ typedef struct end_rendering_parms_s
 	qboolean render_warp   : 1;
 	qboolean vid_palettize : 1;
 	uint32_t render_scale  : 4;
+	qboolean occlusion_cull : 1;
 	uint32_t vid_height    : 20;
 	float    time;
 	uint8_t  v_blend[4];
@@ -2566,7 +3011,7 @@ static void GL_ScreenEffects (cb_context_t *cbx, qboolean enabled, end_rendering
 			(float)parms->v_blend[3] / 255.0f};
 		R_PushConstants (cbx, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof (screen_effect_constants_t), &push_constants);
 
-		vkCmdDispatch (cbx->cb, (parms->vid_width + 7) / 8, (parms->vid_height + 7) / 8, 1);
+		vulkan_globals.vk_cmd_dispatch (cbx->cb, (parms->vid_width + 7) / 8, (parms->vid_height + 7) / 8, 1);
 
 		image_barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 		image_barriers[0].pNext = NULL;
@@ -2601,6 +3046,83 @@ static void GL_ScreenEffects (cb_context_t *cbx, qboolean enabled, end_rendering
 	}
 }
 
+/*
+=================
+GL_BuildHiZ
+
+Reduces the depth buffer of this frame into the Hi-Z pyramid the next frame tests against
+=================
+*/
+static void GL_BuildHiZ (cb_context_t *cbx)
+{
+	R_BeginDebugUtilsLabel (cbx, "Hi-Z");
+
+	VkImageMemoryBarrier image_barriers[2];
+	memset (image_barriers, 0, sizeof (image_barriers));
+	image_barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	image_barriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	image_barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	image_barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	image_barriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	image_barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barriers[0].image = depth_buffer;
+	image_barriers[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	image_barriers[0].subresourceRange.baseMipLevel = 0;
+	image_barriers[0].subresourceRange.levelCount = 1;
+	image_barriers[0].subresourceRange.baseArrayLayer = 0;
+	image_barriers[0].subresourceRange.layerCount = 1;
+
+	// the previous contents were only read by the occlusion test at the start of this frame
+	image_barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	image_barriers[1].srcAccessMask = 0;
+	image_barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	image_barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	image_barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	image_barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barriers[1].image = hiz_image;
+	image_barriers[1].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	image_barriers[1].subresourceRange.baseMipLevel = 0;
+	image_barriers[1].subresourceRange.levelCount = hiz_num_levels;
+	image_barriers[1].subresourceRange.baseArrayLayer = 0;
+	image_barriers[1].subresourceRange.layerCount = 1;
+
+	vulkan_globals.vk_cmd_pipeline_barrier (
+		cbx->cb, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0, NULL,
+		2, image_barriers);
+
+	VkMemoryBarrier memory_barrier;
+	memset (&memory_barrier, 0, sizeof (memory_barrier));
+	memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	for (int level = 0; level < hiz_num_levels; ++level)
+	{
+		const uint32_t  src_level = (level > 0) ? (level - 1) : 0;
+		VkDescriptorSet sets[2] = {(level > 0) ? vulkan_globals.hiz_desc_set : depth_buffer_desc_set, hiz_level_desc_sets[level]};
+		if (level == 0)
+			R_BindPipeline (
+				cbx, VK_PIPELINE_BIND_POINT_COMPUTE,
+				(vulkan_globals.sample_count != VK_SAMPLE_COUNT_1_BIT) ? vulkan_globals.hiz_reduce_ms_pipeline : vulkan_globals.hiz_reduce_pipeline);
+		else
+			R_BindPipeline (cbx, VK_PIPELINE_BIND_POINT_COMPUTE, vulkan_globals.hiz_reduce_pipeline);
+		vkCmdBindDescriptorSets (cbx->cb, VK_PIPELINE_BIND_POINT_COMPUTE, vulkan_globals.hiz_reduce_pipeline.layout.handle, 0, 2, sets, 0, NULL);
+		R_PushConstants (cbx, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof (uint32_t), &src_level);
+
+		const int level_width = q_max (1, hiz_width >> level);
+		const int level_height = q_max (1, hiz_height >> level);
+		vulkan_globals.vk_cmd_dispatch (cbx->cb, (level_width + 7) / 8, (level_height + 7) / 8, 1);
+
+		// also makes the last level visible to the occlusion test of the next frame
+		vulkan_globals.vk_cmd_pipeline_barrier (
+			cbx->cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memory_barrier, 0, NULL, 0, NULL);
+	}
+
+	R_EndDebugUtilsLabel (cbx);
+}
+
 /*
 =================
 GL_EndRenderingTask
@@ -2627,7 +3149,7 @@ static void GL_EndRenderingTask (end_rendering_parms_t *parms)
 		vkCmdBindDescriptorSets (
 			cbx->cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.postprocess_pipeline.layout.handle, 0, 1, &postprocess_descriptor_set, 0, NULL);
 		R_PushConstants (cbx, VK_SHADER_STAGE_FRAGMENT_BIT, 0, 2 * sizeof (float), postprocess_values);
-		vkCmdDraw (cbx->cb, 3, 1, 0, 0);
+		vulkan_globals.vk_cmd_draw (cbx->cb, 3, 1, 0, 0);
 	}
 
 	for (int cbx_index = 0; cbx_index < CBX_NUM; ++cbx_index)
@@ -2657,6 +3179,11 @@ static void GL_EndRenderingTask (end_rendering_parms_t *parms)
 
 	vkCmdExecuteCommands (primary_cb, 1, &vulkan_globals.secondary_cb_contexts[CBX_UPDATE_LIGHTMAPS].cb);
 
+	if (parms->occlusion_cull)
+		R_CullOccludedEntities (&vulkan_globals.primary_cb_context, cb_index, hiz_ready ? hiz_num_levels : 0);
+	R_SimulateParticles (&vulkan_globals.primary_cb_context, cb_index);
+	R_CullWorldSurfaces (&vulkan_globals.primary_cb_context, cb_index);
+
 	const qboolean screen_effects = parms->render_warp || (parms->render_scale >= 2) || parms->vid_palettize || (gl_polyblend.value && parms->v_blend[3]);
 	{
 		const qboolean        resolve = (vulkan_globals.sample_count != VK_SAMPLE_COUNT_1_BIT);
@@ -2674,6 +3201,10 @@ static void GL_EndRenderingTask (end_rendering_parms_t *parms)
 		vkCmdEndRenderPass (primary_cb);
 	}
 
+	hiz_ready = parms->occlusion_cull && (hiz_image != VK_NULL_HANDLE);
+	if (hiz_ready)
+		GL_BuildHiZ (&vulkan_globals.primary_cb_context);
+
 	GL_ScreenEffects (&vulkan_globals.primary_cb_context, screen_effects, parms);
 
 	{
@@ -2691,6 +3222,9 @@ static void GL_EndRenderingTask (end_rendering_parms_t *parms)
 		vkCmdEndRenderPass (primary_cb);
 	}
 
+	if (swapchain_acquired == true)
+		GL_CaptureScreenShots (primary_cb, cb_index, parms->vid_width, parms->vid_height);
+
 	{
 		VkSubmitInfo submit_info;
 		err = vkEndCommandBuffer (primary_cb);
@@ -2757,6 +3291,7 @@ task_handle_t GL_EndRendering (qboolean use_tasks, qboolean swapchain)
 		.render_warp = render_warp,
 		.vid_palettize = vid_palettize.value != 0,
 		.render_scale = CLAMP (0, render_scale, 8),
+		.occlusion_cull = R_OcclusionCullingActive (),
 		.vid_width = vid.width,
 		.vid_height = vid.height,
 		.time = fmod (cl.time, 2.0 * M_PI),
@@ -2800,6 +3335,10 @@ void VID_Shutdown (void)
 {
 	if (vid_initialized)
 	{
+		// nothing is waited on when shutting down from an error, which may come from a task
+		if (!host_parms->errstate)
+			GL_FlushScreenShots ();
+		R_DestroyPipelineCache ();
 		SDL_QuitSubSystem (SDL_INIT_VIDEO);
 		draw_context = NULL;
 		PL_VID_Shutdown ();
@@ -4039,201 +4578,491 @@ static void SCR_ScreenShot_Usage (void)
 
 /*
 ==================
-SCR_ScreenShot_f -- johnfitz -- rewritten to use Image_WriteTGA
+SCR_FindScreenShot -- returns a free slot, or NULL if too many screenshots are in flight
 ==================
 */
-void SCR_ScreenShot_f (void)
+static screenshot_t *SCR_FindScreenShot (void)
 {
-	VkBuffer buffer;
-	VkResult err;
-	char     ext[4];
-	char     imagename[16]; // johnfitz -- was [80]
-	char     checkname[MAX_OSPATH];
-	int      i, quality;
-	qboolean ok;
+	for (int i = 0; i < MAX_PENDING_SCREENSHOTS; ++i)
+		if (Atomic_LoadUInt32 (&screenshots[i].state) == SCREENSHOT_FREE)
+			return &screenshots[i];
+	return NULL;
+}
 
-	qboolean bgra = (vulkan_globals.swap_chain_format == VK_FORMAT_B8G8R8A8_UNORM) || (vulkan_globals.swap_chain_format == VK_FORMAT_B8G8R8A8_SRGB);
+/*
+==================
+SCR_ScreenShotNamePending
+==================
+*/
+static qboolean SCR_ScreenShotNamePending (const char *name)
+{
+	for (int i = 0; i < MAX_PENDING_SCREENSHOTS; ++i)
+		if ((Atomic_LoadUInt32 (&screenshots[i].state) != SCREENSHOT_FREE) && !strcmp (screenshots[i].name, name))
+			return true;
+	return false;
+}
 
-	memcpy (ext, "png", sizeof (ext));
+/*
+==================
+SCR_MapScreenShot -- returns the pixels as RGBA
+==================
+*/
+static byte *SCR_MapScreenShot (screenshot_t *shot)
+{
+	byte *data = screenshot_ring.data + ((shot - screenshots) * screenshot_ring.slot_size);
 
-	if (Cmd_Argc () >= 2)
+	if (shot->bgra)
 	{
-		const char *requested_ext = Cmd_Argv (1);
-
-		if (!q_strcasecmp ("png", requested_ext) || !q_strcasecmp ("tga", requested_ext) || !q_strcasecmp ("jpg", requested_ext))
-			memcpy (ext, requested_ext, sizeof (ext));
-		else
+		const int size = shot->width * shot->height * 4;
+		for (int i = 0; i < size; i += 4)
 		{
-			SCR_ScreenShot_Usage ();
-			return;
+			const byte temp = data[i];
+			data[i] = data[i + 2];
+			data[i + 2] = temp;
 		}
 	}
+	return data;
+}
 
-	// read quality as the 3rd param (only used for JPG)
-	quality = 90;
-	if (Cmd_Argc () >= 3)
-		quality = atoi (Cmd_Argv (2));
-	if (quality < 1 || quality > 100)
-	{
-		SCR_ScreenShot_Usage ();
-		return;
-	}
+/*
+==================
+SCR_ReleaseScreenShot
+==================
+*/
+static void SCR_ReleaseScreenShot (screenshot_t *shot)
+{
+	Atomic_StoreUInt32 (&shot->state, SCREENSHOT_FREE);
+}
 
-	if ((vulkan_globals.swap_chain_format != VK_FORMAT_B8G8R8A8_UNORM) && (vulkan_globals.swap_chain_format != VK_FORMAT_B8G8R8A8_SRGB) &&
-	    (vulkan_globals.swap_chain_format != VK_FORMAT_R8G8B8A8_UNORM) && (vulkan_globals.swap_chain_format != VK_FORMAT_R8G8B8A8_SRGB))
-	{
-		Con_Printf ("SCR_ScreenShot_f: Unsupported surface format\n");
-		return;
-	}
+/*
+==================
+SCR_EncodeScreenShotTask
+==================
+*/
+static void SCR_EncodeScreenShotTask (screenshot_t **pshot)
+{
+	screenshot_t *shot = *pshot;
+	byte         *data = SCR_MapScreenShot (shot);
+	qboolean      ok;
+
+	if (!q_strncasecmp (shot->ext, "png", sizeof (shot->ext)))
+		ok = Image_WritePNG (shot->name, data, shot->width, shot->height, 32, true);
+	else if (!q_strncasecmp (shot->ext, "tga", sizeof (shot->ext)))
+		ok = Image_WriteTGA (shot->name, data, shot->width, shot->height, 32, true);
+	else if (!q_strncasecmp (shot->ext, "jpg", sizeof (shot->ext)))
+		ok = Image_WriteJPG (shot->name, data, shot->width, shot->height, 32, shot->quality, true);
+	else
+		ok = false;
 
-	// find a file name to save it to
-	for (i = 0; i < 10000; i++)
-	{
-		q_snprintf (imagename, sizeof (imagename), "vkquake%04i.%s", i, ext); // "fitz%04cbx_index.tga"
-		q_snprintf (checkname, sizeof (checkname), "%s/%s", com_gamedir, imagename);
-		if (Sys_FileTime (checkname) == -1)
-			break; // file doesn't exist
-	}
-	if (i == 10000)
-	{
-		Con_Printf ("SCR_ScreenShot_f: Couldn't find an unused filename\n");
+	if (ok)
+		Con_Printf ("Wrote %s\n", shot->name);
+	else
+		Con_Printf ("SCR_ScreenShot_f: Couldn't create %s\n", shot->name);
+
+	SCR_ReleaseScreenShot (shot);
+}
+
+/*
+==================
+SCR_WriteVideoFrameTask -- frames are chained so they reach the capture output in order
+==================
+*/
+static void SCR_WriteVideoFrameTask (screenshot_t **pshot)
+{
+	screenshot_t *shot = *pshot;
+	CL_CaptureVideoFrame (SCR_MapScreenShot (shot), shot->width, shot->height);
+	SCR_ReleaseScreenShot (shot);
+}
+
+/*
+==================
+GL_CreateScreenShotRing -- main thread only, while no end rendering task is running
+==================
+*/
+static void GL_CreateScreenShotRing (void)
+{
+	VkResult err;
+
+	if (screenshot_ring.buffer != VK_NULL_HANDLE)
 		return;
-	}
 
-	// get data
+	screenshot_ring.width = vid.width;
+	screenshot_ring.height = vid.height;
+	screenshot_ring.slot_size = (VkDeviceSize)vid.width * vid.height * 4;
+
 	VkBufferCreateInfo buffer_create_info;
 	memset (&buffer_create_info, 0, sizeof (buffer_create_info));
 	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	buffer_create_info.size = glwidth * glheight * 4;
+	buffer_create_info.size = MAX_PENDING_SCREENSHOTS * screenshot_ring.slot_size;
 	buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-	err = vkCreateBuffer (vulkan_globals.device, &buffer_create_info, NULL, &buffer);
+	err = vkCreateBuffer (vulkan_globals.device, &buffer_create_info, NULL, &screenshot_ring.buffer);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateBuffer failed");
+	GL_SetObjectName ((uint64_t)screenshot_ring.buffer, VK_OBJECT_TYPE_BUFFER, "Screenshot Readback");
 
 	VkMemoryRequirements memory_requirements;
-	vkGetBufferMemoryRequirements (vulkan_globals.device, buffer, &memory_requirements);
-
-	uint32_t memory_type_index = GL_MemoryTypeFromProperties (
-		memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+	vkGetBufferMemoryRequirements (vulkan_globals.device, screenshot_ring.buffer, &memory_requirements);
 
 	VkMemoryAllocateInfo memory_allocate_info;
 	memset (&memory_allocate_info, 0, sizeof (memory_allocate_info));
 	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 	memory_allocate_info.allocationSize = memory_requirements.size;
-	memory_allocate_info.memoryTypeIndex = memory_type_index;
+	memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties (
+		memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
 
-	VkDeviceMemory memory;
-	err = vkAllocateMemory (vulkan_globals.device, &memory_allocate_info, NULL, &memory);
-	if (err != VK_SUCCESS)
-		Sys_Error ("vkAllocateMemory failed");
+	Atomic_IncrementUInt32 (&num_vulkan_misc_allocations);
+	R_AllocateVulkanMemory (&screenshot_ring.memory, &memory_allocate_info, VULKAN_MEMORY_TYPE_HOST);
+	GL_SetObjectName ((uint64_t)screenshot_ring.memory.handle, VK_OBJECT_TYPE_DEVICE_MEMORY, "Screenshot Readback");
 
-	err = vkBindBufferMemory (vulkan_globals.device, buffer, memory, 0);
+	err = vkBindBufferMemory (vulkan_globals.device, screenshot_ring.buffer, screenshot_ring.memory.handle, 0);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkBindBufferMemory failed");
 
-	VkCommandBuffer command_buffer;
-
-	VkCommandBufferAllocateInfo command_buffer_allocate_info;
-	memset (&command_buffer_allocate_info, 0, sizeof (command_buffer_allocate_info));
-	command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	command_buffer_allocate_info.commandPool = transient_command_pool;
-	command_buffer_allocate_info.commandBufferCount = 1;
-	err = vkAllocateCommandBuffers (vulkan_globals.device, &command_buffer_allocate_info, &command_buffer);
+	void *data;
+	err = vkMapMemory (vulkan_globals.device, screenshot_ring.memory.handle, 0, VK_WHOLE_SIZE, 0, &data);
 	if (err != VK_SUCCESS)
-		Sys_Error ("vkAllocateCommandBuffers failed");
+		Sys_Error ("vkMapMemory failed");
+	screenshot_ring.data = (byte *)data;
+}
 
-	VkCommandBufferBeginInfo command_buffer_begin_info;
-	memset (&command_buffer_begin_info, 0, sizeof (command_buffer_begin_info));
-	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+/*
+==================
+GL_DestroyScreenShotRing -- every copy has to be written out first
+==================
+*/
+static void GL_DestroyScreenShotRing (void)
+{
+	if (screenshot_ring.buffer == VK_NULL_HANDLE)
+		return;
 
-	err = vkBeginCommandBuffer (command_buffer, &command_buffer_begin_info);
-	if (err != VK_SUCCESS)
-		Sys_Error ("vkBeginCommandBuffer failed");
-
-	VkImageMemoryBarrier image_barrier;
-	image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	image_barrier.pNext = NULL;
-	image_barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	image_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-	image_barrier.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-	image_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-	image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	image_barrier.image = swapchain_images[current_cb_index];
-	image_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	image_barrier.subresourceRange.baseMipLevel = 0;
-	image_barrier.subresourceRange.levelCount = 1;
-	image_barrier.subresourceRange.baseArrayLayer = 0;
-	image_barrier.subresourceRange.layerCount = 1;
-
-	vkCmdPipelineBarrier (
-		command_buffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &image_barrier);
-
-	VkBufferImageCopy image_copy;
-	memset (&image_copy, 0, sizeof (image_copy));
-	image_copy.bufferOffset = 0;
-	image_copy.bufferRowLength = glwidth;
-	image_copy.bufferImageHeight = glheight;
-	image_copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	image_copy.imageSubresource.layerCount = 1;
-	image_copy.imageExtent.width = glwidth;
-	image_copy.imageExtent.height = glheight;
-	image_copy.imageExtent.depth = 1;
-
-	vkCmdCopyImageToBuffer (command_buffer, swapchain_images[current_cb_index], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &image_copy);
-
-	err = vkEndCommandBuffer (command_buffer);
-	if (err != VK_SUCCESS)
-		Sys_Error ("vkEndCommandBuffer failed");
+	vkUnmapMemory (vulkan_globals.device, screenshot_ring.memory.handle);
+	Atomic_DecrementUInt32 (&num_vulkan_misc_allocations);
+	R_FreeVulkanMemory (&screenshot_ring.memory);
+	vkDestroyBuffer (vulkan_globals.device, screenshot_ring.buffer, NULL);
+	memset (&screenshot_ring, 0, sizeof (screenshot_ring));
+}
 
-	VkSubmitInfo submit_info;
-	memset (&submit_info, 0, sizeof (submit_info));
-	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submit_info.commandBufferCount = 1;
-	submit_info.pCommandBuffers = &command_buffer;
+/*
+==================
+GL_PrepareScreenShot -- called before a slot is marked as requested
+==================
+*/
+static void GL_PrepareScreenShot (void)
+{
+	if (screenshot_ring.buffer != VK_NULL_HANDLE)
+		return;
+	// the end rendering task reads the ring
+	GL_SynchronizeEndRenderingTask ();
+	GL_CreateScreenShotRing ();
+}
 
-	err = vkQueueSubmit (vulkan_globals.queue, 1, &submit_info, VK_NULL_HANDLE);
-	if (err != VK_SUCCESS)
-		Sys_Error ("vkQueueSubmit failed");
+/*
+==================
+GL_CaptureScreenShots -- records the copy of the finished swap chain image into the frame's command buffer
+==================
+*/
+static void GL_CaptureScreenShots (VkCommandBuffer command_buffer, int cb_index, int width, int height)
+{
+	// the ring is created with the swap chain whenever something was requested
+	if ((screenshot_ring.buffer == VK_NULL_HANDLE) || (screenshot_ring.width != width) || (screenshot_ring.height != height))
+		return;
 
-	err = vkDeviceWaitIdle (vulkan_globals.device);
-	if (err != VK_SUCCESS)
-		Sys_Error ("vkDeviceWaitIdle failed");
+	for (int i = 0; i < MAX_PENDING_SCREENSHOTS; ++i)
+	{
+		screenshot_t *shot = &screenshots[i];
+		if (Atomic_LoadUInt32 (&shot->state) != SCREENSHOT_REQUESTED)
+			continue;
+
+		VkImageMemoryBarrier image_barrier;
+		image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		image_barrier.pNext = NULL;
+		image_barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		image_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		image_barrier.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		image_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		image_barrier.image = swapchain_images[current_swapchain_buffer];
+		image_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		image_barrier.subresourceRange.baseMipLevel = 0;
+		image_barrier.subresourceRange.levelCount = 1;
+		image_barrier.subresourceRange.baseArrayLayer = 0;
+		image_barrier.subresourceRange.layerCount = 1;
+
+		vkCmdPipelineBarrier (
+			command_buffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &image_barrier);
+
+		VkBufferImageCopy image_copy;
+		memset (&image_copy, 0, sizeof (image_copy));
+		image_copy.bufferOffset = i * screenshot_ring.slot_size;
+		image_copy.bufferRowLength = width;
+		image_copy.bufferImageHeight = height;
+		image_copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		image_copy.imageSubresource.layerCount = 1;
+		image_copy.imageExtent.width = width;
+		image_copy.imageExtent.height = height;
+		image_copy.imageExtent.depth = 1;
+
+		vkCmdCopyImageToBuffer (
+			command_buffer, swapchain_images[current_swapchain_buffer], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, screenshot_ring.buffer, 1, &image_copy);
+
+		// hand the image back to the presentation engine
+		image_barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		image_barrier.dstAccessMask = 0;
+		image_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		image_barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		vkCmdPipelineBarrier (command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, 0, NULL, 1, &image_barrier);
+
+		VkBufferMemoryBarrier buffer_barrier;
+		memset (&buffer_barrier, 0, sizeof (buffer_barrier));
+		buffer_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		buffer_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		buffer_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		buffer_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		buffer_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		buffer_barrier.buffer = screenshot_ring.buffer;
+		buffer_barrier.offset = image_copy.bufferOffset;
+		buffer_barrier.size = screenshot_ring.slot_size;
+		vkCmdPipelineBarrier (command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, NULL, 1, &buffer_barrier, 0, NULL);
+
+		// the task is submitted once the frame fence has been waited on
+		if (shot->video)
+		{
+			shot->write_task = Task_AllocateAndAssignFunc ((task_func_t)SCR_WriteVideoFrameTask, &shot, sizeof (shot));
+			if (prev_video_write_task != INVALID_TASK_HANDLE)
+				Task_AddDependency (prev_video_write_task, shot->write_task);
+			prev_video_write_task = shot->write_task;
+			Atomic_IncrementUInt32 (&capture_frames_recorded);
+		}
+		else
+			shot->write_task = Task_AllocateAndAssignFunc ((task_func_t)SCR_EncodeScreenShotTask, &shot, sizeof (shot));
+
+		shot->width = width;
+		shot->height = height;
+		shot->cb_index = cb_index;
+		Atomic_StoreUInt32 (&shot->state, SCREENSHOT_CAPTURED);
+	}
+}
+
+/*
+==================
+GL_EncodeScreenShots -- called once the fence of cb_index has been waited on, so its copies are done
+==================
+*/
+static void GL_EncodeScreenShots (int cb_index)
+{
+	for (int i = 0; i < MAX_PENDING_SCREENSHOTS; ++i)
+	{
+		screenshot_t *shot = &screenshots[i];
+		uint32_t      state = Atomic_LoadUInt32 (&shot->state);
+		if ((state != SCREENSHOT_CAPTURED) || (shot->cb_index != cb_index))
+			continue;
+		// GL_PollScreenShots may race us for it
+		if (Atomic_CompareExchangeUInt32 (&shot->state, &state, SCREENSHOT_ENCODING))
+			Task_Submit (shot->write_task);
+	}
+}
+
+/*
+==================
+GL_PollScreenShots -- hands finished copies to their tasks without waiting for the next frame to begin
+==================
+*/
+static void GL_PollScreenShots (void)
+{
+	for (int i = 0; i < MAX_PENDING_SCREENSHOTS; ++i)
+	{
+		screenshot_t *shot = &screenshots[i];
+		uint32_t      state = Atomic_LoadUInt32 (&shot->state);
+		if ((state != SCREENSHOT_CAPTURED) || (vkGetFenceStatus (vulkan_globals.device, command_buffer_fences[shot->cb_index]) != VK_SUCCESS))
+			continue;
+		if (Atomic_CompareExchangeUInt32 (&shot->state, &state, SCREENSHOT_ENCODING))
+			Task_Submit (shot->write_task);
+	}
+}
+
+/*
+==================
+GL_FlushScreenShots -- writes every copied screenshot and waits for it, requests that weren't rendered yet are kept
+==================
+*/
+static void GL_FlushScreenShots (void)
+{
+	GL_WaitForDeviceIdle ();
+	GL_PollScreenShots ();
 
-	void *buffer_ptr;
-	vkMapMemory (vulkan_globals.device, memory, 0, glwidth * glheight * 4, 0, &buffer_ptr);
+	for (int i = 0; i < MAX_PENDING_SCREENSHOTS; ++i)
+		if (Atomic_LoadUInt32 (&screenshots[i].state) == SCREENSHOT_ENCODING)
+			Task_Join (screenshots[i].write_task, SDL_MUTEX_MAXWAIT);
+	prev_video_write_task = INVALID_TASK_HANDLE;
+}
 
-	if (bgra)
+/*
+==================
+SCR_FinishScreenShots -- renders the frame pending screenshots are waiting for, then writes them out
+==================
+*/
+void SCR_FinishScreenShots (void)
+{
+	for (int i = 0; i < MAX_PENDING_SCREENSHOTS; ++i)
 	{
-		byte     *data = (byte *)buffer_ptr;
-		const int size = glwidth * glheight * 4;
-		for (i = 0; i < size; i += 4)
+		if ((Atomic_LoadUInt32 (&screenshots[i].state) == SCREENSHOT_REQUESTED) && !screenshots[i].video)
 		{
-			const byte temp = data[i];
-			data[i] = data[i + 2];
-			data[i + 2] = temp;
+			SCR_UpdateScreen (false);
+			break;
 		}
 	}
+	GL_FlushScreenShots ();
+}
 
-	if (!q_strncasecmp (ext, "png", sizeof (ext)))
-		ok = Image_WritePNG (imagename, buffer_ptr, glwidth, glheight, 32, true);
-	else if (!q_strncasecmp (ext, "tga", sizeof (ext)))
-		ok = Image_WriteTGA (imagename, buffer_ptr, glwidth, glheight, 32, true);
-	else if (!q_strncasecmp (ext, "jpg", sizeof (ext)))
-		ok = Image_WriteJPG (imagename, buffer_ptr, glwidth, glheight, 32, quality, true);
-	else
-		ok = false;
+/*
+==================
+GL_ScreenShotFormatSupported
+==================
+*/
+static qboolean GL_ScreenShotFormatSupported (void)
+{
+	return (vulkan_globals.swap_chain_format == VK_FORMAT_B8G8R8A8_UNORM) || (vulkan_globals.swap_chain_format == VK_FORMAT_B8G8R8A8_SRGB) ||
+		   (vulkan_globals.swap_chain_format == VK_FORMAT_R8G8B8A8_UNORM) || (vulkan_globals.swap_chain_format == VK_FORMAT_R8G8B8A8_SRGB);
+}
 
-	if (ok)
-		Con_Printf ("Wrote %s\n", imagename);
-	else
-		Con_Printf ("SCR_ScreenShot_f: Couldn't create %s\n", imagename);
+/*
+==================
+GL_RequestCaptureFrame -- queues a copy of the next frame for demo capture
+
+CAPTURE_BUSY means every slot is busy, the caller should skip the frame
+instead of waiting for the encoder. CAPTURE_PENDING means the last frame
+wasn't rendered, so the step it was requested for has no frame yet.
+==================
+*/
+capture_request_t GL_RequestCaptureFrame (void)
+{
+	screenshot_t *shot;
+
+	if (!GL_ScreenShotFormatSupported ())
+		return CAPTURE_REQUESTED;
+
+	for (int i = 0; i < MAX_PENDING_SCREENSHOTS; ++i)
+		if ((Atomic_LoadUInt32 (&screenshots[i].state) == SCREENSHOT_REQUESTED) && screenshots[i].video)
+			return CAPTURE_PENDING;
+
+	shot = SCR_FindScreenShot ();
+	if (!shot)
+	{
+		GL_PollScreenShots ();
+		return CAPTURE_BUSY;
+	}
+
+	GL_PrepareScreenShot ();
+	shot->video = true;
+	shot->name[0] = 0;
+	shot->bgra = (vulkan_globals.swap_chain_format == VK_FORMAT_B8G8R8A8_UNORM) || (vulkan_globals.swap_chain_format == VK_FORMAT_B8G8R8A8_SRGB);
+	Atomic_StoreUInt32 (&shot->state, SCREENSHOT_REQUESTED);
+	return CAPTURE_REQUESTED;
+}
+
+/*
+==================
+GL_CaptureFramesRecorded -- number of demo capture frames copied so far
+==================
+*/
+uint32_t GL_CaptureFramesRecorded (void)
+{
+	return Atomic_LoadUInt32 (&capture_frames_recorded);
+}
+
+/*
+==================
+GL_FlushCaptureFrames -- waits until every captured demo frame has been written
+==================
+*/
+void GL_FlushCaptureFrames (void)
+{
+	GL_WaitForDeviceIdle ();
+
+	// nothing will render the outstanding request anymore
+	for (int i = 0; i < MAX_PENDING_SCREENSHOTS; ++i)
+		if ((Atomic_LoadUInt32 (&screenshots[i].state) == SCREENSHOT_REQUESTED) && screenshots[i].video)
+			Atomic_StoreUInt32 (&screenshots[i].state, SCREENSHOT_FREE);
+
+	GL_FlushScreenShots ();
+}
+
+/*
+==================
+SCR_ScreenShot_f -- johnfitz -- rewritten to use Image_WriteTGA
+
+The swap chain image is copied at the end of the next frame and encoded on a
+worker once that frame's fence has been waited on, so nothing stalls here.
+==================
+*/
+void SCR_ScreenShot_f (void)
+{
+	char          ext[4];
+	char          imagename[16]; // johnfitz -- was [80]
+	char          checkname[MAX_OSPATH];
+	int           i, quality;
+	screenshot_t *shot;
+
+	memcpy (ext, "png", sizeof (ext));
+
+	if (Cmd_Argc () >= 2)
+	{
+		const char *requested_ext = Cmd_Argv (1);
+
+		if (!q_strcasecmp ("png", requested_ext) || !q_strcasecmp ("tga", requested_ext) || !q_strcasecmp ("jpg", requested_ext))
+			memcpy (ext, requested_ext, sizeof (ext));
+		else
+		{
+			SCR_ScreenShot_Usage ();
+			return;
+		}
+	}
+
+	// read quality as the 3rd param (only used for JPG)
+	quality = 90;
+	if (Cmd_Argc () >= 3)
+		quality = atoi (Cmd_Argv (2));
+	if (quality < 1 || quality > 100)
+	{
+		SCR_ScreenShot_Usage ();
+		return;
+	}
+
+	if (!GL_ScreenShotFormatSupported ())
+	{
+		Con_Printf ("SCR_ScreenShot_f: Unsupported surface format\n");
+		return;
+	}
+
+	shot = SCR_FindScreenShot ();
+	if (!shot)
+	{
+		Con_Printf ("SCR_ScreenShot_f: Too many screenshots in progress\n");
+		return;
+	}
+
+	// find a file name to save it to, skipping the ones still being written
+	for (i = 0; i < 10000; i++)
+	{
+		q_snprintf (imagename, sizeof (imagename), "vkquake%04i.%s", i, ext); // "fitz%04cbx_index.tga"
+		q_snprintf (checkname, sizeof (checkname), "%s/%s", com_gamedir, imagename);
+		if (Sys_FileTime (checkname) == -1 && !SCR_ScreenShotNamePending (imagename))
+			break; // file doesn't exist
+	}
+	if (i == 10000)
+	{
+		Con_Printf ("SCR_ScreenShot_f: Couldn't find an unused filename\n");
+		return;
+	}
 
-	vkUnmapMemory (vulkan_globals.device, memory);
-	vkFreeMemory (vulkan_globals.device, memory, NULL);
-	vkDestroyBuffer (vulkan_globals.device, buffer, NULL);
-	vkFreeCommandBuffers (vulkan_globals.device, transient_command_pool, 1, &command_buffer);
+	GL_PrepareScreenShot ();
+	shot->video = false;
+	q_strlcpy (shot->name, imagename, sizeof (shot->name));
+	memcpy (shot->ext, ext, sizeof (shot->ext));
+	shot->quality = quality;
+	shot->bgra = (vulkan_globals.swap_chain_format == VK_FORMAT_B8G8R8A8_UNORM) || (vulkan_globals.swap_chain_format == VK_FORMAT_B8G8R8A8_SRGB);
+	Atomic_StoreUInt32 (&shot->state, SCREENSHOT_REQUESTED);
 }
 
 void VID_FocusGained (void)
@@ -106,7 +106,7 @@ static void R_RasterWarpTexture (cb_context_t *cbx, texture_t *tx, float warptes
 		}
 
 		vkCmdBindVertexBuffers (cbx->cb, 0, 1, &buffer, &buffer_offset);
-		vkCmdDraw (cbx->cb, num_verts, 1, 0, 0);
+		vulkan_globals.vk_cmd_draw (cbx->cb, num_verts, 1, 0, 0);
 	}
 
 	vkCmdEndRenderPass (cbx->cb);
@@ -127,7 +127,7 @@ static void R_ComputeWarpTexture (cb_context_t *cbx, texture_t *tx, float warpte
 		sets[0] = whitetexture->descriptor_set;
 	vkCmdBindDescriptorSets (cbx->cb, VK_PIPELINE_BIND_POINT_COMPUTE, vulkan_globals.cs_tex_warp_pipeline.layout.handle, 0, 2, sets, 0, NULL);
 	R_PushConstants (cbx, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof (float), &time);
-	vkCmdDispatch (cbx->cb, WARPIMAGESIZE / 8, WARPIMAGESIZE / 8, 1);
+	vulkan_globals.vk_cmd_dispatch (cbx->cb, WARPIMAGESIZE / 8, WARPIMAGESIZE / 8, 1);
 }
 
 /*
@@ -28,11 +28,21 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "atomics.h"
 #include "tasks.h"
 
-void          GL_WaitForDeviceIdle (void);
-qboolean      GL_BeginRendering (qboolean use_tasks, task_handle_t *begin_rendering_task, int *x, int *y, int *width, int *height);
-qboolean      GL_AcquireNextSwapChainImage (void);
-task_handle_t GL_EndRendering (qboolean use_tasks, qboolean use_swapchain);
-void          GL_SynchronizeEndRenderingTask (void);
+typedef enum
+{
+	CAPTURE_REQUESTED, // the next frame will be copied
+	CAPTURE_PENDING,   // the previous request wasn't rendered yet
+	CAPTURE_BUSY,      // every readback slot is in use
+} capture_request_t;
+
+void              GL_WaitForDeviceIdle (void);
+qboolean          GL_BeginRendering (qboolean use_tasks, task_handle_t *begin_rendering_task, int *x, int *y, int *width, int *height);
+qboolean          GL_AcquireNextSwapChainImage (void);
+task_handle_t     GL_EndRendering (qboolean use_tasks, qboolean use_swapchain);
+void              GL_SynchronizeEndRenderingTask (void);
+capture_request_t GL_RequestCaptureFrame (void);
+void              GL_FlushCaptureFrames (void);
+uint32_t          GL_CaptureFramesRecorded (void);
 
 extern int glx, gly, glwidth, glheight;
 
@@ -77,24 +87,23 @@ typedef enum
 	pt_blob2
 } ptype_t;
 
-// !!! if this is changed, it must be changed in d_ifacea.h too !!!
+// spawn record, r_part.c keeps live particles in structure-of-arrays form
 typedef struct particle_s
 {
-	// driver-usable fields
-	vec3_t             org;
-	float              color;
-	// drivers never touch the following fields
-	struct particle_s *next;
-	vec3_t             vel;
-	float              ramp;
-	float              die;
-	ptype_t            type;
+	vec3_t  org;
+	float   color;
+	vec3_t  vel;
+	float   ramp;
+	float   die;
+	ptype_t type;
 } particle_t;
 
 #define P_INVALID -1
 #ifdef PSET_SCRIPT
 void PScript_InitParticles (void);
 void PScript_Shutdown (void);
+void PScript_UpdateParticles (void);
+void PScript_BuildParticleVertices (int index, int *num_tasks);
 void PScript_DrawParticles (cb_context_t *cbx);
 void PScript_DrawParticles_ShowTris (cb_context_t *cbx);
 struct trailstate_s;
@@ -166,11 +175,14 @@ typedef struct vulkan_memory_s
 	vulkan_memory_type_t type;
 } vulkan_memory_t;
 
-#define WORLD_PIPELINE_COUNT        16
-#define FTE_PARTICLE_PIPELINE_COUNT 16
-#define MAX_BATCH_SIZE              65536
-#define NUM_WORLD_CBX               6
-#define NUM_ENTITIES_CBX            6
+#define WORLD_PIPELINE_COUNT          16
+#define WORLD_BINDLESS_PIPELINE_COUNT 4
+#define FTE_PARTICLE_PIPELINE_COUNT   16
+#define MAX_BATCH_SIZE                65536
+#define MAX_INDIRECT_BATCH_SIZE       4096
+#define NUM_WORLD_CBX                 6
+#define NUM_ENTITIES_CBX              6
+#define MAX_HIZ_LEVELS                16
 
 typedef enum
 {
@@ -198,14 +210,23 @@ typedef enum
 
 typedef struct cb_context_s
 {
-	VkCommandBuffer   cb;
-	canvastype        current_canvas;
-	VkRenderPass      render_pass;
-	int               render_pass_index;
-	int               subpass;
-	vulkan_pipeline_t current_pipeline;
-	uint32_t          vbo_indices[MAX_BATCH_SIZE];
-	unsigned int      num_vbo_indices;
+	VkCommandBuffer              cb;
+	canvastype                   current_canvas;
+	VkRenderPass                 render_pass;
+	int                          render_pass_index;
+	int                          subpass;
+	vulkan_pipeline_t            current_pipeline;
+	uint32_t                     vbo_indices[MAX_BATCH_SIZE];
+	unsigned int                 num_vbo_indices;
+	VkDrawIndexedIndirectCommand indirect_draws[MAX_INDIRECT_BATCH_SIZE];
+	unsigned int                 num_indirect_draws;
+	// world batch state, only valid while drawing texture chains
+	VkDescriptorSet world_lightmap_set;
+	int             world_depth_bias;
+	// bindings of the last alias model draw, NULL model if anything else was bound since
+	struct qmodel_s    *alias_model;
+	struct gltexture_s *alias_textures[2];
+	VkDeviceSize        alias_pose_offsets[2];
 } cb_context_t;
 
 typedef struct
@@ -215,6 +236,7 @@ typedef struct
 	qboolean                         validation;
 	qboolean                         debug_utils;
 	VkQueue                          queue;
+	VkPipelineCache                  pipeline_cache;
 	cb_context_t                     primary_cb_context;
 	cb_context_t                     secondary_cb_contexts[CBX_NUM];
 	VkClearValue                     color_clear_value;
@@ -230,7 +252,14 @@ typedef struct
 	VkSampleCountFlagBits            sample_count;
 	qboolean                         supersampling;
 	qboolean                         non_solid_fill;
+	qboolean                         texture_compression_bc;
+	qboolean                         multi_draw_indirect;
+	qboolean                         draw_indirect_count;
 	qboolean                         screen_effects_sops;
+	qboolean                         conditional_rendering;
+	qboolean                         bindless_textures;
+	qboolean                         occlusion_culling;
+	qboolean                         discard_draws;
 
 	// Instance extensions
 	qboolean get_surface_capabilities_2;
@@ -260,6 +289,8 @@ typedef struct
 	vulkan_pipeline_layout_t basic_pipeline_layout;
 	vulkan_pipeline_t        world_pipelines[WORLD_PIPELINE_COUNT];
 	vulkan_pipeline_layout_t world_pipeline_layout;
+	vulkan_pipeline_t        world_bindless_pipelines[WORLD_BINDLESS_PIPELINE_COUNT];
+	vulkan_pipeline_layout_t world_bindless_pipeline_layout;
 	vulkan_pipeline_t        raster_tex_warp_pipeline;
 	vulkan_pipeline_t        particle_pipeline;
 	vulkan_pipeline_t        sprite_pipeline;
@@ -271,6 +302,7 @@ typedef struct
 	vulkan_pipeline_t        alias_blend_pipeline;
 	vulkan_pipeline_t        alias_alphatest_pipeline;
 	vulkan_pipeline_t        alias_alphatest_blend_pipeline;
+	vulkan_pipeline_t        alias_instanced_pipelines[2];
 	vulkan_pipeline_t        postprocess_pipeline;
 	vulkan_pipeline_t        screen_effects_pipeline;
 	vulkan_pipeline_t        screen_effects_scale_pipeline;
@@ -279,6 +311,11 @@ typedef struct
 	vulkan_pipeline_t        showtris_pipeline;
 	vulkan_pipeline_t        showtris_depth_test_pipeline;
 	vulkan_pipeline_t        showbboxes_pipeline;
+	vulkan_pipeline_t        hiz_reduce_pipeline;
+	vulkan_pipeline_t        hiz_reduce_ms_pipeline;
+	vulkan_pipeline_t        occlusion_cull_pipeline;
+	vulkan_pipeline_t        particle_update_pipeline;
+	vulkan_pipeline_t        world_cull_pipeline;
 	vulkan_pipeline_t        alias_showtris_pipeline;
 	vulkan_pipeline_t        alias_showtris_depth_test_pipeline;
 	vulkan_pipeline_t        update_lightmap_pipeline;
@@ -295,6 +332,14 @@ typedef struct
 	vulkan_desc_set_layout_t screen_effects_set_layout;
 	vulkan_desc_set_layout_t single_texture_cs_write_set_layout;
 	vulkan_desc_set_layout_t lightmap_compute_set_layout;
+	vulkan_desc_set_layout_t occlusion_cull_set_layout;
+	vulkan_desc_set_layout_t particle_compute_set_layout;
+	vulkan_desc_set_layout_t world_cull_set_layout;
+	vulkan_desc_set_layout_t world_materials_set_layout;
+	VkDescriptorSet          hiz_desc_set;
+	VkDescriptorPool         bindless_descriptor_pool;
+	vulkan_desc_set_layout_t bindless_textures_set_layout;
+	VkDescriptorSet          bindless_textures_desc_set;
 
 	// Samplers
 	VkSampler point_sampler;
@@ -312,15 +357,24 @@ typedef struct
 	float view_projection_matrix[16];
 
 	// Dispatch table
-	PFN_vkCmdBindPipeline       vk_cmd_bind_pipeline;
-	PFN_vkCmdPushConstants      vk_cmd_push_constants;
-	PFN_vkCmdBindDescriptorSets vk_cmd_bind_descriptor_sets;
-	PFN_vkCmdBindIndexBuffer    vk_cmd_bind_index_buffer;
-	PFN_vkCmdBindVertexBuffers  vk_cmd_bind_vertex_buffers;
-	PFN_vkCmdDraw               vk_cmd_draw;
-	PFN_vkCmdDrawIndexed        vk_cmd_draw_indexed;
-	PFN_vkCmdPipelineBarrier    vk_cmd_pipeline_barrier;
-	PFN_vkCmdCopyBufferToImage  vk_cmd_copy_buffer_to_image;
+	PFN_vkCmdBindPipeline        vk_cmd_bind_pipeline;
+	PFN_vkCmdPushConstants       vk_cmd_push_constants;
+	PFN_vkCmdBindDescriptorSets  vk_cmd_bind_descriptor_sets;
+	PFN_vkCmdBindIndexBuffer     vk_cmd_bind_index_buffer;
+	PFN_vkCmdBindVertexBuffers   vk_cmd_bind_vertex_buffers;
+	PFN_vkCmdDraw                vk_cmd_draw;
+	PFN_vkCmdDrawIndexed         vk_cmd_draw_indexed;
+	PFN_vkCmdDrawIndexedIndirect vk_cmd_draw_indexed_indirect;
+	PFN_vkCmdDispatch            vk_cmd_dispatch;
+	PFN_vkCmdPipelineBarrier     vk_cmd_pipeline_barrier;
+	PFN_vkCmdCopyBufferToImage   vk_cmd_copy_buffer_to_image;
+#if defined(VK_KHR_draw_indirect_count)
+	PFN_vkCmdDrawIndexedIndirectCountKHR vk_cmd_draw_indexed_indirect_count;
+#endif
+#if defined(VK_EXT_conditional_rendering)
+	PFN_vkCmdBeginConditionalRenderingEXT vk_cmd_begin_conditional_rendering;
+	PFN_vkCmdEndConditionalRenderingEXT   vk_cmd_end_conditional_rendering;
+#endif
 
 #ifdef _DEBUG
 	PFN_vkCmdBeginDebugUtilsLabelEXT vk_cmd_begin_debug_utils_label;
@@ -380,7 +434,7 @@ extern cvar_t gl_nocolors;
 
 // johnfitz -- rendering statistics
 extern atomic_uint32_t rs_brushpolys, rs_aliaspolys, rs_skypolys, rs_particles, rs_fogpolys;
-extern atomic_uint32_t rs_dynamiclightmaps, rs_brushpasses, rs_aliaspasses;
+extern atomic_uint32_t rs_dynamiclightmaps, rs_brushpasses, rs_aliaspasses, rs_occlusiontests;
 
 extern atomic_uint64_t total_device_vulkan_allocation_size;
 extern atomic_uint64_t total_host_vulkan_allocation_size;
@@ -448,7 +502,7 @@ struct lightmap_s
 	VkBuffer workgroup_bounds_buffer;
 
 	lm_compute_workgroup_bounds_t global_bounds;
-	byte                          active_dlights[MAX_DLIGHTS];
+	uint32_t                      active_dlights[(MAX_DLIGHTS + 31) >> 5];
 	byte                          used_lightstyles[MAX_LIGHTSTYLES];
 	int                           cached_light[MAX_LIGHTSTYLES];
 
@@ -484,23 +538,41 @@ void R_NewGame (void);
 void R_AnimateLight (void);
 void R_UpdateLightmaps (void *unused);
 void R_MarkSurfaces (qboolean use_tasks, task_handle_t before_mark, task_handle_t *store_efrags, task_handle_t *cull_surfaces, task_handle_t *chain_surfaces);
+void R_InvalidateMarkSurfacesCache (void);
+void R_GetMarkSurfacesStats (double *mark_time, double *saved_time, int *cache_level);
 qboolean R_CullBox (vec3_t emins, vec3_t emaxs);
 void     R_StoreEfrags (efrag_t **ppefrag);
 qboolean R_CullModelForEntity (entity_t *e);
+void     R_EntityBounds (entity_t *e, vec3_t mins, vec3_t maxs);
+void     R_InitOcclusionCulling (void);
+void     R_BeginOcclusionCulling (int frame_index);
+qboolean R_OcclusionCullingActive (void);
+void     R_CullOccludedEntities (cb_context_t *cbx, int frame_index, int hiz_levels);
 void     R_RotateForEntity (float matrix[16], vec3_t origin, vec3_t angles, unsigned char scale);
 void     R_MarkLights (dlight_t *light, int num, mnode_t *node);
 
+void R_AllocParticles (void);
 void R_InitParticles (void);
+int  R_CountParticles (void);
 void R_DrawParticles (cb_context_t *cbx);
 void CL_RunParticles (void);
+void R_WaitParticles (void);
 void R_ClearParticles (void);
+void R_BeginParticles (int frame_index);
+void R_SimulateParticles (cb_context_t *cbx, int frame_index);
 
 void R_TranslatePlayerSkin (int playernum);
 void R_TranslateNewPlayerSkin (int playernum); // johnfitz -- this handles cases when the actual texture changes
 void R_UpdateWarpTextures (cb_context_t **cbx_ptr);
 
 void R_DrawWorld (cb_context_t *cbx, int index);
+void R_BuildWorldCull (void);
+void R_DeleteWorldCull (void);
+void R_BeginWorldCulling (int frame_index);
+void R_CullWorldSurfaces (cb_context_t *cbx, int frame_index);
 void R_DrawAliasModel (cb_context_t *cbx, entity_t *e, int *aliaspolys);
+void R_BatchAliasModel (cb_context_t *cbx, entity_t *e, int *aliaspolys, int *aliaspasses);
+void R_FlushAliasBatch (cb_context_t *cbx, int *aliaspasses);
 void R_DrawBrushModel (cb_context_t *cbx, entity_t *e, int chain, int *brushpolys);
 void R_DrawSpriteModel (cb_context_t *cbx, entity_t *e);
 
@@ -509,6 +581,8 @@ void R_DrawTextureChains_Water (cb_context_t *cbx, qmodel_t *model, entity_t *en
 void GL_BuildLightmaps (void);
 void GL_DeleteBModelVertexBuffer (void);
 void GL_BuildBModelVertexBuffer (void);
+void GL_CreateBModelBuffer (
+	const void *data, int size, VkBufferUsageFlags usage, const char *name, VkBuffer *buffer, vulkan_memory_t *memory, const char *memory_name);
 void GL_PrepareSIMDData (void);
 void GLMesh_LoadVertexBuffers (void);
 void GLMesh_DeleteVertexBuffers (void);
@@ -552,6 +626,8 @@ void R_InitSamplers ();
 void R_CreatePipelineLayouts ();
 void R_CreatePipelines ();
 void R_DestroyPipelines ();
+void R_WaitPipelineCache (void);
+void R_DestroyPipelineCache (void);
 
 #define MAX_PUSH_CONSTANT_SIZE 128 // Vulkan guaranteed minimum maxPushConstantsSize
 
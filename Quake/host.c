@@ -50,7 +50,7 @@ int host_framecount;
 
 int minimum_memory;
 
-client_t *host_client; // current client
+THREAD_LOCAL client_t *host_client; // current client
 
 jmp_buf host_abortserver;
 jmp_buf screen_error;
@@ -66,6 +66,7 @@ cvar_t cl_nocsqc = {"cl_nocsqc", "0", CVAR_NONE};           // spike -- blocks t
 
 cvar_t sys_ticrate = {"sys_ticrate", "0.025", CVAR_NONE}; // dedicated server
 cvar_t serverprofile = {"serverprofile", "0", CVAR_NONE};
+cvar_t sv_threaded = {"sv_threaded", "0", CVAR_ARCHIVE}; // run the local single player server on its own thread
 
 cvar_t fraglimit = {"fraglimit", "0", CVAR_NOTIFY | CVAR_SERVERINFO};
 cvar_t timelimit = {"timelimit", "0", CVAR_NOTIFY | CVAR_SERVERINFO};
@@ -89,6 +90,8 @@ cvar_t campaign = {"campaign", "0", CVAR_NONE};   // for the 2021 rerelease
 cvar_t horde = {"horde", "0", CVAR_NONE};         // for the 2021 rerelease
 cvar_t sv_cheats = {"sv_cheats", "0", CVAR_NONE}; // for the 2021 rerelease
 
+extern cvar_t r_showbboxes;
+
 devstats_t      dev_stats, dev_peakstats;
 overflowtimes_t dev_overflows; // this stores the last time overflow messages were displayed, not the last time overflows occured
 
@@ -141,6 +144,11 @@ void Host_EndGame (const char *message, ...)
 	va_start (argptr, message);
 	q_vsnprintf (string, sizeof (string), message, argptr);
 	va_end (argptr);
+
+	if (Host_IsServerThread ())
+		Host_AbortServerThread (SV_THREAD_ENDGAME, string);
+	Host_WaitServerThread ();
+
 	Con_DPrintf ("Host_EndGame: %s\n", string);
 
 	PR_SwitchQCVM (NULL);
@@ -172,17 +180,23 @@ void Host_Error (const char *error, ...)
 	char            string[1024];
 	static qboolean inerror = false;
 
+	va_start (argptr, error);
+	q_vsnprintf (string, sizeof (string), error, argptr);
+	va_end (argptr);
+
+	// the main thread rethrows it once it joins the server thread
+	if (Host_IsServerThread ())
+		Host_AbortServerThread (SV_THREAD_ERROR, string);
+
 	if (inerror)
 		Sys_Error ("Host_Error: recursively entered");
 	inerror = true;
 
+	Host_WaitServerThread ();
 	PR_SwitchQCVM (NULL);
 
 	SCR_EndLoadingPlaque (); // reenable screen updates
 
-	va_start (argptr, error);
-	q_vsnprintf (string, sizeof (string), error, argptr);
-	va_end (argptr);
 	Con_Printf ("Host_Error: %s\n", string);
 
 	if (cl.qcvm.extfuncs.CSQC_DrawHud && in_update_screen)
@@ -231,6 +245,10 @@ void Host_FindMaxClients (void)
 	else
 		cls.state = ca_disconnected;
 
+	cls.demoanalyze = COM_CheckParm ("-demoanalyze") != 0;
+	if (cls.demoanalyze && cls.state == ca_dedicated)
+		Sys_Error ("Only one of -dedicated or -demoanalyze can be specified");
+
 	i = COM_CheckParm ("-listen");
 	if (i)
 	{
@@ -297,6 +315,7 @@ void Host_InitLocal (void)
 
 	Cvar_RegisterVariable (&sys_ticrate);
 	Cvar_RegisterVariable (&serverprofile);
+	Cvar_RegisterVariable (&sv_threaded);
 
 	Cvar_RegisterVariable (&fraglimit);
 	Cvar_RegisterVariable (&timelimit);
@@ -525,6 +544,8 @@ void Host_ShutdownServer (qboolean crash)
 	if (!sv.active)
 		return;
 
+	Host_WaitServerThread ();
+	SV_MVD_Stop ();
 	sv.active = false;
 
 	// stop all client sounds immediately
@@ -635,6 +656,28 @@ qboolean Host_FilterTime (float time)
 	realtime += time;
 	delta_since_last_frame = realtime - oldrealtime;
 
+	// demo capture runs at a fixed step, frames are skipped while the readback slots are busy
+	const double capture_frametime = CL_CaptureFrameTime ();
+	if (capture_frametime > 0.0)
+	{
+		CL_CaptureFrameAudio ();
+		switch (GL_RequestCaptureFrame ())
+		{
+		case CAPTURE_BUSY:
+			SDL_Delay (1); // leave the core to the encoder tasks
+			return false;
+		case CAPTURE_PENDING:
+			// the last step has no frame yet, render it again instead of advancing time
+			host_frametime = 0.0;
+			break;
+		default:
+			host_frametime = capture_frametime;
+			break;
+		}
+		oldrealtime = realtime;
+		return true;
+	}
+
 	if (host_maxfps.value)
 	{
 		// johnfitz -- max fps cvar
@@ -702,7 +745,7 @@ void Host_ServerFrame (void)
 	edict_t *ent;       // johnfitz
 
 	// run the world state
-	pr_global_struct->frametime = host_frametime;
+	pr_global_struct->frametime = sv_frametime;
 
 	// set the time and clear the general datagram
 	SV_ClearDatagram ();
@@ -738,6 +781,297 @@ void Host_ServerFrame (void)
 	SV_SendClientMessages ();
 }
 
+/*
+===============================================================================
+
+THREADED SERVER
+
+With sv_threaded the ticks of a local single player server are queued by the
+main thread and run on their own thread while the client renders. The two
+only talk through the loopback socket; the main thread joins at the start of
+the next frame, before anything else may touch the server. What the server
+shares with the client (cvars, models) is changed through
+Host_CallOnMainThread, which runs while the main thread waits to join.
+
+===============================================================================
+*/
+
+#define MAX_SERVER_THREAD_TICKS 16
+
+static SDL_Thread *sv_thread;
+static SDL_sem    *sv_thread_start;
+static SDL_sem    *sv_thread_done;
+static SDL_sem    *sv_thread_call_done;
+static qboolean    sv_thread_busy;
+static qboolean    sv_thread_quit;
+static int         sv_thread_numticks;
+static double      sv_thread_ticks[MAX_SERVER_THREAD_TICKS];
+static jmp_buf     sv_thread_abort;
+static int         sv_thread_failed;
+static char        sv_thread_error[1024];
+
+// a call the server thread waits on, see Host_CallOnMainThread
+static void (*sv_thread_call) (void *);
+static void    *sv_thread_call_data;
+static qboolean sv_thread_call_failed;
+static qboolean in_server_thread_call;
+
+static THREAD_LOCAL qboolean is_server_thread;
+
+qboolean Host_IsServerThread (void)
+{
+	return is_server_thread;
+}
+
+/*
+==================
+Host_ServerThreaded
+
+CSQC shares the progs temp strings with the server, so it keeps the server on
+the main thread. Remote clients would share net_message with the datagram
+drivers.
+==================
+*/
+qboolean Host_ServerThreaded (void)
+{
+	return sv_threaded.value && sv.active && host_netinterval && svs.maxclients == 1 && !listening && !cl.qcvm.progs && !isDedicated;
+}
+
+/*
+==================
+Host_ServerThreadBusy
+
+True while queued ticks may still be running on the server thread
+==================
+*/
+qboolean Host_ServerThreadBusy (void)
+{
+	return sv_thread_busy;
+}
+
+/*
+==================
+Host_AbortServerThread
+
+Host_Error/Host_EndGame on the server thread unwind to the thread loop.
+==================
+*/
+FUNC_NORETURN void Host_AbortServerThread (int failure, const char *message)
+{
+	q_strlcpy (sv_thread_error, message, sizeof (sv_thread_error));
+	sv_thread_failed = failure;
+	longjmp (sv_thread_abort, 1);
+}
+
+static int Host_ServerThread (void *unused)
+{
+	int i;
+
+	is_server_thread = true;
+	SZ_Alloc (&net_message, NET_MAXMESSAGE);
+
+	for (;;)
+	{
+		SDL_SemWait (sv_thread_start);
+		if (sv_thread_quit)
+			break;
+
+		if (!setjmp (sv_thread_abort))
+		{
+			for (i = 0; i < sv_thread_numticks; i++)
+			{
+				sv_frametime = sv_thread_ticks[i];
+				PR_SwitchQCVM (&sv.qcvm);
+				Host_ServerFrame ();
+				PR_SwitchQCVM (NULL);
+			}
+		}
+		else
+			PR_SwitchQCVM (NULL);
+		sv_thread_numticks = 0;
+
+		SDL_SemPost (sv_thread_done);
+	}
+
+	SZ_Free (&net_message);
+	return 0;
+}
+
+/*
+==================
+Host_QueueServerTick
+==================
+*/
+static void Host_QueueServerTick (double frametime)
+{
+	if (sv_thread_numticks == MAX_SERVER_THREAD_TICKS)
+		sv_thread_ticks[sv_thread_numticks - 1] += frametime;
+	else
+		sv_thread_ticks[sv_thread_numticks++] = frametime;
+}
+
+/*
+==================
+Host_KickServerThread
+==================
+*/
+static void Host_KickServerThread (void)
+{
+	if (!sv_thread_numticks)
+		return;
+
+	if (!sv_thread)
+	{
+		sv_thread_start = SDL_CreateSemaphore (0);
+		sv_thread_done = SDL_CreateSemaphore (0);
+		sv_thread_call_done = SDL_CreateSemaphore (0);
+		sv_thread = SDL_CreateThread (Host_ServerThread, "Server", NULL);
+		if (!sv_thread)
+			Sys_Error ("Host_KickServerThread: %s", SDL_GetError ());
+	}
+
+	sv_thread_busy = true;
+	SDL_SemPost (sv_thread_start);
+}
+
+/*
+==================
+Host_CallOnMainThread
+
+Runs func with the client and server both stopped. On the server thread this
+blocks until the main thread waits for the ticks to finish. If func ends in
+Host_Error, the main thread has already torn the server down and the ticks
+are abandoned.
+==================
+*/
+void Host_CallOnMainThread (void (*func) (void *), void *data)
+{
+	if (!Host_IsServerThread ())
+	{
+		func (data);
+		return;
+	}
+
+	sv_thread_call = func;
+	sv_thread_call_data = data;
+	SDL_SemPost (sv_thread_done);
+	SDL_SemWait (sv_thread_call_done);
+	if (sv_thread_call_failed)
+	{
+		sv_thread_call_failed = false;
+		longjmp (sv_thread_abort, 1);
+	}
+}
+
+/*
+==================
+Host_WaitServerTicks
+
+Waits for the queued ticks to finish and runs the calls the server thread
+makes meanwhile. Returns false if one of those ended in Host_Error.
+==================
+*/
+static qboolean Host_WaitServerTicks (void)
+{
+	jmp_buf           prev_abortserver;
+	volatile qboolean ok = true;
+
+	for (;;)
+	{
+		SDL_SemWait (sv_thread_done);
+		if (!sv_thread_call)
+			break;
+
+		// Host_Error in the call must land here, and must not wait for the server thread
+		memcpy (prev_abortserver, host_abortserver, sizeof (jmp_buf));
+		in_server_thread_call = true;
+		if (!setjmp (host_abortserver))
+			sv_thread_call (sv_thread_call_data);
+		else
+		{
+			sv_thread_call_failed = true;
+			ok = false;
+		}
+		in_server_thread_call = false;
+		memcpy (host_abortserver, prev_abortserver, sizeof (jmp_buf));
+
+		sv_thread_call = NULL;
+		SDL_SemPost (sv_thread_call_done);
+	}
+	sv_thread_busy = false;
+
+	return ok;
+}
+
+/*
+==================
+Host_WaitServerThread
+
+Waits for the queued ticks to finish. A failure is only reported, callers
+are already tearing the server down.
+==================
+*/
+void Host_WaitServerThread (void)
+{
+	if (!sv_thread_busy || Host_IsServerThread () || in_server_thread_call)
+		return;
+
+	Host_WaitServerTicks ();
+	if (sv_thread_failed)
+	{
+		Con_Printf ("Host_Error: %s\n", sv_thread_error);
+		sv_thread_failed = SV_THREAD_OK;
+	}
+}
+
+/*
+==================
+Host_JoinServerThread
+
+Waits for the queued ticks to finish and rethrows any error on this thread.
+==================
+*/
+static void Host_JoinServerThread (void)
+{
+	if (!sv_thread_busy)
+		return;
+
+	// a call that failed has already been handled like any other Host_Error
+	if (!Host_WaitServerTicks ())
+		longjmp (host_abortserver, 1);
+	switch (sv_thread_failed)
+	{
+	case SV_THREAD_ERROR:
+		sv_thread_failed = SV_THREAD_OK;
+		Host_Error ("%s", sv_thread_error);
+	case SV_THREAD_ENDGAME:
+		sv_thread_failed = SV_THREAD_OK;
+		Host_EndGame ("%s", sv_thread_error);
+	default:
+		break;
+	}
+}
+
+/*
+==================
+Host_StopServerThread
+==================
+*/
+static void Host_StopServerThread (void)
+{
+	if (!sv_thread)
+		return;
+
+	Host_WaitServerThread ();
+	sv_thread_quit = true;
+	SDL_SemPost (sv_thread_start);
+	SDL_WaitThread (sv_thread, NULL);
+	SDL_DestroySemaphore (sv_thread_start);
+	SDL_DestroySemaphore (sv_thread_done);
+	SDL_DestroySemaphore (sv_thread_call_done);
+	sv_thread = NULL;
+}
+
 static void CL_LoadCSProgs (void)
 {
 	PR_ClearProgs (&cl.qcvm);
@@ -834,6 +1168,9 @@ void _Host_Frame (double time)
 	if (!Host_FilterTime (time))
 		return; // don't run too fast, or packets will flood out
 
+	// nothing below may race the ticks queued last frame
+	Host_JoinServerThread ();
+
 	if (host_speeds.value)
 		time3 = Sys_DoubleTime ();
 
@@ -880,8 +1217,11 @@ void _Host_Frame (double time)
 		}
 
 		CL_SendCmd ();
-		if (sv.active)
+		if (sv.active && Host_ServerThreaded ())
+			Host_QueueServerTick (host_frametime);
+		else if (sv.active)
 		{
+			sv_frametime = host_frametime;
 			PR_SwitchQCVM (&sv.qcvm);
 			Host_ServerFrame ();
 			PR_SwitchQCVM (NULL);
@@ -892,11 +1232,12 @@ void _Host_Frame (double time)
 		if (host_netinterval == 0 || isDedicated)
 			break;
 	}
+	Host_KickServerThread ();
 
 	if (cl.qcvm.progs)
 	{
 		PR_SwitchQCVM (&cl.qcvm);
-		pr_global_struct->frametime = host_frametime;
+		pr_global_struct->frametime = sv_frametime = host_frametime;
 		SV_Physics ();
 		PR_SwitchQCVM (NULL);
 	}
@@ -905,6 +1246,10 @@ void _Host_Frame (double time)
 	if (cls.state == ca_connected)
 		CL_ReadFromServer ();
 
+	// r_showbboxes reads the server's edicts while rendering
+	if (r_showbboxes.value)
+		Host_JoinServerThread ();
+
 	// update video
 	if (host_speeds.value)
 		time1 = Sys_DoubleTime ();
@@ -996,7 +1341,7 @@ void Host_Init (void)
 	COM_InitFilesystem ();
 	Host_InitLocal ();
 	W_LoadWadFile (); // johnfitz -- filename is now hard-coded for honesty
-	if (cls.state != ca_dedicated)
+	if (cls.state != ca_dedicated && !cls.demoanalyze)
 	{
 		Key_Init ();
 		Con_Init ();
@@ -1008,7 +1353,13 @@ void Host_Init (void)
 
 	Con_Printf ("Exe: " __TIME__ " " __DATE__ "\n");
 
-	if (cls.state != ca_dedicated)
+	if (cls.demoanalyze)
+	{
+		// headless demo analysis: client state and particles, but no video, audio or input
+		R_AllocParticles ();
+		CL_Init ();
+	}
+	else if (cls.state != ca_dedicated)
 	{
 		host_colormap = (byte *)COM_LoadFile ("gfx/colormap.lmp", NULL);
 		if (!host_colormap)
@@ -1042,7 +1393,7 @@ void Host_Init (void)
 	host_initialized = true;
 	Con_Printf ("\n========= Quake Initialized =========\n\n");
 
-	if (cls.state != ca_dedicated)
+	if (cls.state != ca_dedicated && !cls.demoanalyze)
 	{
 		Cbuf_InsertText ("exec quake.rc\n");
 		// johnfitz -- in case the vid mode was locked during vid_init, we can unlock it now.
@@ -1083,11 +1434,12 @@ void Host_Shutdown (void)
 	// keep Con_Printf from trying to update the screen
 	scr_disabled_for_loading = true;
 
+	Host_StopServerThread ();
 	Host_WriteConfiguration ();
 
 	NET_Shutdown ();
 
-	if (cls.state != ca_dedicated)
+	if (cls.state != ca_dedicated && !cls.demoanalyze)
 	{
 		if (con_initialized)
 			History_Shutdown ();
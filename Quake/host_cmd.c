@@ -47,6 +47,9 @@ void Host_Quit_f (void)
 		M_Menu_Quit_f ();
 		return;
 	}
+	// "screenshot; quit" still gets its shot of the current scene
+	if (cls.state != ca_dedicated)
+		SCR_FinishScreenShots ();
 	CL_Disconnect ();
 	Host_ShutdownServer (false);
 
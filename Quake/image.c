@@ -86,30 +86,309 @@ static inline int Buf_GetC (stdio_buffer_t *buf)
 	return buf->buffer[buf->pos++];
 }
 
+/*
+================================================================================
+
+    BLOCK COMPRESSED IMAGES
+
+================================================================================
+*/
+
+#define DDS_HEADER_SIZE       128 // magic + DDS_HEADER
+#define DDS_DX10_HEADER_SIZE  20
+#define DDSD_MIPMAPCOUNT      0x20000
+#define DDSCAPS2_CUBEMAP      0x200
+#define KTX2_HEADER_SIZE      80
+#define KTX2_LEVEL_INDEX_SIZE 24
+
+static const byte ktx2_identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
 /*
 ============
-Image_LoadImage
+Image_CompressedMipSize
 
-returns a pointer to hunk allocated RGBA data
+size in bytes of one mip level, rounded up to whole 4x4 blocks
+============
+*/
+size_t Image_CompressedMipSize (compressedformat_t format, int width, int height)
+{
+	const size_t block_size = (format == COMPRESSED_BC1) ? 8 : 16;
+	return (size_t)q_max ((width + 3) / 4, 1) * (size_t)q_max ((height + 3) / 4, 1) * block_size;
+}
 
-TODO: search order: tga png jpg pcx lmp
+static unsigned Image_ReadLong (const byte *p)
+{
+	return (unsigned)p[0] | ((unsigned)p[1] << 8) | ((unsigned)p[2] << 16) | ((unsigned)p[3] << 24);
+}
+
+/*
+============
+Image_AddCompressedMips
+
+packs num_mips levels from the file into image->data, largest first. level_offsets are
+relative to the start of the file. returns false if the file is truncated.
 ============
 */
-byte *Image_LoadImage (const char *name, int *width, int *height)
+static qboolean Image_AddCompressedMips (compressedimage_t *image, const byte *file, size_t file_size, const size_t *level_offsets, int num_mips)
+{
+	int    width = image->width;
+	int    height = image->height;
+	size_t total = 0;
+	int    i;
+
+	for (i = 0; i < num_mips; ++i)
+	{
+		const size_t size = Image_CompressedMipSize (image->format, width, height);
+		if (level_offsets[i] > file_size || size > file_size - level_offsets[i])
+			return false;
+		image->mip_offsets[i] = total;
+		total += size;
+		width = q_max (width / 2, 1);
+		height = q_max (height / 2, 1);
+	}
+
+	image->data = (byte *)Mem_Alloc (total);
+	image->size = total;
+	image->num_mips = num_mips;
+	for (i = 0; i < num_mips; ++i)
+	{
+		const size_t size = ((i + 1 < num_mips) ? image->mip_offsets[i + 1] : total) - image->mip_offsets[i];
+		memcpy (image->data + image->mip_offsets[i], file + level_offsets[i], size);
+	}
+	return true;
+}
+
+/*
+============
+Image_ParseDDS
+============
+*/
+static qboolean Image_ParseDDS (const byte *file, size_t file_size, int maxsize, compressedimage_t *image)
+{
+	size_t offset = DDS_HEADER_SIZE;
+	size_t level_offsets[MAX_COMPRESSED_MIPS];
+
+	if (file_size < DDS_HEADER_SIZE || memcmp (file, "DDS ", 4) || Image_ReadLong (file + 4) != 124)
+		return false;
+
+	const unsigned flags = Image_ReadLong (file + 8);
+	image->height = Image_ReadLong (file + 12);
+	image->width = Image_ReadLong (file + 16);
+	int num_mips = (flags & DDSD_MIPMAPCOUNT) ? (int)Image_ReadLong (file + 28) : 1;
+	if (Image_ReadLong (file + 112) & DDSCAPS2_CUBEMAP)
+		return false;
+
+	const byte *fourcc = file + 84;
+	if (!memcmp (fourcc, "DXT1", 4))
+		image->format = COMPRESSED_BC1;
+	else if (!memcmp (fourcc, "DXT5", 4))
+		image->format = COMPRESSED_BC3;
+	else if (!memcmp (fourcc, "DX10", 4))
+	{
+		if (file_size < DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE || Image_ReadLong (file + DDS_HEADER_SIZE + 12) > 1)
+			return false;
+		switch (Image_ReadLong (file + DDS_HEADER_SIZE))
+		{
+		case 70: // DXGI_FORMAT_BC1_TYPELESS
+		case 71: // DXGI_FORMAT_BC1_UNORM
+		case 72: // DXGI_FORMAT_BC1_UNORM_SRGB
+			image->format = COMPRESSED_BC1;
+			break;
+		case 76: // DXGI_FORMAT_BC3_TYPELESS
+		case 77: // DXGI_FORMAT_BC3_UNORM
+		case 78: // DXGI_FORMAT_BC3_UNORM_SRGB
+			image->format = COMPRESSED_BC3;
+			break;
+		case 97: // DXGI_FORMAT_BC7_TYPELESS
+		case 98: // DXGI_FORMAT_BC7_UNORM
+		case 99: // DXGI_FORMAT_BC7_UNORM_SRGB
+			image->format = COMPRESSED_BC7;
+			break;
+		default:
+			return false;
+		}
+		offset += DDS_DX10_HEADER_SIZE;
+	}
+	else
+		return false;
+
+	if (image->width <= 0 || image->height <= 0 || image->width > maxsize || image->height > maxsize)
+		return false;
+	num_mips = CLAMP (1, num_mips, MAX_COMPRESSED_MIPS);
+
+	// DDS stores the levels back to back, largest first
+	int width = image->width;
+	int height = image->height;
+	for (int i = 0; i < num_mips; ++i)
+	{
+		level_offsets[i] = offset;
+		offset += Image_CompressedMipSize (image->format, width, height);
+		width = q_max (width / 2, 1);
+		height = q_max (height / 2, 1);
+	}
+
+	return Image_AddCompressedMips (image, file, file_size, level_offsets, num_mips);
+}
+
+/*
+============
+Image_ParseKTX2
+
+only plain 2D BC1/BC3/BC7 textures; supercompressed (basis, zstd) files are rejected
+============
+*/
+static qboolean Image_ParseKTX2 (const byte *file, size_t file_size, int maxsize, compressedimage_t *image)
+{
+	size_t level_offsets[MAX_COMPRESSED_MIPS];
+
+	if (file_size < KTX2_HEADER_SIZE || memcmp (file, ktx2_identifier, sizeof (ktx2_identifier)))
+		return false;
+
+	switch (Image_ReadLong (file + 12))
+	{
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		image->format = COMPRESSED_BC1;
+		break;
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+	case VK_FORMAT_BC3_SRGB_BLOCK:
+		image->format = COMPRESSED_BC3;
+		break;
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+		image->format = COMPRESSED_BC7;
+		break;
+	default:
+		return false;
+	}
+
+	image->width = Image_ReadLong (file + 20);
+	image->height = Image_ReadLong (file + 24);
+	const unsigned depth = Image_ReadLong (file + 28);
+	const unsigned layers = Image_ReadLong (file + 32);
+	const unsigned faces = Image_ReadLong (file + 36);
+	const unsigned levels = Image_ReadLong (file + 40);
+	const unsigned supercompression = Image_ReadLong (file + 44);
+	if (image->width <= 0 || image->height <= 0 || image->width > maxsize || image->height > maxsize || depth > 1 || layers > 1 || faces != 1 ||
+		supercompression != 0)
+		return false;
+
+	const int num_mips = CLAMP (1, (int)levels, MAX_COMPRESSED_MIPS);
+	if (file_size < KTX2_HEADER_SIZE + (size_t)num_mips * KTX2_LEVEL_INDEX_SIZE)
+		return false;
+
+	// the level index is ordered largest first, the data itself usually isn't
+	for (int i = 0; i < num_mips; ++i)
+	{
+		const byte *level = file + KTX2_HEADER_SIZE + i * KTX2_LEVEL_INDEX_SIZE;
+		if (Image_ReadLong (level + 4) != 0) // high half of the 64 bit byteOffset
+			return false;
+		level_offsets[i] = Image_ReadLong (level);
+	}
+
+	return Image_AddCompressedMips (image, file, file_size, level_offsets, num_mips);
+}
+
+/*
+============
+Image_LoadCompressedImage
+
+looks for name.dds, then name.ktx2. on success image->data is Mem_Alloc'ed and
+holds the mip levels back to back, largest first. images larger than maxsize
+in either dimension are rejected.
+============
+*/
+qboolean Image_LoadCompressedImage (const char *name, int maxsize, compressedimage_t *image)
+{
+	static const char *const extensions[] = {"dds", "ktx2"};
+	FILE                    *f;
+
+	memset (image, 0, sizeof (*image));
+	for (int i = 0; i < (int)countof (extensions); ++i)
+	{
+		q_snprintf (loadfilename, sizeof (loadfilename), "%s.%s", name, extensions[i]);
+		const int length = COM_FOpenFile (loadfilename, &f, NULL);
+		if (!f)
+			continue;
+
+		byte *file = (byte *)Mem_Alloc (length);
+		const qboolean read = (int)fread (file, 1, length, f) == length;
+		fclose (f);
+
+		qboolean ok = false;
+		if (read)
+			ok = (i == 0) ? Image_ParseDDS (file, length, maxsize, image) : Image_ParseKTX2 (file, length, maxsize, image);
+		Mem_Free (file);
+
+		if (ok)
+			return true;
+		Con_Warning ("%s is not a supported BC1/BC3/BC7 texture\n", loadfilename);
+		memset (image, 0, sizeof (*image));
+	}
+
+	return false;
+}
+
+/*
+============
+Image_OpenImage
+
+opens name.tga or name.pcx in the order Image_LoadImage searches them,
+leaving com_filesize and com_filestamp describing the file that was found
+============
+*/
+FILE *Image_OpenImage (const char *name, imagetype_t *type)
 {
 	FILE *f;
 
 	q_snprintf (loadfilename, sizeof (loadfilename), "%s.tga", name);
 	COM_FOpenFile (loadfilename, &f, NULL);
 	if (f)
-		return Image_LoadTGA (f, width, height, name);
+	{
+		*type = IMAGE_TGA;
+		return f;
+	}
 
 	q_snprintf (loadfilename, sizeof (loadfilename), "%s.pcx", name);
 	COM_FOpenFile (loadfilename, &f, NULL);
 	if (f)
-		return Image_LoadPCX (f, width, height);
+		*type = IMAGE_PCX;
+	return f;
+}
+
+/*
+============
+Image_ReadImage
+
+decodes a file opened by Image_OpenImage and closes it
+============
+*/
+byte *Image_ReadImage (FILE *f, imagetype_t type, const char *name, int *width, int *height)
+{
+	if (type == IMAGE_TGA)
+		return Image_LoadTGA (f, width, height, name);
+	return Image_LoadPCX (f, width, height);
+}
+
+/*
+============
+Image_LoadImage
+
+returns a pointer to hunk allocated RGBA data
+
+TODO: search order: tga png jpg pcx lmp
+============
+*/
+byte *Image_LoadImage (const char *name, int *width, int *height)
+{
+	imagetype_t type;
+	FILE       *f = Image_OpenImage (name, &type);
 
-	return NULL;
+	if (!f)
+		return NULL;
+	return Image_ReadImage (f, type, name, width, height);
 }
 
 //==============================================================================
@@ -657,3 +936,29 @@ qboolean Image_WritePNG (const char *name, byte *data, int width, int height, in
 
 	return (error == 0);
 }
+
+/*
+============
+Image_Deflate
+
+Raw deflate stream (no zlib header) of in, for callers other than the png
+writer that need a compressor: the bundled miniz is built inflate only.
+Returns NULL on failure, the result must be freed with Mem_Free.
+============
+*/
+byte *Image_Deflate (const byte *in, size_t insize, size_t *outsize)
+{
+	LodePNGCompressSettings settings;
+	unsigned char          *out = NULL;
+
+	lodepng_compress_settings_init (&settings);
+	settings.windowsize = 32768;
+
+	*outsize = 0;
+	if (lodepng_deflate (&out, outsize, in, insize, &settings) != 0)
+	{
+		lodepng_free (out);
+		return NULL;
+	}
+	return out;
+}
@@ -25,13 +25,46 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 // image.h -- image reading / writing
 
+#define MAX_COMPRESSED_MIPS 16
+
+typedef enum
+{
+	COMPRESSED_BC1,
+	COMPRESSED_BC3,
+	COMPRESSED_BC7,
+} compressedformat_t;
+
+typedef enum
+{
+	IMAGE_TGA,
+	IMAGE_PCX,
+} imagetype_t;
+
+typedef struct compressedimage_s
+{
+	compressedformat_t format;
+	int                width;
+	int                height;
+	int                num_mips;
+	size_t             mip_offsets[MAX_COMPRESSED_MIPS]; // into data, largest level first
+	size_t             size;
+	byte              *data;
+} compressedimage_t;
+
 // be sure to free the hunk after using these loading functions
 byte *Image_LoadTGA (FILE *f, int *width, int *height, const char *name);
 byte *Image_LoadPCX (FILE *f, int *width, int *height);
 byte *Image_LoadImage (const char *name, int *width, int *height);
+FILE *Image_OpenImage (const char *name, imagetype_t *type);
+byte *Image_ReadImage (FILE *f, imagetype_t type, const char *name, int *width, int *height);
+
+qboolean Image_LoadCompressedImage (const char *name, int maxsize, compressedimage_t *image);
+size_t   Image_CompressedMipSize (compressedformat_t format, int width, int height);
 
 qboolean Image_WriteTGA (const char *name, byte *data, int width, int height, int bpp, qboolean upsidedown);
 qboolean Image_WritePNG (const char *name, byte *data, int width, int height, int bpp, qboolean upsidedown);
 qboolean Image_WriteJPG (const char *name, byte *data, int width, int height, int bpp, int quality, qboolean upsidedown);
 
+byte *Image_Deflate (const byte *in, size_t insize, size_t *outsize);
+
 #endif /* GL_IMAGE_H */
@@ -54,6 +54,7 @@ static quakeparms_t parms;
 int main (int argc, char *argv[])
 {
 	double time, oldtime, newtime;
+	int    worker = 0, numworkers = 1;
 
 	host_parms = &parms;
 	parms.basedir = ".";
@@ -65,7 +66,17 @@ int main (int argc, char *argv[])
 
 	COM_InitArgv (parms.argc, parms.argv);
 
-	isDedicated = (COM_CheckParm ("-dedicated") != 0);
+	// headless demo analysis runs without video, audio or input, like a dedicated server
+	isDedicated = (COM_CheckParm ("-dedicated") != 0) || (COM_CheckParm ("-demoanalyze") != 0);
+
+	if (COM_CheckParm ("-demoanalyze"))
+	{
+		int i = COM_CheckParm ("-demoanalyze_jobs");
+		numworkers = (i && i < com_argc - 1) ? atoi (com_argv[i + 1]) : 1;
+		worker = Sys_ForkWorkers (&numworkers);
+		if (worker < 0)
+			return 0; // all workers done
+	}
 
 	Sys_InitSDL ();
 
@@ -85,6 +96,12 @@ int main (int argc, char *argv[])
 	Sys_Printf ("Host_Init\n");
 	Host_Init ();
 
+	if (cls.demoanalyze)
+	{
+		CL_DemoAnalyze (worker, numworkers);
+		Sys_Quit ();
+	}
+
 	oldtime = Sys_DoubleTime ();
 	if (isDedicated)
 	{
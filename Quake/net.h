@@ -40,10 +40,10 @@ extern int net_hostport;
 
 extern cvar_t hostname;
 
-extern double    net_time;
-extern sizebuf_t net_message;
-extern int       net_activeconnections;
-extern qboolean  listening;
+extern THREAD_LOCAL double    net_time;
+extern THREAD_LOCAL sizebuf_t net_message;
+extern int                    net_activeconnections;
+extern qboolean               listening;
 
 typedef char qhostaddr_t[NET_NAMELEN];
 
@@ -240,12 +240,12 @@ extern const int    net_numdrivers;
 /* Loop driver must always be registered the first */
 #define IS_LOOP_DRIVER(p) ((p) == 0)
 
-extern int net_driverlevel;
+extern THREAD_LOCAL int net_driverlevel;
 
-extern int messagesSent;
-extern int messagesReceived;
-extern int unreliableMessagesSent;
-extern int unreliableMessagesReceived;
+extern atomic_uint32_t messagesSent;
+extern atomic_uint32_t messagesReceived;
+extern atomic_uint32_t unreliableMessagesSent;
+extern atomic_uint32_t unreliableMessagesReceived;
 
 qsocket_t *NET_NewQSocket (void);
 void       NET_FreeQSocket (qsocket_t *);
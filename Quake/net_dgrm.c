@@ -345,7 +345,7 @@ qboolean Datagram_ProcessPacket (unsigned int length, qsocket_t *sock)
 		SZ_Clear (&net_message);
 		SZ_Write (&net_message, packetBuffer.data, length);
 
-		unreliableMessagesReceived++;
+		Atomic_IncrementUInt32 (&unreliableMessagesReceived);
 		return true; // parse the unreliable
 	}
 
@@ -408,7 +408,7 @@ qboolean Datagram_ProcessPacket (unsigned int length, qsocket_t *sock)
 			SZ_Write (&net_message, packetBuffer.data, length);
 			sock->receiveMessageLength = 0;
 
-			messagesReceived++;
+			Atomic_IncrementUInt32 (&messagesReceived);
 			return true; // parse this reliable!
 		}
 
@@ -683,10 +683,10 @@ static void NET_Stats_f (void)
 
 	if (Cmd_Argc () == 1)
 	{
-		Con_Printf ("unreliable messages sent   = %i\n", unreliableMessagesSent);
-		Con_Printf ("unreliable messages recv   = %i\n", unreliableMessagesReceived);
-		Con_Printf ("reliable messages sent     = %i\n", messagesSent);
-		Con_Printf ("reliable messages received = %i\n", messagesReceived);
+		Con_Printf ("unreliable messages sent   = %u\n", Atomic_LoadUInt32 (&unreliableMessagesSent));
+		Con_Printf ("unreliable messages recv   = %u\n", Atomic_LoadUInt32 (&unreliableMessagesReceived));
+		Con_Printf ("reliable messages sent     = %u\n", Atomic_LoadUInt32 (&messagesSent));
+		Con_Printf ("reliable messages received = %u\n", Atomic_LoadUInt32 (&messagesReceived));
 		Con_Printf ("packetsSent                = %i\n", packetsSent);
 		Con_Printf ("packetsReSent              = %i\n", packetsReSent);
 		Con_Printf ("packetsReceived            = %i\n", packetsReceived);
@@ -25,11 +25,86 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "net_sys.h"
 #include "net_defs.h"
 #include "net_loop.h"
+#include "atomics.h"
+
+/*
+Each direction of the loopback connection is a single-producer/single-consumer
+ring of variable sized records. The sender copies its message into the ring
+once and the receiver parses it in place: net_message is pointed straight at
+the record until the next read on that socket releases it. Only the head and
+tail positions are shared between the two ends, so the server may produce
+while the client consumes on another thread.
+*/
+
+#define LOOP_RINGSIZE   (1 << 19)
+#define LOOP_RINGMASK   (LOOP_RINGSIZE - 1)
+#define LOOP_RECORDSIZE sizeof (looprecord_t)
+
+#define LOOP_WRAP       0
+#define LOOP_RELIABLE   1
+#define LOOP_UNRELIABLE 2
+
+typedef struct
+{
+	byte           type;
+	byte           pad;
+	unsigned short length;
+	unsigned int   sequence;
+} looprecord_t;
+
+typedef struct
+{
+	atomic_uint32_t head;     // end of the last published record, written by the sender
+	atomic_uint32_t tail;     // start of the oldest record still referenced, written by the receiver
+	atomic_uint32_t reliable; // number of reliable messages queued and not parsed yet
+	uint32_t        readpos;  // start of the next record to parse
+	byte            data[LOOP_RINGSIZE];
+} loopring_t;
+
+COMPILE_TIME_ASSERT (looprecord_t, sizeof (looprecord_t) == 8);
+COMPILE_TIME_ASSERT (loopring_t, LOOP_RINGSIZE >= NET_MAXMESSAGE * NET_LOOPBACKBUFFERS);
 
 static qboolean   localconnectpending = false;
 static qsocket_t *loop_client = NULL;
 static qsocket_t *loop_server = NULL;
 
+static loopring_t loop_rings[2];
+
+// net_message's own buffer while it is viewing a ring record, per thread like net_message
+static THREAD_LOCAL byte *loop_messagedata;
+static THREAD_LOCAL int   loop_messagemaxsize;
+
+static loopring_t *Loop_ReceiveRing (qsocket_t *sock)
+{
+	return (sock == loop_client) ? &loop_rings[0] : &loop_rings[1];
+}
+
+static void Loop_ResetRing (loopring_t *ring)
+{
+	Atomic_StoreUInt32 (&ring->head, 0);
+	Atomic_StoreUInt32 (&ring->tail, 0);
+	Atomic_StoreUInt32 (&ring->reliable, 0);
+	ring->readpos = 0;
+}
+
+/*
+=================
+Loop_ReleaseMessage
+
+Points net_message back at its own buffer if it is still viewing a ring
+record. Must be called before anything else fills net_message.
+=================
+*/
+void Loop_ReleaseMessage (void)
+{
+	if (!loop_messagedata)
+		return;
+	net_message.data = loop_messagedata;
+	net_message.maxsize = loop_messagemaxsize;
+	net_message.cursize = 0;
+	loop_messagedata = NULL;
+}
+
 int Loop_Init (void)
 {
 	if (cls.state == ca_dedicated)
@@ -76,9 +151,7 @@ qsocket_t *Loop_Connect (const char *host)
 		strcpy (loop_client->trueaddress, "localhost");
 		strcpy (loop_client->maskedaddress, "localhost");
 	}
-	loop_client->receiveMessageLength = 0;
 	loop_client->sendMessageLength = 0;
-	loop_client->canSend = true;
 
 	if (!loop_server)
 	{
@@ -90,9 +163,11 @@ qsocket_t *Loop_Connect (const char *host)
 		strcpy (loop_server->trueaddress, "LOCAL");
 		strcpy (loop_server->maskedaddress, "LOCAL");
 	}
-	loop_server->receiveMessageLength = 0;
 	loop_server->sendMessageLength = 0;
-	loop_server->canSend = true;
+
+	Loop_ReleaseMessage ();
+	Loop_ResetRing (&loop_rings[0]);
+	Loop_ResetRing (&loop_rings[1]);
 
 	loop_client->driverdata = (void *)loop_server;
 	loop_server->driverdata = (void *)loop_client;
@@ -109,54 +184,92 @@ qsocket_t *Loop_CheckNewConnections (void)
 
 	localconnectpending = false;
 	loop_server->sendMessageLength = 0;
-	loop_server->receiveMessageLength = 0;
-	loop_server->canSend = true;
 	loop_client->sendMessageLength = 0;
-	loop_client->receiveMessageLength = 0;
-	loop_client->canSend = true;
+	// the rings were reset by Loop_Connect, the client may already be reading its own
 	return loop_server;
 }
 
-static int IntAlign (int value)
+static uint32_t Loop_RecordAlign (uint32_t value)
 {
-	return (value + (sizeof (int) - 1)) & (~(sizeof (int) - 1));
+	return (value + (LOOP_RECORDSIZE - 1)) & ~(uint32_t)(LOOP_RECORDSIZE - 1);
 }
 
 int Loop_GetMessage (qsocket_t *sock)
 {
-	int ret;
-	int length;
+	loopring_t   *ring = Loop_ReceiveRing (sock);
+	looprecord_t *record;
+	uint32_t      head;
 
-	if (sock->receiveMessageLength == 0)
-		return 0;
+	// the previous record is no longer referenced once we're asked for the next one
+	Loop_ReleaseMessage ();
+	Atomic_StoreUInt32 (&ring->tail, ring->readpos);
 
-	ret = sock->receiveMessage[0];
-	length = sock->receiveMessage[1] + (sock->receiveMessage[2] << 8);
-	// alignment byte skipped here
-	SZ_Clear (&net_message);
-	if (ret == 2)
+	head = Atomic_LoadUInt32 (&ring->head);
+	for (;;)
+	{
+		if (ring->readpos == head)
+			return 0;
+		record = (looprecord_t *)(ring->data + (ring->readpos & LOOP_RINGMASK));
+		if (record->type != LOOP_WRAP)
+			break;
+		ring->readpos += LOOP_RINGSIZE - (ring->readpos & LOOP_RINGMASK);
+	}
+	ring->readpos += Loop_RecordAlign (LOOP_RECORDSIZE + record->length);
+
+	loop_messagedata = net_message.data;
+	loop_messagemaxsize = net_message.maxsize;
+	net_message.data = (byte *)(record + 1);
+	net_message.maxsize = record->length;
+	net_message.cursize = record->length;
+
+	if (record->type == LOOP_UNRELIABLE)
 	{ // unreliables have sequences that we (now) care about so that clients can ack them.
-		sock->unreliableReceiveSequence =
-			sock->receiveMessage[4] | (sock->receiveMessage[5] << 8) | (sock->receiveMessage[6] << 16) | (sock->receiveMessage[7] << 24);
-		sock->unreliableReceiveSequence++;
-		SZ_Write (&net_message, &sock->receiveMessage[8], length);
-		length = IntAlign (length + 8);
+		sock->unreliableReceiveSequence = record->sequence + 1;
 	}
 	else
-	{ // reliable
-		SZ_Write (&net_message, &sock->receiveMessage[4], length);
-		length = IntAlign (length + 4);
-	}
+		Atomic_DecrementUInt32 (&ring->reliable);
 
-	sock->receiveMessageLength -= length;
+	return record->type;
+}
+
+/*
+=================
+Loop_WriteRecord
 
-	if (sock->receiveMessageLength)
-		memmove (sock->receiveMessage, &sock->receiveMessage[length], sock->receiveMessageLength);
+Copies a message into the peer's ring. reserve bytes are kept free for
+messages that must not be dropped. Returns false if the ring is full.
+=================
+*/
+static qboolean Loop_WriteRecord (loopring_t *ring, int type, unsigned int sequence, sizebuf_t *data, uint32_t reserve)
+{
+	const uint32_t size = Loop_RecordAlign (LOOP_RECORDSIZE + data->cursize);
+	uint32_t       head = Atomic_LoadUInt32 (&ring->head);
+	uint32_t       tail = Atomic_LoadUInt32 (&ring->tail);
+	uint32_t       skip = LOOP_RINGSIZE - (head & LOOP_RINGMASK);
+	looprecord_t  *record;
+
+	// records are contiguous, pad to the start of the ring if this one doesn't fit
+	if (skip >= size)
+		skip = 0;
+	if (head + skip + size - tail > LOOP_RINGSIZE - reserve)
+		return false;
+
+	if (skip)
+	{
+		record = (looprecord_t *)(ring->data + (head & LOOP_RINGMASK));
+		record->type = LOOP_WRAP;
+		head += skip;
+	}
 
-	if (sock->driverdata && ret == 1)
-		((qsocket_t *)sock->driverdata)->canSend = true;
+	record = (looprecord_t *)(ring->data + (head & LOOP_RINGMASK));
+	record->type = type;
+	record->pad = 0;
+	record->length = data->cursize;
+	record->sequence = sequence;
+	memcpy (record + 1, data->data, data->cursize);
 
-	return ret;
+	Atomic_StoreUInt32 (&ring->head, head + size);
+	return true;
 }
 
 qsocket_t *Loop_GetAnyMessage (void)
@@ -171,72 +284,30 @@ qsocket_t *Loop_GetAnyMessage (void)
 
 int Loop_SendMessage (qsocket_t *sock, sizebuf_t *data)
 {
-	byte *buffer;
-	int  *bufferLength;
+	loopring_t *ring;
 
 	if (!sock->driverdata)
 		return -1;
 
-	bufferLength = &((qsocket_t *)sock->driverdata)->receiveMessageLength;
-
-	if ((*bufferLength + data->cursize + NET_LOOPBACKHEADERSIZE) > NET_MAXMESSAGE * NET_LOOPBACKBUFFERS + NET_LOOPBACKHEADERSIZE)
+	ring = Loop_ReceiveRing ((qsocket_t *)sock->driverdata);
+	Atomic_IncrementUInt32 (&ring->reliable);
+	if (!Loop_WriteRecord (ring, LOOP_RELIABLE, 0, data, 0))
 		Sys_Error ("Loop_SendMessage: overflow");
 
-	buffer = ((qsocket_t *)sock->driverdata)->receiveMessage + *bufferLength;
-
-	// message type
-	*buffer++ = 1;
-
-	// length
-	*buffer++ = data->cursize & 0xff;
-	*buffer++ = data->cursize >> 8;
-
-	// align
-	buffer++;
-
-	// message
-	memcpy (buffer, data->data, data->cursize);
-	*bufferLength = IntAlign (*bufferLength + data->cursize + 4);
-
-	sock->canSend = false;
 	return 1;
 }
 
 int Loop_SendUnreliableMessage (qsocket_t *sock, sizebuf_t *data)
 {
-	byte *buffer;
-	int  *bufferLength;
-	int   sequence = sock->unreliableSendSequence++;
+	int sequence = sock->unreliableSendSequence++;
 
 	if (!sock->driverdata)
 		return -1;
 
-	bufferLength = &((qsocket_t *)sock->driverdata)->receiveMessageLength;
-
 	// always leave one buffer for reliable messages
-	if ((*bufferLength + data->cursize + NET_LOOPBACKHEADERSIZE) > NET_MAXMESSAGE * (NET_LOOPBACKBUFFERS - 1))
+	if (!Loop_WriteRecord (Loop_ReceiveRing ((qsocket_t *)sock->driverdata), LOOP_UNRELIABLE, sequence, data, 2 * (NET_MAXMESSAGE + LOOP_RECORDSIZE)))
 		return 0;
 
-	buffer = ((qsocket_t *)sock->driverdata)->receiveMessage + *bufferLength;
-
-	// message type
-	*buffer++ = 2;
-
-	// length
-	*buffer++ = data->cursize & 0xff;
-	*buffer++ = data->cursize >> 8;
-
-	// align
-	buffer++;
-
-	*buffer++ = (sequence >> 0) & 0xff;
-	*buffer++ = (sequence >> 8) & 0xff;
-	*buffer++ = (sequence >> 16) & 0xff;
-	*buffer++ = (sequence >> 24) & 0xff;
-
-	// message
-	memcpy (buffer, data->data, data->cursize);
-	*bufferLength = IntAlign (*bufferLength + data->cursize + 8);
 	return 1;
 }
 
@@ -244,7 +315,7 @@ qboolean Loop_CanSendMessage (qsocket_t *sock)
 {
 	if (!sock->driverdata)
 		return false;
-	return sock->canSend;
+	return !Atomic_LoadUInt32 (&Loop_ReceiveRing ((qsocket_t *)sock->driverdata)->reliable);
 }
 
 qboolean Loop_CanSendUnreliableMessage (qsocket_t *sock)
@@ -256,9 +327,9 @@ void Loop_Close (qsocket_t *sock)
 {
 	if (sock->driverdata)
 		((qsocket_t *)sock->driverdata)->driverdata = NULL;
-	sock->receiveMessageLength = 0;
+	Loop_ReleaseMessage ();
+	Loop_ResetRing (Loop_ReceiveRing (sock));
 	sock->sendMessageLength = 0;
-	sock->canSend = true;
 	if (sock == loop_client)
 		loop_client = NULL;
 	else
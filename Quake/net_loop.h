@@ -37,5 +37,6 @@ qboolean   Loop_CanSendMessage (qsocket_t *sock);
 qboolean   Loop_CanSendUnreliableMessage (qsocket_t *sock);
 void       Loop_Close (qsocket_t *sock);
 void       Loop_Shutdown (void);
+void       Loop_ReleaseMessage (void);
 
 #endif /* __NET_LOOP_H */
@@ -24,6 +24,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "arch_def.h"
 #include "net_sys.h"
 #include "net_defs.h"
+#include "net_loop.h"
 
 qsocket_t *net_activeSockets = NULL;
 qsocket_t *net_freeSockets = NULL;
@@ -54,13 +55,14 @@ static void          Slist_Poll (void *);
 static PollProcedure slistSendProcedure = {NULL, 0.0, Slist_Send};
 static PollProcedure slistPollProcedure = {NULL, 0.0, Slist_Poll};
 
-sizebuf_t net_message;
-int       net_activeconnections = 0;
+THREAD_LOCAL sizebuf_t net_message;
+int                    net_activeconnections = 0;
 
-int messagesSent = 0;
-int messagesReceived = 0;
-int unreliableMessagesSent = 0;
-int unreliableMessagesReceived = 0;
+// the threaded server may count alongside the client
+atomic_uint32_t messagesSent;
+atomic_uint32_t messagesReceived;
+atomic_uint32_t unreliableMessagesSent;
+atomic_uint32_t unreliableMessagesReceived;
 
 cvar_t net_messagetimeout = {"net_messagetimeout", "300", CVAR_NONE};
 cvar_t net_connecttimeout = {"net_connecttimeout", "10", CVAR_NONE}; // this might be a little brief, but we don't have a way to protect against smurf attacks.
@@ -70,9 +72,10 @@ cvar_t hostname = {"hostname", "UNNAMED", CVAR_SERVERINFO};
 #define sfunc net_drivers[sock->driver]
 #define dfunc net_drivers[net_driverlevel]
 
-int net_driverlevel;
+// per thread, the threaded server polls its own socket while the client polls
+THREAD_LOCAL int net_driverlevel;
 
-double net_time;
+THREAD_LOCAL double net_time;
 
 double SetNetTime (void)
 {
@@ -374,6 +377,7 @@ const char *NET_SlistPrintServerName (size_t idx)
 
 static void Slist_Send (void *unused)
 {
+	Loop_ReleaseMessage ();
 	for (net_driverlevel = 0; net_driverlevel < net_numdrivers; net_driverlevel++)
 	{
 		if (slistScope != SLIST_LOOP && IS_LOOP_DRIVER (net_driverlevel))
@@ -389,6 +393,7 @@ static void Slist_Send (void *unused)
 
 static void Slist_Poll (void *unused)
 {
+	Loop_ReleaseMessage ();
 	for (net_driverlevel = 0; net_driverlevel < net_numdrivers; net_driverlevel++)
 	{
 		if (slistScope != SLIST_LOOP && IS_LOOP_DRIVER (net_driverlevel))
@@ -431,6 +436,7 @@ qsocket_t *NET_Connect (const char *host)
 	int        numdrivers = net_numdrivers;
 
 	SetNetTime ();
+	Loop_ReleaseMessage ();
 
 	if (host && *host == 0)
 		host = NULL;
@@ -513,6 +519,7 @@ qsocket_t *NET_CheckNewConnections (void)
 	qsocket_t *ret;
 
 	SetNetTime ();
+	Loop_ReleaseMessage ();
 
 	for (net_driverlevel = 0; net_driverlevel < net_numdrivers; net_driverlevel++)
 	{
@@ -577,6 +584,8 @@ int NET_GetMessage (qsocket_t *sock)
 
 	SetNetTime ();
 
+	// a loopback record may still be viewed through net_message
+	Loop_ReleaseMessage ();
 	ret = sfunc.QGetMessage (sock);
 
 	// see if this connection has timed out
@@ -595,9 +604,9 @@ int NET_GetMessage (qsocket_t *sock)
 		{
 			sock->lastMessageTime = net_time;
 			if (ret == 1)
-				messagesReceived++;
+				Atomic_IncrementUInt32 (&messagesReceived);
 			else if (ret == 2)
-				unreliableMessagesReceived++;
+				Atomic_IncrementUInt32 (&unreliableMessagesReceived);
 		}
 	}
 
@@ -616,6 +625,8 @@ returns the qsocket that the message was meant to be for.
 qsocket_t *NET_GetServerMessage (void)
 {
 	qsocket_t *s;
+
+	Loop_ReleaseMessage ();
 	for (net_driverlevel = 0; net_driverlevel < net_numdrivers; net_driverlevel++)
 	{
 		if (!net_drivers[net_driverlevel].initialized)
@@ -671,7 +682,7 @@ int NET_SendMessage (qsocket_t *sock, sizebuf_t *data)
 	SetNetTime ();
 	r = sfunc.QSendMessage (sock, data);
 	if (r == 1 && !IS_LOOP_DRIVER (sock->driver))
-		messagesSent++;
+		Atomic_IncrementUInt32 (&messagesSent);
 
 	return r;
 }
@@ -692,7 +703,7 @@ int NET_SendUnreliableMessage (qsocket_t *sock, sizebuf_t *data)
 	SetNetTime ();
 	r = sfunc.SendUnreliableMessage (sock, data);
 	if (r == 1 && !IS_LOOP_DRIVER (sock->driver))
-		unreliableMessagesSent++;
+		Atomic_IncrementUInt32 (&unreliableMessagesSent);
 
 	return r;
 }
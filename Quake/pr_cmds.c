@@ -922,6 +922,46 @@ static void PF_cvar (void)
 	G_FLOAT (OFS_RETURN) = Cvar_VariableValue (str);
 }
 
+/*
+=================
+PR_CvarSet / PR_CvarCreate
+
+Cvars and their callbacks belong to the client too, the threaded server
+changes them on the main thread
+=================
+*/
+typedef struct
+{
+	const char *name;
+	const char *value;
+	cvar_t     *var;
+} pr_cvarcall_t;
+
+static void PR_CvarSetCall (void *data)
+{
+	pr_cvarcall_t *call = (pr_cvarcall_t *)data;
+	Cvar_Set (call->name, call->value);
+}
+
+static void PR_CvarCreateCall (void *data)
+{
+	pr_cvarcall_t *call = (pr_cvarcall_t *)data;
+	call->var = Cvar_Create (call->name, call->value);
+}
+
+void PR_CvarSet (const char *name, const char *value)
+{
+	pr_cvarcall_t call = {name, value, NULL};
+	Host_CallOnMainThread (PR_CvarSetCall, &call);
+}
+
+cvar_t *PR_CvarCreate (const char *name, const char *value)
+{
+	pr_cvarcall_t call = {name, value, NULL};
+	Host_CallOnMainThread (PR_CvarCreateCall, &call);
+	return call.var;
+}
+
 /*
 =================
 PF_cvar_set
@@ -936,7 +976,7 @@ static void PF_cvar_set (void)
 	var = G_STRING (OFS_PARM0);
 	val = G_STRING (OFS_PARM1);
 
-	Cvar_Set (var, val);
+	PR_CvarSet (var, val);
 }
 
 /*
@@ -1131,6 +1171,34 @@ static void PF_sv_precache_sound (void)
 		PR_RunError ("PF_precache_sound: overflow");
 }
 
+/*
+=================
+SV_ModelForName
+
+Models are shared with the client, late precaches from the threaded server
+load them on the main thread
+=================
+*/
+typedef struct
+{
+	const char *name;
+	qboolean    crash;
+	qmodel_t   *mod;
+} sv_modelcall_t;
+
+static void SV_ModelForNameCall (void *data)
+{
+	sv_modelcall_t *call = (sv_modelcall_t *)data;
+	call->mod = Mod_ForName (call->name, call->crash);
+}
+
+static qmodel_t *SV_ModelForName (const char *name, qboolean crash)
+{
+	sv_modelcall_t call = {name, crash, NULL};
+	Host_CallOnMainThread (SV_ModelForNameCall, &call);
+	return call.mod;
+}
+
 int SV_Precache_Model (const char *s)
 {
 	size_t i;
@@ -1147,7 +1215,7 @@ int SV_Precache_Model (const char *s)
 			}
 
 			sv.model_precache[i] = s;
-			sv.models[i] = Mod_ForName (s, i == 1);
+			sv.models[i] = SV_ModelForName (s, i == 1);
 			return i;
 		}
 		if (!strcmp (sv.model_precache[i], s))
@@ -1179,7 +1247,7 @@ static void PF_sv_precache_model (void)
 			}
 
 			sv.model_precache[i] = s;
-			sv.models[i] = Mod_ForName (s, i == 1);
+			sv.models[i] = SV_ModelForName (s, i == 1);
 			return;
 		}
 		if (!strcmp (sv.model_precache[i], s))
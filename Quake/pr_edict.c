@@ -1076,8 +1076,8 @@ void ED_LoadFromFile (const char *data)
 }
 
 #ifndef PR_SwitchQCVM
-qcvm_t       *qcvm;
-globalvars_t *pr_global_struct;
+THREAD_LOCAL qcvm_t       *qcvm;
+THREAD_LOCAL globalvars_t *pr_global_struct;
 void          PR_SwitchQCVM (qcvm_t *nvm)
 {
 	if (qcvm && nvm)
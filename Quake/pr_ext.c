@@ -2430,7 +2430,7 @@ static void PF_registercvar (void)
 {
 	const char *name = G_STRING (OFS_PARM0);
 	const char *value = (qcvm->argc > 1) ? G_STRING (OFS_PARM0) : "";
-	Cvar_Create (name, value);
+	PR_CvarCreate (name, value);
 }
 
 // temp entities + networking
@@ -3709,8 +3709,9 @@ static void PF_infokey_f (void)
 static void PF_multicast_internal (qboolean reliable, byte *pvs, unsigned int requireext2)
 {
 	unsigned int i;
-	int          cluster;
+	int          cluster, start;
 	mleaf_t     *playerleaf;
+	sizebuf_t   *buf;
 	if (!pvs)
 	{
 		if (!requireext2)
@@ -3723,7 +3724,10 @@ static void PF_multicast_internal (qboolean reliable, byte *pvs, unsigned int re
 					continue;
 				if (!(svs.clients[i].protocol_pext2 & requireext2))
 					continue;
-				SZ_Write ((reliable ? &svs.clients[i].message : &svs.clients[i].datagram), sv.multicast.data, sv.multicast.cursize);
+				buf = reliable ? &svs.clients[i].message : &svs.clients[i].datagram;
+				start = buf->cursize;
+				SZ_Write (buf, sv.multicast.data, sv.multicast.cursize);
+				SV_MVD_SkipClientData (&svs.clients[i], buf, start);
 			}
 		}
 	}
@@ -3744,10 +3748,11 @@ static void PF_multicast_internal (qboolean reliable, byte *pvs, unsigned int re
 			if (cluster < 0 || (pvs[cluster >> 3] & (1 << (cluster & 7))))
 			{
 				// they can see it. add it in to whichever buffer is appropriate.
-				if (reliable)
-					SZ_Write (&svs.clients[i].message, sv.multicast.data, sv.multicast.cursize);
-				else
-					SZ_Write (&svs.clients[i].datagram, sv.multicast.data, sv.multicast.cursize);
+				buf = reliable ? &svs.clients[i].message : &svs.clients[i].datagram;
+				start = buf->cursize;
+				SZ_Write (buf, sv.multicast.data, sv.multicast.cursize);
+				if (requireext2)
+					SV_MVD_SkipClientData (&svs.clients[i], buf, start);
 			}
 		}
 	}
@@ -5215,7 +5220,7 @@ static void PF_checkextension (void)
 			for (i = 0; cvn[i]; i++)
 				if (cvn[i] >= 'A' && cvn[i] <= 'Z')
 					cvn[i] = 'a' + (cvn[i] - 'A');
-			v = Cvar_Create (cvn, "1");
+			v = PR_CvarCreate (cvn, "1");
 			if (v && !v->value)
 			{
 				if (!pr_checkextension.value)
@@ -158,6 +158,8 @@ sizebuf_t *WriteDest (void);
 char      *PR_GetTempString (void);
 int        PR_MakeTempString (const char *val);
 char      *PF_VarString (int first);
+void       PR_CvarSet (const char *name, const char *value);
+cvar_t    *PR_CvarCreate (const char *name, const char *value);
 #define STRINGTEMP_BUFFERS 1024
 #define STRINGTEMP_LENGTH  1024
 void PF_Fixme (void); // the 'unimplemented' builtin. woot.
@@ -364,9 +366,9 @@ struct qcvm_s
 	areanode_t areanodes[AREA_NODES];
 	int        numareanodes;
 };
-extern globalvars_t *pr_global_struct;
+extern THREAD_LOCAL globalvars_t *pr_global_struct;
 
-extern qcvm_t *qcvm;
+extern THREAD_LOCAL qcvm_t *qcvm;
 void           PR_SwitchQCVM (qcvm_t *nvm);
 
 extern builtin_t pr_ssqcbuiltins[];
@@ -104,12 +104,17 @@ void S_ClearAll (void);
 void S_BlockSound (void);
 void S_UnblockSound (void);
 
+void S_BeginCapture (double step);
+void S_EndCapture (void);
+void S_CaptureFrame (void);
+
 sfx_t *S_PrecacheSound (const char *sample);
 void   S_TouchSound (const char *sample);
 void   S_ClearPrecache (void);
 void   S_BeginPrecaching (void);
 void   S_EndPrecaching (void);
 void   S_PaintChannels (int endtime);
+void   S_CaptureChannels (int endtime, short *out);
 void   S_InitPaintChannels (void);
 
 /* picks a channel based on priorities, empty slots, number of channels */
@@ -352,14 +352,28 @@ extern filelist_item_t *extralevels;
 extern filelist_item_t *demolist;
 extern filelist_item_t *savelist;
 
+// how the threaded server's last ticks ended
+enum
+{
+	SV_THREAD_OK,
+	SV_THREAD_ERROR,
+	SV_THREAD_ENDGAME
+};
+
 void               Host_ClearMemory (void);
 void               Host_ServerFrame (void);
+qboolean           Host_ServerThreaded (void);
+qboolean           Host_ServerThreadBusy (void);
+qboolean           Host_IsServerThread (void);
+void               Host_WaitServerThread (void);
+void               Host_CallOnMainThread (void (*func) (void *), void *data);
 void               Host_InitCommands (void);
 void               Host_Init (void);
 void               Host_Shutdown (void);
 void               Host_Callback_Notify (cvar_t *var); /* callback function for CVAR_NOTIFY */
 FUNC_NORETURN void Host_Error (const char *error, ...) FUNC_PRINTF (1, 2);
 FUNC_NORETURN void Host_EndGame (const char *message, ...) FUNC_PRINTF (1, 2);
+FUNC_NORETURN void Host_AbortServerThread (int failure, const char *message);
 void               Host_Frame (double time);
 void               Host_Quit_f (void);
 void               Host_ClientCommands (const char *fmt, ...) FUNC_PRINTF (1, 2);
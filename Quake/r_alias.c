@@ -60,6 +60,24 @@ typedef struct
 	float        entalpha;
 	unsigned int flags;
 } aliasubo_t;
+COMPILE_TIME_ASSERT (aliasubo_t, sizeof (aliasubo_t) == 100); // instance stride of the alias_instanced_pipelines
+
+// opaque entities waiting for R_FlushAliasBatch
+#define MAX_ALIAS_BATCH 256
+
+typedef struct
+{
+	entity_t    *entity;
+	aliashdr_t  *paliashdr;
+	lerpdata_t   lerpdata;
+	gltexture_t *tx;
+	gltexture_t *fb;
+	qboolean     alphatest;
+	int          num_instances;
+	aliasubo_t   instances[MAX_ALIAS_BATCH];
+} aliasbatch_t;
+
+static THREAD_LOCAL aliasbatch_t alias_batch;
 
 /*
 =============
@@ -75,6 +93,40 @@ static VkDeviceSize GLARB_GetXYZOffset (entity_t *e, aliashdr_t *hdr, int pose)
 	return e->model->vboxyzofs + (hdr->numverts_vbo * pose * sizeof (meshxyz_t)) + xyzoffs;
 }
 
+/*
+=============
+GL_BindAliasModel
+
+Entities are sorted by model, skin and frame, so only rebind what changed since the previous alias draw
+=============
+*/
+static void GL_BindAliasModel (cb_context_t *cbx, entity_t *e, aliashdr_t *paliashdr, lerpdata_t *lerpdata, gltexture_t *tx, gltexture_t *fb)
+{
+	const qboolean  same_model = (cbx->alias_model == e->model);
+	gltexture_t    *textures[2] = {tx, (fb != NULL) ? fb : tx};
+	VkDescriptorSet descriptor_sets[2] = {textures[0]->descriptor_set, textures[1]->descriptor_set};
+	if (!same_model || (cbx->alias_textures[0] != textures[0]) || (cbx->alias_textures[1] != textures[1]))
+		vulkan_globals.vk_cmd_bind_descriptor_sets (
+			cbx->cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.alias_pipeline.layout.handle, 0, 2, descriptor_sets, 0, NULL);
+
+	VkBuffer     vertex_buffers[3] = {e->model->vertex_buffer, e->model->vertex_buffer, e->model->vertex_buffer};
+	VkDeviceSize vertex_offsets[3] = {
+		(unsigned)e->model->vbostofs, GLARB_GetXYZOffset (e, paliashdr, lerpdata->pose1), GLARB_GetXYZOffset (e, paliashdr, lerpdata->pose2)};
+	if (!same_model)
+	{
+		vulkan_globals.vk_cmd_bind_vertex_buffers (cbx->cb, 0, 3, vertex_buffers, vertex_offsets);
+		vulkan_globals.vk_cmd_bind_index_buffer (cbx->cb, e->model->index_buffer, 0, VK_INDEX_TYPE_UINT16);
+	}
+	else if ((cbx->alias_pose_offsets[0] != vertex_offsets[1]) || (cbx->alias_pose_offsets[1] != vertex_offsets[2]))
+		vulkan_globals.vk_cmd_bind_vertex_buffers (cbx->cb, 1, 2, &vertex_buffers[1], &vertex_offsets[1]);
+
+	cbx->alias_model = e->model;
+	cbx->alias_textures[0] = textures[0];
+	cbx->alias_textures[1] = textures[1];
+	cbx->alias_pose_offsets[0] = vertex_offsets[1];
+	cbx->alias_pose_offsets[1] = vertex_offsets[2];
+}
+
 /*
 =============
 GL_DrawAliasFrame -- ericw
@@ -89,18 +141,11 @@ Based on code by MH from RMQEngine
 =============
 */
 static void GL_DrawAliasFrame (
-	cb_context_t *cbx, entity_t *e, aliashdr_t *paliashdr, lerpdata_t lerpdata, gltexture_t *tx, gltexture_t *fb, float model_matrix[16], float entity_alpha,
-	qboolean alphatest, vec3_t shadevector, vec3_t lightcolor)
+	cb_context_t *cbx, entity_t *e, aliashdr_t *paliashdr, lerpdata_t *lerpdata, gltexture_t *tx, gltexture_t *fb, qboolean alphatest,
+	const aliasubo_t *instance)
 {
-	float blend;
-
-	if (lerpdata.pose1 != lerpdata.pose2)
-		blend = lerpdata.blend;
-	else // poses the same means either 1. the entity has paused its animation, or 2. r_lerpmodels is disabled
-		blend = 0;
-
 	vulkan_pipeline_t pipeline;
-	if (entity_alpha >= 1.0f)
+	if (instance->entalpha >= 1.0f)
 	{
 		if (!alphatest)
 			pipeline = vulkan_globals.alias_pipeline;
@@ -121,25 +166,11 @@ static void GL_DrawAliasFrame (
 	uint32_t        uniform_offset;
 	VkDescriptorSet ubo_set;
 	aliasubo_t     *ubo = (aliasubo_t *)R_UniformAllocate (sizeof (aliasubo_t), &uniform_buffer, &uniform_offset, &ubo_set);
+	memcpy (ubo, instance, sizeof (aliasubo_t));
 
-	memcpy (ubo->model_matrix, model_matrix, 16 * sizeof (float));
-	memcpy (ubo->shade_vector, shadevector, 3 * sizeof (float));
-	ubo->blend_factor = blend;
-	memcpy (ubo->light_color, lightcolor, 3 * sizeof (float));
-	ubo->flags = (fb != NULL) ? 0x1 : 0x0;
-	if (r_fullbright_cheatsafe || (r_lightmap_cheatsafe && r_fullbright.value))
-		ubo->flags |= 0x2;
-	ubo->entalpha = entity_alpha;
-
-	VkDescriptorSet descriptor_sets[3] = {tx->descriptor_set, (fb != NULL) ? fb->descriptor_set : tx->descriptor_set, ubo_set};
+	GL_BindAliasModel (cbx, e, paliashdr, lerpdata, tx, fb);
 	vulkan_globals.vk_cmd_bind_descriptor_sets (
-		cbx->cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.alias_pipeline.layout.handle, 0, 3, descriptor_sets, 1, &uniform_offset);
-
-	VkBuffer     vertex_buffers[3] = {e->model->vertex_buffer, e->model->vertex_buffer, e->model->vertex_buffer};
-	VkDeviceSize vertex_offsets[3] = {
-		(unsigned)e->model->vbostofs, GLARB_GetXYZOffset (e, paliashdr, lerpdata.pose1), GLARB_GetXYZOffset (e, paliashdr, lerpdata.pose2)};
-	vulkan_globals.vk_cmd_bind_vertex_buffers (cbx->cb, 0, 3, vertex_buffers, vertex_offsets);
-	vulkan_globals.vk_cmd_bind_index_buffer (cbx->cb, e->model->index_buffer, 0, VK_INDEX_TYPE_UINT16);
+		cbx->cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.alias_pipeline.layout.handle, 2, 1, &ubo_set, 1, &uniform_offset);
 
 	vulkan_globals.vk_cmd_draw_indexed (cbx->cb, paliashdr->numindexes, 1, 0, 0, 0);
 }
@@ -365,36 +396,37 @@ static void R_SetupAliasLighting (entity_t *e, vec3_t *shadevector, vec3_t *ligh
 
 /*
 =================
-R_DrawAliasModel -- johnfitz -- almost completely rewritten
+R_SetupAliasInstance
+
+Everything R_DrawAliasModel needs to draw the entity, returns false if it's culled or invisible
 =================
 */
-void R_DrawAliasModel (cb_context_t *cbx, entity_t *e, int *aliaspolys)
+static qboolean R_SetupAliasInstance (
+	entity_t *e, aliashdr_t **ppaliashdr, lerpdata_t *lerpdata, gltexture_t **ptx, gltexture_t **pfb, aliasubo_t *instance, int *aliaspolys)
 {
 	aliashdr_t  *paliashdr;
 	int          anim, skinnum;
 	gltexture_t *tx, *fb;
-	lerpdata_t   lerpdata;
-	qboolean     alphatest = !!(e->model->flags & MF_HOLEY);
 
 	//
 	// setup pose/lerp data -- do it first so we don't miss updates due to culling
 	//
 	paliashdr = (aliashdr_t *)Mod_Extradata (e->model);
-	R_SetupAliasFrame (e, paliashdr, e->frame, &lerpdata);
-	R_SetupEntityTransform (e, &lerpdata);
+	R_SetupAliasFrame (e, paliashdr, e->frame, lerpdata);
+	R_SetupEntityTransform (e, lerpdata);
 
 	//
 	// cull it
 	//
 	if (R_CullModelForEntity (e))
-		return;
+		return false;
 
 	//
 	// transform it
 	//
-	float model_matrix[16];
+	float *model_matrix = instance->model_matrix;
 	IdentityMatrix (model_matrix);
-	R_RotateForEntity (model_matrix, lerpdata.origin, lerpdata.angles, e->netstate.scale);
+	R_RotateForEntity (model_matrix, lerpdata->origin, lerpdata->angles, e->netstate.scale);
 
 	float fovscale = 1.0f;
 	if (e == &cl.viewent && r_refdef.basefov > 90.f && cl_gun_fovscale.value)
@@ -412,16 +444,20 @@ void R_DrawAliasModel (cb_context_t *cbx, entity_t *e, int *aliaspolys)
 	ScaleMatrix (scale_matrix, paliashdr->scale[0] * 255.0f, paliashdr->scale[1] * fovscale * 255.0f, paliashdr->scale[2] * fovscale * 255.0f);
 	MatrixMultiply (model_matrix, scale_matrix);
 
+	if (lerpdata->pose1 != lerpdata->pose2)
+		instance->blend_factor = lerpdata->blend;
+	else // poses the same means either 1. the entity has paused its animation, or 2. r_lerpmodels is disabled
+		instance->blend_factor = 0;
+
 	//
 	// set up for alpha blending
 	//
-	float entalpha;
 	if (r_lightmap_cheatsafe)
-		entalpha = 1;
+		instance->entalpha = 1;
 	else
-		entalpha = ENTALPHA_DECODE (e->alpha);
-	if (entalpha == 0)
-		return;
+		instance->entalpha = ENTALPHA_DECODE (e->alpha);
+	if (instance->entalpha == 0)
+		return false;
 
 	//
 	// set up lighting
@@ -467,10 +503,97 @@ void R_DrawAliasModel (cb_context_t *cbx, entity_t *e, int *aliaspolys)
 		}
 	}
 
+	memcpy (instance->shade_vector, shadevector, 3 * sizeof (float));
+	memcpy (instance->light_color, lightcolor, 3 * sizeof (float));
+	instance->flags = (fb != NULL) ? 0x1 : 0x0;
+	if (r_fullbright_cheatsafe || (r_lightmap_cheatsafe && r_fullbright.value))
+		instance->flags |= 0x2;
+
+	*ppaliashdr = paliashdr;
+	*ptx = tx;
+	*pfb = fb;
+	return true;
+}
+
+/*
+=================
+R_DrawAliasModel -- johnfitz -- almost completely rewritten
+=================
+*/
+void R_DrawAliasModel (cb_context_t *cbx, entity_t *e, int *aliaspolys)
+{
+	aliashdr_t  *paliashdr;
+	gltexture_t *tx, *fb;
+	lerpdata_t   lerpdata;
+	aliasubo_t   instance;
+
+	if (!R_SetupAliasInstance (e, &paliashdr, &lerpdata, &tx, &fb, &instance, aliaspolys))
+		return;
+
 	//
 	// draw it
 	//
-	GL_DrawAliasFrame (cbx, e, paliashdr, lerpdata, tx, fb, model_matrix, entalpha, alphatest, shadevector, lightcolor);
+	GL_DrawAliasFrame (cbx, e, paliashdr, &lerpdata, tx, fb, !!(e->model->flags & MF_HOLEY), &instance);
+}
+
+/*
+=================
+R_BatchAliasModel
+
+Opaque entities that share the model, textures and poses of the previous one are appended to its batch
+instead of being drawn, R_FlushAliasBatch draws the whole batch with one instanced draw
+=================
+*/
+void R_BatchAliasModel (cb_context_t *cbx, entity_t *e, int *aliaspolys, int *aliaspasses)
+{
+	aliashdr_t  *paliashdr;
+	gltexture_t *tx, *fb;
+	lerpdata_t   lerpdata;
+	aliasubo_t   instance;
+
+	if (!R_SetupAliasInstance (e, &paliashdr, &lerpdata, &tx, &fb, &instance, aliaspolys))
+		return;
+
+	if ((alias_batch.num_instances > 0) &&
+		((alias_batch.entity->model != e->model) || (alias_batch.tx != tx) || (alias_batch.fb != fb) || (alias_batch.lerpdata.pose1 != lerpdata.pose1) ||
+		 (alias_batch.lerpdata.pose2 != lerpdata.pose2) || (alias_batch.num_instances == MAX_ALIAS_BATCH)))
+		R_FlushAliasBatch (cbx, aliaspasses);
+
+	if (alias_batch.num_instances == 0)
+	{
+		alias_batch.entity = e;
+		alias_batch.paliashdr = paliashdr;
+		alias_batch.lerpdata = lerpdata;
+		alias_batch.tx = tx;
+		alias_batch.fb = fb;
+		alias_batch.alphatest = !!(e->model->flags & MF_HOLEY);
+	}
+	alias_batch.instances[alias_batch.num_instances++] = instance;
+}
+
+/*
+=================
+R_FlushAliasBatch
+=================
+*/
+void R_FlushAliasBatch (cb_context_t *cbx, int *aliaspasses)
+{
+	if (alias_batch.num_instances == 0)
+		return;
+
+	R_BindPipeline (cbx, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.alias_instanced_pipelines[alias_batch.alphatest ? 1 : 0]);
+	GL_BindAliasModel (cbx, alias_batch.entity, alias_batch.paliashdr, &alias_batch.lerpdata, alias_batch.tx, alias_batch.fb);
+
+	VkBuffer     instance_buffer;
+	VkDeviceSize instance_buffer_offset;
+	const int    instances_size = alias_batch.num_instances * sizeof (aliasubo_t);
+	byte        *instances = R_VertexAllocate (instances_size, &instance_buffer, &instance_buffer_offset);
+	memcpy (instances, alias_batch.instances, instances_size);
+	vulkan_globals.vk_cmd_bind_vertex_buffers (cbx->cb, 3, 1, &instance_buffer, &instance_buffer_offset);
+
+	vulkan_globals.vk_cmd_draw_indexed (cbx->cb, alias_batch.paliashdr->numindexes, alias_batch.num_instances, 0, 0, 0);
+	alias_batch.num_instances = 0;
+	++*aliaspasses;
 }
 
 // johnfitz -- values for shadow matrix
@@ -558,6 +681,7 @@ void R_DrawAliasModel_ShowTris (cb_context_t *cbx, entity_t *e)
 		(unsigned)e->model->vbostofs, GLARB_GetXYZOffset (e, paliashdr, lerpdata.pose1), GLARB_GetXYZOffset (e, paliashdr, lerpdata.pose2)};
 	vulkan_globals.vk_cmd_bind_vertex_buffers (cbx->cb, 0, 3, vertex_buffers, vertex_offsets);
 	vulkan_globals.vk_cmd_bind_index_buffer (cbx->cb, e->model->index_buffer, 0, VK_INDEX_TYPE_UINT16);
+	cbx->alias_model = NULL;
 
 	vulkan_globals.vk_cmd_draw_indexed (cbx->cb, paliashdr->numindexes, 1, 0, 0, 0);
 }
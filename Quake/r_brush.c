@@ -47,7 +47,9 @@ unsigned blocklights[LMBLOCK_WIDTH * LMBLOCK_HEIGHT * 3 + 1]; // johnfitz -- was
                                                               // (LMBLOCK_WIDTH*LMBLOCK_HEIGHT)
 
 static vulkan_memory_t bmodel_memory;
+static vulkan_memory_t bmodel_index_memory;
 VkBuffer               bmodel_vertex_buffer;
+VkBuffer               bmodel_index_buffer;
 
 extern cvar_t r_showtris;
 extern cvar_t r_simd;
@@ -72,6 +74,26 @@ typedef struct lm_compute_light_s
 } lm_compute_light_t;
 COMPILE_TIME_ASSERT (lm_compute_light_t, sizeof (lm_compute_light_t) == 32);
 
+// must match update_lightmap.comp
+#define DLIGHT_GRID_SIZE_X      16
+#define DLIGHT_GRID_SIZE_Y      16
+#define DLIGHT_GRID_SIZE_Z      8
+#define DLIGHT_GRID_CELLS       (DLIGHT_GRID_SIZE_X * DLIGHT_GRID_SIZE_Y * DLIGHT_GRID_SIZE_Z)
+#define DLIGHT_GRID_MAX_INDICES (MAX_DLIGHTS * 16)
+#define DLIGHT_GRID_MASK_WORDS  ((MAX_DLIGHTS + 31) >> 5)
+
+typedef struct lm_compute_lights_s
+{
+	vec4_t             grid_origin; // w: 0 if the grid overflowed and every light has to be tested
+	vec4_t             grid_inv_cell_size;
+	lm_compute_light_t lights[MAX_DLIGHTS];
+	uint32_t           grid_cells[DLIGHT_GRID_CELLS + 1]; // first entry of every cell in grid_lights, the last one is the end
+	uint32_t           grid_lights[DLIGHT_GRID_MAX_INDICES];
+} lm_compute_lights_t;
+
+// dynamic offsets are at most 256 byte aligned
+#define LIGHTS_BUFFER_SLOT_SIZE ((sizeof (lm_compute_lights_t) + 255) & ~(size_t)255)
+
 #define WORKGROUP_BOUNDS_BUFFER_SIZE ((LMBLOCK_WIDTH / 8) * (LMBLOCK_HEIGHT / 8) * sizeof (lm_compute_workgroup_bounds_t))
 
 static vulkan_memory_t     lightstyles_scales_buffer_memory;
@@ -82,7 +104,7 @@ static VkBuffer            surface_data_buffer;
 static VkBuffer            lightstyles_scales_buffer;
 static VkBuffer            lights_buffer;
 static float              *lightstyles_scales_buffer_mapped;
-static lm_compute_light_t *lights_buffer_mapped;
+static byte               *lights_buffer_mapped;
 
 static int current_compute_lightmap_buffer_index;
 
@@ -223,7 +245,7 @@ void R_DrawBrushModel (cb_context_t *cbx, entity_t *e, int chain, int *brushpoly
 	// instanced model
 	if (!r_gpulightmapupdate.value && clmodel->firstmodelsurface != 0)
 	{
-		for (k = 0; k < MAX_DLIGHTS; k++)
+		for (k = 0; k < MAX_CPU_DLIGHTS; k++)
 		{
 			if ((cl_dlights[k].die < cl.time) || (!cl_dlights[k].radius))
 				continue;
@@ -774,8 +796,7 @@ void R_AllocateLightmapComputeBuffers ()
 	}
 
 	{
-		size_t buffer_size = MAX_DLIGHTS * sizeof (lm_compute_light_t) * 2;
-		COMPILE_TIME_ASSERT (light_buffer_alignment, ((MAX_DLIGHTS * sizeof (lm_compute_light_t)) % 256) == 0);
+		size_t buffer_size = LIGHTS_BUFFER_SLOT_SIZE * 2;
 
 		Sys_Printf ("Allocating lights buffer (%u KB)\n", (int)buffer_size / 1024);
 
@@ -783,7 +804,7 @@ void R_AllocateLightmapComputeBuffers ()
 		memset (&buffer_create_info, 0, sizeof (buffer_create_info));
 		buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 		buffer_create_info.size = buffer_size;
-		buffer_create_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+		buffer_create_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 
 		err = vkCreateBuffer (vulkan_globals.device, &buffer_create_info, NULL, &lights_buffer);
 		if (err != VK_SUCCESS)
@@ -1124,7 +1145,7 @@ void GL_BuildLightmaps (void)
 		memset (&lights_buffer_info, 0, sizeof (lights_buffer_info));
 		lights_buffer_info.buffer = lights_buffer;
 		lights_buffer_info.offset = 0;
-		lights_buffer_info.range = MAX_DLIGHTS * sizeof (lm_compute_light_t);
+		lights_buffer_info.range = sizeof (lm_compute_lights_t);
 
 		VkWriteDescriptorSet writes[7];
 		memset (&writes, 0, sizeof (writes));
@@ -1181,7 +1202,7 @@ void GL_BuildLightmaps (void)
 		writes[6].dstBinding = 6;
 		writes[6].dstArrayElement = 0;
 		writes[6].descriptorCount = 1;
-		writes[6].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		writes[6].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
 		writes[6].dstSet = lm->descriptor_set;
 		writes[6].pBufferInfo = &lights_buffer_info;
 
@@ -1211,81 +1232,52 @@ void GL_DeleteBModelVertexBuffer (void)
 
 	if (bmodel_vertex_buffer)
 		vkDestroyBuffer (vulkan_globals.device, bmodel_vertex_buffer, NULL);
+	bmodel_vertex_buffer = VK_NULL_HANDLE;
+
+	if (bmodel_index_buffer)
+		vkDestroyBuffer (vulkan_globals.device, bmodel_index_buffer, NULL);
+	bmodel_index_buffer = VK_NULL_HANDLE;
 
 	if (bmodel_memory.handle != VK_NULL_HANDLE)
 	{
 		Atomic_DecrementUInt32 (&num_vulkan_bmodel_allocations);
 		R_FreeVulkanMemory (&bmodel_memory);
 	}
+
+	if (bmodel_index_memory.handle != VK_NULL_HANDLE)
+	{
+		Atomic_DecrementUInt32 (&num_vulkan_bmodel_allocations);
+		R_FreeVulkanMemory (&bmodel_index_memory);
+	}
 }
 
 /*
 ==================
-GL_BuildBModelVertexBuffer
+GL_CreateBModelBuffer
 
-Deletes gl_bmodel_vbo if it already exists, then rebuilds it with all
-surfaces from world + all brush models
+Creates a device local buffer with its own allocation and uploads data to it
 ==================
 */
-void GL_BuildBModelVertexBuffer (void)
+void GL_CreateBModelBuffer (
+	const void *data, int size, VkBufferUsageFlags usage, const char *name, VkBuffer *buffer, vulkan_memory_t *memory, const char *memory_name)
 {
-	unsigned int numverts, varray_bytes, varray_index;
-	int          i, j;
-	qmodel_t    *m;
-	float       *varray;
-	int          remaining_size;
-	int          copy_offset;
-
-	// count all verts in all models
-	numverts = 0;
-	for (j = 1; j < MAX_MODELS; j++)
-	{
-		m = cl.model_precache[j];
-		if (!m || m->name[0] == '*' || m->type != mod_brush)
-			continue;
-
-		for (i = 0; i < m->numsurfaces; i++)
-		{
-			numverts += m->surfaces[i].numedges;
-		}
-	}
-
-	// build vertex array
-	varray_bytes = VERTEXSIZE * sizeof (float) * numverts;
-	varray = (float *)Mem_Alloc (varray_bytes);
-	varray_index = 0;
-
-	for (j = 1; j < MAX_MODELS; j++)
-	{
-		m = cl.model_precache[j];
-		if (!m || m->name[0] == '*' || m->type != mod_brush)
-			continue;
-
-		for (i = 0; i < m->numsurfaces; i++)
-		{
-			msurface_t *s = &m->surfaces[i];
-			s->vbo_firstvert = varray_index;
-			memcpy (&varray[VERTEXSIZE * varray_index], s->polys->verts, VERTEXSIZE * sizeof (float) * s->numedges);
-			varray_index += s->numedges;
-		}
-	}
-
-	// Allocate & upload to GPU
 	VkResult err;
+	int      remaining_size;
+	int      copy_offset;
 
 	VkBufferCreateInfo buffer_create_info;
 	memset (&buffer_create_info, 0, sizeof (buffer_create_info));
 	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	buffer_create_info.size = varray_bytes;
-	buffer_create_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-	err = vkCreateBuffer (vulkan_globals.device, &buffer_create_info, NULL, &bmodel_vertex_buffer);
+	buffer_create_info.size = size;
+	buffer_create_info.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	err = vkCreateBuffer (vulkan_globals.device, &buffer_create_info, NULL, buffer);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkCreateBuffer failed");
 
-	GL_SetObjectName ((uint64_t)bmodel_vertex_buffer, VK_OBJECT_TYPE_BUFFER, "Brush Vertex Buffer");
+	GL_SetObjectName ((uint64_t)*buffer, VK_OBJECT_TYPE_BUFFER, name);
 
 	VkMemoryRequirements memory_requirements;
-	vkGetBufferMemoryRequirements (vulkan_globals.device, bmodel_vertex_buffer, &memory_requirements);
+	vkGetBufferMemoryRequirements (vulkan_globals.device, *buffer, &memory_requirements);
 
 	const int align_mod = memory_requirements.size % memory_requirements.alignment;
 	const int aligned_size = ((memory_requirements.size % memory_requirements.alignment) == 0)
@@ -1299,14 +1291,14 @@ void GL_BuildBModelVertexBuffer (void)
 	memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties (memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
 
 	Atomic_IncrementUInt32 (&num_vulkan_bmodel_allocations);
-	R_AllocateVulkanMemory (&bmodel_memory, &memory_allocate_info, VULKAN_MEMORY_TYPE_DEVICE);
-	GL_SetObjectName ((uint64_t)bmodel_memory.handle, VK_OBJECT_TYPE_DEVICE_MEMORY, "Brush Memory");
+	R_AllocateVulkanMemory (memory, &memory_allocate_info, VULKAN_MEMORY_TYPE_DEVICE);
+	GL_SetObjectName ((uint64_t)memory->handle, VK_OBJECT_TYPE_DEVICE_MEMORY, memory_name);
 
-	err = vkBindBufferMemory (vulkan_globals.device, bmodel_vertex_buffer, bmodel_memory.handle, 0);
+	err = vkBindBufferMemory (vulkan_globals.device, *buffer, memory->handle, 0);
 	if (err != VK_SUCCESS)
 		Sys_Error ("vkBindImageMemory failed");
 
-	remaining_size = varray_bytes;
+	remaining_size = size;
 	copy_offset = 0;
 
 	while (remaining_size > 0)
@@ -1321,17 +1313,93 @@ void GL_BuildBModelVertexBuffer (void)
 		region.srcOffset = staging_offset;
 		region.dstOffset = copy_offset;
 		region.size = size_to_copy;
-		vkCmdCopyBuffer (command_buffer, staging_buffer, bmodel_vertex_buffer, 1, &region);
+		vkCmdCopyBuffer (command_buffer, staging_buffer, *buffer, 1, &region);
 
 		R_StagingBeginCopy ();
-		memcpy (staging_memory, (byte *)varray + copy_offset, size_to_copy);
+		memcpy (staging_memory, (const byte *)data + copy_offset, size_to_copy);
 		R_StagingEndCopy ();
 
 		copy_offset += size_to_copy;
 		remaining_size -= size_to_copy;
 	}
+}
+
+/*
+==================
+GL_BuildBModelVertexBuffer
+
+Deletes gl_bmodel_vbo if it already exists, then rebuilds it with all
+surfaces from world + all brush models. Also builds a static index buffer
+with the fan triangulation of every surface so the world can be drawn
+with indirect draws instead of uploading indices every frame.
+==================
+*/
+void GL_BuildBModelVertexBuffer (void)
+{
+	unsigned int numverts, varray_bytes, varray_index;
+	unsigned int numindices, iarray_bytes, iarray_index;
+	int          i, j, k;
+	qmodel_t    *m;
+	float       *varray;
+	uint32_t    *iarray;
+
+	// count all verts in all models
+	numverts = 0;
+	numindices = 0;
+	for (j = 1; j < MAX_MODELS; j++)
+	{
+		m = cl.model_precache[j];
+		if (!m || m->name[0] == '*' || m->type != mod_brush)
+			continue;
+
+		for (i = 0; i < m->numsurfaces; i++)
+		{
+			numverts += m->surfaces[i].numedges;
+			numindices += 3 * (m->surfaces[i].numedges - 2);
+		}
+	}
+
+	// build vertex and index arrays
+	varray_bytes = VERTEXSIZE * sizeof (float) * numverts;
+	varray = (float *)Mem_Alloc (varray_bytes);
+	varray_index = 0;
+	iarray_bytes = sizeof (uint32_t) * numindices;
+	iarray = (uint32_t *)Mem_Alloc (q_max (iarray_bytes, sizeof (uint32_t)));
+	iarray_index = 0;
+
+	for (j = 1; j < MAX_MODELS; j++)
+	{
+		m = cl.model_precache[j];
+		if (!m || m->name[0] == '*' || m->type != mod_brush)
+			continue;
+
+		for (i = 0; i < m->numsurfaces; i++)
+		{
+			msurface_t *s = &m->surfaces[i];
+			s->vbo_firstvert = varray_index;
+			memcpy (&varray[VERTEXSIZE * varray_index], s->polys->verts, VERTEXSIZE * sizeof (float) * s->numedges);
+			varray_index += s->numedges;
+
+			s->vbo_firstindex = iarray_index;
+			for (k = 2; k < s->numedges; k++)
+			{
+				iarray[iarray_index++] = s->vbo_firstvert;
+				iarray[iarray_index++] = s->vbo_firstvert + k - 1;
+				iarray[iarray_index++] = s->vbo_firstvert + k;
+			}
+		}
+	}
+
+	// Allocate & upload to GPU
+	GL_CreateBModelBuffer (
+		varray, varray_bytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, "Brush Vertex Buffer", &bmodel_vertex_buffer, &bmodel_memory, "Brush Memory");
+	if (iarray_bytes > 0)
+		GL_CreateBModelBuffer (
+			iarray, iarray_bytes, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, "Brush Index Buffer", &bmodel_index_buffer, &bmodel_index_memory,
+			"Brush Index Memory");
 
 	Mem_Free (varray);
+	Mem_Free (iarray);
 }
 
 /*
@@ -1419,7 +1487,7 @@ void R_AddDynamicLights (msurface_t *surf)
 	tmax = (surf->extents[1] >> 4) + 1;
 	tex = surf->texinfo;
 
-	for (lnum = 0; lnum < MAX_DLIGHTS; lnum++)
+	for (lnum = 0; lnum < MAX_CPU_DLIGHTS; lnum++)
 	{
 		if (!(surf->dlightbits[lnum >> 5] & (1U << (lnum & 31))))
 			continue; // not lit by this light
@@ -1718,6 +1786,179 @@ static void R_UploadLightmap (int lmap, gltexture_t *lightmap_tex)
 	lm->rectchange.w = 0;
 }
 
+/*
+===============================================================================
+
+DYNAMIC LIGHT GRID
+
+The world bounds are split into a coarse grid of cells, each listing the
+dynamic lights whose bounds overlap it. It is rebuilt every frame by the
+lightmap update task and uploaded along with the lights, so the compute
+shader only tests the lights of the cells an 8x8 workgroup overlaps instead
+of all of them. Light indices are into the compacted lights of the frame.
+
+===============================================================================
+*/
+
+typedef struct
+{
+	vec3_t   origin;
+	vec3_t   inv_cell_size;
+	qboolean complete; // false if the lights didn't fit in DLIGHT_GRID_MAX_INDICES
+	int      num_lights;
+	int      lights[MAX_DLIGHTS]; // cl_dlights index of every compacted light
+	int      light_cells[MAX_DLIGHTS][2][3];
+	uint32_t cells[DLIGHT_GRID_CELLS + 1];
+	uint32_t cell_ends[DLIGHT_GRID_CELLS];
+	uint32_t indices[DLIGHT_GRID_MAX_INDICES];
+} dlight_grid_t;
+static dlight_grid_t dlight_grid;
+
+static const int dlight_grid_size[3] = {DLIGHT_GRID_SIZE_X, DLIGHT_GRID_SIZE_Y, DLIGHT_GRID_SIZE_Z};
+
+/*
+=============
+R_DlightGridRange
+=============
+*/
+static void R_DlightGridRange (const float *mins, const float *maxs, int first[3], int last[3])
+{
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		const float cell_max = dlight_grid_size[axis] - 1;
+		first[axis] = (int)CLAMP (0.0f, floorf ((mins[axis] - dlight_grid.origin[axis]) * dlight_grid.inv_cell_size[axis]), cell_max);
+		last[axis] = (int)CLAMP (0.0f, floorf ((maxs[axis] - dlight_grid.origin[axis]) * dlight_grid.inv_cell_size[axis]), cell_max);
+	}
+}
+
+#define DLIGHT_GRID_CELL(x, y, z) ((x) + (DLIGHT_GRID_SIZE_X * ((y) + (DLIGHT_GRID_SIZE_Y * (z)))))
+
+/*
+=============
+R_BuildDlightGrid
+
+Counting sort of the lights into the cells they overlap
+=============
+*/
+static void R_BuildDlightGrid (void)
+{
+	int      axis, i, x, y, z;
+	uint32_t num_indices = 0;
+
+	for (axis = 0; axis < 3; ++axis)
+	{
+		const float size = cl.worldmodel->maxs[axis] - cl.worldmodel->mins[axis];
+		dlight_grid.origin[axis] = cl.worldmodel->mins[axis];
+		dlight_grid.inv_cell_size[axis] = dlight_grid_size[axis] / q_max (size, 1.0f);
+	}
+
+	memset (dlight_grid.cells, 0, sizeof (dlight_grid.cells));
+	dlight_grid.num_lights = 0;
+	for (i = 0; i < MAX_DLIGHTS; ++i)
+	{
+		dlight_t *l = &cl_dlights[i];
+		if ((l->die < cl.time) || (l->radius == 0.0f))
+			continue;
+
+		const int light_index = dlight_grid.num_lights++;
+		int      *first = dlight_grid.light_cells[light_index][0];
+		int      *last = dlight_grid.light_cells[light_index][1];
+		vec3_t    mins, maxs;
+		for (axis = 0; axis < 3; ++axis)
+		{
+			mins[axis] = l->origin[axis] - l->radius;
+			maxs[axis] = l->origin[axis] + l->radius;
+		}
+		dlight_grid.lights[light_index] = i;
+		R_DlightGridRange (mins, maxs, first, last);
+		for (z = first[2]; z <= last[2]; ++z)
+			for (y = first[1]; y <= last[1]; ++y)
+				for (x = first[0]; x <= last[0]; ++x)
+					++dlight_grid.cells[DLIGHT_GRID_CELL (x, y, z) + 1];
+		num_indices += (last[0] - first[0] + 1) * (last[1] - first[1] + 1) * (last[2] - first[2] + 1);
+	}
+
+	dlight_grid.complete = num_indices <= DLIGHT_GRID_MAX_INDICES;
+	if (!dlight_grid.complete)
+	{
+		memset (dlight_grid.cells, 0, sizeof (dlight_grid.cells));
+		return;
+	}
+
+	for (i = 1; i <= DLIGHT_GRID_CELLS; ++i)
+		dlight_grid.cells[i] += dlight_grid.cells[i - 1];
+	memcpy (dlight_grid.cell_ends, dlight_grid.cells, sizeof (dlight_grid.cell_ends));
+	for (i = 0; i < dlight_grid.num_lights; ++i)
+	{
+		const int *first = dlight_grid.light_cells[i][0];
+		const int *last = dlight_grid.light_cells[i][1];
+		for (z = first[2]; z <= last[2]; ++z)
+			for (y = first[1]; y <= last[1]; ++y)
+				for (x = first[0]; x <= last[0]; ++x)
+					dlight_grid.indices[dlight_grid.cell_ends[DLIGHT_GRID_CELL (x, y, z)]++] = i;
+	}
+}
+
+/*
+=============
+R_DlightGridQuery
+
+Conservative set of compacted lights that may touch the box
+=============
+*/
+static void R_DlightGridQuery (const float *mins, const float *maxs, uint32_t lights[DLIGHT_GRID_MASK_WORDS])
+{
+	int first[3], last[3];
+	int i, x, y, z;
+
+	memset (lights, 0, DLIGHT_GRID_MASK_WORDS * sizeof (uint32_t));
+	if (!dlight_grid.complete)
+	{
+		for (i = 0; i < dlight_grid.num_lights; ++i)
+			lights[i >> 5] |= 1u << (i & 31);
+		return;
+	}
+
+	R_DlightGridRange (mins, maxs, first, last);
+	for (z = first[2]; z <= last[2]; ++z)
+		for (y = first[1]; y <= last[1]; ++y)
+			for (x = first[0]; x <= last[0]; ++x)
+			{
+				const int cell = DLIGHT_GRID_CELL (x, y, z);
+				for (uint32_t j = dlight_grid.cells[cell]; j < dlight_grid.cells[cell + 1]; ++j)
+					lights[dlight_grid.indices[j] >> 5] |= 1u << (dlight_grid.indices[j] & 31);
+			}
+}
+
+/*
+=============
+R_UploadDlightGrid
+=============
+*/
+static void R_UploadDlightGrid (void)
+{
+	lm_compute_lights_t *dst = (lm_compute_lights_t *)(lights_buffer_mapped + (current_compute_lightmap_buffer_index * LIGHTS_BUFFER_SLOT_SIZE));
+	int                  i;
+
+	VectorCopy (dlight_grid.origin, dst->grid_origin);
+	dst->grid_origin[3] = dlight_grid.complete ? 1.0f : 0.0f;
+	VectorCopy (dlight_grid.inv_cell_size, dst->grid_inv_cell_size);
+	dst->grid_inv_cell_size[3] = 0.0f;
+
+	for (i = 0; i < dlight_grid.num_lights; ++i)
+	{
+		const dlight_t     *l = &cl_dlights[dlight_grid.lights[i]];
+		lm_compute_light_t *light = &dst->lights[i];
+		VectorCopy (l->origin, light->origin);
+		light->radius = l->radius;
+		VectorCopy (l->color, light->color);
+		light->minlight = l->minlight;
+	}
+
+	memcpy (dst->grid_cells, dlight_grid.cells, sizeof (dlight_grid.cells));
+	memcpy (dst->grid_lights, dlight_grid.indices, dlight_grid.cells[DLIGHT_GRID_CELLS] * sizeof (uint32_t));
+}
+
 /*
 =============
 R_FlushUpdateLightmaps
@@ -1729,16 +1970,16 @@ void R_FlushUpdateLightmaps (
 	vkCmdPipelineBarrier (
 		cbx->cb, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0, NULL, num_batch_lightmaps, pre_barriers);
 	R_BindPipeline (cbx, VK_PIPELINE_BIND_POINT_COMPUTE, vulkan_globals.update_lightmap_pipeline);
-	uint32_t push_constants[2] = {MAX_DLIGHTS, LMBLOCK_WIDTH};
+	uint32_t push_constants[2] = {dlight_grid.num_lights, LMBLOCK_WIDTH};
 	uint32_t offsets[2] = {
 		current_compute_lightmap_buffer_index * MAX_LIGHTSTYLES * sizeof (float),
-		current_compute_lightmap_buffer_index * MAX_DLIGHTS * sizeof (lm_compute_light_t)};
+		current_compute_lightmap_buffer_index * LIGHTS_BUFFER_SLOT_SIZE};
 	R_PushConstants (cbx, VK_SHADER_STAGE_COMPUTE_BIT, 0, 2 * sizeof (uint32_t), push_constants);
 	for (int j = 0; j < num_batch_lightmaps; ++j)
 	{
 		VkDescriptorSet sets[1] = {lightmaps[lightmap_indexes[j]].descriptor_set};
 		vkCmdBindDescriptorSets (cbx->cb, VK_PIPELINE_BIND_POINT_COMPUTE, vulkan_globals.update_lightmap_pipeline.layout.handle, 0, 1, sets, 2, offsets);
-		vkCmdDispatch (cbx->cb, LMBLOCK_WIDTH / 8, LMBLOCK_HEIGHT / 8, 1);
+		vulkan_globals.vk_cmd_dispatch (cbx->cb, LMBLOCK_WIDTH / 8, LMBLOCK_HEIGHT / 8, 1);
 	}
 
 	vkCmdPipelineBarrier (
@@ -1763,14 +2004,9 @@ void R_UpdateLightmaps (void *unused)
 		*style = (float)d_lightstylevalue[i] / 256.0f;
 	}
 
-	for (int i = 0; i < MAX_DLIGHTS; ++i)
-	{
-		lm_compute_light_t *light = lights_buffer_mapped + i + (current_compute_lightmap_buffer_index * MAX_DLIGHTS);
-		VectorCopy (cl_dlights[i].origin, light->origin);
-		light->radius = (cl_dlights[i].die < cl.time) ? 0.0f : cl_dlights[i].radius;
-		VectorCopy (cl_dlights[i].color, light->color);
-		light->minlight = cl_dlights[i].minlight;
-	}
+	// only the lights that are alive are uploaded, the shader stops at num_lights
+	R_BuildDlightGrid ();
+	R_UploadDlightGrid ();
 
 	int                  num_lightmaps = 0;
 	int                  num_batch_lightmaps = 0;
@@ -1797,14 +2033,18 @@ void R_UpdateLightmaps (void *unused)
 				needs_update = true;
 				break;
 			}
-		for (int i = 0; i < MAX_DLIGHTS; i++)
+		uint32_t candidate_dlights[DLIGHT_GRID_MASK_WORDS];
+		R_DlightGridQuery (lm->global_bounds.mins, lm->global_bounds.maxs, candidate_dlights);
+		for (int word = 0; word < DLIGHT_GRID_MASK_WORDS; ++word)
 		{
-			qboolean hit = true;
-
-			if (cl_dlights[i].die < cl.time || cl_dlights[i].radius == 0.0f)
-				hit = false;
-			else
+			uint32_t hits = 0;
+			uint32_t mask = candidate_dlights[word];
+			while (mask != 0)
 			{
+				const int bit = FindFirstBitNonZero (mask);
+				const int i = dlight_grid.lights[(word * 32) + bit];
+				mask &= ~(1u << bit);
+
 				float sq_dist = 0.0f;
 				for (int j = 0; j < 3; j++)
 				{
@@ -1818,19 +2058,14 @@ void R_UpdateLightmaps (void *unused)
 						sq_dist += (v - maxs) * (v - maxs);
 				}
 
-				if (sq_dist > cl_dlights[i].radius * cl_dlights[i].radius)
-					hit = false;
+				if (sq_dist <= cl_dlights[i].radius * cl_dlights[i].radius)
+					hits |= 1u << bit;
 			}
-			if (hit)
-			{
-				needs_update = true;
-				lm->active_dlights[i] = true;
-			}
-			else if (lm->active_dlights[i])
-			{
+
+			// lit now or was lit before and needs to be cleared
+			if ((hits != 0) || (lm->active_dlights[word] & ~hits))
 				needs_update = true;
-				lm->active_dlights[i] = false;
-			}
+			lm->active_dlights[word] = hits;
 		}
 		if (!needs_update)
 			continue;
@@ -35,7 +35,35 @@ int ramp1[8] = {0x6f, 0x6d, 0x6b, 0x69, 0x67, 0x65, 0x63, 0x61};
 int ramp2[8] = {0x6f, 0x6e, 0x6d, 0x6c, 0x6b, 0x6a, 0x68, 0x66};
 int ramp3[8] = {0x6d, 0x6b, 6, 5, 4, 3};
 
-particle_t *active_particles, *free_particles, *particles;
+#define PARTICLES_PER_TASK 16384
+
+// live particles, compacted with swap-remove as they die
+static struct
+{
+	float *org[3];
+	float *vel[3];
+	float *ramp;
+	float *die;
+	byte  *color;
+	byte  *type;
+	int    count;
+} particles;
+
+// particles spawned since the last flush, appended by the main thread only
+static particle_t *spawned_particles;
+static int         num_spawned_particles;
+static int         max_live_particles; // upper bound of particles.count while the simulation runs
+
+typedef struct
+{
+	float      vel_scale[3];
+	float      vel_add_z;
+	float      ramp_speed;
+	float      ramp_limit;
+	const int *ramp_table;
+} particle_physics_t;
+
+static particle_physics_t particle_physics[pt_blob2 + 1];
 
 vec3_t r_pright, r_pup, r_ppn;
 
@@ -46,10 +74,88 @@ float        texturescalefactor; // johnfitz -- compensate for apparent size of
 
 cvar_t r_particles = {"r_particles", "1", CVAR_ARCHIVE};         // johnfitz
 cvar_t r_quadparticles = {"r_quadparticles", "1", CVAR_ARCHIVE}; // johnfitz
+cvar_t r_gpuparticles = {"r_gpuparticles", "1", CVAR_ARCHIVE};
 
 extern cvar_t r_showtris;
 
-static VkBuffer particle_index_buffer;
+static VkBuffer     particle_index_buffer;
+static VkIndexType particle_index_type;
+
+static task_handle_t run_particles_task = INVALID_TASK_HANDLE;
+
+typedef struct
+{
+	double time;
+	float  frametime;
+	int    num_tasks;
+} run_particles_args_t;
+
+#define GPU_PARTICLES_GROUP_SIZE 256
+#define GPU_PARTICLES_DRAW_SIZE  64 // VkDrawIndexedIndirectCommand padded, the vertices follow
+
+// must match particle_update.comp
+typedef struct
+{
+	float    org_ramp[4];
+	float    vel_die[4];
+	uint32_t color_type;
+	uint32_t padding[3];
+} gpu_particle_spawn_t;
+
+typedef struct
+{
+	float    origin[4];
+	float    forward[4];
+	float    up[4];
+	float    right[4];
+	uint32_t num_spawns;
+	uint32_t first_spawn;
+	uint32_t capacity;
+	uint32_t quads;
+	float    physics_vel[pt_blob2 + 1][4];
+	float    physics_ramp[pt_blob2 + 1][4];
+	uint32_t ramps[24];
+	uint32_t palette[256];
+} gpu_particle_frame_t;
+
+/*
+===============
+gpu_particles_t
+
+With r_gpuparticles the classic particles live in device memory. The main thread only collects
+spawns and the time that passed, each drawn frame hands them to particle_update.comp which places
+the spawns in a ring of slots, advances the live ones and writes their quads for an indirect draw.
+===============
+*/
+typedef struct
+{
+	qboolean        initialized;
+	VkBuffer        state_buffer; // org/ramp, vel/die and color/type arrays
+	vulkan_memory_t state_memory;
+	VkDeviceSize    state_offsets[3];
+	VkBuffer        frame_buffer; // per frame slot: gpu_particle_frame_t followed by the spawns
+	vulkan_memory_t frame_memory;
+	byte           *frame_mapped;
+	VkDeviceSize    frame_slot_size;
+	VkBuffer        draw_buffer; // per frame slot: indirect draw command followed by the vertices
+	vulkan_memory_t draw_memory;
+	VkDeviceSize    draw_slot_size;
+	VkDescriptorSet desc_sets[DOUBLE_BUFFERED];
+
+	// main thread, accumulated until the next frame that is drawn
+	double   time;
+	float    frametime;
+	float    gravity;
+	qboolean clear;
+	uint32_t first_spawn;
+
+	// the frame slot being recorded and the work GL_EndRenderingTask records for each slot
+	int      frame_index;
+	qboolean simulate[DOUBLE_BUFFERED];
+	qboolean clear_slot[DOUBLE_BUFFERED];
+	uint32_t num_spawns[DOUBLE_BUFFERED];
+} gpu_particles_t;
+static gpu_particles_t gpu_particles;
 
 /*
 ===============
@@ -158,7 +264,11 @@ R_InitParticleIndexBuffer
 */
 void R_InitParticleIndexBuffer (void)
 {
-	uint32_t particle_index_buffer_size = r_numparticles * sizeof (uint16_t) * 6; // 6 indices per particle quad
+	// 4 vertices and 6 indices per particle quad
+	const qboolean use_32bit_indices = (r_numparticles * 4) > 65536;
+	const uint32_t index_size = use_32bit_indices ? sizeof (uint32_t) : sizeof (uint16_t);
+	uint32_t       particle_index_buffer_size = r_numparticles * index_size * 6;
+	particle_index_type = use_32bit_indices ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
 
 	VkResult err;
 
@@ -204,7 +314,7 @@ void R_InitParticleIndexBuffer (void)
 	VkBuffer        staging_buffer;
 	VkCommandBuffer cb_context;
 	int             staging_offset;
-	uint16_t       *staging_indices = (uint16_t *)R_StagingAllocate (particle_index_buffer_size, 1, &cb_context, &staging_buffer, &staging_offset);
+	byte           *staging_indices = R_StagingAllocate (particle_index_buffer_size, 1, &cb_context, &staging_buffer, &staging_offset);
 
 	VkBufferCopy region;
 	region.srcOffset = staging_offset;
@@ -213,24 +323,169 @@ void R_InitParticleIndexBuffer (void)
 	vkCmdCopyBuffer (cb_context, staging_buffer, particle_index_buffer, 1, &region);
 
 	R_StagingBeginCopy ();
+	static const uint32_t quad_indices[6] = {0, 1, 2, 0, 2, 3};
 	for (int i = 0; i < r_numparticles; ++i)
 	{
-		staging_indices[i * 6 + 0] = i * 4 + 0;
-		staging_indices[i * 6 + 1] = i * 4 + 1;
-		staging_indices[i * 6 + 2] = i * 4 + 2;
-		staging_indices[i * 6 + 3] = i * 4 + 0;
-		staging_indices[i * 6 + 4] = i * 4 + 2;
-		staging_indices[i * 6 + 5] = i * 4 + 3;
+		for (int j = 0; j < 6; ++j)
+		{
+			if (use_32bit_indices)
+				((uint32_t *)staging_indices)[i * 6 + j] = i * 4 + quad_indices[j];
+			else
+				((uint16_t *)staging_indices)[i * 6 + j] = i * 4 + quad_indices[j];
+		}
 	}
 	R_StagingEndCopy ();
 }
 
 /*
 ===============
-R_InitParticles
+R_CreateGPUParticlesBuffer
 ===============
 */
-void R_InitParticles (void)
+static void R_CreateGPUParticlesBuffer (
+	VkDeviceSize size, VkBufferUsageFlags usage, qboolean host_visible, const char *name, VkBuffer *buffer, vulkan_memory_t *memory)
+{
+	VkResult err;
+
+	VkBufferCreateInfo buffer_create_info;
+	memset (&buffer_create_info, 0, sizeof (buffer_create_info));
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.size = size;
+	buffer_create_info.usage = usage;
+
+	err = vkCreateBuffer (vulkan_globals.device, &buffer_create_info, NULL, buffer);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreateBuffer failed");
+	GL_SetObjectName ((uint64_t)*buffer, VK_OBJECT_TYPE_BUFFER, name);
+
+	VkMemoryRequirements memory_requirements;
+	vkGetBufferMemoryRequirements (vulkan_globals.device, *buffer, &memory_requirements);
+
+	VkMemoryAllocateInfo memory_allocate_info;
+	memset (&memory_allocate_info, 0, sizeof (memory_allocate_info));
+	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memory_allocate_info.allocationSize = memory_requirements.size;
+	if (host_visible)
+		memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties (
+			memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+	else
+		memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties (memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+
+	Atomic_IncrementUInt32 (&num_vulkan_misc_allocations);
+	R_AllocateVulkanMemory (memory, &memory_allocate_info, host_visible ? VULKAN_MEMORY_TYPE_HOST : VULKAN_MEMORY_TYPE_DEVICE);
+	GL_SetObjectName ((uint64_t)memory->handle, VK_OBJECT_TYPE_DEVICE_MEMORY, name);
+
+	err = vkBindBufferMemory (vulkan_globals.device, *buffer, memory->handle, 0);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkBindBufferMemory failed");
+}
+
+/*
+===============
+R_InitGPUParticles
+===============
+*/
+static void R_InitGPUParticles (void)
+{
+	const VkDeviceSize alignment = vulkan_globals.device_properties.limits.minStorageBufferOffsetAlignment;
+	const VkDeviceSize capacity = r_numparticles;
+	VkResult           err;
+	int                i;
+
+	if (((uint64_t)vulkan_globals.device_properties.limits.maxComputeWorkGroupCount[0] * GPU_PARTICLES_GROUP_SIZE) < capacity)
+		return;
+
+	// org/ramp and vel/die are vec4, color/type a uint
+	gpu_particles.state_offsets[0] = 0;
+	gpu_particles.state_offsets[1] = (capacity * 4 * sizeof (float) + alignment - 1) & ~(alignment - 1);
+	gpu_particles.state_offsets[2] = (gpu_particles.state_offsets[1] + capacity * 4 * sizeof (float) + alignment - 1) & ~(alignment - 1);
+	R_CreateGPUParticlesBuffer (
+		gpu_particles.state_offsets[2] + capacity * sizeof (uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, false,
+		"Particle state", &gpu_particles.state_buffer, &gpu_particles.state_memory);
+
+	gpu_particles.frame_slot_size = (sizeof (gpu_particle_frame_t) + capacity * sizeof (gpu_particle_spawn_t) + alignment - 1) & ~(alignment - 1);
+	R_CreateGPUParticlesBuffer (
+		DOUBLE_BUFFERED * gpu_particles.frame_slot_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true, "Particle spawns", &gpu_particles.frame_buffer,
+		&gpu_particles.frame_memory);
+	err = vkMapMemory (
+		vulkan_globals.device, gpu_particles.frame_memory.handle, 0, DOUBLE_BUFFERED * gpu_particles.frame_slot_size, 0, (void **)&gpu_particles.frame_mapped);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkMapMemory failed");
+
+	gpu_particles.draw_slot_size = (GPU_PARTICLES_DRAW_SIZE + capacity * 4 * sizeof (basicvertex_t) + alignment - 1) & ~(alignment - 1);
+	R_CreateGPUParticlesBuffer (
+		DOUBLE_BUFFERED * gpu_particles.draw_slot_size,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, false,
+		"Particle vertices", &gpu_particles.draw_buffer, &gpu_particles.draw_memory);
+
+	for (i = 0; i < DOUBLE_BUFFERED; ++i)
+	{
+		gpu_particles.desc_sets[i] = R_AllocateDescriptorSet (&vulkan_globals.particle_compute_set_layout);
+
+		VkDescriptorBufferInfo buffer_infos[5];
+		memset (&buffer_infos, 0, sizeof (buffer_infos));
+		buffer_infos[0].buffer = gpu_particles.state_buffer;
+		buffer_infos[0].offset = gpu_particles.state_offsets[0];
+		buffer_infos[0].range = capacity * 4 * sizeof (float);
+		buffer_infos[1].buffer = gpu_particles.state_buffer;
+		buffer_infos[1].offset = gpu_particles.state_offsets[1];
+		buffer_infos[1].range = capacity * 4 * sizeof (float);
+		buffer_infos[2].buffer = gpu_particles.state_buffer;
+		buffer_infos[2].offset = gpu_particles.state_offsets[2];
+		buffer_infos[2].range = capacity * sizeof (uint32_t);
+		buffer_infos[3].buffer = gpu_particles.frame_buffer;
+		buffer_infos[3].offset = i * gpu_particles.frame_slot_size;
+		buffer_infos[3].range = gpu_particles.frame_slot_size;
+		buffer_infos[4].buffer = gpu_particles.draw_buffer;
+		buffer_infos[4].offset = i * gpu_particles.draw_slot_size;
+		buffer_infos[4].range = gpu_particles.draw_slot_size;
+
+		VkWriteDescriptorSet writes[5];
+		memset (&writes, 0, sizeof (writes));
+		for (int j = 0; j < 5; ++j)
+		{
+			writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[j].dstBinding = j;
+			writes[j].dstArrayElement = 0;
+			writes[j].descriptorCount = 1;
+			writes[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[j].dstSet = gpu_particles.desc_sets[i];
+			writes[j].pBufferInfo = &buffer_infos[j];
+		}
+		vkUpdateDescriptorSets (vulkan_globals.device, 5, writes, 0, NULL);
+	}
+
+	// the state is undefined until the first simulated frame clears it
+	gpu_particles.clear = true;
+	gpu_particles.initialized = true;
+}
+
+/*
+===============
+R_GPUParticles
+===============
+*/
+static inline qboolean R_GPUParticles (void)
+{
+	return gpu_particles.initialized && (r_gpuparticles.value != 0.0f);
+}
+
+/*
+===============
+R_SetGPUParticles_f
+===============
+*/
+static void R_SetGPUParticles_f (cvar_t *var)
+{
+	R_ClearParticles ();
+}
+
+/*
+===============
+R_AllocParticles
+===============
+*/
+void R_AllocParticles (void)
 {
 	int i;
 
@@ -247,14 +502,95 @@ void R_InitParticles (void)
 		r_numparticles = MAX_PARTICLES;
 	}
 
-	particles = (particle_t *)Mem_Alloc (r_numparticles * sizeof (particle_t));
+	for (i = 0; i < 3; ++i)
+	{
+		particles.org[i] = (float *)Mem_Alloc (r_numparticles * sizeof (float));
+		particles.vel[i] = (float *)Mem_Alloc (r_numparticles * sizeof (float));
+	}
+	particles.ramp = (float *)Mem_Alloc (r_numparticles * sizeof (float));
+	particles.die = (float *)Mem_Alloc (r_numparticles * sizeof (float));
+	particles.color = (byte *)Mem_Alloc (r_numparticles);
+	particles.type = (byte *)Mem_Alloc (r_numparticles);
+	spawned_particles = (particle_t *)Mem_Alloc (r_numparticles * sizeof (particle_t));
+}
+
+/*
+===============
+R_InitParticles
+===============
+*/
+void R_InitParticles (void)
+{
+	R_AllocParticles ();
 
 	Cvar_RegisterVariable (&r_particles); // johnfitz
 	Cvar_SetCallback (&r_particles, R_SetParticleTexture_f);
 	Cvar_RegisterVariable (&r_quadparticles); // johnfitz
+	Cvar_RegisterVariable (&r_gpuparticles);
+	Cvar_SetCallback (&r_gpuparticles, R_SetGPUParticles_f);
 
 	R_InitParticleTextures (); // johnfitz
 	R_InitParticleIndexBuffer ();
+	R_InitGPUParticles ();
+}
+
+/*
+===============
+R_WaitParticles
+
+Waits for the simulation started by the last CL_RunParticles and moves the
+particles spawned since into the live set. Must be called on the main thread
+before particles are counted, cleared or drawn. Spawns for the GPU stay
+queued until the next frame is drawn.
+===============
+*/
+void R_WaitParticles (void)
+{
+	int i, j;
+
+	if (run_particles_task != INVALID_TASK_HANDLE)
+	{
+		Task_Join (run_particles_task, SDL_MUTEX_MAXWAIT);
+		run_particles_task = INVALID_TASK_HANDLE;
+	}
+
+	if (R_GPUParticles ())
+		return;
+
+	for (i = 0; i < num_spawned_particles; ++i)
+	{
+		const particle_t *p = &spawned_particles[i];
+		const int         index = particles.count++;
+		for (j = 0; j < 3; ++j)
+		{
+			particles.org[j][index] = p->org[j];
+			particles.vel[j][index] = p->vel[j];
+		}
+		particles.ramp[index] = p->ramp;
+		particles.die[index] = p->die;
+		particles.color[index] = (int)p->color;
+		particles.type[index] = p->type;
+	}
+	num_spawned_particles = 0;
+	max_live_particles = particles.count;
+}
+
+/*
+===============
+R_AllocParticle
+
+Spawns only append to spawned_particles, so they never wait for the simulation
+===============
+*/
+static particle_t *R_AllocParticle (void)
+{
+	particle_t *p;
+
+	if ((max_live_particles + num_spawned_particles) >= r_numparticles)
+		return NULL;
+	p = &spawned_particles[num_spawned_particles++];
+	memset (p, 0, sizeof (*p));
+	return p;
 }
 
 /*
@@ -310,12 +646,8 @@ void R_EntityParticles (entity_t *ent)
 		forward[1] = cp * sy;
 		forward[2] = -sp;
 
-		if (!free_particles)
+		if (!(p = R_AllocParticle ()))
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
 		p->die = cl.time + 0.01;
 		p->color = 0x6f;
@@ -334,14 +666,27 @@ R_ClearParticles
 */
 void R_ClearParticles (void)
 {
-	int i;
+	R_WaitParticles ();
+	particles.count = 0;
+	max_live_particles = 0;
+	num_spawned_particles = 0;
+
+	gpu_particles.clear = true;
+	gpu_particles.first_spawn = 0;
+	gpu_particles.frametime = 0.0f;
+}
 
-	free_particles = &particles[0];
-	active_particles = NULL;
+/*
+===============
+R_CountParticles
 
-	for (i = 0; i < r_numparticles; i++)
-		particles[i].next = &particles[i + 1];
-	particles[r_numparticles - 1].next = NULL;
+Particles simulated on the GPU are not counted
+===============
+*/
+int R_CountParticles (void)
+{
+	R_WaitParticles ();
+	return particles.count;
 }
 
 /*
@@ -380,15 +725,11 @@ void R_ReadPointFile_f (void)
 			break;
 		c++;
 
-		if (!free_particles)
+		if (!(p = R_AllocParticle ()))
 		{
 			Con_Printf ("Not enough free particles\n");
 			break;
 		}
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
 		p->die = 99999;
 		p->color = (-c) & 15;
@@ -440,12 +781,8 @@ void R_ParticleExplosion (vec3_t org)
 
 	for (i = 0; i < 1024; i++)
 	{
-		if (!free_particles)
+		if (!(p = R_AllocParticle ()))
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
 		p->die = cl.time + 5;
 		p->color = ramp1[0];
@@ -484,12 +821,8 @@ void R_ParticleExplosion2 (vec3_t org, int colorStart, int colorLength)
 
 	for (i = 0; i < 512; i++)
 	{
-		if (!free_particles)
+		if (!(p = R_AllocParticle ()))
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
 		p->die = cl.time + 0.3;
 		p->color = colorStart + (colorMod % colorLength);
@@ -516,12 +849,8 @@ void R_BlobExplosion (vec3_t org)
 
 	for (i = 0; i < 1024; i++)
 	{
-		if (!free_particles)
+		if (!(p = R_AllocParticle ()))
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
 		p->die = cl.time + 1 + (rand () & 8) * 0.05;
 
@@ -560,12 +889,8 @@ void R_RunParticleEffect (vec3_t org, vec3_t dir, int color, int count)
 
 	for (i = 0; i < count; i++)
 	{
-		if (!free_particles)
+		if (!(p = R_AllocParticle ()))
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
 		if (count == 1024)
 		{ // rocket explosion
@@ -621,12 +946,8 @@ void R_LavaSplash (vec3_t org)
 		for (j = -16; j < 16; j++)
 			for (k = 0; k < 1; k++)
 			{
-				if (!free_particles)
+				if (!(p = R_AllocParticle ()))
 					return;
-				p = free_particles;
-				free_particles = p->next;
-				p->next = active_particles;
-				active_particles = p;
 
 				p->die = cl.time + 2 + (rand () & 31) * 0.02;
 				p->color = 224 + (rand () & 7);
@@ -662,12 +983,8 @@ void R_TeleportSplash (vec3_t org)
 		for (j = -16; j < 16; j += 4)
 			for (k = -24; k < 32; k += 4)
 			{
-				if (!free_particles)
+				if (!(p = R_AllocParticle ()))
 					return;
-				p = free_particles;
-				free_particles = p->next;
-				p->next = active_particles;
-				active_particles = p;
 
 				p->die = cl.time + 0.2 + (rand () & 7) * 0.02;
 				p->color = 7 + (rand () & 7);
@@ -717,12 +1034,8 @@ void R_RocketTrail (vec3_t start, vec3_t end, int type)
 	{
 		len -= dec;
 
-		if (!free_particles)
+		if (!(p = R_AllocParticle ()))
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
 		VectorCopy (vec3_origin, p->vel);
 		p->die = cl.time + 2;
@@ -799,108 +1112,392 @@ void R_RocketTrail (vec3_t start, vec3_t end, int type)
 
 /*
 ===============
-CL_RunParticles -- johnfitz -- all the particle behavior, separated from R_DrawParticles
+R_SetupParticlePhysics
+
+Each particle type becomes a per-frame velocity scale, a vertical velocity
+delta and a color ramp speed, so the update has no switch per particle.
 ===============
 */
-void CL_RunParticles (void)
+static void R_SetupParticlePhysics (float frametime, float gravity)
 {
-	particle_t   *p, *kill;
-	int           i;
-	float         time1, time2, time3, dvel, frametime, grav;
-	extern cvar_t sv_gravity;
-
-	frametime = q_max (0.0, cl.time - cl.oldtime);
-	time3 = frametime * 15;
-	time2 = frametime * 10;
-	time1 = frametime * 5;
-	grav = frametime * sv_gravity.value * 0.05;
-	dvel = 4 * frametime;
+	const float grav = frametime * gravity * 0.05;
+	const float dvel = 4 * frametime;
+	int         i, j;
 
-	for (;;)
+	for (i = pt_static; i <= pt_blob2; ++i)
 	{
-		kill = active_particles;
-		if (kill && kill->die < cl.time)
+		particle_physics_t *phys = &particle_physics[i];
+		for (j = 0; j < 3; ++j)
+			phys->vel_scale[j] = 1.0f;
+		phys->vel_add_z = -grav;
+		phys->ramp_speed = 0.0f;
+		phys->ramp_limit = FLT_MAX;
+		phys->ramp_table = NULL;
+	}
+
+	particle_physics[pt_static].vel_add_z = 0.0f;
+
+	particle_physics[pt_fire].vel_add_z = grav;
+	particle_physics[pt_fire].ramp_speed = frametime * 5;
+	particle_physics[pt_fire].ramp_limit = 6;
+	particle_physics[pt_fire].ramp_table = ramp3;
+
+	particle_physics[pt_explode].ramp_speed = frametime * 10;
+	particle_physics[pt_explode].ramp_limit = 8;
+	particle_physics[pt_explode].ramp_table = ramp1;
+
+	particle_physics[pt_explode2].ramp_speed = frametime * 15;
+	particle_physics[pt_explode2].ramp_limit = 8;
+	particle_physics[pt_explode2].ramp_table = ramp2;
+
+	for (j = 0; j < 3; ++j)
+	{
+		particle_physics[pt_explode].vel_scale[j] = 1.0f + dvel;
+		particle_physics[pt_explode2].vel_scale[j] = 1.0f - frametime;
+		particle_physics[pt_blob].vel_scale[j] = 1.0f + dvel;
+	}
+	for (j = 0; j < 2; ++j)
+		particle_physics[pt_blob2].vel_scale[j] = 1.0f - dvel;
+}
+
+/*
+===============
+R_CompactParticlesTask
+
+Removes dead particles by moving the last live particle into their slot
+===============
+*/
+static void R_CompactParticlesTask (run_particles_args_t *args)
+{
+	const double time = args->time;
+	int          i = 0, j;
+
+	while (i < particles.count)
+	{
+		if (particles.die[i] >= time)
 		{
-			active_particles = kill->next;
-			kill->next = free_particles;
-			free_particles = kill;
+			++i;
 			continue;
 		}
-		break;
-	}
 
-	for (p = active_particles; p; p = p->next)
-	{
-		for (;;)
+		const int last = --particles.count;
+		for (j = 0; j < 3; ++j)
 		{
-			kill = p->next;
-			if (kill && kill->die < cl.time)
-			{
-				p->next = kill->next;
-				kill->next = free_particles;
-				free_particles = kill;
-				continue;
-			}
-			break;
+			particles.org[j][i] = particles.org[j][last];
+			particles.vel[j][i] = particles.vel[j][last];
 		}
+		particles.ramp[i] = particles.ramp[last];
+		particles.die[i] = particles.die[last];
+		particles.color[i] = particles.color[last];
+		particles.type[i] = particles.type[last];
+	}
+}
 
-		p->org[0] += p->vel[0] * frametime;
-		p->org[1] += p->vel[1] * frametime;
-		p->org[2] += p->vel[2] * frametime;
+/*
+===============
+R_UpdateParticleRamp
+===============
+*/
+static FORCE_INLINE void R_UpdateParticleRamp (int i, const particle_physics_t *phys)
+{
+	if (!phys->ramp_table)
+		return;
+	if (particles.ramp[i] >= phys->ramp_limit)
+		particles.die[i] = -1;
+	else
+		particles.color[i] = phys->ramp_table[(int)particles.ramp[i]];
+}
 
-		switch (p->type)
-		{
-		case pt_static:
-			break;
-		case pt_fire:
-			p->ramp += time1;
-			if (p->ramp >= 6)
-				p->die = -1;
-			else
-				p->color = ramp3[(int)p->ramp];
-			p->vel[2] += grav;
-			break;
+/*
+===============
+R_UpdateParticle
+===============
+*/
+static FORCE_INLINE void R_UpdateParticle (int i, float frametime)
+{
+	const particle_physics_t *phys = &particle_physics[particles.type[i]];
+	int                       j;
 
-		case pt_explode:
-			p->ramp += time2;
-			if (p->ramp >= 8)
-				p->die = -1;
-			else
-				p->color = ramp1[(int)p->ramp];
-			for (i = 0; i < 3; i++)
-				p->vel[i] += p->vel[i] * dvel;
-			p->vel[2] -= grav;
-			break;
+	for (j = 0; j < 3; ++j)
+	{
+		particles.org[j][i] += particles.vel[j][i] * frametime;
+		particles.vel[j][i] *= phys->vel_scale[j];
+	}
+	particles.vel[2][i] += phys->vel_add_z;
+	particles.ramp[i] += phys->ramp_speed;
+	R_UpdateParticleRamp (i, phys);
+}
 
-		case pt_explode2:
-			p->ramp += time3;
-			if (p->ramp >= 8)
-				p->die = -1;
-			else
-				p->color = ramp2[(int)p->ramp];
-			for (i = 0; i < 3; i++)
-				p->vel[i] -= p->vel[i] * frametime;
-			p->vel[2] -= grav;
-			break;
+#ifdef USE_SSE2
+/*
+===============
+R_UpdateParticlesSIMD
 
-		case pt_blob:
-			for (i = 0; i < 3; i++)
-				p->vel[i] += p->vel[i] * dvel;
-			p->vel[2] -= grav;
-			break;
+Updates 4 particles starting at i
+===============
+*/
+static FORCE_INLINE void R_UpdateParticlesSIMD (int i, __m128 frametime)
+{
+	const particle_physics_t *phys0 = &particle_physics[particles.type[i + 0]];
+	const particle_physics_t *phys1 = &particle_physics[particles.type[i + 1]];
+	const particle_physics_t *phys2 = &particle_physics[particles.type[i + 2]];
+	const particle_physics_t *phys3 = &particle_physics[particles.type[i + 3]];
+	int                       j;
 
-		case pt_blob2:
-			for (i = 0; i < 2; i++)
-				p->vel[i] -= p->vel[i] * dvel;
-			p->vel[2] -= grav;
-			break;
+	for (j = 0; j < 3; ++j)
+	{
+		__m128 org = _mm_loadu_ps (particles.org[j] + i);
+		__m128 vel = _mm_loadu_ps (particles.vel[j] + i);
+		__m128 vel_scale = _mm_setr_ps (phys0->vel_scale[j], phys1->vel_scale[j], phys2->vel_scale[j], phys3->vel_scale[j]);
+		_mm_storeu_ps (particles.org[j] + i, _mm_add_ps (org, _mm_mul_ps (vel, frametime)));
+		vel = _mm_mul_ps (vel, vel_scale);
+		if (j == 2)
+			vel = _mm_add_ps (vel, _mm_setr_ps (phys0->vel_add_z, phys1->vel_add_z, phys2->vel_add_z, phys3->vel_add_z));
+		_mm_storeu_ps (particles.vel[j] + i, vel);
+	}
 
-		case pt_grav:
-		case pt_slowgrav:
-			p->vel[2] -= grav;
-			break;
-		}
+	__m128 ramp = _mm_loadu_ps (particles.ramp + i);
+	ramp = _mm_add_ps (ramp, _mm_setr_ps (phys0->ramp_speed, phys1->ramp_speed, phys2->ramp_speed, phys3->ramp_speed));
+	_mm_storeu_ps (particles.ramp + i, ramp);
+
+	R_UpdateParticleRamp (i + 0, phys0);
+	R_UpdateParticleRamp (i + 1, phys1);
+	R_UpdateParticleRamp (i + 2, phys2);
+	R_UpdateParticleRamp (i + 3, phys3);
+}
+#endif // defined(USE_SSE2)
+
+/*
+===============
+R_UpdateParticlesTask
+===============
+*/
+static void R_UpdateParticlesTask (int index, run_particles_args_t *args)
+{
+	const int count = particles.count;
+	const int particles_per_task = (((count + args->num_tasks - 1) / args->num_tasks) + 3) & ~3;
+	const int start = index * particles_per_task;
+	const int end = q_min (start + particles_per_task, count);
+	int       i = start;
+
+#ifdef USE_SSE2
+	const __m128 frametime = _mm_set1_ps (args->frametime);
+	for (; (i + 4) <= end; i += 4)
+		R_UpdateParticlesSIMD (i, frametime);
+#endif
+	for (; i < end; ++i)
+		R_UpdateParticle (i, args->frametime);
+}
+
+/*
+===============
+CL_RunParticles -- johnfitz -- all the particle behavior, separated from R_DrawParticles
+
+The simulation runs on workers while the main thread carries on with the
+rest of the frame: one task compacts away dead particles, then the update is
+split into chunks of PARTICLES_PER_TASK. Drawing and counting wait for it
+through R_WaitParticles. Particles simulated on the GPU only accumulate the
+time that passed until the next frame is drawn.
+===============
+*/
+void CL_RunParticles (void)
+{
+	run_particles_args_t args;
+	extern cvar_t        sv_gravity;
+
+	R_WaitParticles ();
+	if (R_GPUParticles ())
+	{
+		gpu_particles.time = cl.time;
+		gpu_particles.frametime += q_max (0.0, cl.time - cl.oldtime);
+		gpu_particles.gravity = sv_gravity.value;
+		return;
 	}
+	if (!particles.count)
+		return;
+
+	args.time = cl.time;
+	args.frametime = q_max (0.0, cl.time - cl.oldtime);
+	args.num_tasks = CLAMP (1, particles.count / PARTICLES_PER_TASK, Tasks_NumWorkers ());
+	R_SetupParticlePhysics (args.frametime, sv_gravity.value);
+
+	task_handle_t compact_task = Task_AllocateAndAssignFunc ((task_func_t)R_CompactParticlesTask, &args, sizeof (args));
+	task_handle_t update_task = Task_AllocateAndAssignIndexedFunc ((task_indexed_func_t)R_UpdateParticlesTask, args.num_tasks, &args, sizeof (args));
+	Task_AddDependency (compact_task, update_task);
+	task_handle_t tasks[] = {compact_task, update_task};
+	Tasks_Submit (countof (tasks), tasks);
+	run_particles_task = update_task;
+}
+
+/*
+===============
+R_BeginParticles
+
+Called once the fence of the frame slot was waited on
+===============
+*/
+void R_BeginParticles (int frame_index)
+{
+	gpu_particles.frame_index = frame_index;
+	gpu_particles.simulate[frame_index] = false;
+}
+
+/*
+===============
+R_SetupGPUParticles
+
+Hands the spawns and the time accumulated since the last drawn frame to the frame slot.
+Runs in the particle draw task while the main thread waits for the frame to be recorded.
+===============
+*/
+static void R_SetupGPUParticles (void)
+{
+	const int             slot = gpu_particles.frame_index;
+	gpu_particle_frame_t *frame = (gpu_particle_frame_t *)(gpu_particles.frame_mapped + (slot * gpu_particles.frame_slot_size));
+	gpu_particle_spawn_t *spawns = (gpu_particle_spawn_t *)(frame + 1);
+	const int             num_spawns = q_min (num_spawned_particles, r_numparticles);
+	float                 size, texcoord_scale;
+	int                   i, j;
+
+	if (r_quadparticles.value)
+	{
+		size = 0.75f;
+		texcoord_scale = 0.5f;
+	}
+	else
+	{
+		size = 1.5f;
+		texcoord_scale = 1.0f;
+	}
+
+	for (i = 0; i < 3; ++i)
+	{
+		frame->origin[i] = r_origin[i];
+		frame->forward[i] = vpn[i];
+		frame->up[i] = vup[i] * size;
+		frame->right[i] = vright[i] * size;
+	}
+	frame->origin[3] = gpu_particles.time;
+	frame->forward[3] = gpu_particles.frametime;
+	frame->up[3] = texcoord_scale;
+	frame->right[3] = texturescalefactor;
+	frame->num_spawns = num_spawns;
+	frame->first_spawn = gpu_particles.first_spawn;
+	frame->capacity = r_numparticles;
+	frame->quads = r_quadparticles.value ? 1 : 0;
+
+	R_SetupParticlePhysics (gpu_particles.frametime, gpu_particles.gravity);
+	for (i = pt_static; i <= pt_blob2; ++i)
+	{
+		const particle_physics_t *phys = &particle_physics[i];
+		for (j = 0; j < 3; ++j)
+			frame->physics_vel[i][j] = phys->vel_scale[j];
+		frame->physics_vel[i][3] = phys->vel_add_z;
+		frame->physics_ramp[i][0] = phys->ramp_speed;
+		frame->physics_ramp[i][1] = phys->ramp_limit;
+		frame->physics_ramp[i][2] = (phys->ramp_table == ramp1) ? 0.0f : (phys->ramp_table == ramp2) ? 8.0f : (phys->ramp_table == ramp3) ? 16.0f : -1.0f;
+		frame->physics_ramp[i][3] = 0.0f;
+	}
+	for (i = 0; i < 8; ++i)
+	{
+		frame->ramps[i] = ramp1[i];
+		frame->ramps[8 + i] = ramp2[i];
+		frame->ramps[16 + i] = ramp3[i];
+	}
+	for (i = 0; i < 256; ++i)
+	{
+		byte *c = (byte *)&frame->palette[i];
+		memcpy (c, &d_8to24table[i], 3);
+		c[3] = 255;
+	}
+
+	for (i = 0; i < num_spawns; ++i)
+	{
+		const particle_t     *p = &spawned_particles[i];
+		gpu_particle_spawn_t *spawn = &spawns[i];
+		VectorCopy (p->org, spawn->org_ramp);
+		spawn->org_ramp[3] = p->ramp;
+		VectorCopy (p->vel, spawn->vel_die);
+		spawn->vel_die[3] = p->die;
+		spawn->color_type = ((int)p->color & 0xFF) | ((uint32_t)p->type << 8);
+	}
+
+	gpu_particles.simulate[slot] = true;
+	gpu_particles.clear_slot[slot] = gpu_particles.clear;
+	gpu_particles.num_spawns[slot] = num_spawns;
+
+	gpu_particles.first_spawn = (gpu_particles.first_spawn + num_spawns) % r_numparticles;
+	gpu_particles.frametime = 0.0f;
+	gpu_particles.clear = false;
+	num_spawned_particles = 0;
+}
+
+/*
+===============
+R_SimulateParticles
+
+Records the spawn and update passes of the frame slot into the primary command buffer
+before the main render pass
+===============
+*/
+void R_SimulateParticles (cb_context_t *cbx, int frame_index)
+{
+	if (!gpu_particles.simulate[frame_index])
+		return;
+
+	R_BeginDebugUtilsLabel (cbx, "Particle Simulation");
+
+	// the previous frame's update wrote the state this one reads
+	VkMemoryBarrier memory_barrier;
+	memset (&memory_barrier, 0, sizeof (memory_barrier));
+	memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	vulkan_globals.vk_cmd_pipeline_barrier (
+		cbx->cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memory_barrier, 0, NULL, 0,
+		NULL);
+
+	// everything dies at -1
+	if (gpu_particles.clear_slot[frame_index])
+		vkCmdFillBuffer (cbx->cb, gpu_particles.state_buffer, 0, VK_WHOLE_SIZE, 0xBF800000);
+
+	static const uint32_t draw_command[5] = {0, 1, 0, 0, 0};
+	vkCmdUpdateBuffer (cbx->cb, gpu_particles.draw_buffer, frame_index * gpu_particles.draw_slot_size, sizeof (draw_command), draw_command);
+
+	memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vulkan_globals.vk_cmd_pipeline_barrier (
+		cbx->cb, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memory_barrier, 0, NULL, 0, NULL);
+
+	R_BindPipeline (cbx, VK_PIPELINE_BIND_POINT_COMPUTE, vulkan_globals.particle_update_pipeline);
+	vulkan_globals.vk_cmd_bind_descriptor_sets (
+		cbx->cb, VK_PIPELINE_BIND_POINT_COMPUTE, vulkan_globals.particle_update_pipeline.layout.handle, 0, 1, &gpu_particles.desc_sets[frame_index], 0,
+		NULL);
+
+	const uint32_t num_spawns = gpu_particles.num_spawns[frame_index];
+	if (num_spawns > 0)
+	{
+		const uint32_t spawn = 1;
+		R_PushConstants (cbx, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof (uint32_t), &spawn);
+		vulkan_globals.vk_cmd_dispatch (cbx->cb, (num_spawns + GPU_PARTICLES_GROUP_SIZE - 1) / GPU_PARTICLES_GROUP_SIZE, 1, 1);
+
+		memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vulkan_globals.vk_cmd_pipeline_barrier (
+			cbx->cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memory_barrier, 0, NULL, 0, NULL);
+	}
+
+	const uint32_t spawn = 0;
+	R_PushConstants (cbx, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof (uint32_t), &spawn);
+	vulkan_globals.vk_cmd_dispatch (cbx->cb, (r_numparticles + GPU_PARTICLES_GROUP_SIZE - 1) / GPU_PARTICLES_GROUP_SIZE, 1, 1);
+
+	memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	memory_barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	vulkan_globals.vk_cmd_pipeline_barrier (
+		cbx->cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &memory_barrier, 0,
+		NULL, 0, NULL);
+
+	R_EndDebugUtilsLabel (cbx);
 }
 
 /*
@@ -910,7 +1507,6 @@ R_DrawParticlesFaces
 */
 static void R_DrawParticlesFaces (cb_context_t *cbx)
 {
-	particle_t   *p;
 	float         scale, texcoord_scale;
 	vec3_t        up, right, up_right, p_up, p_right, p_up_right;
 	extern cvar_t r_particles; // johnfitz
@@ -918,7 +1514,17 @@ static void R_DrawParticlesFaces (cb_context_t *cbx)
 	if (!r_particles.value)
 		return;
 
-	if (!active_particles)
+	if (R_GPUParticles ())
+	{
+		const VkDeviceSize draw_offset = gpu_particles.frame_index * gpu_particles.draw_slot_size;
+		const VkDeviceSize vertex_offset = draw_offset + GPU_PARTICLES_DRAW_SIZE;
+		vulkan_globals.vk_cmd_bind_vertex_buffers (cbx->cb, 0, 1, &gpu_particles.draw_buffer, &vertex_offset);
+		vulkan_globals.vk_cmd_bind_index_buffer (cbx->cb, particle_index_buffer, 0, particle_index_type);
+		vulkan_globals.vk_cmd_draw_indexed_indirect (cbx->cb, gpu_particles.draw_buffer, draw_offset, 1, sizeof (VkDrawIndexedIndirectCommand));
+		return;
+	}
+
+	if (!particles.count)
 		return;
 
 	if (r_quadparticles.value)
@@ -937,9 +1543,7 @@ static void R_DrawParticlesFaces (cb_context_t *cbx)
 	for (int i = 0; i < 3; ++i)
 		up_right[i] = up[i] + right[i];
 
-	int num_particles = 0;
-	for (p = active_particles; p; p = p->next)
-		num_particles += 1;
+	const int num_particles = particles.count;
 	Atomic_AddUInt32 (&rs_particles, num_particles);
 
 	VkBuffer       vertex_buffer;
@@ -951,10 +1555,12 @@ static void R_DrawParticlesFaces (cb_context_t *cbx)
 		vertices = (basicvertex_t *)R_VertexAllocate (num_particles * 3 * sizeof (basicvertex_t), &vertex_buffer, &vertex_buffer_offset);
 
 	int current_vertex = 0;
-	for (p = active_particles; p; p = p->next)
+	for (int i = 0; i < num_particles; ++i)
 	{
+		vec3_t org = {particles.org[0][i], particles.org[1][i], particles.org[2][i]};
+
 		// hack a scale up to keep particles from disapearing
-		scale = (p->org[0] - r_origin[0]) * vpn[0] + (p->org[1] - r_origin[1]) * vpn[1] + (p->org[2] - r_origin[2]) * vpn[2];
+		scale = (org[0] - r_origin[0]) * vpn[0] + (org[1] - r_origin[1]) * vpn[1] + (org[2] - r_origin[2]) * vpn[2];
 		if (scale < 20)
 			scale = 1 + 0.08; // johnfitz -- added .08 to be consistent
 		else
@@ -962,11 +1568,11 @@ static void R_DrawParticlesFaces (cb_context_t *cbx)
 
 		scale *= texturescalefactor; // johnfitz -- compensate for apparent size of different particle textures
 
-		byte *c = (byte *)&d_8to24table[(int)p->color];
+		byte *c = (byte *)&d_8to24table[particles.color[i]];
 
-		vertices[current_vertex].position[0] = p->org[0];
-		vertices[current_vertex].position[1] = p->org[1];
-		vertices[current_vertex].position[2] = p->org[2];
+		vertices[current_vertex].position[0] = org[0];
+		vertices[current_vertex].position[1] = org[1];
+		vertices[current_vertex].position[2] = org[2];
 		vertices[current_vertex].texcoord[0] = 0.0f;
 		vertices[current_vertex].texcoord[1] = 0.0f;
 		vertices[current_vertex].color[0] = c[0];
@@ -975,7 +1581,7 @@ static void R_DrawParticlesFaces (cb_context_t *cbx)
 		vertices[current_vertex].color[3] = 255;
 		current_vertex++;
 
-		VectorMA (p->org, scale, up, p_up);
+		VectorMA (org, scale, up, p_up);
 		vertices[current_vertex].position[0] = p_up[0];
 		vertices[current_vertex].position[1] = p_up[1];
 		vertices[current_vertex].position[2] = p_up[2];
@@ -989,7 +1595,7 @@ static void R_DrawParticlesFaces (cb_context_t *cbx)
 
 		if (r_quadparticles.value)
 		{
-			VectorMA (p->org, scale, up_right, p_up_right);
+			VectorMA (org, scale, up_right, p_up_right);
 			vertices[current_vertex].position[0] = p_up_right[0];
 			vertices[current_vertex].position[1] = p_up_right[1];
 			vertices[current_vertex].position[2] = p_up_right[2];
@@ -1002,7 +1608,7 @@ static void R_DrawParticlesFaces (cb_context_t *cbx)
 			current_vertex++;
 		}
 
-		VectorMA (p->org, scale, right, p_right);
+		VectorMA (org, scale, right, p_right);
 		vertices[current_vertex].position[0] = p_right[0];
 		vertices[current_vertex].position[1] = p_right[1];
 		vertices[current_vertex].position[2] = p_right[2];
@@ -1018,7 +1624,7 @@ static void R_DrawParticlesFaces (cb_context_t *cbx)
 	vulkan_globals.vk_cmd_bind_vertex_buffers (cbx->cb, 0, 1, &vertex_buffer, &vertex_buffer_offset);
 	if (r_quadparticles.value)
 	{
-		vulkan_globals.vk_cmd_bind_index_buffer (cbx->cb, particle_index_buffer, 0, VK_INDEX_TYPE_UINT16);
+		vulkan_globals.vk_cmd_bind_index_buffer (cbx->cb, particle_index_buffer, 0, particle_index_type);
 		vulkan_globals.vk_cmd_draw_indexed (cbx->cb, num_particles * 6, 1, 0, 0, 0);
 	}
 	else
@@ -1032,6 +1638,9 @@ R_DrawParticles -- johnfitz -- moved all non-drawing code to CL_RunParticles
 */
 void R_DrawParticles (cb_context_t *cbx)
 {
+	if (R_GPUParticles ())
+		R_SetupGPUParticles ();
+
 	R_BeginDebugUtilsLabel (cbx, "Particles");
 	R_BindPipeline (cbx, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.particle_pipeline);
 	vulkan_globals.vk_cmd_bind_descriptor_sets (
@@ -5704,14 +5704,11 @@ static void ReallocateIndexBuffer ()
 
 static vec3_t pright, pup;
 
-static void R_AddFanSparkParticle (scenetris_t *t, particle_t *p, plooks_t *type)
+static void R_AddFanSparkParticle (basicvertex_t *verts, unsigned short *indices, unsigned short basevert, particle_t *p, plooks_t *type)
 {
 	vec3_t v, cr, o2;
 	float  scale;
 
-	if (cl_numstrisvert + 3 > cl_maxstrisvert[current_buffer_index])
-		ReallocateVertexBuffer ();
-
 	scale = (p->org[0] - r_origin[0]) * vpn[0] + (p->org[1] - r_origin[1]) * vpn[1] + (p->org[2] - r_origin[2]) * vpn[2];
 	scale = (scale * p->scale) * (type->invscalefactor) + p->scale * (type->scalefactor * 250);
 	if (scale < 20)
@@ -5730,48 +5727,37 @@ static void R_AddFanSparkParticle (scenetris_t *t, particle_t *p, plooks_t *type
 		rgba[1] = p->rgba[1] * a;
 		rgba[2] = p->rgba[2] * a;
 		rgba[3] = (type->premul == 2) ? 0 : a;
-		Vector4ToColor (rgba, cl_curstrisvert[cl_numstrisvert + 0].color);
-		Vector4ToColor (rgba, cl_curstrisvert[cl_numstrisvert + 1].color);
-		Vector4ToColor (rgba, cl_curstrisvert[cl_numstrisvert + 2].color);
+		Vector4ToColor (rgba, verts[0].color);
+		Vector4ToColor (rgba, verts[1].color);
+		Vector4ToColor (rgba, verts[2].color);
 	}
 	else
 	{
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 0].color);
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 1].color);
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 2].color);
+		Vector4ToColor (p->rgba, verts[0].color);
+		Vector4ToColor (p->rgba, verts[1].color);
+		Vector4ToColor (p->rgba, verts[2].color);
 	}
 
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 0].texcoord, p->s1, p->t1);
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 1].texcoord, p->s1, p->t2);
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 2].texcoord, p->s2, p->t1);
+	Vector2Set (verts[0].texcoord, p->s1, p->t1);
+	Vector2Set (verts[1].texcoord, p->s1, p->t2);
+	Vector2Set (verts[2].texcoord, p->s2, p->t1);
 
 	VectorMA (p->org, -scale, p->vel, o2);
 	VectorSubtract (r_refdef.vieworg, o2, v);
 	CrossProduct (v, p->vel, cr);
 	VectorNormalize (cr);
 
-	VectorCopy (p->org, cl_curstrisvert[cl_numstrisvert + 0].position);
-	VectorMA (o2, -p->scale, cr, cl_curstrisvert[cl_numstrisvert + 1].position);
-	VectorMA (o2, p->scale, cr, cl_curstrisvert[cl_numstrisvert + 2].position);
-
-	if (cl_numstrisidx + 3 > cl_maxstrisidx[current_buffer_index])
-		ReallocateIndexBuffer ();
+	VectorCopy (p->org, verts[0].position);
+	VectorMA (o2, -p->scale, cr, verts[1].position);
+	VectorMA (o2, p->scale, cr, verts[2].position);
 
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 0;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 1;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 2;
-
-	cl_numstrisvert += 3;
-
-	t->numvert += 3;
-	t->numidx += 3;
+	indices[0] = basevert + 0;
+	indices[1] = basevert + 1;
+	indices[2] = basevert + 2;
 }
 
-static void R_AddLineSparkParticle (scenetris_t *t, particle_t *p, plooks_t *type)
+static void R_AddLineSparkParticle (basicvertex_t *verts, unsigned short *indices, unsigned short basevert, particle_t *p, plooks_t *type)
 {
-	if (cl_numstrisvert + 2 > cl_maxstrisvert[current_buffer_index])
-		ReallocateVertexBuffer ();
-
 	if (type->premul)
 	{
 		vec4_t scaled_color;
@@ -5779,41 +5765,30 @@ static void R_AddLineSparkParticle (scenetris_t *t, particle_t *p, plooks_t *typ
 		if (a > 1)
 			a = 1;
 		VectorScale (p->rgba, a, scaled_color);
-		Vector3ToColor (scaled_color, cl_curstrisvert[cl_numstrisvert + 0].color);
-		FloatToColor ((type->premul == 2) ? 0 : a, cl_curstrisvert[cl_numstrisvert + 0].color[3]);
-		Vector4Clear (cl_curstrisvert[cl_numstrisvert + 1].color);
+		Vector3ToColor (scaled_color, verts[0].color);
+		FloatToColor ((type->premul == 2) ? 0 : a, verts[0].color[3]);
+		Vector4Clear (verts[1].color);
 	}
 	else
 	{
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 0].color);
-		Vector3ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 1].color);
-		cl_curstrisvert[cl_numstrisvert + 1].color[3] = 0;
+		Vector4ToColor (p->rgba, verts[0].color);
+		Vector3ToColor (p->rgba, verts[1].color);
+		verts[1].color[3] = 0;
 	}
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 0].texcoord, p->s1, p->t1);
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 1].texcoord, p->s2, p->t2);
-
-	VectorCopy (p->org, cl_curstrisvert[cl_numstrisvert + 0].position);
-	VectorMA (p->org, -1.0 / 10, p->vel, cl_curstrisvert[cl_numstrisvert + 1].position);
+	Vector2Set (verts[0].texcoord, p->s1, p->t1);
+	Vector2Set (verts[1].texcoord, p->s2, p->t2);
 
-	if (cl_numstrisidx + 2 > cl_maxstrisidx[current_buffer_index])
-		ReallocateIndexBuffer ();
-
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 0;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 1;
+	VectorCopy (p->org, verts[0].position);
+	VectorMA (p->org, -1.0 / 10, p->vel, verts[1].position);
 
-	cl_numstrisvert += 2;
-
-	t->numvert += 2;
-	t->numidx += 2;
+	indices[0] = basevert + 0;
+	indices[1] = basevert + 1;
 }
 
-static void R_AddTSparkParticle (scenetris_t *t, particle_t *p, plooks_t *type)
+static void R_AddTSparkParticle (basicvertex_t *verts, unsigned short *indices, unsigned short basevert, particle_t *p, plooks_t *type)
 {
 	vec3_t v, cr, o2;
 
-	if (cl_numstrisvert + 4 > cl_maxstrisvert[current_buffer_index])
-		ReallocateVertexBuffer ();
-
 	if (type->premul)
 	{
 		vec4_t rgba;
@@ -5824,23 +5799,23 @@ static void R_AddTSparkParticle (scenetris_t *t, particle_t *p, plooks_t *type)
 		rgba[1] = p->rgba[1] * a;
 		rgba[2] = p->rgba[2] * a;
 		rgba[3] = (type->premul == 2) ? 0 : a;
-		Vector4ToColor (rgba, cl_curstrisvert[cl_numstrisvert + 0].color);
-		Vector4ToColor (rgba, cl_curstrisvert[cl_numstrisvert + 1].color);
-		Vector4ToColor (rgba, cl_curstrisvert[cl_numstrisvert + 2].color);
-		Vector4ToColor (rgba, cl_curstrisvert[cl_numstrisvert + 3].color);
+		Vector4ToColor (rgba, verts[0].color);
+		Vector4ToColor (rgba, verts[1].color);
+		Vector4ToColor (rgba, verts[2].color);
+		Vector4ToColor (rgba, verts[3].color);
 	}
 	else
 	{
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 0].color);
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 1].color);
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 2].color);
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 3].color);
+		Vector4ToColor (p->rgba, verts[0].color);
+		Vector4ToColor (p->rgba, verts[1].color);
+		Vector4ToColor (p->rgba, verts[2].color);
+		Vector4ToColor (p->rgba, verts[3].color);
 	}
 
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 0].texcoord, p->s1, p->t1);
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 1].texcoord, p->s1, p->t2);
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 2].texcoord, p->s2, p->t2);
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 3].texcoord, p->s2, p->t1);
+	Vector2Set (verts[0].texcoord, p->s1, p->t1);
+	Vector2Set (verts[1].texcoord, p->s1, p->t2);
+	Vector2Set (verts[2].texcoord, p->s2, p->t2);
+	Vector2Set (verts[3].texcoord, p->s2, p->t1);
 
 	{
 		vec3_t movedir;
@@ -5861,8 +5836,8 @@ static void R_AddTSparkParticle (scenetris_t *t, particle_t *p, plooks_t *type)
 		VectorSubtract (r_refdef.vieworg, o2, v);
 		CrossProduct (v, p->vel, cr);
 		VectorNormalize (cr);
-		VectorMA (o2, -p->scale / 2, cr, cl_curstrisvert[cl_numstrisvert + 0].position);
-		VectorMA (o2, p->scale / 2, cr, cl_curstrisvert[cl_numstrisvert + 1].position);
+		VectorMA (o2, -p->scale / 2, cr, verts[0].position);
+		VectorMA (o2, p->scale / 2, cr, verts[1].position);
 
 		VectorMA (p->org, length, movedir, o2);
 	}
@@ -5871,23 +5846,15 @@ static void R_AddTSparkParticle (scenetris_t *t, particle_t *p, plooks_t *type)
 	CrossProduct (v, p->vel, cr);
 	VectorNormalize (cr);
 
-	VectorMA (o2, p->scale * 0.5, cr, cl_curstrisvert[cl_numstrisvert + 2].position);
-	VectorMA (o2, -p->scale * 0.5, cr, cl_curstrisvert[cl_numstrisvert + 3].position);
+	VectorMA (o2, p->scale * 0.5, cr, verts[2].position);
+	VectorMA (o2, -p->scale * 0.5, cr, verts[3].position);
 
-	if (cl_numstrisidx + 6 > cl_maxstrisidx[current_buffer_index])
-		ReallocateIndexBuffer ();
-
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 0;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 1;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 2;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 0;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 2;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 3;
-
-	cl_numstrisvert += 4;
-
-	t->numvert += 4;
-	t->numidx += 6;
+	indices[0] = basevert + 0;
+	indices[1] = basevert + 1;
+	indices[2] = basevert + 2;
+	indices[3] = basevert + 0;
+	indices[4] = basevert + 2;
+	indices[5] = basevert + 3;
 }
 
 static void R_DrawParticleBeam (scenetris_t *t, beamseg_t *b, plooks_t *type)
@@ -6021,14 +5988,11 @@ static void R_AddClippedDecal (scenetris_t *t, clippeddecal_t *d, plooks_t *type
 	t->numidx += 3;
 }
 
-static void R_AddUnclippedDecal (scenetris_t *t, particle_t *p, plooks_t *type)
+static void R_AddUnclippedDecal (basicvertex_t *verts, unsigned short *indices, unsigned short basevert, particle_t *p, plooks_t *type)
 {
 	float  x, y;
 	vec3_t sdir, tdir;
 
-	if (cl_numstrisvert + 4 > cl_maxstrisvert[current_buffer_index])
-		ReallocateVertexBuffer ();
-
 	if (type->premul)
 	{
 		vec4_t rgba;
@@ -6039,23 +6003,23 @@ static void R_AddUnclippedDecal (scenetris_t *t, particle_t *p, plooks_t *type)
 		rgba[1] = p->rgba[1] * a;
 		rgba[2] = p->rgba[2] * a;
 		rgba[3] = (type->premul == 2) ? 0 : a;
-		Vector4ToColor (rgba, cl_curstrisvert[cl_numstrisvert + 0].color);
-		Vector4ToColor (rgba, cl_curstrisvert[cl_numstrisvert + 1].color);
-		Vector4ToColor (rgba, cl_curstrisvert[cl_numstrisvert + 2].color);
-		Vector4ToColor (rgba, cl_curstrisvert[cl_numstrisvert + 3].color);
+		Vector4ToColor (rgba, verts[0].color);
+		Vector4ToColor (rgba, verts[1].color);
+		Vector4ToColor (rgba, verts[2].color);
+		Vector4ToColor (rgba, verts[3].color);
 	}
 	else
 	{
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 0].color);
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 1].color);
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 2].color);
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 3].color);
+		Vector4ToColor (p->rgba, verts[0].color);
+		Vector4ToColor (p->rgba, verts[1].color);
+		Vector4ToColor (p->rgba, verts[2].color);
+		Vector4ToColor (p->rgba, verts[3].color);
 	}
 
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 0].texcoord, p->s1, p->t1);
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 1].texcoord, p->s1, p->t2);
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 2].texcoord, p->s2, p->t2);
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 3].texcoord, p->s2, p->t1);
+	Vector2Set (verts[0].texcoord, p->s1, p->t1);
+	Vector2Set (verts[1].texcoord, p->s1, p->t2);
+	Vector2Set (verts[2].texcoord, p->s2, p->t2);
+	Vector2Set (verts[3].texcoord, p->s2, p->t1);
 
 	//	if (p->vel[1] == 1)
 	{
@@ -6068,50 +6032,39 @@ static void R_AddUnclippedDecal (scenetris_t *t, particle_t *p, plooks_t *type)
 		x = sin (p->angle) * p->scale;
 		y = cos (p->angle) * p->scale;
 
-		cl_curstrisvert[cl_numstrisvert + 0].position[0] = p->org[0] - x * sdir[0] - y * tdir[0];
-		cl_curstrisvert[cl_numstrisvert + 0].position[1] = p->org[1] - x * sdir[1] - y * tdir[1];
-		cl_curstrisvert[cl_numstrisvert + 0].position[2] = p->org[2] - x * sdir[2] - y * tdir[2];
-		cl_curstrisvert[cl_numstrisvert + 1].position[0] = p->org[0] - y * sdir[0] + x * tdir[0];
-		cl_curstrisvert[cl_numstrisvert + 1].position[1] = p->org[1] - y * sdir[1] + x * tdir[1];
-		cl_curstrisvert[cl_numstrisvert + 1].position[2] = p->org[2] - y * sdir[2] + x * tdir[2];
-		cl_curstrisvert[cl_numstrisvert + 2].position[0] = p->org[0] + x * sdir[0] + y * tdir[0];
-		cl_curstrisvert[cl_numstrisvert + 2].position[1] = p->org[1] + x * sdir[1] + y * tdir[1];
-		cl_curstrisvert[cl_numstrisvert + 2].position[2] = p->org[2] + x * sdir[2] + y * tdir[2];
-		cl_curstrisvert[cl_numstrisvert + 3].position[0] = p->org[0] + y * sdir[0] - x * tdir[0];
-		cl_curstrisvert[cl_numstrisvert + 3].position[1] = p->org[1] + y * sdir[1] - x * tdir[1];
-		cl_curstrisvert[cl_numstrisvert + 3].position[2] = p->org[2] + y * sdir[2] - x * tdir[2];
+		verts[0].position[0] = p->org[0] - x * sdir[0] - y * tdir[0];
+		verts[0].position[1] = p->org[1] - x * sdir[1] - y * tdir[1];
+		verts[0].position[2] = p->org[2] - x * sdir[2] - y * tdir[2];
+		verts[1].position[0] = p->org[0] - y * sdir[0] + x * tdir[0];
+		verts[1].position[1] = p->org[1] - y * sdir[1] + x * tdir[1];
+		verts[1].position[2] = p->org[2] - y * sdir[2] + x * tdir[2];
+		verts[2].position[0] = p->org[0] + x * sdir[0] + y * tdir[0];
+		verts[2].position[1] = p->org[1] + x * sdir[1] + y * tdir[1];
+		verts[2].position[2] = p->org[2] + x * sdir[2] + y * tdir[2];
+		verts[3].position[0] = p->org[0] + y * sdir[0] - x * tdir[0];
+		verts[3].position[1] = p->org[1] + y * sdir[1] - x * tdir[1];
+		verts[3].position[2] = p->org[2] + y * sdir[2] - x * tdir[2];
 	}
 	else
 	{
-		VectorMA (p->org, -p->scale, tdir, cl_curstrisvert[cl_numstrisvert + 0].position);
-		VectorMA (p->org, -p->scale, sdir, cl_curstrisvert[cl_numstrisvert + 1].position);
-		VectorMA (p->org, p->scale, tdir, cl_curstrisvert[cl_numstrisvert + 2].position);
-		VectorMA (p->org, p->scale, sdir, cl_curstrisvert[cl_numstrisvert + 3].position);
+		VectorMA (p->org, -p->scale, tdir, verts[0].position);
+		VectorMA (p->org, -p->scale, sdir, verts[1].position);
+		VectorMA (p->org, p->scale, tdir, verts[2].position);
+		VectorMA (p->org, p->scale, sdir, verts[3].position);
 	}
 
-	if (cl_numstrisidx + 6 > cl_maxstrisidx[current_buffer_index])
-		ReallocateIndexBuffer ();
-
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 0;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 1;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 2;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 0;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 2;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 3;
-
-	cl_numstrisvert += 4;
-
-	t->numvert += 4;
-	t->numidx += 6;
+	indices[0] = basevert + 0;
+	indices[1] = basevert + 1;
+	indices[2] = basevert + 2;
+	indices[3] = basevert + 0;
+	indices[4] = basevert + 2;
+	indices[5] = basevert + 3;
 }
 
-static void R_AddTexturedParticle (scenetris_t *t, particle_t *p, plooks_t *type)
+static void R_AddTexturedParticle (basicvertex_t *verts, unsigned short *indices, unsigned short basevert, particle_t *p, plooks_t *type)
 {
 	float scale, x, y;
 
-	if (cl_numstrisvert + 4 > cl_maxstrisvert[current_buffer_index])
-		ReallocateVertexBuffer ();
-
 	if (type->scalefactor == 1)
 		scale = p->scale * 0.25;
 	else
@@ -6134,70 +6087,136 @@ static void R_AddTexturedParticle (scenetris_t *t, particle_t *p, plooks_t *type
 		rgba[1] = p->rgba[1] * a;
 		rgba[2] = p->rgba[2] * a;
 		rgba[3] = (type->premul == 2) ? 0 : a;
-		Vector4ToColor (rgba, cl_curstrisvert[cl_numstrisvert + 0].color);
-		Vector4ToColor (rgba, cl_curstrisvert[cl_numstrisvert + 1].color);
-		Vector4ToColor (rgba, cl_curstrisvert[cl_numstrisvert + 2].color);
-		Vector4ToColor (rgba, cl_curstrisvert[cl_numstrisvert + 3].color);
+		Vector4ToColor (rgba, verts[0].color);
+		Vector4ToColor (rgba, verts[1].color);
+		Vector4ToColor (rgba, verts[2].color);
+		Vector4ToColor (rgba, verts[3].color);
 	}
 	else
 	{
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 0].color);
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 1].color);
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 2].color);
-		Vector4ToColor (p->rgba, cl_curstrisvert[cl_numstrisvert + 3].color);
+		Vector4ToColor (p->rgba, verts[0].color);
+		Vector4ToColor (p->rgba, verts[1].color);
+		Vector4ToColor (p->rgba, verts[2].color);
+		Vector4ToColor (p->rgba, verts[3].color);
 	}
 
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 0].texcoord, p->s1, p->t1);
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 1].texcoord, p->s1, p->t2);
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 2].texcoord, p->s2, p->t2);
-	Vector2Set (cl_curstrisvert[cl_numstrisvert + 3].texcoord, p->s2, p->t1);
+	Vector2Set (verts[0].texcoord, p->s1, p->t1);
+	Vector2Set (verts[1].texcoord, p->s1, p->t2);
+	Vector2Set (verts[2].texcoord, p->s2, p->t2);
+	Vector2Set (verts[3].texcoord, p->s2, p->t1);
 
 	if (p->angle)
 	{
 		x = sin (p->angle) * scale;
 		y = cos (p->angle) * scale;
 
-		cl_curstrisvert[cl_numstrisvert + 0].position[0] = p->org[0] - x * pright[0] - y * pup[0];
-		cl_curstrisvert[cl_numstrisvert + 0].position[1] = p->org[1] - x * pright[1] - y * pup[1];
-		cl_curstrisvert[cl_numstrisvert + 0].position[2] = p->org[2] - x * pright[2] - y * pup[2];
-		cl_curstrisvert[cl_numstrisvert + 1].position[0] = p->org[0] - y * pright[0] + x * pup[0];
-		cl_curstrisvert[cl_numstrisvert + 1].position[1] = p->org[1] - y * pright[1] + x * pup[1];
-		cl_curstrisvert[cl_numstrisvert + 1].position[2] = p->org[2] - y * pright[2] + x * pup[2];
-		cl_curstrisvert[cl_numstrisvert + 2].position[0] = p->org[0] + x * pright[0] + y * pup[0];
-		cl_curstrisvert[cl_numstrisvert + 2].position[1] = p->org[1] + x * pright[1] + y * pup[1];
-		cl_curstrisvert[cl_numstrisvert + 2].position[2] = p->org[2] + x * pright[2] + y * pup[2];
-		cl_curstrisvert[cl_numstrisvert + 3].position[0] = p->org[0] + y * pright[0] - x * pup[0];
-		cl_curstrisvert[cl_numstrisvert + 3].position[1] = p->org[1] + y * pright[1] - x * pup[1];
-		cl_curstrisvert[cl_numstrisvert + 3].position[2] = p->org[2] + y * pright[2] - x * pup[2];
+		verts[0].position[0] = p->org[0] - x * pright[0] - y * pup[0];
+		verts[0].position[1] = p->org[1] - x * pright[1] - y * pup[1];
+		verts[0].position[2] = p->org[2] - x * pright[2] - y * pup[2];
+		verts[1].position[0] = p->org[0] - y * pright[0] + x * pup[0];
+		verts[1].position[1] = p->org[1] - y * pright[1] + x * pup[1];
+		verts[1].position[2] = p->org[2] - y * pright[2] + x * pup[2];
+		verts[2].position[0] = p->org[0] + x * pright[0] + y * pup[0];
+		verts[2].position[1] = p->org[1] + x * pright[1] + y * pup[1];
+		verts[2].position[2] = p->org[2] + x * pright[2] + y * pup[2];
+		verts[3].position[0] = p->org[0] + y * pright[0] - x * pup[0];
+		verts[3].position[1] = p->org[1] + y * pright[1] - x * pup[1];
+		verts[3].position[2] = p->org[2] + y * pright[2] - x * pup[2];
 	}
 	else
 	{
-		VectorMA (p->org, -scale, pup, cl_curstrisvert[cl_numstrisvert + 0].position);
-		VectorMA (p->org, -scale, pright, cl_curstrisvert[cl_numstrisvert + 1].position);
-		VectorMA (p->org, scale, pup, cl_curstrisvert[cl_numstrisvert + 2].position);
-		VectorMA (p->org, scale, pright, cl_curstrisvert[cl_numstrisvert + 3].position);
+		VectorMA (p->org, -scale, pup, verts[0].position);
+		VectorMA (p->org, -scale, pright, verts[1].position);
+		VectorMA (p->org, scale, pup, verts[2].position);
+		VectorMA (p->org, scale, pright, verts[3].position);
 	}
 
-	if (cl_numstrisidx + 6 > cl_maxstrisidx[current_buffer_index])
+	indices[0] = basevert + 0;
+	indices[1] = basevert + 1;
+	indices[2] = basevert + 2;
+	indices[3] = basevert + 0;
+	indices[4] = basevert + 2;
+	indices[5] = basevert + 3;
+}
+
+typedef void (*particle_vertices_func_t) (basicvertex_t *verts, unsigned short *indices, unsigned short basevert, particle_t *p, plooks_t *type);
+
+typedef struct
+{
+	particle_vertices_func_t func;
+	particle_t              *p;
+	plooks_t                *type;
+	unsigned int             firstvert;
+	unsigned int             firstidx;
+	unsigned short           basevert;
+} particle_vertices_job_t;
+
+static particle_vertices_job_t *vertices_jobs;
+static int                      num_vertices_jobs;
+static int                      max_vertices_jobs;
+
+/*
+===============
+R_QueueParticleVertices
+
+Reserves vertex and index ranges for a particle so PScript_BuildParticleVertices
+can fill them in on any worker.
+===============
+*/
+static void R_QueueParticleVertices (scenetris_t *t, particle_vertices_func_t func, int numverts, int numidx, particle_t *p, plooks_t *type)
+{
+	particle_vertices_job_t *job;
+
+	if (cl_numstrisvert + numverts > cl_maxstrisvert[current_buffer_index])
+		ReallocateVertexBuffer ();
+	if (cl_numstrisidx + numidx > cl_maxstrisidx[current_buffer_index])
 		ReallocateIndexBuffer ();
 
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 0;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 1;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 2;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 0;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 2;
-	cl_curstrisidx[cl_numstrisidx++] = (cl_numstrisvert - t->firstvert) + 3;
+	if (num_vertices_jobs == max_vertices_jobs)
+	{
+		max_vertices_jobs = q_max (max_vertices_jobs * 2, 1024);
+		vertices_jobs = Mem_Realloc (vertices_jobs, sizeof (*vertices_jobs) * max_vertices_jobs);
+	}
+	job = &vertices_jobs[num_vertices_jobs++];
+	job->func = func;
+	job->p = p;
+	job->type = type;
+	job->firstvert = cl_numstrisvert;
+	job->firstidx = cl_numstrisidx;
+	job->basevert = cl_numstrisvert - t->firstvert;
 
-	cl_numstrisvert += 4;
+	cl_numstrisvert += numverts;
+	cl_numstrisidx += numidx;
+	t->numvert += numverts;
+	t->numidx += numidx;
+}
 
-	t->numvert += 4;
-	t->numidx += 6;
+/*
+===============
+PScript_BuildParticleVertices
+
+Fills in the ranges reserved by PScript_UpdateParticles, split into num_tasks
+chunks.
+===============
+*/
+void PScript_BuildParticleVertices (int index, int *num_tasks)
+{
+	const int jobs_per_task = (num_vertices_jobs + *num_tasks - 1) / *num_tasks;
+	const int start = index * jobs_per_task;
+	const int end = q_min (start + jobs_per_task, num_vertices_jobs);
+
+	for (int i = start; i < end; ++i)
+	{
+		const particle_vertices_job_t *job = &vertices_jobs[i];
+		job->func (cl_curstrisvert + job->firstvert, cl_curstrisidx + job->firstidx, job->basevert, job->p, job->type);
+	}
 }
 
-static void PScript_DrawParticleTypes (cb_context_t *cbx, float pframetime)
+static void PScript_UpdateParticleTypes (float pframetime)
 {
 	void (*bdraw) (scenetris_t * t, beamseg_t * p, plooks_t * type);
-	void (*tdraw) (scenetris_t * t, particle_t * p, plooks_t * type);
+	particle_vertices_func_t tdraw;
+	int                      tdraw_verts, tdraw_idx;
 
 	vec3_t          oldorg;
 	vec3_t          stop, normal;
@@ -6219,7 +6238,7 @@ static void PScript_DrawParticleTypes (cb_context_t *cbx, float pframetime)
 	static float flurrytime;
 	qboolean     doflurry;
 	int          batchflags;
-	unsigned int i, o;
+	unsigned int i;
 
 	if (r_plooksdirty)
 	{
@@ -6400,6 +6419,8 @@ static void PScript_DrawParticleTypes (cb_context_t *cbx, float pframetime)
 
 		bdraw = NULL;
 		tdraw = NULL;
+		tdraw_verts = 4;
+		tdraw_idx = 6;
 		batchflags = 0;
 
 		// set drawing methods by type and cvars and hope branch
@@ -6422,10 +6443,14 @@ static void PScript_DrawParticleTypes (cb_context_t *cbx, float pframetime)
 			break;
 		case PT_SPARK:
 			tdraw = R_AddLineSparkParticle;
+			tdraw_verts = 2;
+			tdraw_idx = 2;
 			batchflags = BEF_LINES;
 			break;
 		case PT_SPARKFAN:
 			tdraw = R_AddFanSparkParticle;
+			tdraw_verts = 3;
+			tdraw_idx = 3;
 			break;
 		case PT_TEXTUREDSPARK:
 			tdraw = R_AddTSparkParticle;
@@ -6475,7 +6500,7 @@ static void PScript_DrawParticleTypes (cb_context_t *cbx, float pframetime)
 						scenetri->numvert = 0;
 						scenetri->numidx = 0;
 					}
-					tdraw (scenetri, p, type->slooks);
+					R_QueueParticleVertices (scenetri, tdraw, tdraw_verts, tdraw_idx, p, type->slooks);
 				}
 
 				// make sure emitter runs at least once
@@ -6810,7 +6835,7 @@ static void PScript_DrawParticleTypes (cb_context_t *cbx, float pframetime)
 					scenetri->numvert = 0;
 					scenetri->numidx = 0;
 				}
-				tdraw (scenetri, p, type->slooks);
+				R_QueueParticleVertices (scenetri, tdraw, tdraw_verts, tdraw_idx, p, type->slooks);
 			}
 		}
 
@@ -6916,6 +6941,16 @@ static void PScript_DrawParticleTypes (cb_context_t *cbx, float pframetime)
 	}
 
 	particletime += pframetime;
+}
+
+/*
+===============
+PScript_DrawParticles
+===============
+*/
+void PScript_DrawParticles (cb_context_t *cbx)
+{
+	unsigned int i, o;
 
 	if (!cl_numstris)
 		return;
@@ -6955,10 +6990,13 @@ static void PScript_DrawParticleTypes (cb_context_t *cbx, float pframetime)
 
 /*
 ===============
-PScript_DrawParticles
+PScript_UpdateParticles
+
+Runs emitters, trails and the particle, beam and decal updates, and reserves
+the vertex ranges that PScript_BuildParticleVertices fills in afterwards.
 ===============
 */
-void PScript_DrawParticles (cb_context_t *cbx)
+void PScript_UpdateParticles (void)
 {
 	int          i;
 	entity_t    *ent;
@@ -6979,6 +7017,7 @@ void PScript_DrawParticles (cb_context_t *cbx)
 	cl_numstrisidx = 0;
 	cl_curstrisvert = cl_strisvert[current_buffer_index];
 	cl_curstrisidx = cl_strisidx[current_buffer_index];
+	num_vertices_jobs = 0;
 
 	if (!r_particles.value)
 		return;
@@ -6999,7 +7038,7 @@ void PScript_DrawParticles (cb_context_t *cbx)
 		}
 	}
 
-	PScript_DrawParticleTypes (cbx, pframetime);
+	PScript_UpdateParticleTypes (pframetime);
 }
 
 /*
@@ -37,10 +37,14 @@ extern cvar_t vid_filter;
 extern cvar_t vid_palettize;
 
 cvar_t r_parallelmark = {"r_parallelmark", "1", CVAR_NONE};
+cvar_t r_drawindirect = {"r_drawindirect", "1", CVAR_NONE};
+cvar_t r_gpuworldcull = {"r_gpuworldcull", "0", CVAR_ARCHIVE};
+cvar_t r_bindless = {"r_bindless", "1", CVAR_ARCHIVE};
 
 byte *SV_FatPVS (vec3_t org, qmodel_t *worldmodel);
 
 extern VkBuffer bmodel_vertex_buffer;
+extern VkBuffer bmodel_index_buffer;
 static int      world_texstart[NUM_WORLD_CBX];
 static int      world_texend[NUM_WORLD_CBX];
 
@@ -64,9 +68,120 @@ typedef struct
 	int    frustum_ofsz[4];
 #endif
 	byte *vis;
+
+	// PVS of the last view leaf, reused while the view leaf doesn't change
+	byte     *cached_pvs;
+	int       vis_capacity;
+	qboolean  pvs_valid;
+	mleaf_t  *pvs_leaf;
+	qmodel_t *pvs_model;
+	float     pvs_novis;
+
+	// leaf culling and backface culling of the parallel path are reused if the view didn't move either
+	qboolean parallel_mark;
+	qboolean cull_valid;
+	qboolean reuse_cull;
+	vec3_t   cull_vieworg;
+	float    cull_frustum[4][4];
+	float    cull_oldskyleaf;
+
+	// the opaque world surfaces are only marked from the PVS, the GPU culls and draws them
+	qboolean gpu_cull;
+
+	double start_time;
+	double mark_time;
+	double full_mark_time;
+	int    cache_level; // 0 = nothing reused, 1 = PVS, 2 = PVS and culling
 } mark_surfaces_state_t;
 mark_surfaces_state_t mark_surfaces_state;
 
+#define WORLD_CULL_GROUP_SIZE 64
+#define NUM_BINDLESS_GROUPS   2           // opaque and alpha tested
+#define BINDLESS_NO_TEXTURE   0xFFFFFFFFu // world_bindless.frag NO_TEXTURE
+
+typedef struct
+{
+	float    frustum[4][4];
+	float    vieworg[4];
+	uint32_t num_surfaces;
+	uint32_t bindless;
+} world_cull_constants_t;
+
+typedef struct
+{
+	float    plane[4]; // flipped for SURF_PLANEBACK
+	float    mins[4];
+	float    maxs[4];
+	uint32_t surface_index;
+	uint32_t first_index;
+	uint32_t num_indices;
+	uint32_t draw_range;
+	uint32_t first_draw;
+	uint32_t group_count; // draw count of the bindless group, after the ones of the ranges
+	uint32_t group_first_draw;
+	uint32_t padding;
+} world_cull_surface_t;
+
+typedef struct
+{
+	texture_t *texture;
+	int        lightmap;
+	qboolean   alpha_test;
+	uint32_t   first_draw;
+	uint32_t   num_surfaces;
+} world_draw_range_t;
+
+/*
+===============
+world_cull_t
+
+The opaque world surfaces are static records in device memory, sorted into one range of indirect
+draws per texture and lightmap. A compute pass before the main render pass tests the surfaces of
+leafs in the PVS against the frustum and for backfaces and appends the visible ones to their range.
+The world command buffers only record one vkCmdDrawIndexedIndirectCount per range.
+
+With bindless textures the visible surfaces are appended to one group of draws for all opaque and
+one for all alpha tested ranges instead. The first instance of each draw is its range, which the
+vertex shader looks up in the materials of the frame slot: the texture, lightmap and fullbright
+element in the bindless set.
+===============
+*/
+typedef struct
+{
+	qmodel_t           *model;
+	uint32_t           *gpu_surfs; // bitset of the surfaces culled and drawn by the GPU
+	int                 num_surfaces;
+	int                 num_ranges;
+	world_draw_range_t *ranges;
+	int                 range_start[NUM_WORLD_CBX];
+	int                 range_end[NUM_WORLD_CBX];
+
+	VkBuffer        surfaces_buffer;
+	vulkan_memory_t surfaces_memory;
+	VkBuffer        surfvis_buffer;
+	vulkan_memory_t surfvis_memory;
+	byte           *surfvis_mapped;
+	VkDeviceSize    surfvis_size; // per frame slot
+	VkBuffer        draws_buffer;
+	vulkan_memory_t draws_memory;
+	VkDeviceSize    counts_size; // per frame slot, the draws follow the counts
+	VkDeviceSize    draws_slot_size;
+	VkDescriptorSet desc_sets[DOUBLE_BUFFERED];
+
+	qboolean        bindless;
+	uint32_t        group_first_draw[NUM_BINDLESS_GROUPS];
+	uint32_t        group_num_surfaces[NUM_BINDLESS_GROUPS];
+	VkBuffer        materials_buffer;
+	vulkan_memory_t materials_memory;
+	byte           *materials_mapped;
+	VkDeviceSize    materials_size; // per frame slot
+	VkDescriptorSet materials_desc_sets[DOUBLE_BUFFERED];
+
+	int                    frame_index;
+	world_cull_constants_t constants[DOUBLE_BUFFERED];
+} world_cull_t;
+static world_cull_t world_cull;
+
 //==============================================================================
 //
 // SETUP CHAINS
@@ -128,6 +243,33 @@ static inline qboolean R_BackFaceCull (msurface_t *surf)
 	return false;
 }
 
+/*
+===============
+R_GPUWorldCullAvailable
+
+The GPU consumes the surfvis bitset of the SIMD mark paths. r_showtris walks the texture chains.
+===============
+*/
+static qboolean R_GPUWorldCullAvailable (void)
+{
+#if defined(USE_SIMD) && defined(VK_KHR_draw_indirect_count)
+	return r_gpuworldcull.value && use_simd && vulkan_globals.draw_indirect_count && vulkan_globals.multi_draw_indirect &&
+	       (world_cull.model == cl.worldmodel) && !r_showtris.value;
+#else
+	return false;
+#endif
+}
+
+/*
+===============
+R_BindlessWorldAvailable
+===============
+*/
+static qboolean R_BindlessWorldAvailable (void)
+{
+	return r_bindless.value && (world_cull.materials_buffer != VK_NULL_HANDLE);
+}
+
 /*
 ===============
 R_SetupWorldCBXTexRanges
@@ -178,6 +320,95 @@ void R_SetupWorldCBXTexRanges (qboolean use_tasks)
 	}
 }
 
+/*
+===============
+R_SetupWorldCBXDrawRanges
+
+Every GPU culled range costs the same to record, no matter how many of its surfaces are visible.
+The bindless draws of all ranges are recorded into the first world command buffer.
+===============
+*/
+static void R_SetupWorldCBXDrawRanges (qboolean use_tasks)
+{
+	memset (world_cull.range_start, 0, sizeof (world_cull.range_start));
+	memset (world_cull.range_end, 0, sizeof (world_cull.range_end));
+
+	if (!mark_surfaces_state.gpu_cull)
+		return;
+
+	world_cull.bindless = R_BindlessWorldAvailable ();
+	if (!use_tasks || world_cull.bindless)
+	{
+		world_cull.range_end[0] = world_cull.num_ranges;
+		return;
+	}
+
+	const int num_ranges_per_cbx = (world_cull.num_ranges + NUM_WORLD_CBX - 1) / NUM_WORLD_CBX;
+	for (int i = 0; i < NUM_WORLD_CBX; ++i)
+	{
+		world_cull.range_start[i] = q_min (i * num_ranges_per_cbx, world_cull.num_ranges);
+		world_cull.range_end[i] = q_min ((i + 1) * num_ranges_per_cbx, world_cull.num_ranges);
+	}
+}
+
+/*
+===============
+R_FinishMarkSurfaces
+===============
+*/
+static void R_FinishMarkSurfaces (qboolean use_tasks)
+{
+	R_SetupWorldCBXTexRanges (use_tasks);
+	R_SetupWorldCBXDrawRanges (use_tasks);
+
+	mark_surfaces_state.mark_time = Sys_DoubleTime () - mark_surfaces_state.start_time;
+	if (mark_surfaces_state.cache_level == 0)
+		mark_surfaces_state.full_mark_time = mark_surfaces_state.mark_time;
+}
+
+/*
+===============
+R_InvalidateMarkSurfacesCache
+
+Called on map changes, the cached PVS and culling results refer to the old world
+===============
+*/
+void R_InvalidateMarkSurfacesCache (void)
+{
+	mark_surfaces_state.pvs_valid = false;
+	mark_surfaces_state.cull_valid = false;
+	mark_surfaces_state.full_mark_time = 0.0;
+}
+
+/*
+===============
+R_GetMarkSurfacesStats
+
+Time of the last R_MarkSurfaces and the time saved by reusing results of previous frames
+===============
+*/
+void R_GetMarkSurfacesStats (double *mark_time, double *saved_time, int *cache_level)
+{
+	*mark_time = mark_surfaces_state.mark_time;
+	*saved_time = (mark_surfaces_state.cache_level != 0) ? q_max (0.0, mark_surfaces_state.full_mark_time - mark_surfaces_state.mark_time) : 0.0;
+	*cache_level = mark_surfaces_state.cache_level;
+}
+
+/*
+===============
+R_ViewMatchesCull
+===============
+*/
+static qboolean R_ViewMatchesCull (void)
+{
+	if (!VectorCompare (r_refdef.vieworg, mark_surfaces_state.cull_vieworg) || (r_oldskyleaf.value != mark_surfaces_state.cull_oldskyleaf))
+		return false;
+	for (int i = 0; i < 4; ++i)
+		if (!VectorCompare (frustum[i].normal, mark_surfaces_state.cull_frustum[i]) || (frustum[i].dist != mark_surfaces_state.cull_frustum[i][3]))
+			return false;
+	return true;
+}
+
 #ifdef USE_SSE2
 /*
 ===============
@@ -310,15 +541,19 @@ void R_MarkVisSurfacesSIMD (qboolean *use_tasks)
 		if (mask == 0)
 			continue;
 
-		mask &= R_BackFaceCullSIMD (&cl.worldmodel->soa_surfplanes[i / 8]);
+		const uint32_t gpu_mask = mark_surfaces_state.gpu_cull ? world_cull.gpu_surfs[i / 32] : 0;
+		mask &= R_BackFaceCullSIMD (&cl.worldmodel->soa_surfplanes[i / 8]) | gpu_mask;
 		while (mask != 0)
 		{
 			const int j = FindFirstBitNonZero (mask);
 			mask &= ~(1u << j);
 
 			surf = &cl.worldmodel->surfaces[i + j];
-			++brushpolys;
-			R_ChainSurface (surf, chain_world);
+			if (!(gpu_mask & (1u << j)))
+			{
+				++brushpolys;
+				R_ChainSurface (surf, chain_world);
+			}
 			if (!r_gpulightmapupdate.value)
 				R_RenderDynamicLightmaps (surf);
 			else if (surf->lightmaptexturenum >= 0)
@@ -329,7 +564,7 @@ void R_MarkVisSurfacesSIMD (qboolean *use_tasks)
 	}
 
 	Atomic_AddUInt32 (&rs_brushpolys, brushpolys); // count wpolys here
-	R_SetupWorldCBXTexRanges (*use_tasks);
+	R_FinishMarkSurfaces (*use_tasks);
 }
 
 /*
@@ -345,6 +580,9 @@ void R_MarkLeafsSIMD (int index, void *unused)
 	soa_aabb_t      *leafbounds = cl.worldmodel->soa_leafbounds;
 	uint32_t        *vis = (uint32_t *)mark_surfaces_state.vis;
 
+	if (mark_surfaces_state.reuse_cull)
+		return;
+
 	uint32_t *mask = &vis[index];
 	if (*mask == 0)
 		return;
@@ -367,12 +605,7 @@ void R_MarkLeafsSIMD (int index, void *unused)
 				Atomic_OrUInt32 (&surfvis[surf_index / 32], 1u << (surf_index % 32));
 			}
 		}
-		const uint32_t bit_mask = ~(1u << i);
-		if (!leaf->efrags)
-		{
-			*mask &= bit_mask;
-		}
-		mask_iter &= bit_mask;
+		mask_iter &= ~(1u << i);
 	}
 }
 
@@ -390,7 +623,9 @@ void R_BackfaceCullSurfacesSIMD (int index, void *unused)
 	if (*mask == 0)
 		return;
 
-	*mask &= R_BackFaceCullSIMD (&cl.worldmodel->soa_surfplanes[index * 4]);
+	// backfaces of GPU culled surfaces are only dropped by the GPU, their lightmaps are still marked
+	if (!mark_surfaces_state.reuse_cull)
+		*mask &= R_BackFaceCullSIMD (&cl.worldmodel->soa_surfplanes[index * 4]) | (mark_surfaces_state.gpu_cull ? world_cull.gpu_surfs[index] : 0);
 
 	const int worker_index = Tasks_GetWorkerIndex();
 	uint32_t mask_iter = *mask;
@@ -427,7 +662,8 @@ void R_StoreLeafEFrags (void *unused)
 			const int j = FindFirstBitNonZero (mask);
 			mask &= ~(1u << j);
 			mleaf_t *leaf = &cl.worldmodel->leafs[1 + i + j];
-			R_StoreEfrags (&leaf->efrags);
+			if (leaf->efrags)
+				R_StoreEfrags (&leaf->efrags);
 		}
 	}
 }
@@ -447,6 +683,8 @@ void R_ChainVisSurfaces (qboolean *use_tasks)
 	for (i = 0; i < numsurfaces; i += 32)
 	{
 		uint32_t mask = surfvis[i / 32];
+		if (mark_surfaces_state.gpu_cull)
+			mask &= ~world_cull.gpu_surfs[i / 32];
 		while (mask != 0)
 		{
 			const int j = FindFirstBitNonZero (mask);
@@ -458,7 +696,7 @@ void R_ChainVisSurfaces (qboolean *use_tasks)
 	}
 
 	Atomic_AddUInt32 (&rs_brushpolys, brushpolys); // count wpolys here
-	R_SetupWorldCBXTexRanges (*use_tasks);
+	R_FinishMarkSurfaces (*use_tasks);
 }
 #endif // defined(USE_SIMD)
 
@@ -513,7 +751,7 @@ void R_MarkVisSurfaces (qboolean *use_tasks)
 	}
 
 	Atomic_AddUInt32 (&rs_brushpolys, brushpolys); // count wpolys here
-	R_SetupWorldCBXTexRanges (*use_tasks);
+	R_FinishMarkSurfaces (*use_tasks);
 }
 
 /*
@@ -526,25 +764,77 @@ static void R_MarkSurfacesPrepare (void *unused)
 	int      i;
 	qboolean nearwaterportal;
 	int      numleafs = cl.worldmodel->numleafs;
+	int      vis_size = (numleafs + 31) / 8;
 
-	// check this leaf for water portals
-	// TODO: loop through all water surfs and use distance to leaf cullbox
-	nearwaterportal = false;
-	for (i = 0; i < r_viewleaf->nummarksurfaces; i++)
-		if (cl.worldmodel->surfaces[r_viewleaf->firstmarksurface[i]].flags & SURF_DRAWTURB)
-			nearwaterportal = true;
-
-	// choose vis data
-	if (r_novis.value || r_viewleaf->contents == CONTENTS_SOLID || r_viewleaf->contents == CONTENTS_SKY)
-		mark_surfaces_state.vis = Mod_NoVisPVS (cl.worldmodel);
-	else if (nearwaterportal)
-		mark_surfaces_state.vis = SV_FatPVS (r_origin, cl.worldmodel);
-	else
-		mark_surfaces_state.vis = Mod_LeafPVS (r_viewleaf, cl.worldmodel);
+	mark_surfaces_state.start_time = Sys_DoubleTime ();
 
-	uint32_t *vis = (uint32_t *)mark_surfaces_state.vis;
-	if ((numleafs % 32) != 0)
-		vis[numleafs / 32] &= (1u << (numleafs % 32)) - 1;
+	if (vis_size > mark_surfaces_state.vis_capacity)
+	{
+		mark_surfaces_state.vis_capacity = vis_size;
+		mark_surfaces_state.vis = (byte *)Mem_Realloc (mark_surfaces_state.vis, vis_size);
+		mark_surfaces_state.cached_pvs = (byte *)Mem_Realloc (mark_surfaces_state.cached_pvs, vis_size);
+		R_InvalidateMarkSurfacesCache ();
+	}
+
+	// the PVS only depends on the view leaf unless we are close to a water portal
+	const qboolean pvs_cached = mark_surfaces_state.pvs_valid && (mark_surfaces_state.pvs_leaf == r_viewleaf) &&
+	                            (mark_surfaces_state.pvs_model == cl.worldmodel) && (mark_surfaces_state.pvs_novis == r_novis.value);
+	if (!pvs_cached)
+	{
+		byte    *pvs;
+		qboolean fatpvs = false;
+
+		// check this leaf for water portals
+		// TODO: loop through all water surfs and use distance to leaf cullbox
+		nearwaterportal = false;
+		for (i = 0; i < r_viewleaf->nummarksurfaces; i++)
+			if (cl.worldmodel->surfaces[r_viewleaf->firstmarksurface[i]].flags & SURF_DRAWTURB)
+				nearwaterportal = true;
+
+		// choose vis data
+		if (r_novis.value || r_viewleaf->contents == CONTENTS_SOLID || r_viewleaf->contents == CONTENTS_SKY)
+			pvs = Mod_NoVisPVS (cl.worldmodel);
+		else if (nearwaterportal)
+		{
+			pvs = SV_FatPVS (r_origin, cl.worldmodel);
+			fatpvs = true;
+		}
+		else
+			pvs = Mod_LeafPVS (r_viewleaf, cl.worldmodel);
+
+		memcpy (mark_surfaces_state.cached_pvs, pvs, vis_size);
+		uint32_t *cached_pvs = (uint32_t *)mark_surfaces_state.cached_pvs;
+		if ((numleafs % 32) != 0)
+			cached_pvs[numleafs / 32] &= (1u << (numleafs % 32)) - 1;
+
+		mark_surfaces_state.pvs_valid = !fatpvs; // depends on the view origin
+		mark_surfaces_state.pvs_leaf = r_viewleaf;
+		mark_surfaces_state.pvs_model = cl.worldmodel;
+		mark_surfaces_state.pvs_novis = r_novis.value;
+		mark_surfaces_state.cull_valid = false;
+	}
+
+	// surfvis keeps the backfaces of GPU culled surfaces, it can't be reused when switching paths
+	const qboolean gpu_cull = R_GPUWorldCullAvailable ();
+	if (gpu_cull != mark_surfaces_state.gpu_cull)
+		mark_surfaces_state.cull_valid = false;
+	mark_surfaces_state.gpu_cull = gpu_cull;
+
+	// vis and surfvis still hold the culled results of the last frame
+	mark_surfaces_state.reuse_cull = pvs_cached && mark_surfaces_state.parallel_mark && mark_surfaces_state.cull_valid && R_ViewMatchesCull ();
+	mark_surfaces_state.cache_level = mark_surfaces_state.reuse_cull ? 2 : (pvs_cached ? 1 : 0);
+	if (!mark_surfaces_state.reuse_cull)
+	{
+		memcpy (mark_surfaces_state.vis, mark_surfaces_state.cached_pvs, vis_size);
+		VectorCopy (r_refdef.vieworg, mark_surfaces_state.cull_vieworg);
+		for (i = 0; i < 4; ++i)
+		{
+			VectorCopy (frustum[i].normal, mark_surfaces_state.cull_frustum[i]);
+			mark_surfaces_state.cull_frustum[i][3] = frustum[i].dist;
+		}
+		mark_surfaces_state.cull_oldskyleaf = r_oldskyleaf.value;
+		mark_surfaces_state.cull_valid = mark_surfaces_state.parallel_mark;
+	}
 
 	r_visframecount++;
 
@@ -559,7 +849,8 @@ static void R_MarkSurfacesPrepare (void *unused)
 #if defined(USE_SIMD)
 	if (use_simd)
 	{
-		memset (cl.worldmodel->surfvis, 0, (cl.worldmodel->numsurfaces + 31) / 8);
+		if (!mark_surfaces_state.reuse_cull)
+			memset (cl.worldmodel->surfvis, 0, (cl.worldmodel->numsurfaces + 31) / 8);
 		for (int frustum_index = 0; frustum_index < 4; ++frustum_index)
 		{
 			mplane_t *p = frustum + frustum_index;
@@ -588,6 +879,7 @@ R_MarkSurfaces -- johnfitz -- mark surfaces based on PVS and rebuild texture cha
 */
 void R_MarkSurfaces (qboolean use_tasks, task_handle_t before_mark, task_handle_t *store_efrags, task_handle_t *cull_surfaces, task_handle_t *chain_surfaces)
 {
+	mark_surfaces_state.parallel_mark = false;
 	if (use_tasks)
 	{
 		task_handle_t prepare_mark = Task_AllocateAndAssignFunc (R_MarkSurfacesPrepare, NULL, 0);
@@ -598,6 +890,7 @@ void R_MarkSurfaces (qboolean use_tasks, task_handle_t before_mark, task_handle_
 		{
 			if (r_parallelmark.value)
 			{
+				mark_surfaces_state.parallel_mark = true;
 				unsigned int  numleafs = cl.worldmodel->numleafs;
 				task_handle_t mark_surfaces = Task_AllocateAndAssignIndexedFunc (R_MarkLeafsSIMD, (numleafs + 31) / 32, NULL, 0);
 				Task_AddDependency (prepare_mark, mark_surfaces);
@@ -685,55 +978,165 @@ R_ClearBatch
 static void R_ClearBatch (cb_context_t *cbx)
 {
 	cbx->num_vbo_indices = 0;
+	cbx->num_indirect_draws = 0;
 }
 
 /*
 ================
-R_FlushBatch
+R_ResetWorldBindings
 
-Draw the current batch if non-empty and clears it, ready for more R_BatchSurface calls.
+Forget the lightmap set and depth bias of previous texture chains, anything
+could have been bound in between.
 ================
 */
-static void R_FlushBatch (
-	cb_context_t *cbx, qboolean fullbright_enabled, qboolean alpha_test, qboolean alpha_blend, qboolean use_zbias, gltexture_t *lightmap_texture,
-	uint32_t *brushpasses)
+static void R_ResetWorldBindings (cb_context_t *cbx)
+{
+	cbx->world_lightmap_set = VK_NULL_HANDLE;
+	cbx->world_depth_bias = -1;
+}
+
+/*
+================
+R_CompareBatchSurfaces
+================
+*/
+static int R_CompareBatchSurfaces (const void *a, const void *b)
 {
-	if (cbx->num_vbo_indices > 0)
+	const msurface_t *s1 = *(const msurface_t **)a;
+	const msurface_t *s2 = *(const msurface_t **)b;
+	if (s1->lightmaptexturenum != s2->lightmaptexturenum)
+		return s1->lightmaptexturenum - s2->lightmaptexturenum;
+	return s1->vbo_firstindex - s2->vbo_firstindex;
+}
+
+/*
+================
+R_SortTextureChain
+
+Returns the surfaces of a texture chain ordered by lightmap, so every lightmap
+is only bound and drawn once per texture, and by index buffer position, so
+neighbouring surfaces merge into one indirect draw. The chain itself is left
+alone because other tasks may walk it concurrently.
+================
+*/
+static msurface_t **R_SortTextureChain (msurface_t *chain_head, texchain_t chain, int chain_size, int *num_surfs)
+{
+	static THREAD_LOCAL msurface_t **sorted_surfs;
+	static THREAD_LOCAL int          max_sorted_surfs;
+	msurface_t                      *s;
+	qboolean                         sorted = true;
+	int                              count = 0;
+
+	if (chain_size > max_sorted_surfs)
 	{
-		int pipeline_index =
-			(fullbright_enabled ? 1 : 0) + (alpha_test ? 2 : 0) + (alpha_blend ? 4 : 0) + (vid_filter.value != 0 && vid_palettize.value != 0 ? 8 : 0);
-		R_BindPipeline (cbx, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipelines[pipeline_index]);
+		max_sorted_surfs = q_max (chain_size, max_sorted_surfs * 2);
+		sorted_surfs = Mem_Realloc (sorted_surfs, sizeof (msurface_t *) * max_sorted_surfs);
+	}
+
+	for (s = chain_head; s && (count < chain_size); s = s->texturechains[chain])
+	{
+		if ((count > 0) && (R_CompareBatchSurfaces (&sorted_surfs[count - 1], &s) > 0))
+			sorted = false;
+		sorted_surfs[count++] = s;
+	}
+
+	if (!sorted)
+		qsort (sorted_surfs, count, sizeof (msurface_t *), R_CompareBatchSurfaces);
+
+	*num_surfs = count;
+	return sorted_surfs;
+}
+
+/*
+================
+R_UseIndirectDraws
+
+Surfaces index into the static brush index buffer and are drawn with
+vkCmdDrawIndexedIndirect instead of uploading their indices every frame.
+================
+*/
+static inline qboolean R_UseIndirectDraws (void)
+{
+	return r_drawindirect.value && vulkan_globals.multi_draw_indirect && (bmodel_index_buffer != VK_NULL_HANDLE);
+}
+
+/*
+================
+R_BindWorldState
 
-		float constant_factor = 0.0f, slope_factor = 0.0f;
-		if (use_zbias)
+Binds the pipeline, depth bias and lightmap of the next world draws
+================
+*/
+static void R_BindWorldState (
+	cb_context_t *cbx, qboolean fullbright_enabled, qboolean alpha_test, qboolean alpha_blend, qboolean use_zbias, gltexture_t *lightmap_texture)
+{
+	int pipeline_index =
+		(fullbright_enabled ? 1 : 0) + (alpha_test ? 2 : 0) + (alpha_blend ? 4 : 0) + (vid_filter.value != 0 && vid_palettize.value != 0 ? 8 : 0);
+	R_BindPipeline (cbx, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipelines[pipeline_index]);
+
+	float constant_factor = 0.0f, slope_factor = 0.0f;
+	if (use_zbias)
+	{
+		if (vulkan_globals.depth_format == VK_FORMAT_D32_SFLOAT_S8_UINT || vulkan_globals.depth_format == VK_FORMAT_D32_SFLOAT)
 		{
-			if (vulkan_globals.depth_format == VK_FORMAT_D32_SFLOAT_S8_UINT || vulkan_globals.depth_format == VK_FORMAT_D32_SFLOAT)
-			{
-				constant_factor = -4.f;
-				slope_factor = -0.125f;
-			}
-			else
-			{
-				constant_factor = -1.f;
-				slope_factor = -0.25f;
-			}
+			constant_factor = -4.f;
+			slope_factor = -0.125f;
+		}
+		else
+		{
+			constant_factor = -1.f;
+			slope_factor = -0.25f;
 		}
+	}
+	if (cbx->world_depth_bias != (int)use_zbias)
+	{
 		vkCmdSetDepthBias (cbx->cb, constant_factor, 0.0f, slope_factor);
+		cbx->world_depth_bias = use_zbias;
+	}
 
-		if (!r_fullbright_cheatsafe)
-			vulkan_globals.vk_cmd_bind_descriptor_sets (
-				cbx->cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout.handle, 1, 1, &lightmap_texture->descriptor_set, 0, NULL);
-		else
-			vulkan_globals.vk_cmd_bind_descriptor_sets (
-				cbx->cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout.handle, 1, 1, &greylightmap->descriptor_set, 0, NULL);
+	VkDescriptorSet lightmap_set = !r_fullbright_cheatsafe ? lightmap_texture->descriptor_set : greylightmap->descriptor_set;
+	if (cbx->world_lightmap_set != lightmap_set)
+	{
+		vulkan_globals.vk_cmd_bind_descriptor_sets (
+			cbx->cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout.handle, 1, 1, &lightmap_set, 0, NULL);
+		cbx->world_lightmap_set = lightmap_set;
+	}
+}
+
+/*
+================
+R_FlushBatch
+
+Draw the current batch if non-empty and clears it, ready for more R_BatchSurface calls.
+================
+*/
+static void R_FlushBatch (
+	cb_context_t *cbx, qboolean fullbright_enabled, qboolean alpha_test, qboolean alpha_blend, qboolean use_zbias, gltexture_t *lightmap_texture,
+	uint32_t *brushpasses)
+{
+	if ((cbx->num_vbo_indices > 0) || (cbx->num_indirect_draws > 0))
+	{
+		R_BindWorldState (cbx, fullbright_enabled, alpha_test, alpha_blend, use_zbias, lightmap_texture);
 
 		VkBuffer     buffer;
 		VkDeviceSize buffer_offset;
-		byte        *indices = R_IndexAllocate (cbx->num_vbo_indices * sizeof (uint32_t), &buffer, &buffer_offset);
-		memcpy (indices, cbx->vbo_indices, cbx->num_vbo_indices * sizeof (uint32_t));
+		if (cbx->num_vbo_indices > 0)
+		{
+			byte *indices = R_IndexAllocate (cbx->num_vbo_indices * sizeof (uint32_t), &buffer, &buffer_offset);
+			memcpy (indices, cbx->vbo_indices, cbx->num_vbo_indices * sizeof (uint32_t));
+
+			vulkan_globals.vk_cmd_bind_index_buffer (cbx->cb, buffer, buffer_offset, VK_INDEX_TYPE_UINT32);
+			vulkan_globals.vk_cmd_draw_indexed (cbx->cb, cbx->num_vbo_indices, 1, 0, 0, 0);
+		}
+		if (cbx->num_indirect_draws > 0)
+		{
+			const int draws_size = cbx->num_indirect_draws * sizeof (VkDrawIndexedIndirectCommand);
+			byte     *draws = R_IndexAllocate (draws_size, &buffer, &buffer_offset);
+			memcpy (draws, cbx->indirect_draws, draws_size);
 
-		vulkan_globals.vk_cmd_bind_index_buffer (cbx->cb, buffer, buffer_offset, VK_INDEX_TYPE_UINT32);
-		vulkan_globals.vk_cmd_draw_indexed (cbx->cb, cbx->num_vbo_indices, 1, 0, 0, 0);
+			vulkan_globals.vk_cmd_bind_index_buffer (cbx->cb, bmodel_index_buffer, 0, VK_INDEX_TYPE_UINT32);
+			vulkan_globals.vk_cmd_draw_indexed_indirect (cbx->cb, buffer, buffer_offset, cbx->num_indirect_draws, sizeof (VkDrawIndexedIndirectCommand));
+		}
 
 		R_ClearBatch (cbx);
 		++(*brushpasses);
@@ -756,6 +1159,31 @@ static void R_BatchSurface (
 
 	num_surf_indices = R_NumTriangleIndicesForSurf (s);
 
+	if (R_UseIndirectDraws ())
+	{
+		// surfaces are laid out in order in the index buffer, so neighbours in the chain can often share a draw
+		if (cbx->num_indirect_draws > 0)
+		{
+			VkDrawIndexedIndirectCommand *last = &cbx->indirect_draws[cbx->num_indirect_draws - 1];
+			if (last->firstIndex + last->indexCount == (uint32_t)s->vbo_firstindex)
+			{
+				last->indexCount += num_surf_indices;
+				return;
+			}
+		}
+
+		if (cbx->num_indirect_draws == MAX_INDIRECT_BATCH_SIZE)
+			R_FlushBatch (cbx, fullbright_enabled, alpha_test, alpha_blend, use_zbias, lightmap_texture, brushpasses);
+
+		VkDrawIndexedIndirectCommand *draw = &cbx->indirect_draws[cbx->num_indirect_draws++];
+		draw->indexCount = num_surf_indices;
+		draw->instanceCount = 1;
+		draw->firstIndex = s->vbo_firstindex;
+		draw->vertexOffset = 0;
+		draw->firstInstance = 0;
+		return;
+	}
+
 	if (cbx->num_vbo_indices + num_surf_indices > MAX_BATCH_SIZE)
 		R_FlushBatch (cbx, fullbright_enabled, alpha_test, alpha_blend, use_zbias, lightmap_texture, brushpasses);
 
@@ -826,6 +1254,7 @@ void R_DrawTextureChains_Water (cb_context_t *cbx, qmodel_t *model, entity_t *en
 		vulkan_globals.vk_cmd_bind_descriptor_sets (
 			cbx->cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout.handle, 0, 1, &greytexture->descriptor_set, 0, NULL);
 
+	R_ResetWorldBindings (cbx);
 	uint32_t brushpasses = 0;
 	for (i = 0; i < model->numtextures; ++i)
 	{
@@ -913,6 +1342,7 @@ void R_DrawTextureChains_Multitexture (cb_context_t *cbx, qmodel_t *model, entit
 		R_PushConstants (cbx, VK_SHADER_STAGE_ALL_GRAPHICS, 20 * sizeof (float), 1 * sizeof (float), &alpha);
 	}
 
+	R_ResetWorldBindings (cbx);
 	uint32_t brushpasses = 0;
 	for (i = texstart; i < texend; ++i)
 	{
@@ -942,8 +1372,11 @@ void R_DrawTextureChains_Multitexture (cb_context_t *cbx, qmodel_t *model, entit
 			vulkan_globals.vk_cmd_bind_descriptor_sets (
 				cbx->cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout.handle, 0, 1, &gl_texture->descriptor_set, 0, NULL);
 
-		for (s = t->texturechains[chain]; s; s = s->texturechains[chain])
+		int          num_surfs;
+		msurface_t **surfs = R_SortTextureChain (t->texturechains[chain], chain, t->chain_size[chain], &num_surfs);
+		for (int j = 0; j < num_surfs; ++j)
 		{
+			s = surfs[j];
 			if (s->lightmaptexturenum != lastlightmap)
 			{
 				R_FlushBatch (cbx, fullbright_enabled, alpha_test, alpha_blend, use_zbias, lightmap_texture, &brushpasses);
@@ -960,6 +1393,495 @@ void R_DrawTextureChains_Multitexture (cb_context_t *cbx, qmodel_t *model, entit
 	Atomic_AddUInt32 (&rs_brushpasses, brushpasses);
 }
 
+#if defined(USE_SIMD) && defined(VK_KHR_draw_indirect_count)
+/*
+================
+R_CompareWorldCullSurfaces
+================
+*/
+static int R_CompareWorldCullSurfaces (const void *a, const void *b)
+{
+	const msurface_t *s1 = *(const msurface_t **)a;
+	const msurface_t *s2 = *(const msurface_t **)b;
+	if (s1->texinfo->texture != s2->texinfo->texture)
+		return ((uintptr_t)s1->texinfo->texture < (uintptr_t)s2->texinfo->texture) ? -1 : 1;
+	return R_CompareBatchSurfaces (a, b);
+}
+
+/*
+================
+R_CreateWorldCullBuffer
+================
+*/
+static void R_CreateWorldCullBuffer (
+	VkDeviceSize size, VkBufferUsageFlags usage, qboolean host_visible, const char *name, VkBuffer *buffer, vulkan_memory_t *memory)
+{
+	VkResult err;
+
+	VkBufferCreateInfo buffer_create_info;
+	memset (&buffer_create_info, 0, sizeof (buffer_create_info));
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.size = size;
+	buffer_create_info.usage = usage;
+
+	err = vkCreateBuffer (vulkan_globals.device, &buffer_create_info, NULL, buffer);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreateBuffer failed");
+	GL_SetObjectName ((uint64_t)*buffer, VK_OBJECT_TYPE_BUFFER, name);
+
+	VkMemoryRequirements memory_requirements;
+	vkGetBufferMemoryRequirements (vulkan_globals.device, *buffer, &memory_requirements);
+
+	VkMemoryAllocateInfo memory_allocate_info;
+	memset (&memory_allocate_info, 0, sizeof (memory_allocate_info));
+	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memory_allocate_info.allocationSize = memory_requirements.size;
+	if (host_visible)
+		memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties (
+			memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+	else
+		memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties (memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+
+	Atomic_IncrementUInt32 (&num_vulkan_misc_allocations);
+	R_AllocateVulkanMemory (memory, &memory_allocate_info, host_visible ? VULKAN_MEMORY_TYPE_HOST : VULKAN_MEMORY_TYPE_DEVICE);
+	GL_SetObjectName ((uint64_t)memory->handle, VK_OBJECT_TYPE_DEVICE_MEMORY, name);
+
+	err = vkBindBufferMemory (vulkan_globals.device, *buffer, memory->handle, 0);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkBindBufferMemory failed");
+}
+#endif
+
+/*
+================
+R_BuildWorldCull
+
+Called after the brush vertex buffer and the SIMD data of a new map were built
+================
+*/
+void R_BuildWorldCull (void)
+{
+#if defined(USE_SIMD) && defined(VK_KHR_draw_indirect_count)
+	qmodel_t          *model = cl.worldmodel;
+	const VkDeviceSize alignment = vulkan_globals.device_properties.limits.minStorageBufferOffsetAlignment;
+	VkResult           err;
+	int                i, j, k;
+
+	if (!use_simd || !vulkan_globals.draw_indirect_count || !vulkan_globals.multi_draw_indirect || !model || (bmodel_index_buffer == VK_NULL_HANDLE))
+		return;
+
+	// the same surfaces R_DrawTextureChains_Multitexture draws
+	msurface_t **surfs = (msurface_t **)Mem_Alloc (q_max (model->numsurfaces, 1) * sizeof (msurface_t *));
+	int          num_surfs = 0;
+	for (i = 0; i < model->numsurfaces; ++i)
+	{
+		msurface_t *s = &model->surfaces[i];
+		if (!s->texinfo->texture || (s->flags & (SURF_DRAWTURB | SURF_DRAWTILED | SURF_NOTEXTURE | SURF_DRAWSKY)) || (s->lightmaptexturenum < 0))
+			continue;
+		surfs[num_surfs++] = s;
+	}
+
+	const uint32_t num_groups = (num_surfs + WORLD_CULL_GROUP_SIZE - 1) / WORLD_CULL_GROUP_SIZE;
+	if ((num_surfs == 0) || (num_groups > vulkan_globals.device_properties.limits.maxComputeWorkGroupCount[0]))
+	{
+		Mem_Free (surfs);
+		return;
+	}
+	qsort (surfs, num_surfs, sizeof (msurface_t *), R_CompareWorldCullSurfaces);
+
+	world_cull.model = model;
+	world_cull.num_surfaces = num_surfs;
+	world_cull.gpu_surfs = (uint32_t *)Mem_Alloc (((model->numsurfaces + 31) / 32) * sizeof (uint32_t));
+	world_cull.ranges = (world_draw_range_t *)Mem_Alloc (num_surfs * sizeof (world_draw_range_t));
+
+	world_cull_surface_t *records = (world_cull_surface_t *)Mem_Alloc (num_surfs * sizeof (world_cull_surface_t));
+	world_draw_range_t   *range = NULL;
+	for (i = 0; i < num_surfs; ++i)
+	{
+		msurface_t *s = surfs[i];
+		if (!range || (range->texture != s->texinfo->texture) || (range->lightmap != s->lightmaptexturenum))
+		{
+			range = &world_cull.ranges[world_cull.num_ranges++];
+			range->texture = s->texinfo->texture;
+			range->lightmap = s->lightmaptexturenum;
+			range->alpha_test = (s->flags & SURF_DRAWFENCE) != 0;
+			range->first_draw = i;
+		}
+		++range->num_surfaces;
+
+		world_cull_surface_t *record = &records[i];
+		const float           side = (s->flags & SURF_PLANEBACK) ? -1.0f : 1.0f;
+		VectorScale (s->plane->normal, side, record->plane);
+		record->plane[3] = s->plane->dist * side;
+		VectorCopy (s->polys->verts[0], record->mins);
+		VectorCopy (s->polys->verts[0], record->maxs);
+		for (j = 1; j < s->polys->numverts; ++j)
+		{
+			for (k = 0; k < 3; ++k)
+			{
+				record->mins[k] = q_min (record->mins[k], s->polys->verts[j][k]);
+				record->maxs[k] = q_max (record->maxs[k], s->polys->verts[j][k]);
+			}
+		}
+
+		const uint32_t surface_index = s - model->surfaces;
+		record->surface_index = surface_index;
+		record->first_index = s->vbo_firstindex;
+		record->num_indices = R_NumTriangleIndicesForSurf (s);
+		record->draw_range = world_cull.num_ranges - 1;
+		record->first_draw = range->first_draw;
+		world_cull.gpu_surfs[surface_index / 32] |= 1u << (surface_index % 32);
+	}
+
+	// the alpha tested group of bindless draws follows the opaque one
+	for (i = 0; i < world_cull.num_ranges; ++i)
+		world_cull.group_num_surfaces[world_cull.ranges[i].alpha_test ? 1 : 0] += world_cull.ranges[i].num_surfaces;
+	world_cull.group_first_draw[0] = 0;
+	world_cull.group_first_draw[1] = world_cull.group_num_surfaces[0];
+	for (i = 0; i < num_surfs; ++i)
+	{
+		const int group = world_cull.ranges[records[i].draw_range].alpha_test ? 1 : 0;
+		records[i].group_count = world_cull.num_ranges + group;
+		records[i].group_first_draw = world_cull.group_first_draw[group];
+	}
+
+	GL_CreateBModelBuffer (
+		records, num_surfs * sizeof (world_cull_surface_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, "World Cull Surfaces", &world_cull.surfaces_buffer,
+		&world_cull.surfaces_memory, "World Cull Surfaces Memory");
+
+	world_cull.surfvis_size = ((((model->numsurfaces + 31) / 32) * sizeof (uint32_t)) + alignment - 1) & ~(alignment - 1);
+	R_CreateWorldCullBuffer (
+		DOUBLE_BUFFERED * world_cull.surfvis_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true, "World Cull Visibility", &world_cull.surfvis_buffer,
+		&world_cull.surfvis_memory);
+	err = vkMapMemory (
+		vulkan_globals.device, world_cull.surfvis_memory.handle, 0, DOUBLE_BUFFERED * world_cull.surfvis_size, 0, (void **)&world_cull.surfvis_mapped);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkMapMemory failed");
+
+	// one draw count per range and bindless group followed by the indirect draws of all ranges
+	world_cull.counts_size = ((world_cull.num_ranges + NUM_BINDLESS_GROUPS) * sizeof (uint32_t) + alignment - 1) & ~(alignment - 1);
+	world_cull.draws_slot_size = (world_cull.counts_size + num_surfs * sizeof (VkDrawIndexedIndirectCommand) + alignment - 1) & ~(alignment - 1);
+	R_CreateWorldCullBuffer (
+		DOUBLE_BUFFERED * world_cull.draws_slot_size,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, false, "World Cull Draws",
+		&world_cull.draws_buffer, &world_cull.draws_memory);
+
+	for (i = 0; i < DOUBLE_BUFFERED; ++i)
+	{
+		world_cull.desc_sets[i] = R_AllocateDescriptorSet (&vulkan_globals.world_cull_set_layout);
+
+		VkDescriptorBufferInfo buffer_infos[4];
+		memset (&buffer_infos, 0, sizeof (buffer_infos));
+		buffer_infos[0].buffer = world_cull.surfaces_buffer;
+		buffer_infos[0].offset = 0;
+		buffer_infos[0].range = VK_WHOLE_SIZE;
+		buffer_infos[1].buffer = world_cull.surfvis_buffer;
+		buffer_infos[1].offset = i * world_cull.surfvis_size;
+		buffer_infos[1].range = world_cull.surfvis_size;
+		buffer_infos[2].buffer = world_cull.draws_buffer;
+		buffer_infos[2].offset = i * world_cull.draws_slot_size;
+		buffer_infos[2].range = world_cull.counts_size;
+		buffer_infos[3].buffer = world_cull.draws_buffer;
+		buffer_infos[3].offset = i * world_cull.draws_slot_size + world_cull.counts_size;
+		buffer_infos[3].range = num_surfs * sizeof (VkDrawIndexedIndirectCommand);
+
+		VkWriteDescriptorSet writes[4];
+		memset (&writes, 0, sizeof (writes));
+		for (j = 0; j < 4; ++j)
+		{
+			writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[j].dstBinding = j;
+			writes[j].dstArrayElement = 0;
+			writes[j].descriptorCount = 1;
+			writes[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[j].dstSet = world_cull.desc_sets[i];
+			writes[j].pBufferInfo = &buffer_infos[j];
+		}
+		vkUpdateDescriptorSets (vulkan_globals.device, 4, writes, 0, NULL);
+	}
+
+	if (vulkan_globals.bindless_textures)
+	{
+		// x diffuse, y lightmap, z fullbright per range, see world_bindless.vert
+		world_cull.materials_size = (world_cull.num_ranges * 4 * sizeof (uint32_t) + alignment - 1) & ~(alignment - 1);
+		R_CreateWorldCullBuffer (
+			DOUBLE_BUFFERED * world_cull.materials_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true, "World Materials", &world_cull.materials_buffer,
+			&world_cull.materials_memory);
+		err = vkMapMemory (
+			vulkan_globals.device, world_cull.materials_memory.handle, 0, DOUBLE_BUFFERED * world_cull.materials_size, 0,
+			(void **)&world_cull.materials_mapped);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkMapMemory failed");
+
+		for (i = 0; i < DOUBLE_BUFFERED; ++i)
+		{
+			world_cull.materials_desc_sets[i] = R_AllocateDescriptorSet (&vulkan_globals.world_materials_set_layout);
+
+			VkDescriptorBufferInfo buffer_info;
+			memset (&buffer_info, 0, sizeof (buffer_info));
+			buffer_info.buffer = world_cull.materials_buffer;
+			buffer_info.offset = i * world_cull.materials_size;
+			buffer_info.range = world_cull.materials_size;
+
+			VkWriteDescriptorSet write;
+			memset (&write, 0, sizeof (write));
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstBinding = 0;
+			write.dstArrayElement = 0;
+			write.descriptorCount = 1;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			write.dstSet = world_cull.materials_desc_sets[i];
+			write.pBufferInfo = &buffer_info;
+			vkUpdateDescriptorSets (vulkan_globals.device, 1, &write, 0, NULL);
+		}
+	}
+
+	Mem_Free (records);
+	Mem_Free (surfs);
+#endif
+}
+
+/*
+================
+R_DeleteWorldCull
+
+The device is idle, GL_DeleteBModelVertexBuffer waited for it
+================
+*/
+void R_DeleteWorldCull (void)
+{
+	if (!world_cull.model)
+		return;
+
+	for (int i = 0; i < DOUBLE_BUFFERED; ++i)
+		R_FreeDescriptorSet (world_cull.desc_sets[i], &vulkan_globals.world_cull_set_layout);
+
+	vkDestroyBuffer (vulkan_globals.device, world_cull.surfaces_buffer, NULL);
+	Atomic_DecrementUInt32 (&num_vulkan_bmodel_allocations);
+	R_FreeVulkanMemory (&world_cull.surfaces_memory);
+
+	vkUnmapMemory (vulkan_globals.device, world_cull.surfvis_memory.handle);
+	vkDestroyBuffer (vulkan_globals.device, world_cull.surfvis_buffer, NULL);
+	Atomic_DecrementUInt32 (&num_vulkan_misc_allocations);
+	R_FreeVulkanMemory (&world_cull.surfvis_memory);
+
+	vkDestroyBuffer (vulkan_globals.device, world_cull.draws_buffer, NULL);
+	Atomic_DecrementUInt32 (&num_vulkan_misc_allocations);
+	R_FreeVulkanMemory (&world_cull.draws_memory);
+
+	if (world_cull.materials_buffer != VK_NULL_HANDLE)
+	{
+		for (int i = 0; i < DOUBLE_BUFFERED; ++i)
+			R_FreeDescriptorSet (world_cull.materials_desc_sets[i], &vulkan_globals.world_materials_set_layout);
+		vkUnmapMemory (vulkan_globals.device, world_cull.materials_memory.handle);
+		vkDestroyBuffer (vulkan_globals.device, world_cull.materials_buffer, NULL);
+		Atomic_DecrementUInt32 (&num_vulkan_misc_allocations);
+		R_FreeVulkanMemory (&world_cull.materials_memory);
+	}
+
+	Mem_Free (world_cull.gpu_surfs);
+	Mem_Free (world_cull.ranges);
+	memset (&world_cull, 0, sizeof (world_cull));
+}
+
+/*
+================
+R_BeginWorldCulling
+
+Called once the fence of the frame slot was waited on
+================
+*/
+void R_BeginWorldCulling (int frame_index)
+{
+	world_cull.frame_index = frame_index;
+	world_cull.constants[frame_index].num_surfaces = 0;
+}
+
+/*
+================
+R_CullWorldSurfaces
+
+Records the cull pass of the frame slot into the primary command buffer before the main render pass
+================
+*/
+void R_CullWorldSurfaces (cb_context_t *cbx, int frame_index)
+{
+	const world_cull_constants_t *constants = &world_cull.constants[frame_index];
+	if (constants->num_surfaces == 0)
+		return;
+
+	R_BeginDebugUtilsLabel (cbx, "World Culling");
+
+	const VkDeviceSize slot_offset = frame_index * world_cull.draws_slot_size;
+	vkCmdFillBuffer (cbx->cb, world_cull.draws_buffer, slot_offset, world_cull.counts_size, 0);
+
+	VkMemoryBarrier memory_barrier;
+	memset (&memory_barrier, 0, sizeof (memory_barrier));
+	memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vulkan_globals.vk_cmd_pipeline_barrier (
+		cbx->cb, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memory_barrier, 0, NULL, 0, NULL);
+
+	R_BindPipeline (cbx, VK_PIPELINE_BIND_POINT_COMPUTE, vulkan_globals.world_cull_pipeline);
+	vulkan_globals.vk_cmd_bind_descriptor_sets (
+		cbx->cb, VK_PIPELINE_BIND_POINT_COMPUTE, vulkan_globals.world_cull_pipeline.layout.handle, 0, 1, &world_cull.desc_sets[frame_index], 0, NULL);
+	R_PushConstants (cbx, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof (world_cull_constants_t), constants);
+	vulkan_globals.vk_cmd_dispatch (cbx->cb, (constants->num_surfaces + WORLD_CULL_GROUP_SIZE - 1) / WORLD_CULL_GROUP_SIZE, 1, 1);
+
+	memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	memory_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	vulkan_globals.vk_cmd_pipeline_barrier (
+		cbx->cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &memory_barrier, 0, NULL, 0, NULL);
+
+	R_EndDebugUtilsLabel (cbx);
+}
+
+#if defined(VK_KHR_draw_indirect_count)
+/*
+================
+R_DrawWorldBindless
+
+Resolves the textures of every range into the materials of the frame slot and draws the opaque
+and the alpha tested group with one indirect draw each
+================
+*/
+static void R_DrawWorldBindless (cb_context_t *cbx, int slot)
+{
+	uint32_t *materials = (uint32_t *)(world_cull.materials_mapped + (slot * world_cull.materials_size));
+	int       i;
+
+	for (i = 0; i < world_cull.num_ranges; ++i, materials += 4)
+	{
+		const world_draw_range_t *range = &world_cull.ranges[i];
+		texture_t                *texture = R_TextureAnimation (range->texture, 0);
+		materials[0] = TexMgr_BindlessIndex (!r_lightmap_cheatsafe ? texture->gltexture : greytexture);
+		materials[1] = TexMgr_BindlessIndex (!r_fullbright_cheatsafe ? lightmaps[range->lightmap].texture : greylightmap);
+		if (gl_fullbrights.value && texture->fullbright && !r_lightmap_cheatsafe)
+			materials[2] = TexMgr_BindlessIndex (texture->fullbright);
+		else
+			materials[2] = BINDLESS_NO_TEXTURE;
+		materials[3] = 0;
+	}
+
+	VkDescriptorSet desc_sets[2] = {vulkan_globals.bindless_textures_desc_set, world_cull.materials_desc_sets[slot]};
+	vulkan_globals.vk_cmd_bind_descriptor_sets (
+		cbx->cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_bindless_pipeline_layout.handle, 0, 2, desc_sets, 0, NULL);
+	R_ResetWorldBindings (cbx);
+	vkCmdSetDepthBias (cbx->cb, 0.0f, 0.0f, 0.0f);
+	cbx->world_depth_bias = false;
+
+	const VkDeviceSize slot_offset = slot * world_cull.draws_slot_size;
+	const int          quantize_lm = (vid_filter.value != 0 && vid_palettize.value != 0) ? 1 : 0;
+	uint32_t           brushpasses = 0;
+	for (i = 0; i < NUM_BINDLESS_GROUPS; ++i)
+	{
+		if (world_cull.group_num_surfaces[i] == 0)
+			continue;
+
+		R_BindPipeline (cbx, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_bindless_pipelines[i + (quantize_lm * 2)]);
+		vulkan_globals.vk_cmd_draw_indexed_indirect_count (
+			cbx->cb, world_cull.draws_buffer, slot_offset + world_cull.counts_size + (world_cull.group_first_draw[i] * sizeof (VkDrawIndexedIndirectCommand)),
+			world_cull.draws_buffer, slot_offset + ((world_cull.num_ranges + i) * sizeof (uint32_t)), world_cull.group_num_surfaces[i],
+			sizeof (VkDrawIndexedIndirectCommand));
+		++brushpasses;
+	}
+
+	// Set 0 was bound with an incompatible layout, rebinding it with the world layout
+	// keeps the sets the texture chains bind afterwards from being disturbed.
+	vulkan_globals.vk_cmd_bind_descriptor_sets (
+		cbx->cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout.handle, 0, 1, &nulltexture->descriptor_set, 0, NULL);
+
+	Atomic_AddUInt32 (&rs_brushpasses, brushpasses);
+}
+#endif
+
+/*
+================
+R_DrawWorldCulled
+
+Records one indirect draw with a GPU written count per range of this world command buffer.
+The first one also hands the marked surfaces and the view of this frame to the cull pass.
+================
+*/
+static void R_DrawWorldCulled (cb_context_t *cbx, int index)
+{
+#if defined(VK_KHR_draw_indirect_count)
+	const int slot = world_cull.frame_index;
+	int       i;
+
+	if (index == 0)
+	{
+		world_cull_constants_t *constants = &world_cull.constants[slot];
+		for (i = 0; i < 4; ++i)
+		{
+			VectorCopy (frustum[i].normal, constants->frustum[i]);
+			constants->frustum[i][3] = frustum[i].dist;
+		}
+		VectorCopy (r_refdef.vieworg, constants->vieworg);
+		constants->vieworg[3] = 0.0f;
+		constants->num_surfaces = world_cull.num_surfaces;
+		constants->bindless = world_cull.bindless;
+		memcpy (
+			world_cull.surfvis_mapped + (slot * world_cull.surfvis_size), cl.worldmodel->surfvis, ((cl.worldmodel->numsurfaces + 31) / 32) * sizeof (uint32_t));
+	}
+
+	if (world_cull.range_start[index] == world_cull.range_end[index])
+		return;
+
+	VkDeviceSize offset = 0;
+	vulkan_globals.vk_cmd_bind_vertex_buffers (cbx->cb, 0, 1, &bmodel_vertex_buffer, &offset);
+	vulkan_globals.vk_cmd_bind_index_buffer (cbx->cb, bmodel_index_buffer, 0, VK_INDEX_TYPE_UINT32);
+
+	if (world_cull.bindless)
+	{
+		R_DrawWorldBindless (cbx, slot);
+		return;
+	}
+
+	vulkan_globals.vk_cmd_bind_descriptor_sets (
+		cbx->cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout.handle, 2, 1, &nulltexture->descriptor_set, 0, NULL);
+	if (r_lightmap_cheatsafe)
+		vulkan_globals.vk_cmd_bind_descriptor_sets (
+			cbx->cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout.handle, 0, 1, &greytexture->descriptor_set, 0, NULL);
+
+	R_ResetWorldBindings (cbx);
+	const VkDeviceSize slot_offset = slot * world_cull.draws_slot_size;
+	texture_t         *last_texture = NULL;
+	qboolean           fullbright_enabled = false;
+	uint32_t           brushpasses = 0;
+	for (i = world_cull.range_start[index]; i < world_cull.range_end[index]; ++i)
+	{
+		const world_draw_range_t *range = &world_cull.ranges[i];
+		if (range->texture != last_texture)
+		{
+			texture_t   *texture = R_TextureAnimation (range->texture, 0);
+			gltexture_t *fullbright;
+			if (gl_fullbrights.value && (fullbright = texture->fullbright) && !r_lightmap_cheatsafe)
+			{
+				fullbright_enabled = true;
+				vulkan_globals.vk_cmd_bind_descriptor_sets (
+					cbx->cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout.handle, 2, 1, &fullbright->descriptor_set, 0, NULL);
+			}
+			else
+				fullbright_enabled = false;
+			if (!r_lightmap_cheatsafe)
+				vulkan_globals.vk_cmd_bind_descriptor_sets (
+					cbx->cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout.handle, 0, 1, &texture->gltexture->descriptor_set, 0, NULL);
+			last_texture = range->texture;
+		}
+
+		R_BindWorldState (cbx, fullbright_enabled, range->alpha_test, false, false, lightmaps[range->lightmap].texture);
+		vulkan_globals.vk_cmd_draw_indexed_indirect_count (
+			cbx->cb, world_cull.draws_buffer, slot_offset + world_cull.counts_size + (range->first_draw * sizeof (VkDrawIndexedIndirectCommand)),
+			world_cull.draws_buffer, slot_offset + (i * sizeof (uint32_t)), range->num_surfaces, sizeof (VkDrawIndexedIndirectCommand));
+		++brushpasses;
+	}
+
+	Atomic_AddUInt32 (&rs_brushpasses, brushpasses);
+#endif
+}
+
 /*
 =============
 R_DrawWorld -- johnfitz -- rewritten
@@ -992,6 +1914,8 @@ void R_DrawWorld (cb_context_t *cbx, int index)
 	R_BeginDebugUtilsLabel (cbx, "World");
 	if (!r_gpulightmapupdate.value)
 		R_UploadLightmaps ();
+	if (mark_surfaces_state.gpu_cull)
+		R_DrawWorldCulled (cbx, index);
 	R_DrawTextureChains_Multitexture (cbx, cl.worldmodel, NULL, chain_world, 1, world_texstart[index], world_texend[index]);
 	R_EndDebugUtilsLabel (cbx);
 }
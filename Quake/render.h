@@ -117,6 +117,8 @@ typedef struct entity_s
 	vec3_t trailorg;   // previous particle trail point
 
 	lightcache_t lightcache; // alias light trace cache
+
+	int occlusion_index; // predicate of the occlusion test this frame, -1 if untested
 } entity_t;
 
 // !!! if this is changed, it must be changed in asm_draw.h too !!!
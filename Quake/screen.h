@@ -29,6 +29,7 @@ void SCR_Init (void);
 void SCR_LoadPics (void);
 
 void SCR_UpdateScreen (qboolean use_tasks);
+void SCR_FinishScreenShots (void);
 void SCR_UpdateZoom (void);
 
 void SCR_CenterPrintClear (void);
@@ -158,6 +158,10 @@ typedef struct client_s
 	sizebuf_t datagram;
 	byte      datagram_buf[MAX_DATAGRAM];
 
+	// how much of message/datagram server demos have already taken or skipped
+	int mvd_messagepos;
+	int mvd_datagrampos;
+
 	unsigned int limit_entities;   // vanilla is 600
 	unsigned int limit_unreliable; // max allowed size for unreliables
 	unsigned int limit_reliable;   // max (total) size of a reliable message.
@@ -289,9 +293,11 @@ extern cvar_t timelimit;
 extern server_static_t svs; // persistant server info
 extern server_t        sv;  // local server
 
-extern client_t *host_client;
+extern double sv_frametime;
+
+extern THREAD_LOCAL client_t *host_client;
 
-extern edict_t *sv_player;
+extern THREAD_LOCAL edict_t *sv_player;
 
 //===========================================================
 
@@ -336,4 +342,19 @@ void SV_RunClients (void);
 void SV_SaveSpawnparms ();
 void SV_SpawnServer (const char *server);
 
+qboolean SV_WriteEntityUpdate (edict_t *ent, unsigned int e, sizebuf_t *msg);
+
+// sv_demo.c
+#define MVD_MAGIC     "VKMV"
+#define MVD_VERSION   1
+#define MVD_CONTINUED -2 // target of the records a tick's entities didn't fit in, for all viewers
+
+void SV_MVD_Init (void);
+void SV_MVD_NewMap (void);
+void SV_MVD_ClientData (client_t *client, const byte *data, int size);
+void SV_MVD_ClientBuffer (client_t *client, sizebuf_t *buf);
+void SV_MVD_SkipClientData (client_t *client, sizebuf_t *buf, int start);
+void SV_MVD_WriteFrame (void);
+void SV_MVD_Stop (void);
+
 #endif /* _QUAKE_SERVER_H */
@@ -60,6 +60,12 @@ vec3_t listener_up;
 int soundtime;   // sample PAIRS
 int paintedtime; // sample PAIRS
 
+// demo capture mixes a fixed amount per captured frame instead of following the device
+static double snd_capture_step;
+static double snd_capture_remainder;
+static short *snd_capture_buffer;
+static int    snd_capture_buffer_size;
+
 int                   s_rawend;
 portable_samplepair_t s_rawsamples[MAX_RAW_SAMPLES];
 
@@ -927,11 +933,81 @@ static void GetSoundtime (void)
 
 void S_ExtraUpdate (void)
 {
-	if (snd_noextraupdate.value)
+	if (snd_noextraupdate.value || (snd_capture_step > 0.0))
 		return; // don't pollute timings
 	S_Update_ ();
 }
 
+/*
+==================
+S_BeginCapture
+
+While capturing, the device no longer paces the mixer. S_CaptureFrame mixes
+exactly step seconds of audio for every frame that the demo capture wrote.
+==================
+*/
+void S_BeginCapture (double step)
+{
+	SDL_LockMutex (snd_mutex);
+	snd_capture_step = step;
+	snd_capture_remainder = 0.0;
+	SDL_UnlockMutex (snd_mutex);
+}
+
+void S_EndCapture (void)
+{
+	SDL_LockMutex (snd_mutex);
+	snd_capture_step = 0.0;
+	SAFE_FREE (snd_capture_buffer);
+	snd_capture_buffer_size = 0;
+	SDL_UnlockMutex (snd_mutex);
+}
+
+/*
+==================
+S_CaptureFrame
+
+Mixes one step into a private buffer, so a step may be longer than the dma
+ring, and hands it to the demo capture in one block.
+==================
+*/
+void S_CaptureFrame (void)
+{
+	int count;
+
+	if (!snd_initialized)
+		return;
+
+	SDL_LockMutex (snd_mutex);
+
+	if (!sound_started || (snd_blocked > 0) || (snd_capture_step <= 0.0))
+		goto unlock_mutex;
+
+	SNDDMA_LockBuffer ();
+	if (!shm->buffer)
+		goto unlock_mutex;
+
+	snd_capture_remainder += snd_capture_step * shm->speed;
+	count = (int)snd_capture_remainder;
+	snd_capture_remainder -= count;
+	if (count > 0)
+	{
+		// always 16 bit stereo, whatever the device format is
+		if (count * 2 > snd_capture_buffer_size)
+		{
+			snd_capture_buffer_size = count * 2;
+			snd_capture_buffer = (short *)Mem_Realloc (snd_capture_buffer, snd_capture_buffer_size * sizeof (short));
+		}
+		S_CaptureChannels (paintedtime + count, snd_capture_buffer);
+		CL_CaptureAudio (snd_capture_buffer, count, 2, shm->speed);
+	}
+
+	SNDDMA_Submit ();
+
+unlock_mutex:
+	SDL_UnlockMutex (snd_mutex);
+}
+
 static void S_Update_ (void)
 {
 	unsigned int endtime;
@@ -949,6 +1025,13 @@ static void S_Update_ (void)
 	if (!shm->buffer)
 		goto unlock_mutex;
 
+	// S_CaptureFrame does the mixing
+	if (snd_capture_step > 0.0)
+	{
+		SNDDMA_Submit ();
+		goto unlock_mutex;
+	}
+
 	// Updates DMA time
 	GetSoundtime ();
 
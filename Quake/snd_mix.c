@@ -29,7 +29,8 @@ int                   snd_scaletable[32][256];
 int                  *snd_p, snd_linear_count;
 short                *snd_out;
 
-static int snd_vol;
+static int    snd_vol;
+static short *snd_capture_out;
 
 static void Snd_WriteLinearBlastStereo16 (void)
 {
@@ -506,12 +507,34 @@ void S_PaintChannels (int endtime)
 			//		Con_Printf ("full stream\n");
 		}
 
+		// demo capture keeps its own copy, the dma ring may be shorter than one step
+		if (snd_capture_out)
+		{
+			for (i = 0; i < end - paintedtime; i++)
+			{
+				*snd_capture_out++ = LittleShort (CLAMP (SHRT_MIN, paintbuffer[i].left / 256, SHRT_MAX));
+				*snd_capture_out++ = LittleShort (CLAMP (SHRT_MIN, paintbuffer[i].right / 256, SHRT_MAX));
+			}
+		}
+
 		// transfer out according to DMA format
 		S_TransferPaintBuffer (end);
 		paintedtime = end;
 	}
 }
 
+/*
+==================
+S_CaptureChannels -- S_PaintChannels that also stores the clipped samples as little endian 16 bit stereo
+==================
+*/
+void S_CaptureChannels (int endtime, short *out)
+{
+	snd_capture_out = out;
+	S_PaintChannels (endtime);
+	snd_capture_out = NULL;
+}
+
 void SND_InitScaletable (void)
 {
 	int i, j;
@@ -0,0 +1,606 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+Copyright (C) 2010-2014 QuakeSpasm developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// sv_demo.c -- server side multi-view demo recording
+
+#include "quakedef.h"
+
+/*
+==============================================================================
+
+MULTI-VIEW DEMOS
+
+The server records what a spectator would need to watch any player: every
+tick a record for all viewers holds the time, all entities regardless of PVS
+and the broadcast datagram, followed by records that only one client
+received (reliable messages, damage, clientdata). Playback follows one
+client and skips the records of all others, see CL_PlayDemo_f.
+
+A record is [size][target][angles][message], target is -1 for all viewers,
+MVD_CONTINUED for the rest of a tick's entities or a client slot. Finished ticks are handed to a writer thread so recording
+only costs the server the time to build them.
+==============================================================================
+*/
+
+#define MVD_HEADERSIZE 20
+#define MVD_FLUSHSIZE  8192 // split signon records like CL_Record_Prespawn does
+
+typedef struct mvdblock_s
+{
+	struct mvdblock_s *next;
+	int                size;
+	byte               data[];
+} mvdblock_t;
+
+static qboolean mvd_recording;
+static FILE    *mvd_file;
+static char     mvd_name[MAX_OSPATH];
+
+// writer thread
+static SDL_Thread *mvd_thread;
+static SDL_mutex  *mvd_mutex;
+static SDL_cond   *mvd_cond;
+static mvdblock_t *mvd_queue_head;
+static mvdblock_t *mvd_queue_tail;
+static size_t      mvd_queue_size;
+static qboolean    mvd_quit;
+
+// records of the tick being built
+static byte  *mvd_tick;
+static size_t mvd_ticksize;
+static size_t mvd_tickmaxsize;
+
+// per client records captured while the tick is sent out
+static byte  *mvd_clients;
+static size_t mvd_clientssize;
+static size_t mvd_clientsmaxsize;
+
+static qboolean mvd_warnedsplit;
+
+static byte      mvd_msgbuf[MAX_MSGLEN];
+static sizebuf_t mvd_msg = {false, false, mvd_msgbuf, sizeof (mvd_msgbuf), 0};
+
+/*
+==================
+SV_MVD_WriterThread
+==================
+*/
+static int SV_MVD_WriterThread (void *unused)
+{
+	mvdblock_t *block;
+
+	SDL_LockMutex (mvd_mutex);
+	for (;;)
+	{
+		while (!mvd_queue_head && !mvd_quit)
+			SDL_CondWait (mvd_cond, mvd_mutex);
+		block = mvd_queue_head;
+		if (!block)
+			break;
+		mvd_queue_head = block->next;
+		if (!mvd_queue_head)
+			mvd_queue_tail = NULL;
+		mvd_queue_size -= block->size;
+		SDL_UnlockMutex (mvd_mutex);
+
+		fwrite (block->data, block->size, 1, mvd_file);
+		Mem_Free (block);
+
+		SDL_LockMutex (mvd_mutex);
+		if (!mvd_queue_head)
+			fflush (mvd_file);
+	}
+	SDL_UnlockMutex (mvd_mutex);
+
+	return 0;
+}
+
+/*
+==================
+SV_MVD_AppendRecord
+==================
+*/
+static void SV_MVD_AppendRecord (byte **buf, size_t *size, size_t *maxsize, int target, const vec3_t angles, const byte *data, int datasize)
+{
+	int   header[2];
+	float f;
+	int   i;
+
+	if (*size + MVD_HEADERSIZE + datasize > *maxsize)
+	{
+		*maxsize = q_max (*maxsize * 2, *size + MVD_HEADERSIZE + datasize + MAX_DATAGRAM);
+		*buf = Mem_Realloc (*buf, *maxsize);
+	}
+
+	header[0] = LittleLong (datasize);
+	header[1] = LittleLong (target);
+	memcpy (*buf + *size, header, 8);
+	for (i = 0; i < 3; i++)
+	{
+		f = LittleFloat (angles ? angles[i] : 0.f);
+		memcpy (*buf + *size + 8 + i * 4, &f, 4);
+	}
+	memcpy (*buf + *size + MVD_HEADERSIZE, data, datasize);
+	*size += MVD_HEADERSIZE + datasize;
+}
+
+static void SV_MVD_FlushMessage (int target, const vec3_t angles)
+{
+	if (mvd_msg.cursize)
+		SV_MVD_AppendRecord (&mvd_tick, &mvd_ticksize, &mvd_tickmaxsize, target, angles, mvd_msg.data, mvd_msg.cursize);
+	SZ_Clear (&mvd_msg);
+}
+
+/*
+==================
+SV_MVD_Submit
+
+Hands everything built so far to the writer thread
+==================
+*/
+static void SV_MVD_Submit (void)
+{
+	mvdblock_t *block;
+
+	if (!mvd_ticksize)
+		return;
+
+	block = (mvdblock_t *)Mem_Alloc (sizeof (mvdblock_t) + mvd_ticksize);
+	block->size = mvd_ticksize;
+	memcpy (block->data, mvd_tick, mvd_ticksize);
+	mvd_ticksize = 0;
+
+	SDL_LockMutex (mvd_mutex);
+	if (mvd_queue_tail)
+		mvd_queue_tail->next = block;
+	else
+		mvd_queue_head = block;
+	mvd_queue_tail = block;
+	mvd_queue_size += block->size;
+	SDL_CondSignal (mvd_cond);
+	SDL_UnlockMutex (mvd_mutex);
+}
+
+/*
+==================
+SV_MVD_WriteSignon
+
+Same signon sequence a client gets, in the server's base protocol without
+any extensions
+==================
+*/
+static void SV_MVD_WriteSignon (void)
+{
+	const char **s;
+	unsigned int i, limit_models = (sv.protocol == PROTOCOL_NETQUAKE) ? 256 : MAX_MODELS;
+	unsigned int limit_sounds = (sv.protocol == PROTOCOL_NETQUAKE) ? 256 : MAX_SOUNDS;
+	int          idx;
+	client_t    *client;
+	edict_t     *ent;
+
+	SZ_Clear (&mvd_msg);
+
+	// serverinfo
+	MSG_WriteByte (&mvd_msg, svc_serverinfo);
+	MSG_WriteLong (&mvd_msg, sv.protocol);
+	if (sv.protocol == PROTOCOL_RMQ)
+		MSG_WriteLong (&mvd_msg, sv.protocolflags);
+	MSG_WriteByte (&mvd_msg, svs.maxclients);
+	if (!coop.value && deathmatch.value)
+		MSG_WriteByte (&mvd_msg, GAME_DEATHMATCH);
+	else
+		MSG_WriteByte (&mvd_msg, GAME_COOP);
+	MSG_WriteString (&mvd_msg, PR_GetString (qcvm->edicts->v.message));
+	for (i = 1, s = sv.model_precache + 1; *s && i < limit_models; s++, i++)
+		MSG_WriteString (&mvd_msg, *s);
+	MSG_WriteByte (&mvd_msg, 0);
+	for (i = 1, s = sv.sound_precache + 1; *s && i < limit_sounds; s++, i++)
+		MSG_WriteString (&mvd_msg, *s);
+	MSG_WriteByte (&mvd_msg, 0);
+	MSG_WriteByte (&mvd_msg, svc_cdtrack);
+	MSG_WriteByte (&mvd_msg, qcvm->edicts->v.sounds);
+	MSG_WriteByte (&mvd_msg, qcvm->edicts->v.sounds);
+	MSG_WriteByte (&mvd_msg, svc_signonnum);
+	MSG_WriteByte (&mvd_msg, 1);
+	SV_MVD_FlushMessage (-1, NULL);
+
+	// baselines, statics, ambients
+	for (idx = 0; idx < qcvm->num_edicts; idx++)
+	{
+		ent = EDICT_NUM (idx);
+		if (!memcmp (&nullentitystate, &ent->baseline, sizeof (nullentitystate)))
+			continue;
+		MSG_WriteStaticOrBaseLine (&mvd_msg, idx, &ent->baseline, 0, sv.protocol, sv.protocolflags);
+		if (mvd_msg.cursize > MVD_FLUSHSIZE)
+			SV_MVD_FlushMessage (-1, NULL);
+	}
+	for (idx = 0; idx < sv.num_statics; idx++)
+	{
+		if (sv.static_entities[idx].modelindex >= limit_models || !memcmp (&nullentitystate, &sv.static_entities[idx], sizeof (nullentitystate)))
+			continue;
+		MSG_WriteStaticOrBaseLine (&mvd_msg, -1, &sv.static_entities[idx], 0, sv.protocol, sv.protocolflags);
+		if (mvd_msg.cursize > MVD_FLUSHSIZE)
+			SV_MVD_FlushMessage (-1, NULL);
+	}
+	for (idx = 0; idx < sv.num_ambients; idx++)
+	{
+		struct ambientsound_s *snd = &sv.ambientsounds[idx];
+		qboolean               large = (snd->soundindex > 255);
+
+		if (snd->soundindex >= limit_sounds)
+			continue;
+		MSG_WriteByte (&mvd_msg, large ? svc_spawnstaticsound2 : svc_spawnstaticsound);
+		for (i = 0; i < 3; i++)
+			MSG_WriteCoord (&mvd_msg, snd->origin[i], sv.protocolflags);
+		if (large)
+			MSG_WriteShort (&mvd_msg, snd->soundindex);
+		else
+			MSG_WriteByte (&mvd_msg, snd->soundindex);
+		MSG_WriteByte (&mvd_msg, snd->volume * 255);
+		MSG_WriteByte (&mvd_msg, snd->attenuation * 64);
+		if (mvd_msg.cursize > MVD_FLUSHSIZE)
+			SV_MVD_FlushMessage (-1, NULL);
+	}
+	SV_MVD_FlushMessage (-1, NULL);
+	SZ_Write (&mvd_msg, sv.signon.data, sv.signon.cursize);
+	MSG_WriteByte (&mvd_msg, svc_signonnum);
+	MSG_WriteByte (&mvd_msg, 2);
+	SV_MVD_FlushMessage (-1, NULL);
+
+	// spawn info
+	for (i = 0, client = svs.clients; i < (unsigned int)svs.maxclients; i++, client++)
+	{
+		if (!client->active)
+			continue;
+		MSG_WriteByte (&mvd_msg, svc_updatename);
+		MSG_WriteByte (&mvd_msg, i);
+		MSG_WriteString (&mvd_msg, client->name);
+		MSG_WriteByte (&mvd_msg, svc_updatecolors);
+		MSG_WriteByte (&mvd_msg, i);
+		MSG_WriteByte (&mvd_msg, client->colors);
+		MSG_WriteByte (&mvd_msg, svc_updatefrags);
+		MSG_WriteByte (&mvd_msg, i);
+		MSG_WriteShort (&mvd_msg, client->old_frags);
+	}
+	for (i = 0; i < MAX_LIGHTSTYLES; i++)
+	{
+		if (!sv.lightstyles[i])
+			continue;
+		MSG_WriteByte (&mvd_msg, svc_lightstyle);
+		MSG_WriteByte (&mvd_msg, i);
+		MSG_WriteString (&mvd_msg, sv.lightstyles[i]);
+		if (mvd_msg.cursize > MVD_FLUSHSIZE)
+			SV_MVD_FlushMessage (-1, NULL);
+	}
+	MSG_WriteByte (&mvd_msg, svc_updatestat);
+	MSG_WriteByte (&mvd_msg, STAT_TOTALSECRETS);
+	MSG_WriteLong (&mvd_msg, pr_global_struct->total_secrets);
+	MSG_WriteByte (&mvd_msg, svc_updatestat);
+	MSG_WriteByte (&mvd_msg, STAT_TOTALMONSTERS);
+	MSG_WriteLong (&mvd_msg, pr_global_struct->total_monsters);
+	MSG_WriteByte (&mvd_msg, svc_updatestat);
+	MSG_WriteByte (&mvd_msg, STAT_SECRETS);
+	MSG_WriteLong (&mvd_msg, pr_global_struct->found_secrets);
+	MSG_WriteByte (&mvd_msg, svc_updatestat);
+	MSG_WriteByte (&mvd_msg, STAT_MONSTERS);
+	MSG_WriteLong (&mvd_msg, pr_global_struct->killed_monsters);
+	MSG_WriteByte (&mvd_msg, svc_signonnum);
+	MSG_WriteByte (&mvd_msg, 3);
+	SV_MVD_FlushMessage (-1, NULL);
+
+	mvd_clientssize = 0;
+	SV_MVD_Submit ();
+}
+
+/*
+==================
+SV_MVD_NewMap
+
+Called when a new map has been spawned
+==================
+*/
+void SV_MVD_NewMap (void)
+{
+	if (mvd_recording)
+		SV_MVD_WriteSignon ();
+}
+
+/*
+==================
+SV_MVD_ClientData
+
+Keeps a copy of data that was sent to client alone, it ends up in the
+client's record of the current tick
+==================
+*/
+void SV_MVD_ClientData (client_t *client, const byte *data, int size)
+{
+	if (!mvd_recording || !client->spawned || size <= 0)
+		return; // signon data is recorded for everyone in SV_MVD_WriteSignon
+	SV_MVD_AppendRecord (&mvd_clients, &mvd_clientssize, &mvd_clientsmaxsize, client - svs.clients, client->edict->v.v_angle, data, size);
+}
+
+static int *SV_MVD_ClientBufferPos (client_t *client, sizebuf_t *buf)
+{
+	int *pos = (buf == &client->message) ? &client->mvd_messagepos : &client->mvd_datagrampos;
+	if (*pos > buf->cursize)
+		*pos = 0; // cleared without being sent
+	return pos;
+}
+
+/*
+==================
+SV_MVD_ClientBuffer
+
+Called when client->message or client->datagram is sent, records what hasn't
+been recorded or skipped yet
+==================
+*/
+void SV_MVD_ClientBuffer (client_t *client, sizebuf_t *buf)
+{
+	int *pos = SV_MVD_ClientBufferPos (client, buf);
+	SV_MVD_ClientData (client, buf->data + *pos, buf->cursize - *pos);
+	*pos = 0;
+}
+
+/*
+==================
+SV_MVD_SkipClientData
+
+Called after data that requires protocol extensions was appended to
+client->message or client->datagram at start. Server demos only use the base
+protocol, so what was there before is recorded now and the rest is left out.
+==================
+*/
+void SV_MVD_SkipClientData (client_t *client, sizebuf_t *buf, int start)
+{
+	int *pos = SV_MVD_ClientBufferPos (client, buf);
+	SV_MVD_ClientData (client, buf->data + *pos, start - *pos);
+	*pos = buf->cursize;
+}
+
+/*
+==================
+SV_MVD_WriteFrame
+
+Called at the end of SV_SendClientMessages, before the entities'
+muzzleflashes are cleared
+==================
+*/
+void SV_MVD_WriteFrame (void)
+{
+	unsigned int e, limit_models = (sv.protocol == PROTOCOL_NETQUAKE) ? 256 : MAX_MODELS;
+	int          i, target;
+	edict_t     *ent;
+	client_t    *client;
+
+	if (!mvd_recording)
+		return;
+
+	// time, all entities and the broadcast datagram. Entities that don't fit
+	// go on in MVD_CONTINUED records, which playback reads in the same tick.
+	target = -1;
+	SZ_Clear (&mvd_msg);
+	MSG_WriteByte (&mvd_msg, svc_time);
+	MSG_WriteFloat (&mvd_msg, qcvm->time);
+	ent = NEXT_EDICT (qcvm->edicts);
+	for (e = 1; e < (unsigned int)qcvm->num_edicts; e++, ent = NEXT_EDICT (ent))
+	{
+		if (ent->free || !ent->v.modelindex || !PR_GetString (ent->v.model)[0])
+			continue;
+		if ((unsigned int)ent->v.modelindex >= limit_models)
+			continue;
+
+		if (!SV_WriteEntityUpdate (ent, e, &mvd_msg))
+			continue;
+		if (mvd_msg.cursize > mvd_msg.maxsize - 64) // room for the largest update
+		{
+			if (!mvd_warnedsplit)
+			{
+				Con_Warning ("MVD frame exceeds %d bytes, splitting it\n", mvd_msg.maxsize);
+				mvd_warnedsplit = true;
+			}
+			SV_MVD_FlushMessage (target, NULL);
+			target = MVD_CONTINUED;
+		}
+	}
+	if (mvd_msg.cursize + sv.datagram.cursize > mvd_msg.maxsize)
+	{
+		SV_MVD_FlushMessage (target, NULL);
+		target = MVD_CONTINUED;
+	}
+	SZ_Write (&mvd_msg, sv.datagram.data, sv.datagram.cursize);
+	SV_MVD_FlushMessage (target, NULL);
+
+	// what only each client received
+	if (mvd_clientssize)
+	{
+		if (mvd_ticksize + mvd_clientssize > mvd_tickmaxsize)
+		{
+			mvd_tickmaxsize = mvd_ticksize + mvd_clientssize;
+			mvd_tick = Mem_Realloc (mvd_tick, mvd_tickmaxsize);
+		}
+		memcpy (mvd_tick + mvd_ticksize, mvd_clients, mvd_clientssize);
+		mvd_ticksize += mvd_clientssize;
+		mvd_clientssize = 0;
+	}
+
+	// the view of each client
+	for (i = 0, client = svs.clients; i < svs.maxclients; i++, client++)
+	{
+		if (!client->active || !client->spawned)
+			continue;
+		MSG_WriteByte (&mvd_msg, svc_setview);
+		MSG_WriteShort (&mvd_msg, NUM_FOR_EDICT (client->edict));
+		SV_WriteClientdataToMessage (client, &mvd_msg);
+		SV_MVD_FlushMessage (i, client->edict->v.v_angle);
+	}
+
+	SV_MVD_Submit ();
+}
+
+/*
+==================
+SV_MVD_Stop
+==================
+*/
+void SV_MVD_Stop (void)
+{
+	if (!mvd_recording)
+		return;
+
+	SZ_Clear (&mvd_msg);
+	MSG_WriteByte (&mvd_msg, svc_disconnect);
+	SV_MVD_FlushMessage (-1, NULL);
+	SV_MVD_Submit ();
+
+	SDL_LockMutex (mvd_mutex);
+	mvd_quit = true;
+	SDL_CondSignal (mvd_cond);
+	SDL_UnlockMutex (mvd_mutex);
+	SDL_WaitThread (mvd_thread, NULL);
+	mvd_thread = NULL;
+
+	fclose (mvd_file);
+	mvd_file = NULL;
+	mvd_recording = false;
+	mvd_clientssize = 0;
+
+	Con_Printf ("Completed server demo %s\n", mvd_name);
+}
+
+/*
+==================
+SV_MVD_Record_f
+
+mvdrecord <demoname>
+==================
+*/
+static void SV_MVD_Record_f (void)
+{
+	int header[2];
+
+	if (cmd_source != src_command)
+		return;
+
+	if (Cmd_Argc () != 2)
+	{
+		Con_Printf ("mvdrecord <demoname> : record all players on this server\n");
+		return;
+	}
+
+	if (!sv.active)
+	{
+		Con_Printf ("No server running\n");
+		return;
+	}
+
+	if (strstr (Cmd_Argv (1), ".."))
+	{
+		Con_Printf ("Relative pathnames are not allowed.\n");
+		return;
+	}
+
+	SV_MVD_Stop ();
+
+	q_snprintf (mvd_name, sizeof (mvd_name), "%s/%s", com_gamedir, Cmd_Argv (1));
+	COM_AddExtension (mvd_name, ".mvd", sizeof (mvd_name));
+	COM_CreatePath (mvd_name);
+	mvd_file = fopen (mvd_name, "wb");
+	if (!mvd_file)
+	{
+		Con_Printf ("ERROR: couldn't create %s\n", mvd_name);
+		return;
+	}
+
+	header[0] = LittleLong (MVD_VERSION);
+	header[1] = LittleLong (-1); // forced cd track
+	fwrite (MVD_MAGIC, 4, 1, mvd_file);
+	fwrite (header, sizeof (header), 1, mvd_file);
+
+	if (!mvd_mutex)
+	{
+		mvd_mutex = SDL_CreateMutex ();
+		mvd_cond = SDL_CreateCond ();
+	}
+	mvd_quit = false;
+	mvd_thread = SDL_CreateThread (SV_MVD_WriterThread, "MVD_Writer", NULL);
+	mvd_recording = true;
+	mvd_warnedsplit = false;
+
+	Con_Printf ("recording server demo to %s.\n", mvd_name);
+
+	PR_SwitchQCVM (&sv.qcvm);
+	SV_MVD_WriteSignon ();
+	PR_SwitchQCVM (NULL);
+}
+
+/*
+==================
+SV_MVD_Stop_f
+==================
+*/
+static void SV_MVD_Stop_f (void)
+{
+	if (cmd_source != src_command)
+		return;
+
+	if (!mvd_recording)
+	{
+		Con_Printf ("Not recording a server demo.\n");
+		return;
+	}
+
+	SV_MVD_Stop ();
+}
+
+/*
+==================
+SV_MVD_Status_f
+==================
+*/
+static void SV_MVD_Status_f (void)
+{
+	size_t queued;
+
+	if (!mvd_recording)
+	{
+		Con_Printf ("Not recording a server demo.\n");
+		return;
+	}
+
+	SDL_LockMutex (mvd_mutex);
+	queued = mvd_queue_size;
+	SDL_UnlockMutex (mvd_mutex);
+	Con_Printf ("recording %s, %.1f KiB waiting to be written\n", mvd_name, queued / 1024.0);
+}
+
+/*
+==================
+SV_MVD_Init
+==================
+*/
+void SV_MVD_Init (void)
+{
+	Cmd_AddCommand ("mvdrecord", SV_MVD_Record_f);
+	Cmd_AddCommand ("mvdstop", SV_MVD_Stop_f);
+	Cmd_AddCommand ("mvdstatus", SV_MVD_Status_f);
+}
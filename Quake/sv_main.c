@@ -27,6 +27,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 server_t        sv;
 server_static_t svs;
 
+double sv_frametime; // length of the tick being simulated, host_frametime belongs to the client
+
 static char localmodels[MAX_MODELS][8]; // inline model names for precache
 
 int sv_protocol = PROTOCOL_RMQ; // spike -- enough maps need this now that we can probably afford incompatibility with engines that still don't support 999
@@ -1124,6 +1126,7 @@ void SV_Init (void)
 
 	Cmd_AddCommand ("pext", SV_Pext_f);
 	Cmd_AddCommand ("sv_protocol", &SV_Protocol_f); // johnfitz
+	SV_MVD_Init ();
 
 	for (i = 0; i < MAX_MODELS; i++)
 		q_snprintf (localmodels[i], 8, "*%i", i);
@@ -1844,6 +1847,167 @@ static byte     net_edict_dists[MAX_EDICTS];
 static int      net_edict_bins[256];
 static uint16_t net_edicts_sorted[MAX_EDICTS];
 
+/*
+=============
+SV_WriteEntityUpdate
+
+Writes an update of ent relative to its baseline, returns false if it has
+nothing visible to send
+=============
+*/
+qboolean SV_WriteEntityUpdate (edict_t *ent, unsigned int e, sizebuf_t *msg)
+{
+	int     bits;
+	int     i;
+	float   miss;
+	eval_t *val;
+	float   scale;
+
+	// send an update
+	bits = 0;
+
+	for (i = 0; i < 3; i++)
+	{
+		miss = ent->v.origin[i] - ent->baseline.origin[i];
+		if (miss < -0.1 || miss > 0.1)
+			bits |= U_ORIGIN1 << i;
+	}
+
+	if (ent->v.angles[0] != ent->baseline.angles[0])
+		bits |= U_ANGLE1;
+
+	if (ent->v.angles[1] != ent->baseline.angles[1])
+		bits |= U_ANGLE2;
+
+	if (ent->v.angles[2] != ent->baseline.angles[2])
+		bits |= U_ANGLE3;
+
+	if (ent->v.movetype == MOVETYPE_STEP)
+		bits |= U_STEP; // don't mess up the step animation
+
+	if (ent->baseline.colormap != ent->v.colormap)
+		bits |= U_COLORMAP;
+
+	if (ent->baseline.skin != ent->v.skin)
+		bits |= U_SKIN;
+
+	if (ent->baseline.frame != ent->v.frame)
+		bits |= U_FRAME;
+
+	if ((ent->baseline.effects ^ (int)ent->v.effects) & sv.effectsmask)
+		bits |= U_EFFECTS;
+
+	if (ent->baseline.modelindex != ent->v.modelindex)
+		bits |= U_MODEL;
+
+	// johnfitz -- alpha
+	//  TODO: find a cleaner place to put this code
+	val = GetEdictFieldValue (ent, qcvm->extfields.alpha);
+	if (val)
+		ent->alpha = ENTALPHA_ENCODE (val->_float);
+
+	// don't send invisible entities unless they have effects
+	if (ent->alpha == ENTALPHA_ZERO && !((int)ent->v.effects & sv.effectsmask))
+		return false;
+	// johnfitz
+
+	val = GetEdictFieldValue (ent, qcvm->extfields.scale);
+	scale = val ? ENTSCALE_ENCODE (val->_float) : ENTSCALE_DEFAULT;
+
+	// johnfitz -- PROTOCOL_FITZQUAKE
+	if (sv.protocol != PROTOCOL_NETQUAKE)
+	{
+
+		if (ent->baseline.alpha != ent->alpha)
+			bits |= U_ALPHA;
+#ifdef BASE_PROTO_SCALES
+		if (sv.protocol == PROTOCOL_RMQ)
+		{
+			if (ent->baseline.scale != scale)
+				bits |= U_SCALE;
+		}
+		else
+#endif
+			if (ENTSCALE_DEFAULT != scale) // for 666, we didn't send the scale in the baseline!
+			bits |= U_SCALE;
+		if (bits & U_FRAME && (int)ent->v.frame & 0xFF00)
+			bits |= U_FRAME2;
+		if (bits & U_MODEL && (int)ent->v.modelindex & 0xFF00)
+			bits |= U_MODEL2;
+		if (ent->sendinterval)
+			bits |= U_LERPFINISH;
+		if (bits >= 65536)
+			bits |= U_EXTEND1;
+		if (bits >= 16777216)
+			bits |= U_EXTEND2;
+	}
+	// johnfitz
+
+	if (e >= 256)
+		bits |= U_LONGENTITY;
+
+	if (bits >= 256)
+		bits |= U_MOREBITS;
+
+	//
+	// write the message
+	//
+	MSG_WriteByte (msg, bits | U_SIGNAL);
+
+	if (bits & U_MOREBITS)
+		MSG_WriteByte (msg, bits >> 8);
+
+	// johnfitz -- PROTOCOL_FITZQUAKE
+	if (bits & U_EXTEND1)
+		MSG_WriteByte (msg, bits >> 16);
+	if (bits & U_EXTEND2)
+		MSG_WriteByte (msg, bits >> 24);
+	// johnfitz
+
+	if (bits & U_LONGENTITY)
+		MSG_WriteShort (msg, e);
+	else
+		MSG_WriteByte (msg, e);
+
+	if (bits & U_MODEL)
+		MSG_WriteByte (msg, ent->v.modelindex);
+	if (bits & U_FRAME)
+		MSG_WriteByte (msg, ent->v.frame);
+	if (bits & U_COLORMAP)
+		MSG_WriteByte (msg, ent->v.colormap);
+	if (bits & U_SKIN)
+		MSG_WriteByte (msg, ent->v.skin);
+	if (bits & U_EFFECTS)
+		MSG_WriteByte (msg, (int)ent->v.effects & sv.effectsmask);
+	if (bits & U_ORIGIN1)
+		MSG_WriteCoord (msg, ent->v.origin[0], sv.protocolflags);
+	if (bits & U_ANGLE1)
+		MSG_WriteAngle (msg, ent->v.angles[0], sv.protocolflags);
+	if (bits & U_ORIGIN2)
+		MSG_WriteCoord (msg, ent->v.origin[1], sv.protocolflags);
+	if (bits & U_ANGLE2)
+		MSG_WriteAngle (msg, ent->v.angles[1], sv.protocolflags);
+	if (bits & U_ORIGIN3)
+		MSG_WriteCoord (msg, ent->v.origin[2], sv.protocolflags);
+	if (bits & U_ANGLE3)
+		MSG_WriteAngle (msg, ent->v.angles[2], sv.protocolflags);
+
+	// johnfitz -- PROTOCOL_FITZQUAKE
+	if (bits & U_ALPHA)
+		MSG_WriteByte (msg, ent->alpha);
+	if (bits & U_SCALE)
+		MSG_WriteByte (msg, scale);
+	if (bits & U_FRAME2)
+		MSG_WriteByte (msg, (int)ent->v.frame >> 8);
+	if (bits & U_MODEL2)
+		MSG_WriteByte (msg, (int)ent->v.modelindex >> 8);
+	if (bits & U_LERPFINISH)
+		MSG_WriteByte (msg, (byte)(Q_rint ((ent->v.nextthink - qcvm->time) * 255)));
+	// johnfitz
+
+	return true;
+}
+
 /*
 =============
 SV_WriteEntitiesToClient
@@ -1854,15 +2018,12 @@ void SV_WriteEntitiesToClient (client_t *client, sizebuf_t *msg, size_t overflow
 {
 	edict_t     *clent = client->edict;
 	unsigned int e, i, maxedict = qcvm->num_edicts, j, numents;
-	int          bits;
 	byte        *pvs;
 	vec3_t       org, forward, right, up;
-	float        miss, dist, size;
+	float        dist, size;
 	edict_t     *ent;
-	eval_t      *val;
 	size_t       rollbacksize, origmaxsize = msg->maxsize;
 	qboolean     sort = sv_netsort.value > 1;
-	float        scale;
 	const char  *model;
 
 	// with sv_netsort = 1, sort only if (any client) overflowed in the last 10 seconds
@@ -1999,147 +2160,8 @@ void SV_WriteEntitiesToClient (client_t *client, sizebuf_t *msg, size_t overflow
 
 		rollbacksize = msg->cursize;
 
-		// send an update
-		bits = 0;
-
-		for (i = 0; i < 3; i++)
-		{
-			miss = ent->v.origin[i] - ent->baseline.origin[i];
-			if (miss < -0.1 || miss > 0.1)
-				bits |= U_ORIGIN1 << i;
-		}
-
-		if (ent->v.angles[0] != ent->baseline.angles[0])
-			bits |= U_ANGLE1;
-
-		if (ent->v.angles[1] != ent->baseline.angles[1])
-			bits |= U_ANGLE2;
-
-		if (ent->v.angles[2] != ent->baseline.angles[2])
-			bits |= U_ANGLE3;
-
-		if (ent->v.movetype == MOVETYPE_STEP)
-			bits |= U_STEP; // don't mess up the step animation
-
-		if (ent->baseline.colormap != ent->v.colormap)
-			bits |= U_COLORMAP;
-
-		if (ent->baseline.skin != ent->v.skin)
-			bits |= U_SKIN;
-
-		if (ent->baseline.frame != ent->v.frame)
-			bits |= U_FRAME;
-
-		if ((ent->baseline.effects ^ (int)ent->v.effects) & sv.effectsmask)
-			bits |= U_EFFECTS;
-
-		if (ent->baseline.modelindex != ent->v.modelindex)
-			bits |= U_MODEL;
-
-		// johnfitz -- alpha
-		//  TODO: find a cleaner place to put this code
-		val = GetEdictFieldValue (ent, qcvm->extfields.alpha);
-		if (val)
-			ent->alpha = ENTALPHA_ENCODE (val->_float);
-
-		// don't send invisible entities unless they have effects
-		if (ent->alpha == ENTALPHA_ZERO && !((int)ent->v.effects & sv.effectsmask))
+		if (!SV_WriteEntityUpdate (ent, e, msg))
 			continue;
-		// johnfitz
-
-		val = GetEdictFieldValue (ent, qcvm->extfields.scale);
-		scale = val ? ENTSCALE_ENCODE (val->_float) : ENTSCALE_DEFAULT;
-
-		// johnfitz -- PROTOCOL_FITZQUAKE
-		if (sv.protocol != PROTOCOL_NETQUAKE)
-		{
-
-			if (ent->baseline.alpha != ent->alpha)
-				bits |= U_ALPHA;
-#ifdef BASE_PROTO_SCALES
-			if (sv.protocol == PROTOCOL_RMQ)
-			{
-				if (ent->baseline.scale != scale)
-					bits |= U_SCALE;
-			}
-			else
-#endif
-				if (ENTSCALE_DEFAULT != scale) // for 666, we didn't send the scale in the baseline!
-				bits |= U_SCALE;
-			if (bits & U_FRAME && (int)ent->v.frame & 0xFF00)
-				bits |= U_FRAME2;
-			if (bits & U_MODEL && (int)ent->v.modelindex & 0xFF00)
-				bits |= U_MODEL2;
-			if (ent->sendinterval)
-				bits |= U_LERPFINISH;
-			if (bits >= 65536)
-				bits |= U_EXTEND1;
-			if (bits >= 16777216)
-				bits |= U_EXTEND2;
-		}
-		// johnfitz
-
-		if (e >= 256)
-			bits |= U_LONGENTITY;
-
-		if (bits >= 256)
-			bits |= U_MOREBITS;
-
-		//
-		// write the message
-		//
-		MSG_WriteByte (msg, bits | U_SIGNAL);
-
-		if (bits & U_MOREBITS)
-			MSG_WriteByte (msg, bits >> 8);
-
-		// johnfitz -- PROTOCOL_FITZQUAKE
-		if (bits & U_EXTEND1)
-			MSG_WriteByte (msg, bits >> 16);
-		if (bits & U_EXTEND2)
-			MSG_WriteByte (msg, bits >> 24);
-		// johnfitz
-
-		if (bits & U_LONGENTITY)
-			MSG_WriteShort (msg, e);
-		else
-			MSG_WriteByte (msg, e);
-
-		if (bits & U_MODEL)
-			MSG_WriteByte (msg, ent->v.modelindex);
-		if (bits & U_FRAME)
-			MSG_WriteByte (msg, ent->v.frame);
-		if (bits & U_COLORMAP)
-			MSG_WriteByte (msg, ent->v.colormap);
-		if (bits & U_SKIN)
-			MSG_WriteByte (msg, ent->v.skin);
-		if (bits & U_EFFECTS)
-			MSG_WriteByte (msg, (int)ent->v.effects & sv.effectsmask);
-		if (bits & U_ORIGIN1)
-			MSG_WriteCoord (msg, ent->v.origin[0], sv.protocolflags);
-		if (bits & U_ANGLE1)
-			MSG_WriteAngle (msg, ent->v.angles[0], sv.protocolflags);
-		if (bits & U_ORIGIN2)
-			MSG_WriteCoord (msg, ent->v.origin[1], sv.protocolflags);
-		if (bits & U_ANGLE2)
-			MSG_WriteAngle (msg, ent->v.angles[1], sv.protocolflags);
-		if (bits & U_ORIGIN3)
-			MSG_WriteCoord (msg, ent->v.origin[2], sv.protocolflags);
-		if (bits & U_ANGLE3)
-			MSG_WriteAngle (msg, ent->v.angles[2], sv.protocolflags);
-
-		// johnfitz -- PROTOCOL_FITZQUAKE
-		if (bits & U_ALPHA)
-			MSG_WriteByte (msg, ent->alpha);
-		if (bits & U_SCALE)
-			MSG_WriteByte (msg, scale);
-		if (bits & U_FRAME2)
-			MSG_WriteByte (msg, (int)ent->v.frame >> 8);
-		if (bits & U_MODEL2)
-			MSG_WriteByte (msg, (int)ent->v.modelindex >> 8);
-		if (bits & U_LERPFINISH)
-			MSG_WriteByte (msg, (byte)(Q_rint ((ent->v.nextthink - qcvm->time) * 255)));
-		// johnfitz
 
 		if ((size_t)msg->cursize > origmaxsize)
 		{
@@ -2193,6 +2215,7 @@ void SV_WriteDamageToMessage (edict_t *ent, sizebuf_t *msg)
 {
 	edict_t *other;
 	int      i;
+	int      start = msg->cursize;
 
 	//
 	// send a damage message
@@ -2223,6 +2246,9 @@ void SV_WriteDamageToMessage (edict_t *ent, sizebuf_t *msg)
 			MSG_WriteAngle (msg, ent->v.angles[i], sv.protocolflags);
 		ent->v.fixangle = 0;
 	}
+
+	// these are one-shot, so server demos can't write their own
+	SV_MVD_ClientData (&svs.clients[NUM_FOR_EDICT (ent) - 1], msg->data + start, msg->cursize - start);
 }
 
 /*
@@ -2488,6 +2514,7 @@ qboolean SV_SendClientDatagram (client_t *client)
 		// copy the private datagram if there is space
 		if (client->datagram.cursize && !client->datagram.overflowed)
 		{
+			SV_MVD_ClientBuffer (client, &client->datagram);
 			if (msg.cursize + client->datagram.cursize < msg.maxsize)
 				SZ_Write (&msg, client->datagram.data, client->datagram.cursize);
 			else if (client->datagram.cursize < msg.maxsize)
@@ -2499,6 +2526,7 @@ qboolean SV_SendClientDatagram (client_t *client)
 			}
 		}
 		SZ_Clear (&client->datagram);
+		client->mvd_datagrampos = 0;
 
 		// copy the server datagram if there is space
 		if (msg.cursize + sv.datagram.cursize < msg.maxsize)
@@ -2870,6 +2898,7 @@ void SV_SendClientMessages (void)
 				SV_DropClient (false); // went to another level
 			else
 			{
+				SV_MVD_ClientBuffer (host_client, &host_client->message);
 				if (NET_SendMessage (host_client->netconnection, &host_client->message) == -1)
 					SV_DropClient (false); // if the message couldn't send, kick off
 				SZ_Clear (&host_client->message);
@@ -2880,6 +2909,8 @@ void SV_SendClientMessages (void)
 		}
 	}
 
+	SV_MVD_WriteFrame ();
+
 	// clear muzzle flashes
 	SV_CleanupEnts ();
 }
@@ -3199,7 +3230,7 @@ void SV_SpawnServer (const char *server)
 	sv.state = ss_active;
 
 	// run two frames to allow everything to settle
-	host_frametime = 0.1;
+	sv_frametime = 0.1;
 	SV_Physics ();
 	SV_Physics ();
 
@@ -3219,5 +3250,7 @@ void SV_SpawnServer (const char *server)
 			SV_SendServerinfo (host_client);
 	}
 
+	SV_MVD_NewMap ();
+
 	Con_DPrintf ("Server spawned.\n");
 }
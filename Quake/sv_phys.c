@@ -124,7 +124,7 @@ qboolean SV_RunThink (edict_t *ent)
 	int   i;        // johnfitz
 
 	thinktime = ent->v.nextthink;
-	if (thinktime <= 0 || thinktime > qcvm->time + host_frametime)
+	if (thinktime <= 0 || thinktime > qcvm->time + sv_frametime)
 		return true;
 
 	if (thinktime < qcvm->time)
@@ -387,7 +387,7 @@ void SV_AddGravity (edict_t *ent)
 	else
 		ent_gravity = 1.0;
 
-	ent->v.velocity[2] -= ent_gravity * sv_gravity.value * host_frametime;
+	ent->v.velocity[2] -= ent_gravity * sv_gravity.value * sv_frametime;
 }
 
 /*
@@ -590,14 +590,14 @@ void SV_Physics_Pusher (edict_t *ent)
 	oldltime = ent->v.ltime;
 
 	thinktime = ent->v.nextthink;
-	if (thinktime < ent->v.ltime + host_frametime)
+	if (thinktime < ent->v.ltime + sv_frametime)
 	{
 		movetime = thinktime - ent->v.ltime;
 		if (movetime < 0)
 			movetime = 0;
 	}
 	else
-		movetime = host_frametime;
+		movetime = sv_frametime;
 
 	if (movetime)
 	{
@@ -846,7 +846,7 @@ void SV_WalkMove (edict_t *ent)
 	VectorCopy (ent->v.origin, oldorg);
 	VectorCopy (ent->v.velocity, oldvel);
 
-	clip = SV_FlyMove (ent, host_frametime, &steptrace);
+	clip = SV_FlyMove (ent, sv_frametime, &steptrace);
 
 	if (!(clip & 2))
 		return; // move didn't block on a step
@@ -874,7 +874,7 @@ void SV_WalkMove (edict_t *ent)
 	VectorCopy (vec3_origin, upmove);
 	VectorCopy (vec3_origin, downmove);
 	upmove[2] = STEPSIZE;
-	downmove[2] = -STEPSIZE + oldvel[2] * host_frametime;
+	downmove[2] = -STEPSIZE + oldvel[2] * sv_frametime;
 
 	// move up
 	SV_PushEntity (ent, upmove); // FIXME: don't link?
@@ -883,7 +883,7 @@ void SV_WalkMove (edict_t *ent)
 	ent->v.velocity[0] = oldvel[0];
 	ent->v.velocity[1] = oldvel[1];
 	ent->v.velocity[2] = 0;
-	clip = SV_FlyMove (ent, host_frametime, &steptrace);
+	clip = SV_FlyMove (ent, sv_frametime, &steptrace);
 
 	// check for stuckness, possibly due to the limited precision of floats
 	// in the clipping hulls
@@ -972,13 +972,13 @@ void SV_Physics_Client (edict_t *ent, int num)
 	case MOVETYPE_FLY:
 		if (!SV_RunThink (ent))
 			return;
-		SV_FlyMove (ent, host_frametime, NULL);
+		SV_FlyMove (ent, sv_frametime, NULL);
 		break;
 
 	case MOVETYPE_NOCLIP:
 		if (!SV_RunThink (ent))
 			return;
-		VectorMA (ent->v.origin, host_frametime, ent->v.velocity, ent->v.origin);
+		VectorMA (ent->v.origin, sv_frametime, ent->v.velocity, ent->v.origin);
 		break;
 
 	default:
@@ -1023,8 +1023,8 @@ void SV_Physics_Noclip (edict_t *ent)
 	if (!SV_RunThink (ent))
 		return;
 
-	VectorMA (ent->v.angles, host_frametime, ent->v.avelocity, ent->v.angles);
-	VectorMA (ent->v.origin, host_frametime, ent->v.velocity, ent->v.origin);
+	VectorMA (ent->v.angles, sv_frametime, ent->v.avelocity, ent->v.angles);
+	VectorMA (ent->v.origin, sv_frametime, ent->v.velocity, ent->v.origin);
 
 	SV_LinkEdict (ent, false);
 }
@@ -1104,10 +1104,10 @@ void SV_Physics_Toss (edict_t *ent)
 		SV_AddGravity (ent);
 
 	// move angles
-	VectorMA (ent->v.angles, host_frametime, ent->v.avelocity, ent->v.angles);
+	VectorMA (ent->v.angles, sv_frametime, ent->v.avelocity, ent->v.angles);
 
 	// move origin
-	VectorScale (ent->v.velocity, host_frametime, move);
+	VectorScale (ent->v.velocity, sv_frametime, move);
 	trace = SV_PushEntity (ent, move);
 	if (trace.fraction == 1)
 		return;
@@ -1170,7 +1170,7 @@ void SV_Physics_Step (edict_t *ent)
 
 		SV_AddGravity (ent);
 		SV_CheckVelocity (ent);
-		SV_FlyMove (ent, host_frametime, NULL);
+		SV_FlyMove (ent, sv_frametime, NULL);
 		SV_LinkEdict (ent, true);
 
 		if ((int)ent->v.flags & FL_ONGROUND) // just hit ground
@@ -1209,7 +1209,7 @@ void SV_Physics (void)
 
 	if (!physics_mode)
 	{
-		qcvm->time += host_frametime;
+		qcvm->time += sv_frametime;
 		return;
 	}
 	else if (physics_mode == 1)
@@ -1220,7 +1220,7 @@ void SV_Physics (void)
 				continue;
 			SV_RunThink (ent);
 		}
-		qcvm->time += host_frametime;
+		qcvm->time += sv_frametime;
 		return;
 	}
 
@@ -1278,5 +1278,5 @@ void SV_Physics (void)
 		pr_global_struct->force_retouch--;
 
 	if (!(sv_freezenonclients.value && qcvm == &sv.qcvm))
-		qcvm->time += host_frametime;
+		qcvm->time += sv_frametime;
 }
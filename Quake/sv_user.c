@@ -23,7 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 
-edict_t *sv_player;
+THREAD_LOCAL edict_t *sv_player;
 
 extern cvar_t sv_friction;
 cvar_t        sv_edgefriction = {"edgefriction", "2", CVAR_NONE};
@@ -146,7 +146,7 @@ void SV_UserFriction (void)
 
 	// apply friction
 	control = speed < sv_stopspeed.value ? sv_stopspeed.value : speed;
-	newspeed = speed - host_frametime * control * friction;
+	newspeed = speed - sv_frametime * control * friction;
 
 	if (newspeed < 0)
 		newspeed = 0;
@@ -173,7 +173,7 @@ void   SV_Accelerate (float wishspeed, const vec3_t wishdir)
 	addspeed = wishspeed - currentspeed;
 	if (addspeed <= 0)
 		return;
-	accelspeed = sv_accelerate.value * host_frametime * wishspeed;
+	accelspeed = sv_accelerate.value * sv_frametime * wishspeed;
 	if (accelspeed > addspeed)
 		accelspeed = addspeed;
 
@@ -193,8 +193,8 @@ void SV_AirAccelerate (float wishspeed, vec3_t wishveloc)
 	addspeed = wishspd - currentspeed;
 	if (addspeed <= 0)
 		return;
-	//	accelspeed = sv_accelerate.value * host_frametime;
-	accelspeed = sv_accelerate.value * wishspeed * host_frametime;
+	//	accelspeed = sv_accelerate.value * sv_frametime;
+	accelspeed = sv_accelerate.value * wishspeed * sv_frametime;
 	if (accelspeed > addspeed)
 		accelspeed = addspeed;
 
@@ -208,7 +208,7 @@ void DropPunchAngle (void)
 
 	len = VectorNormalize (sv_player->v.punchangle);
 
-	len -= 10 * host_frametime;
+	len -= 10 * sv_frametime;
 	if (len < 0)
 		len = 0;
 	VectorScale (sv_player->v.punchangle, len, sv_player->v.punchangle);
@@ -253,7 +253,7 @@ void SV_WaterMove (void)
 	speed = VectorLength (velocity);
 	if (speed)
 	{
-		newspeed = speed - host_frametime * speed * sv_friction.value;
+		newspeed = speed - sv_frametime * speed * sv_friction.value;
 		if (newspeed < 0)
 			newspeed = 0;
 		VectorScale (velocity, newspeed / speed, velocity);
@@ -272,7 +272,7 @@ void SV_WaterMove (void)
 		return;
 
 	VectorNormalize (wishvel);
-	accelspeed = sv_accelerate.value * wishspeed * host_frametime;
+	accelspeed = sv_accelerate.value * wishspeed * sv_frametime;
 	if (accelspeed > addspeed)
 		accelspeed = addspeed;
 
@@ -63,4 +63,9 @@ void Sys_Sleep (unsigned long msecs);
 void Sys_SendKeyEvents (void);
 // Perform Key_Event () callbacks until the input que is empty
 
+int Sys_ForkWorkers (int *numworkers);
+// splits the process into *numworkers processes and returns the worker index
+// in each of them, or -1 in the original process once all workers have exited.
+// platforms without fork run a single in-process worker (*numworkers = 1).
+
 #endif /* _QUAKE_SYS_H */
@@ -32,6 +32,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #endif
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/wait.h>
 #include <fcntl.h>
 #include <time.h>
 #ifdef DO_USERDIRS
@@ -370,3 +371,29 @@ void Sys_SendKeyEvents (void)
 	IN_Commands (); // ericw -- allow joysticks to add keys so they can be used to confirm SCR_ModalMessage
 	IN_SendKeyEvents ();
 }
+
+int Sys_ForkWorkers (int *numworkers)
+{
+	int   i, status;
+	pid_t pid;
+
+	if (*numworkers <= 1)
+	{
+		*numworkers = 1;
+		return 0;
+	}
+
+	fflush (stdout);
+	for (i = 0; i < *numworkers; i++)
+	{
+		pid = fork ();
+		if (pid == 0)
+			return i;
+		if (pid < 0)
+			Sys_Error ("Sys_ForkWorkers: fork failed (%s)", strerror (errno));
+	}
+
+	while (wait (&status) > 0)
+		;
+	return -1;
+}
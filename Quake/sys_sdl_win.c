@@ -316,3 +316,9 @@ void Sys_SendKeyEvents (void)
 	IN_Commands (); // ericw -- allow joysticks to add keys so they can be used to confirm SCR_ModalMessage
 	IN_SendKeyEvents ();
 }
+
+int Sys_ForkWorkers (int *numworkers)
+{
+	*numworkers = 1;
+	return 0;
+}
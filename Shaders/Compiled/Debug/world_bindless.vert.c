@@ -0,0 +1,322 @@
+const unsigned char world_bindless_vert_spv[] = {
+0x03, 0x02, 0x23, 0x07, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x11, 0x00, 0x02, 0x00, 0x01, 0x00, 0x00, 0x00, 0x0E, 0x00, 
+0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+0x0F, 0x00, 0x0D, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x00, 
+0x00, 0x00, 0x6D, 0x61, 0x69, 0x6E, 0x00, 0x00, 0x00, 0x00, 
+0x0F, 0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x14, 0x00, 
+0x00, 0x00, 0x15, 0x00, 0x00, 0x00, 0x17, 0x00, 0x00, 0x00, 
+0x19, 0x00, 0x00, 0x00, 0x1D, 0x00, 0x00, 0x00, 0x2B, 0x00, 
+0x00, 0x00, 0x07, 0x00, 0x07, 0x00, 0x01, 0x00, 0x00, 0x00, 
+0x77, 0x6F, 0x72, 0x6C, 0x64, 0x5F, 0x62, 0x69, 0x6E, 0x64, 
+0x6C, 0x65, 0x73, 0x73, 0x2E, 0x76, 0x65, 0x72, 0x74, 0x00, 
+0x04, 0x00, 0x09, 0x00, 0x47, 0x4C, 0x5F, 0x41, 0x52, 0x42, 
+0x5F, 0x73, 0x65, 0x70, 0x61, 0x72, 0x61, 0x74, 0x65, 0x5F, 
+0x73, 0x68, 0x61, 0x64, 0x65, 0x72, 0x5F, 0x6F, 0x62, 0x6A, 
+0x65, 0x63, 0x74, 0x73, 0x00, 0x00, 0x04, 0x00, 0x09, 0x00, 
+0x47, 0x4C, 0x5F, 0x41, 0x52, 0x42, 0x5F, 0x73, 0x68, 0x61, 
+0x64, 0x69, 0x6E, 0x67, 0x5F, 0x6C, 0x61, 0x6E, 0x67, 0x75, 
+0x61, 0x67, 0x65, 0x5F, 0x34, 0x32, 0x30, 0x70, 0x61, 0x63, 
+0x6B, 0x00, 0x03, 0x00, 0x0F, 0x01, 0x02, 0x00, 0x00, 0x00, 
+0xCC, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x23, 0x76, 
+0x65, 0x72, 0x73, 0x69, 0x6F, 0x6E, 0x20, 0x34, 0x36, 0x30, 
+0x0A, 0x23, 0x65, 0x78, 0x74, 0x65, 0x6E, 0x73, 0x69, 0x6F, 
+0x6E, 0x20, 0x47, 0x4C, 0x5F, 0x41, 0x52, 0x42, 0x5F, 0x73, 
+0x65, 0x70, 0x61, 0x72, 0x61, 0x74, 0x65, 0x5F, 0x73, 0x68, 
+0x61, 0x64, 0x65, 0x72, 0x5F, 0x6F, 0x62, 0x6A, 0x65, 0x63, 
+0x74, 0x73, 0x20, 0x3A, 0x20, 0x65, 0x6E, 0x61, 0x62, 0x6C, 
+0x65, 0x0A, 0x23, 0x65, 0x78, 0x74, 0x65, 0x6E, 0x73, 0x69, 
+0x6F, 0x6E, 0x20, 0x47, 0x4C, 0x5F, 0x41, 0x52, 0x42, 0x5F, 
+0x73, 0x68, 0x61, 0x64, 0x69, 0x6E, 0x67, 0x5F, 0x6C, 0x61, 
+0x6E, 0x67, 0x75, 0x61, 0x67, 0x65, 0x5F, 0x34, 0x32, 0x30, 
+0x70, 0x61, 0x63, 0x6B, 0x20, 0x3A, 0x20, 0x65, 0x6E, 0x61, 
+0x62, 0x6C, 0x65, 0x0A, 0x0A, 0x6C, 0x61, 0x79, 0x6F, 0x75, 
+0x74, 0x20, 0x28, 0x70, 0x75, 0x73, 0x68, 0x5F, 0x63, 0x6F, 
+0x6E, 0x73, 0x74, 0x61, 0x6E, 0x74, 0x29, 0x20, 0x75, 0x6E, 
+0x69, 0x66, 0x6F, 0x72, 0x6D, 0x20, 0x50, 0x75, 0x73, 0x68, 
+0x43, 0x6F, 0x6E, 0x73, 0x74, 0x73, 0x0A, 0x7B, 0x0A, 0x09, 
+0x6D, 0x61, 0x74, 0x34, 0x20, 0x20, 0x6D, 0x76, 0x70, 0x3B, 
+0x0A, 0x09, 0x76, 0x65, 0x63, 0x33, 0x20, 0x20, 0x66, 0x6F, 
+0x67, 0x5F, 0x63, 0x6F, 0x6C, 0x6F, 0x72, 0x3B, 0x0A, 0x09, 
+0x66, 0x6C, 0x6F, 0x61, 0x74, 0x20, 0x66, 0x6F, 0x67, 0x5F, 
+0x64, 0x65, 0x6E, 0x73, 0x69, 0x74, 0x79, 0x3B, 0x0A, 0x7D, 
+0x0A, 0x70, 0x75, 0x73, 0x68, 0x5F, 0x63, 0x6F, 0x6E, 0x73, 
+0x74, 0x61, 0x6E, 0x74, 0x73, 0x3B, 0x0A, 0x0A, 0x2F, 0x2F, 
+0x20, 0x78, 0x20, 0x64, 0x69, 0x66, 0x66, 0x75, 0x73, 0x65, 
+0x2C, 0x20, 0x79, 0x20, 0x6C, 0x69, 0x67, 0x68, 0x74, 0x6D, 
+0x61, 0x70, 0x2C, 0x20, 0x7A, 0x20, 0x66, 0x75, 0x6C, 0x6C, 
+0x62, 0x72, 0x69, 0x67, 0x68, 0x74, 0x20, 0x6F, 0x72, 0x20, 
+0x7E, 0x30, 0x75, 0x2C, 0x20, 0x69, 0x6E, 0x64, 0x69, 0x63, 
+0x65, 0x73, 0x20, 0x69, 0x6E, 0x74, 0x6F, 0x20, 0x74, 0x68, 
+0x65, 0x20, 0x62, 0x69, 0x6E, 0x64, 0x6C, 0x65, 0x73, 0x73, 
+0x20, 0x74, 0x65, 0x78, 0x74, 0x75, 0x72, 0x65, 0x73, 0x0A, 
+0x6C, 0x61, 0x79, 0x6F, 0x75, 0x74, 0x20, 0x28, 0x73, 0x74, 
+0x64, 0x34, 0x33, 0x30, 0x2C, 0x20, 0x73, 0x65, 0x74, 0x20, 
+0x3D, 0x20, 0x31, 0x2C, 0x20, 0x62, 0x69, 0x6E, 0x64, 0x69, 
+0x6E, 0x67, 0x20, 0x3D, 0x20, 0x30, 0x29, 0x20, 0x72, 0x65, 
+0x73, 0x74, 0x72, 0x69, 0x63, 0x74, 0x20, 0x72, 0x65, 0x61, 
+0x64, 0x6F, 0x6E, 0x6C, 0x79, 0x20, 0x62, 0x75, 0x66, 0x66, 
+0x65, 0x72, 0x20, 0x6D, 0x61, 0x74, 0x65, 0x72, 0x69, 0x61, 
+0x6C, 0x73, 0x5F, 0x74, 0x0A, 0x7B, 0x0A, 0x09, 0x75, 0x76, 
+0x65, 0x63, 0x34, 0x20, 0x6D, 0x61, 0x74, 0x65, 0x72, 0x69, 
+0x61, 0x6C, 0x73, 0x5B, 0x5D, 0x3B, 0x0A, 0x7D, 0x3B, 0x0A, 
+0x0A, 0x6C, 0x61, 0x79, 0x6F, 0x75, 0x74, 0x20, 0x28, 0x6C, 
+0x6F, 0x63, 0x61, 0x74, 0x69, 0x6F, 0x6E, 0x20, 0x3D, 0x20, 
+0x30, 0x29, 0x20, 0x69, 0x6E, 0x20, 0x76, 0x65, 0x63, 0x33, 
+0x20, 0x69, 0x6E, 0x5F, 0x70, 0x6F, 0x73, 0x69, 0x74, 0x69, 
+0x6F, 0x6E, 0x3B, 0x0A, 0x6C, 0x61, 0x79, 0x6F, 0x75, 0x74, 
+0x20, 0x28, 0x6C, 0x6F, 0x63, 0x61, 0x74, 0x69, 0x6F, 0x6E, 
+0x20, 0x3D, 0x20, 0x31, 0x29, 0x20, 0x69, 0x6E, 0x20, 0x76, 
+0x65, 0x63, 0x32, 0x20, 0x69, 0x6E, 0x5F, 0x74, 0x65, 0x78, 
+0x63, 0x6F, 0x6F, 0x72, 0x64, 0x31, 0x3B, 0x0A, 0x6C, 0x61, 
+0x79, 0x6F, 0x75, 0x74, 0x20, 0x28, 0x6C, 0x6F, 0x63, 0x61, 
+0x74, 0x69, 0x6F, 0x6E, 0x20, 0x3D, 0x20, 0x32, 0x29, 0x20, 
+0x69, 0x6E, 0x20, 0x76, 0x65, 0x63, 0x32, 0x20, 0x69, 0x6E, 
+0x5F, 0x74, 0x65, 0x78, 0x63, 0x6F, 0x6F, 0x72, 0x64, 0x32, 
+0x3B, 0x0A, 0x0A, 0x6C, 0x61, 0x79, 0x6F, 0x75, 0x74, 0x20, 
+0x28, 0x6C, 0x6F, 0x63, 0x61, 0x74, 0x69, 0x6F, 0x6E, 0x20, 
+0x3D, 0x20, 0x30, 0x29, 0x20, 0x6F, 0x75, 0x74, 0x20, 0x76, 
+0x65, 0x63, 0x34, 0x20, 0x6F, 0x75, 0x74, 0x5F, 0x74, 0x65, 
+0x78, 0x63, 0x6F, 0x6F, 0x72, 0x64, 0x73, 0x3B, 0x0A, 0x6C, 
+0x61, 0x79, 0x6F, 0x75, 0x74, 0x20, 0x28, 0x6C, 0x6F, 0x63, 
+0x61, 0x74, 0x69, 0x6F, 0x6E, 0x20, 0x3D, 0x20, 0x31, 0x29, 
+0x20, 0x6F, 0x75, 0x74, 0x20, 0x66, 0x6C, 0x6F, 0x61, 0x74, 
+0x20, 0x6F, 0x75, 0x74, 0x5F, 0x66, 0x6F, 0x67, 0x5F, 0x66, 
+0x72, 0x61, 0x67, 0x5F, 0x63, 0x6F, 0x6F, 0x72, 0x64, 0x3B, 
+0x0A, 0x6C, 0x61, 0x79, 0x6F, 0x75, 0x74, 0x20, 0x28, 0x6C, 
+0x6F, 0x63, 0x61, 0x74, 0x69, 0x6F, 0x6E, 0x20, 0x3D, 0x20, 
+0x32, 0x29, 0x20, 0x66, 0x6C, 0x61, 0x74, 0x20, 0x6F, 0x75, 
+0x74, 0x20, 0x75, 0x76, 0x65, 0x63, 0x33, 0x20, 0x6F, 0x75, 
+0x74, 0x5F, 0x74, 0x65, 0x78, 0x74, 0x75, 0x72, 0x65, 0x73, 
+0x3B, 0x0A, 0x0A, 0x6F, 0x75, 0x74, 0x20, 0x67, 0x6C, 0x5F, 
+0x50, 0x65, 0x72, 0x56, 0x65, 0x72, 0x74, 0x65, 0x78, 0x0A, 
+0x7B, 0x0A, 0x09, 0x76, 0x65, 0x63, 0x34, 0x20, 0x67, 0x6C, 
+0x5F, 0x50, 0x6F, 0x73, 0x69, 0x74, 0x69, 0x6F, 0x6E, 0x3B, 
+0x0A, 0x7D, 0x3B, 0x0A, 0x0A, 0x2F, 0x2F, 0x20, 0x54, 0x68, 
+0x65, 0x20, 0x66, 0x69, 0x72, 0x73, 0x74, 0x20, 0x69, 0x6E, 
+0x73, 0x74, 0x61, 0x6E, 0x63, 0x65, 0x20, 0x6F, 0x66, 0x20, 
+0x65, 0x76, 0x65, 0x72, 0x79, 0x20, 0x69, 0x6E, 0x64, 0x69, 
+0x72, 0x65, 0x63, 0x74, 0x20, 0x64, 0x72, 0x61, 0x77, 0x20, 
+0x69, 0x73, 0x20, 0x74, 0x68, 0x65, 0x20, 0x72, 0x61, 0x6E, 
+0x67, 0x65, 0x20, 0x6F, 0x66, 0x20, 0x69, 0x74, 0x73, 0x20, 
+0x73, 0x75, 0x72, 0x66, 0x61, 0x63, 0x65, 0x20, 0x69, 0x6E, 
+0x20, 0x74, 0x68, 0x65, 0x20, 0x6D, 0x61, 0x74, 0x65, 0x72, 
+0x69, 0x61, 0x6C, 0x73, 0x0A, 0x76, 0x6F, 0x69, 0x64, 0x20, 
+0x6D, 0x61, 0x69, 0x6E, 0x20, 0x28, 0x29, 0x0A, 0x7B, 0x0A, 
+0x09, 0x6F, 0x75, 0x74, 0x5F, 0x74, 0x65, 0x78, 0x63, 0x6F, 
+0x6F, 0x72, 0x64, 0x73, 0x2E, 0x78, 0x79, 0x20, 0x3D, 0x20, 
+0x69, 0x6E, 0x5F, 0x74, 0x65, 0x78, 0x63, 0x6F, 0x6F, 0x72, 
+0x64, 0x31, 0x2E, 0x78, 0x79, 0x3B, 0x0A, 0x09, 0x6F, 0x75, 
+0x74, 0x5F, 0x74, 0x65, 0x78, 0x63, 0x6F, 0x6F, 0x72, 0x64, 
+0x73, 0x2E, 0x7A, 0x77, 0x20, 0x3D, 0x20, 0x69, 0x6E, 0x5F, 
+0x74, 0x65, 0x78, 0x63, 0x6F, 0x6F, 0x72, 0x64, 0x32, 0x2E, 
+0x78, 0x79, 0x3B, 0x0A, 0x09, 0x6F, 0x75, 0x74, 0x5F, 0x74, 
+0x65, 0x78, 0x74, 0x75, 0x72, 0x65, 0x73, 0x20, 0x3D, 0x20, 
+0x6D, 0x61, 0x74, 0x65, 0x72, 0x69, 0x61, 0x6C, 0x73, 0x5B, 
+0x67, 0x6C, 0x5F, 0x49, 0x6E, 0x73, 0x74, 0x61, 0x6E, 0x63, 
+0x65, 0x49, 0x6E, 0x64, 0x65, 0x78, 0x5D, 0x2E, 0x78, 0x79, 
+0x7A, 0x3B, 0x0A, 0x09, 0x67, 0x6C, 0x5F, 0x50, 0x6F, 0x73, 
+0x69, 0x74, 0x69, 0x6F, 0x6E, 0x20, 0x3D, 0x20, 0x70, 0x75, 
+0x73, 0x68, 0x5F, 0x63, 0x6F, 0x6E, 0x73, 0x74, 0x61, 0x6E, 
+0x74, 0x73, 0x2E, 0x6D, 0x76, 0x70, 0x20, 0x2A, 0x20, 0x76, 
+0x65, 0x63, 0x34, 0x20, 0x28, 0x69, 0x6E, 0x5F, 0x70, 0x6F, 
+0x73, 0x69, 0x74, 0x69, 0x6F, 0x6E, 0x2C, 0x20, 0x31, 0x2E, 
+0x30, 0x66, 0x29, 0x3B, 0x0A, 0x0A, 0x09, 0x6F, 0x75, 0x74, 
+0x5F, 0x66, 0x6F, 0x67, 0x5F, 0x66, 0x72, 0x61, 0x67, 0x5F, 
+0x63, 0x6F, 0x6F, 0x72, 0x64, 0x20, 0x3D, 0x20, 0x67, 0x6C, 
+0x5F, 0x50, 0x6F, 0x73, 0x69, 0x74, 0x69, 0x6F, 0x6E, 0x2E, 
+0x77, 0x3B, 0x0A, 0x7D, 0x0A, 0x00, 0x05, 0x00, 0x05, 0x00, 
+0x06, 0x00, 0x00, 0x00, 0x50, 0x75, 0x73, 0x68, 0x43, 0x6F, 
+0x6E, 0x73, 0x74, 0x73, 0x00, 0x00, 0x06, 0x00, 0x04, 0x00, 
+0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x6D, 0x76, 
+0x70, 0x00, 0x06, 0x00, 0x06, 0x00, 0x06, 0x00, 0x00, 0x00, 
+0x01, 0x00, 0x00, 0x00, 0x66, 0x6F, 0x67, 0x5F, 0x63, 0x6F, 
+0x6C, 0x6F, 0x72, 0x00, 0x00, 0x00, 0x06, 0x00, 0x06, 0x00, 
+0x06, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x66, 0x6F, 
+0x67, 0x5F, 0x64, 0x65, 0x6E, 0x73, 0x69, 0x74, 0x79, 0x00, 
+0x05, 0x00, 0x06, 0x00, 0x07, 0x00, 0x00, 0x00, 0x70, 0x75, 
+0x73, 0x68, 0x5F, 0x63, 0x6F, 0x6E, 0x73, 0x74, 0x61, 0x6E, 
+0x74, 0x73, 0x00, 0x00, 0x05, 0x00, 0x05, 0x00, 0x0C, 0x00, 
+0x00, 0x00, 0x6D, 0x61, 0x74, 0x65, 0x72, 0x69, 0x61, 0x6C, 
+0x73, 0x5F, 0x74, 0x00, 0x06, 0x00, 0x06, 0x00, 0x0C, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x6D, 0x61, 0x74, 0x65, 
+0x72, 0x69, 0x61, 0x6C, 0x73, 0x00, 0x00, 0x00, 0x05, 0x00, 
+0x03, 0x00, 0x0D, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x05, 0x00, 0x05, 0x00, 0x0F, 0x00, 0x00, 0x00, 0x69, 0x6E, 
+0x5F, 0x70, 0x6F, 0x73, 0x69, 0x74, 0x69, 0x6F, 0x6E, 0x00, 
+0x05, 0x00, 0x06, 0x00, 0x11, 0x00, 0x00, 0x00, 0x69, 0x6E, 
+0x5F, 0x74, 0x65, 0x78, 0x63, 0x6F, 0x6F, 0x72, 0x64, 0x31, 
+0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x06, 0x00, 0x14, 0x00, 
+0x00, 0x00, 0x69, 0x6E, 0x5F, 0x74, 0x65, 0x78, 0x63, 0x6F, 
+0x6F, 0x72, 0x64, 0x32, 0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 
+0x06, 0x00, 0x15, 0x00, 0x00, 0x00, 0x6F, 0x75, 0x74, 0x5F, 
+0x74, 0x65, 0x78, 0x63, 0x6F, 0x6F, 0x72, 0x64, 0x73, 0x00, 
+0x00, 0x00, 0x05, 0x00, 0x07, 0x00, 0x17, 0x00, 0x00, 0x00, 
+0x6F, 0x75, 0x74, 0x5F, 0x66, 0x6F, 0x67, 0x5F, 0x66, 0x72, 
+0x61, 0x67, 0x5F, 0x63, 0x6F, 0x6F, 0x72, 0x64, 0x00, 0x00, 
+0x05, 0x00, 0x06, 0x00, 0x19, 0x00, 0x00, 0x00, 0x6F, 0x75, 
+0x74, 0x5F, 0x74, 0x65, 0x78, 0x74, 0x75, 0x72, 0x65, 0x73, 
+0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x06, 0x00, 0x1C, 0x00, 
+0x00, 0x00, 0x67, 0x6C, 0x5F, 0x50, 0x65, 0x72, 0x56, 0x65, 
+0x72, 0x74, 0x65, 0x78, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 
+0x06, 0x00, 0x1C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x67, 0x6C, 0x5F, 0x50, 0x6F, 0x73, 0x69, 0x74, 0x69, 0x6F, 
+0x6E, 0x00, 0x05, 0x00, 0x03, 0x00, 0x1D, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x04, 0x00, 0x1F, 0x00, 
+0x00, 0x00, 0x6D, 0x61, 0x69, 0x6E, 0x00, 0x00, 0x00, 0x00, 
+0x05, 0x00, 0x07, 0x00, 0x2B, 0x00, 0x00, 0x00, 0x67, 0x6C, 
+0x5F, 0x49, 0x6E, 0x73, 0x74, 0x61, 0x6E, 0x63, 0x65, 0x49, 
+0x6E, 0x64, 0x65, 0x78, 0x00, 0x00, 0x00, 0x00, 0x48, 0x00, 
+0x04, 0x00, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x05, 0x00, 0x00, 0x00, 0x48, 0x00, 0x05, 0x00, 0x06, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x23, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x48, 0x00, 0x05, 0x00, 0x06, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 
+0x10, 0x00, 0x00, 0x00, 0x48, 0x00, 0x05, 0x00, 0x06, 0x00, 
+0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x23, 0x00, 0x00, 0x00, 
+0x40, 0x00, 0x00, 0x00, 0x48, 0x00, 0x05, 0x00, 0x06, 0x00, 
+0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x23, 0x00, 0x00, 0x00, 
+0x4C, 0x00, 0x00, 0x00, 0x47, 0x00, 0x03, 0x00, 0x06, 0x00, 
+0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x47, 0x00, 0x04, 0x00, 
+0x0B, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x10, 0x00, 
+0x00, 0x00, 0x48, 0x00, 0x05, 0x00, 0x0C, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x23, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x47, 0x00, 0x03, 0x00, 0x0C, 0x00, 0x00, 0x00, 
+0x03, 0x00, 0x00, 0x00, 0x48, 0x00, 0x04, 0x00, 0x0C, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 
+0x48, 0x00, 0x04, 0x00, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x47, 0x00, 0x04, 0x00, 
+0x0D, 0x00, 0x00, 0x00, 0x22, 0x00, 0x00, 0x00, 0x01, 0x00, 
+0x00, 0x00, 0x47, 0x00, 0x04, 0x00, 0x0D, 0x00, 0x00, 0x00, 
+0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x47, 0x00, 
+0x04, 0x00, 0x0F, 0x00, 0x00, 0x00, 0x1E, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x47, 0x00, 0x04, 0x00, 0x11, 0x00, 
+0x00, 0x00, 0x1E, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+0x47, 0x00, 0x04, 0x00, 0x14, 0x00, 0x00, 0x00, 0x1E, 0x00, 
+0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x47, 0x00, 0x04, 0x00, 
+0x15, 0x00, 0x00, 0x00, 0x1E, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x47, 0x00, 0x04, 0x00, 0x17, 0x00, 0x00, 0x00, 
+0x1E, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x47, 0x00, 
+0x04, 0x00, 0x19, 0x00, 0x00, 0x00, 0x1E, 0x00, 0x00, 0x00, 
+0x02, 0x00, 0x00, 0x00, 0x47, 0x00, 0x03, 0x00, 0x19, 0x00, 
+0x00, 0x00, 0x0E, 0x00, 0x00, 0x00, 0x47, 0x00, 0x03, 0x00, 
+0x1C, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x48, 0x00, 
+0x05, 0x00, 0x1C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x0B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x47, 0x00, 
+0x04, 0x00, 0x2B, 0x00, 0x00, 0x00, 0x0B, 0x00, 0x00, 0x00, 
+0x2B, 0x00, 0x00, 0x00, 0x16, 0x00, 0x03, 0x00, 0x02, 0x00, 
+0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x17, 0x00, 0x04, 0x00, 
+0x03, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x04, 0x00, 
+0x00, 0x00, 0x18, 0x00, 0x04, 0x00, 0x04, 0x00, 0x00, 0x00, 
+0x03, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x17, 0x00, 
+0x04, 0x00, 0x05, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 
+0x03, 0x00, 0x00, 0x00, 0x1E, 0x00, 0x05, 0x00, 0x06, 0x00, 
+0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 
+0x02, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00, 0x08, 0x00, 
+0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 
+0x3B, 0x00, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00, 0x07, 0x00, 
+0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x15, 0x00, 0x04, 0x00, 
+0x09, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x17, 0x00, 0x04, 0x00, 0x0A, 0x00, 0x00, 0x00, 
+0x09, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x1D, 0x00, 
+0x03, 0x00, 0x0B, 0x00, 0x00, 0x00, 0x0A, 0x00, 0x00, 0x00, 
+0x1E, 0x00, 0x03, 0x00, 0x0C, 0x00, 0x00, 0x00, 0x0B, 0x00, 
+0x00, 0x00, 0x20, 0x00, 0x04, 0x00, 0x0E, 0x00, 0x00, 0x00, 
+0x02, 0x00, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00, 0x3B, 0x00, 
+0x04, 0x00, 0x0E, 0x00, 0x00, 0x00, 0x0D, 0x00, 0x00, 0x00, 
+0x02, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00, 0x10, 0x00, 
+0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 
+0x3B, 0x00, 0x04, 0x00, 0x10, 0x00, 0x00, 0x00, 0x0F, 0x00, 
+0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x17, 0x00, 0x04, 0x00, 
+0x12, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, 0x00, 
+0x00, 0x00, 0x20, 0x00, 0x04, 0x00, 0x13, 0x00, 0x00, 0x00, 
+0x01, 0x00, 0x00, 0x00, 0x12, 0x00, 0x00, 0x00, 0x3B, 0x00, 
+0x04, 0x00, 0x13, 0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 
+0x01, 0x00, 0x00, 0x00, 0x3B, 0x00, 0x04, 0x00, 0x13, 0x00, 
+0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+0x20, 0x00, 0x04, 0x00, 0x16, 0x00, 0x00, 0x00, 0x03, 0x00, 
+0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x3B, 0x00, 0x04, 0x00, 
+0x16, 0x00, 0x00, 0x00, 0x15, 0x00, 0x00, 0x00, 0x03, 0x00, 
+0x00, 0x00, 0x20, 0x00, 0x04, 0x00, 0x18, 0x00, 0x00, 0x00, 
+0x03, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x3B, 0x00, 
+0x04, 0x00, 0x18, 0x00, 0x00, 0x00, 0x17, 0x00, 0x00, 0x00, 
+0x03, 0x00, 0x00, 0x00, 0x17, 0x00, 0x04, 0x00, 0x1A, 0x00, 
+0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 
+0x20, 0x00, 0x04, 0x00, 0x1B, 0x00, 0x00, 0x00, 0x03, 0x00, 
+0x00, 0x00, 0x1A, 0x00, 0x00, 0x00, 0x3B, 0x00, 0x04, 0x00, 
+0x1B, 0x00, 0x00, 0x00, 0x19, 0x00, 0x00, 0x00, 0x03, 0x00, 
+0x00, 0x00, 0x1E, 0x00, 0x03, 0x00, 0x1C, 0x00, 0x00, 0x00, 
+0x03, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00, 0x1E, 0x00, 
+0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x1C, 0x00, 0x00, 0x00, 
+0x3B, 0x00, 0x04, 0x00, 0x1E, 0x00, 0x00, 0x00, 0x1D, 0x00, 
+0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x13, 0x00, 0x02, 0x00, 
+0x20, 0x00, 0x00, 0x00, 0x21, 0x00, 0x03, 0x00, 0x21, 0x00, 
+0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x15, 0x00, 0x04, 0x00, 
+0x2C, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x01, 0x00, 
+0x00, 0x00, 0x20, 0x00, 0x04, 0x00, 0x2D, 0x00, 0x00, 0x00, 
+0x01, 0x00, 0x00, 0x00, 0x2C, 0x00, 0x00, 0x00, 0x3B, 0x00, 
+0x04, 0x00, 0x2D, 0x00, 0x00, 0x00, 0x2B, 0x00, 0x00, 0x00, 
+0x01, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00, 0x30, 0x00, 
+0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x0A, 0x00, 0x00, 0x00, 
+0x2B, 0x00, 0x04, 0x00, 0x2C, 0x00, 0x00, 0x00, 0x31, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00, 
+0x35, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x04, 0x00, 
+0x00, 0x00, 0x2B, 0x00, 0x04, 0x00, 0x02, 0x00, 0x00, 0x00, 
+0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x3F, 0x2B, 0x00, 
+0x04, 0x00, 0x2C, 0x00, 0x00, 0x00, 0x3D, 0x00, 0x00, 0x00, 
+0x03, 0x00, 0x00, 0x00, 0x36, 0x00, 0x05, 0x00, 0x20, 0x00, 
+0x00, 0x00, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x21, 0x00, 0x00, 0x00, 0xF8, 0x00, 0x02, 0x00, 0x22, 0x00, 
+0x00, 0x00, 0x3D, 0x00, 0x04, 0x00, 0x12, 0x00, 0x00, 0x00, 
+0x23, 0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x4F, 0x00, 
+0x07, 0x00, 0x12, 0x00, 0x00, 0x00, 0x24, 0x00, 0x00, 0x00, 
+0x23, 0x00, 0x00, 0x00, 0x23, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3D, 0x00, 0x04, 0x00, 
+0x03, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x00, 0x15, 0x00, 
+0x00, 0x00, 0x4F, 0x00, 0x09, 0x00, 0x03, 0x00, 0x00, 0x00, 
+0x26, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x00, 0x24, 0x00, 
+0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 
+0x02, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x3E, 0x00, 
+0x03, 0x00, 0x15, 0x00, 0x00, 0x00, 0x26, 0x00, 0x00, 0x00, 
+0x3D, 0x00, 0x04, 0x00, 0x12, 0x00, 0x00, 0x00, 0x27, 0x00, 
+0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x4F, 0x00, 0x07, 0x00, 
+0x12, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00, 0x27, 0x00, 
+0x00, 0x00, 0x27, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x01, 0x00, 0x00, 0x00, 0x3D, 0x00, 0x04, 0x00, 0x03, 0x00, 
+0x00, 0x00, 0x29, 0x00, 0x00, 0x00, 0x15, 0x00, 0x00, 0x00, 
+0x4F, 0x00, 0x09, 0x00, 0x03, 0x00, 0x00, 0x00, 0x2A, 0x00, 
+0x00, 0x00, 0x29, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x04, 0x00, 
+0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x3E, 0x00, 0x03, 0x00, 
+0x15, 0x00, 0x00, 0x00, 0x2A, 0x00, 0x00, 0x00, 0x3D, 0x00, 
+0x04, 0x00, 0x2C, 0x00, 0x00, 0x00, 0x2E, 0x00, 0x00, 0x00, 
+0x2B, 0x00, 0x00, 0x00, 0x41, 0x00, 0x06, 0x00, 0x30, 0x00, 
+0x00, 0x00, 0x2F, 0x00, 0x00, 0x00, 0x0D, 0x00, 0x00, 0x00, 
+0x31, 0x00, 0x00, 0x00, 0x2E, 0x00, 0x00, 0x00, 0x3D, 0x00, 
+0x04, 0x00, 0x0A, 0x00, 0x00, 0x00, 0x32, 0x00, 0x00, 0x00, 
+0x2F, 0x00, 0x00, 0x00, 0x4F, 0x00, 0x08, 0x00, 0x1A, 0x00, 
+0x00, 0x00, 0x33, 0x00, 0x00, 0x00, 0x32, 0x00, 0x00, 0x00, 
+0x32, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 
+0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x3E, 0x00, 0x03, 0x00, 
+0x19, 0x00, 0x00, 0x00, 0x33, 0x00, 0x00, 0x00, 0x41, 0x00, 
+0x05, 0x00, 0x35, 0x00, 0x00, 0x00, 0x34, 0x00, 0x00, 0x00, 
+0x07, 0x00, 0x00, 0x00, 0x31, 0x00, 0x00, 0x00, 0x3D, 0x00, 
+0x04, 0x00, 0x04, 0x00, 0x00, 0x00, 0x36, 0x00, 0x00, 0x00, 
+0x34, 0x00, 0x00, 0x00, 0x3D, 0x00, 0x04, 0x00, 0x05, 0x00, 
+0x00, 0x00, 0x37, 0x00, 0x00, 0x00, 0x0F, 0x00, 0x00, 0x00, 
+0x50, 0x00, 0x05, 0x00, 0x03, 0x00, 0x00, 0x00, 0x39, 0x00, 
+0x00, 0x00, 0x37, 0x00, 0x00, 0x00, 0x38, 0x00, 0x00, 0x00, 
+0x91, 0x00, 0x05, 0x00, 0x03, 0x00, 0x00, 0x00, 0x3A, 0x00, 
+0x00, 0x00, 0x36, 0x00, 0x00, 0x00, 0x39, 0x00, 0x00, 0x00, 
+0x41, 0x00, 0x05, 0x00, 0x16, 0x00, 0x00, 0x00, 0x3B, 0x00, 
+0x00, 0x00, 0x1D, 0x00, 0x00, 0x00, 0x31, 0x00, 0x00, 0x00, 
+0x3E, 0x00, 0x03, 0x00, 0x3B, 0x00, 0x00, 0x00, 0x3A, 0x00, 
+0x00, 0x00, 0x41, 0x00, 0x06, 0x00, 0x18, 0x00, 0x00, 0x00, 
+0x3C, 0x00, 0x00, 0x00, 0x1D, 0x00, 0x00, 0x00, 0x31, 0x00, 
+0x00, 0x00, 0x3D, 0x00, 0x00, 0x00, 0x3D, 0x00, 0x04, 0x00, 
+0x02, 0x00, 0x00, 0x00, 0x3E, 0x00, 0x00, 0x00, 0x3C, 0x00, 
+0x00, 0x00, 0x3E, 0x00, 0x03, 0x00, 0x17, 0x00, 0x00, 0x00, 
+0x3E, 0x00, 0x00, 0x00, 0xFD, 0x00, 0x01, 0x00, 0x38, 0x00, 
+0x01, 0x00, };
+const int world_bindless_vert_spv_size = 3192;
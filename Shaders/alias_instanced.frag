@@ -0,0 +1,49 @@
+#version 460
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_GOOGLE_include_directive : enable
+
+layout (constant_id = 0) const bool use_alpha_test = false;
+
+layout (push_constant) uniform PushConsts
+{
+	mat4  mvp;
+	vec3  fog_color;
+	float fog_density;
+}
+push_constants;
+
+layout (set = 0, binding = 0) uniform sampler2D diffuse_tex;
+layout (set = 1, binding = 0) uniform sampler2D fullbright_tex;
+
+layout (location = 0) in vec2 in_texcoord;
+layout (location = 1) in vec4 in_color;
+layout (location = 2) in float in_fog_frag_coord;
+layout (location = 3) flat in uint in_flags;
+
+layout (location = 0) out vec4 out_frag_color;
+
+// Opaque alias models only, see alias.frag and alias_alphatest.frag
+void main ()
+{
+	vec4 result = texture (diffuse_tex, in_texcoord.xy);
+	if (use_alpha_test)
+	{
+		if (result.a < 0.666f)
+			discard;
+		result *= in_color;
+	}
+	else
+		result *= in_color * 2.0f;
+
+	if ((in_flags & 0x1) != 0)
+		result += texture (fullbright_tex, in_texcoord.xy);
+
+	result.a = 1.0f;
+
+	float fog = exp (-push_constants.fog_density * push_constants.fog_density * in_fog_frag_coord * in_fog_frag_coord);
+	fog = clamp (fog, 0.0, 1.0);
+	result.rgb = mix (push_constants.fog_color, result.rgb, fog);
+
+	out_frag_color = result;
+}
@@ -31,9 +31,13 @@ DECLARE_SHADER_SPV (basic_alphatest_frag);
 DECLARE_SHADER_SPV (basic_notex_frag);
 DECLARE_SHADER_SPV (world_vert);
 DECLARE_SHADER_SPV (world_frag);
+DECLARE_SHADER_SPV (world_bindless_vert);
+DECLARE_SHADER_SPV (world_bindless_frag);
 DECLARE_SHADER_SPV (alias_vert);
 DECLARE_SHADER_SPV (alias_frag);
 DECLARE_SHADER_SPV (alias_alphatest_frag);
+DECLARE_SHADER_SPV (alias_instanced_vert);
+DECLARE_SHADER_SPV (alias_instanced_frag);
 DECLARE_SHADER_SPV (sky_layer_vert);
 DECLARE_SHADER_SPV (sky_layer_frag);
 DECLARE_SHADER_SPV (sky_box_frag);
@@ -49,6 +53,11 @@ DECLARE_SHADER_SPV (cs_tex_warp_comp);
 DECLARE_SHADER_SPV (showtris_vert);
 DECLARE_SHADER_SPV (showtris_frag);
 DECLARE_SHADER_SPV (update_lightmap_comp);
+DECLARE_SHADER_SPV (hiz_reduce_comp);
+DECLARE_SHADER_SPV (hiz_reduce_ms_comp);
+DECLARE_SHADER_SPV (occlusion_cull_comp);
+DECLARE_SHADER_SPV (particle_update_comp);
+DECLARE_SHADER_SPV (world_cull_comp);
 
 #undef DECLARE_SHADER_SPV
 
@@ -0,0 +1,62 @@
+#version 460
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_EXT_nonuniform_qualifier : enable
+
+// keep in sync with glquake.h
+#define LMBLOCK_WIDTH 1024
+#define LMBLOCK_HEIGHT 1024
+#define MAX_GLTEXTURES 4096
+#define NO_TEXTURE 0xFFFFFFFFu
+
+layout (push_constant) uniform PushConsts
+{
+	mat4  mvp;
+	vec3  fog_color;
+	float fog_density;
+}
+push_constants;
+
+layout (set = 0, binding = 0) uniform sampler2D textures[MAX_GLTEXTURES];
+
+layout (location = 0) in vec4 in_texcoords;
+layout (location = 1) in float in_fog_frag_coord;
+layout (location = 2) flat in uvec3 in_textures;
+
+layout (location = 0) out vec4 out_frag_color;
+
+layout (constant_id = 1) const bool use_alpha_test = false;
+layout (constant_id = 3) const bool quantize_lm = false;
+layout (constant_id = 4) const bool scaled_lm = false;
+
+// world.frag for opaque surfaces, the textures of a draw vary per instance
+void main ()
+{
+	vec4 diffuse = texture (textures[nonuniformEXT (in_textures.x)], in_texcoords.xy);
+	if (use_alpha_test && diffuse.a < 0.666f)
+		discard;
+
+	float lm_multiplier = scaled_lm ? 8.0f : 2.0f;
+	vec3 light;
+
+	if (quantize_lm)
+	{
+		ivec2 lm_size = ivec2(LMBLOCK_WIDTH, LMBLOCK_HEIGHT);
+		vec2 uv_exp = (floor ((lm_size * 16) * in_texcoords.zw) + 0.5) / (lm_size * 16);
+		light = texture (textures[nonuniformEXT (in_textures.y)], uv_exp).rgb * lm_multiplier;
+	}
+	else
+		light = texture (textures[nonuniformEXT (in_textures.y)], in_texcoords.zw).rgb * lm_multiplier;
+
+	out_frag_color.rgb = diffuse.rgb * light.rgb;
+
+	if (in_textures.z != NO_TEXTURE)
+	{
+		vec3 fullbright = texture (textures[nonuniformEXT (in_textures.z)], in_texcoords.xy).rgb;
+		out_frag_color.rgb += fullbright;
+	}
+
+	float fog = exp (-push_constants.fog_density * push_constants.fog_density * in_fog_frag_coord * in_fog_frag_coord);
+	fog = clamp (fog, 0.0, 1.0);
+	out_frag_color.rgb = mix (push_constants.fog_color, out_frag_color.rgb, fog);
+}